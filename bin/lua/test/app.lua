@@ -40,7 +40,18 @@ function App:InitModules()
         --"test/test32",
         --"test/test33",
         --"test/test34"
-        "test/test35"
+        "test/test35",
+        --"test/test36",
+        --"test/test37",
+        --"test/test38",
+        --"test/test39",
+        --"test/test40",
+        --"test/test41",
+        --"test/test42",
+        --"test/test43",
+        --"test/test44",
+        --"test/test45",
+        --"test/test46",
     }
     for k, v in pairs(test_cases) do
         require(v)
@@ -0,0 +1,77 @@
+-- TCP echo over loopback, round trip time of small messages one at a time.
+-- Run it once per poller backend and compare:
+--   ./tinynet --app=test --labels=id=test1,env=.${USER}
+--   ./tinynet --app=test --labels=id=test1,env=.${USER},poller_backend=io_uring
+-- Syscalls per message: strace -c -f -p <pid> while it runs, divided by the message count.
+local log = log
+local high_resolution_time = high_resolution_time
+
+local port = 18036
+local count = 100000
+local msg = string.rep("x", 64)
+
+local peers = {}
+local server = tinynet.socket.tcp.new()
+server:on_event(function(evt)
+    if evt.type ~= "onaccept" then
+        return
+    end
+    local peer = evt.data
+    peers[peer] = true
+    peer:on_event(function(e)
+        if e.type == "onread" then
+            peer:send(e.data)
+        elseif e.type == "onerror" then
+            peers[peer] = nil
+        end
+    end)
+end)
+local err = server:listen(port)
+if err then
+    log.error("echo listen failed:%s", err)
+    return
+end
+
+local rtts = {}
+local received = 0
+local sent_time = 0
+local begin_time = 0
+local client = tinynet.socket.tcp.new()
+
+local function report()
+    local cost = high_resolution_time() - begin_time
+    table.sort(rtts)
+    log.warning("echo backend:%s, messages:%d, %.0f msg/s, p50:%.1f us, p99:%.1f us, max:%.1f us",
+        env.meta.labels.poller_backend or "default", count, count / cost,
+        rtts[math.floor(count * 0.5)] * 1e6, rtts[math.floor(count * 0.99)] * 1e6, rtts[count] * 1e6)
+    client:close()
+    server:close()
+end
+
+client:on_event(function(evt)
+    if evt.type == "onopen" then
+        begin_time = high_resolution_time()
+        sent_time = begin_time
+        client:send(msg)
+    elseif evt.type == "onread" then
+        received = received + #evt.data
+        if received < #msg then
+            return
+        end
+        received = 0
+        local now = high_resolution_time()
+        rtts[#rtts + 1] = now - sent_time
+        if #rtts == count then
+            report()
+            return
+        end
+        sent_time = now
+        client:send(msg)
+    elseif evt.type == "onerror" then
+        log.error("echo client error:%s", evt.data)
+    end
+end)
+err = client:connect("127.0.0.1", port)
+if err then
+    log.error("echo connect failed:%s", err)
+end
@@ -0,0 +1,62 @@
+-- Timer engine cost with 10k, 100k and 1M live timers.
+-- Run it once per engine and compare:
+--   ./tinynet --app=test --labels=id=test1,env=.${USER}
+--   ./tinynet --app=test --labels=id=test1,env=.${USER},timer_backend=wheel
+-- Each round adds the timers far in the future and then clears them, so add and clear are measured
+-- with the engine holding that many timers. The last round fires 100k timers spread over one second.
+local log = log
+local ctimer = tinynet.timer
+local high_resolution_time = high_resolution_time
+local get_loop_stats = get_loop_stats
+
+local backend = env.meta.labels.timer_backend or "set"
+local sizes = { 10000, 100000, 1000000 }
+local fire_count = 100000
+local fire_span = 1000
+
+local function on_timeout()
+end
+
+local function run_live(count)
+    local ids = {}
+    local begin_time = high_resolution_time()
+    for i = 1, count do
+        --Due in an hour or more, none of them fires during the round
+        ids[i] = ctimer.start(3600000 + i % 1000, 0, on_timeout)
+    end
+    local add_cost = high_resolution_time() - begin_time
+    begin_time = high_resolution_time()
+    for i = 1, count do
+        ctimer.stop(ids[i])
+    end
+    local clear_cost = high_resolution_time() - begin_time
+    log.warning("timer backend:%s, live:%d, add:%.0f ns, clear:%.0f ns",
+        backend, count, add_cost / count * 1e9, clear_cost / count * 1e9)
+end
+
+local function run_fire()
+    local fired = 0
+    local last_time = 0
+    local stats = get_loop_stats()
+    local timers, timer_us = stats.timers, stats.timer_us
+    local begin_time = high_resolution_time()
+    local function on_fire()
+        fired = fired + 1
+        if fired < fire_count then
+            return
+        end
+        last_time = high_resolution_time()
+        stats = get_loop_stats()
+        log.warning("timer backend:%s, fired:%d, late by:%.1f ms, in callbacks:%.1f ms, %.0f ns per timer",
+            backend, fired, (last_time - begin_time) * 1000 - fire_span,
+            (stats.timer_us - timer_us) / 1000, (stats.timer_us - timer_us) * 1000 / (stats.timers - timers))
+    end
+    for i = 1, fire_count do
+        ctimer.start(1 + i % fire_span, 0, on_fire)
+    end
+end
+
+for _, count in ipairs(sizes) do
+    run_live(count)
+end
+run_fire()
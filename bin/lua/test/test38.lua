@@ -0,0 +1,82 @@
+-- Cross thread ping-pong through the task queues of two event loops.
+-- Two apps of one process exchange messages over the in-process TDC path, every message is a task
+-- posted to the other loop:
+--   ./tinynet --app="test|test" --labels="id=test1,env=.${USER},role=pong|id=test2,env=.${USER},role=ping"
+-- The ping side reports round trips per second, tasks per second and wakeups written per task,
+-- first with one message in flight, where every task finds the peer loop parked, then with a window.
+local log = log
+local c_cluster = tinynet.cluster
+local AppUtil = require("tinynet/util/app_util")
+local high_resolution_time = high_resolution_time
+local get_loop_stats = get_loop_stats
+
+local role = env.meta.labels.role
+local rounds = 100000
+local windows = { 1, 64 }
+local msg = string.rep("x", 32)
+
+local config = AppUtil.require_config("cluster")
+config.bytesAsString = true
+
+local function on_sent(err)
+    if err then
+        log.error("%s send failed:%s", role, err)
+    end
+end
+
+if role == "pong" then
+    local err = c_cluster.start("bench-pong", config, function(data)
+        c_cluster.send_message("bench-ping", data, on_sent)
+    end)
+    if err then
+        log.error("pong start failed:%s", err)
+    end
+    return
+end
+if role ~= "ping" then
+    log.error("label role=ping or role=pong expected")
+    return
+end
+
+local window_index = 0
+local received = 0
+local begin_time, begin_stats
+
+local function start_round()
+    window_index = window_index + 1
+    local window = windows[window_index]
+    if not window then
+        return
+    end
+    received = 0
+    begin_stats = get_loop_stats()
+    begin_time = high_resolution_time()
+    for _ = 1, window do
+        c_cluster.send_message("bench-pong", msg, on_sent)
+    end
+end
+
+local function on_reply(data)
+    received = received + 1
+    local window = windows[window_index]
+    if received + window <= rounds then
+        c_cluster.send_message("bench-pong", data, on_sent)
+    end
+    if received < rounds then
+        return
+    end
+    local cost = high_resolution_time() - begin_time
+    local stats = get_loop_stats()
+    local tasks = stats.tasks - begin_stats.tasks
+    log.warning("ping-pong window:%d, %.0f round trips/s, %.0f tasks/s, %.3f wakeups per task",
+        window, rounds / cost, tasks / cost, (stats.wakeups - begin_stats.wakeups) / tasks)
+    start_round()
+end
+
+local err = c_cluster.start("bench-ping", config, on_reply)
+if err then
+    log.error("ping start failed:%s", err)
+    return
+end
+--Leaves the pong app time to register in the process
+tinynet.timer.start(1000, 0, start_round)
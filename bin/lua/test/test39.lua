@@ -0,0 +1,114 @@
+-- Reliable UDP echo over loopback with simulated packet loss.
+--   ./tinynet --app=test --labels=id=test1,env=.${USER}
+-- Both endpoints drop the given percent of the datagrams they receive. For each loss rate the client
+-- keeps a window of messages in flight, checks they come back in order, and reports messages per
+-- second, round trip percentiles and retransmissions.
+local log = log
+local rudp = tinynet.socket.rudp
+local high_resolution_time = high_resolution_time
+local string_format = string.format
+
+local base_port = 18039
+local drop_rates = { 0, 5, 20 }
+local count = 10000
+local window = 32
+local padding = string.rep("x", 248)
+
+local round = 0
+local run_round
+
+local function make_opts(drop_rate)
+    return { nodelay = true, resend = 2, interval = 10, snd_wnd = 128, rcv_wnd = 128, drop_rate = drop_rate }
+end
+
+local function percentile(sorted, p)
+    return sorted[math.max(1, math.floor(#sorted * p))] * 1000
+end
+
+run_round = function()
+    round = round + 1
+    local drop_rate = drop_rates[round]
+    if not drop_rate then
+        return
+    end
+    local port = base_port + round
+    local server = rudp.new(make_opts(drop_rate))
+    local peers = {}
+    server:on_event(function(evt)
+        if evt.type ~= "onaccept" then
+            return
+        end
+        local peer = evt.data
+        peers[peer] = true
+        peer:on_event(function(e)
+            if e.type == "onread" then
+                peer:send(e.data)
+            elseif e.type == "onerror" then
+                peers[peer] = nil
+            end
+        end)
+    end)
+    local err = server:listen(port)
+    if err then
+        log.error("rudp listen failed:%s", err)
+        return
+    end
+
+    local client = rudp.new(make_opts(drop_rate))
+    local sent_times = {}
+    local rtts = {}
+    local next_seq = 1
+    local expected = 1
+    local begin_time = 0
+
+    local function send_next()
+        local seq = next_seq
+        next_seq = next_seq + 1
+        sent_times[seq] = high_resolution_time()
+        client:send(string_format("%08d", seq) .. padding)
+    end
+
+    local function report()
+        local cost = high_resolution_time() - begin_time
+        local stats = client:get_stats()
+        table.sort(rtts)
+        log.warning("rudp drop:%d%%, messages:%d, %.0f msg/s, p50:%.1f ms, p99:%.1f ms, max:%.1f ms, retransmits:%d",
+            drop_rate, count, count / cost, percentile(rtts, 0.5), percentile(rtts, 0.99),
+            rtts[#rtts] * 1000, stats and stats.retransmits or 0)
+        client:close()
+        server:close()
+        run_round()
+    end
+
+    client:on_event(function(evt)
+        if evt.type == "onopen" then
+            begin_time = high_resolution_time()
+            for _ = 1, window do
+                send_next()
+            end
+        elseif evt.type == "onread" then
+            local seq = tonumber(string.sub(evt.data, 1, 8))
+            if seq ~= expected then
+                log.error("rudp drop:%d%%, message %s arrived, %d expected", drop_rate, seq, expected)
+            end
+            expected = expected + 1
+            rtts[#rtts + 1] = high_resolution_time() - sent_times[seq]
+            sent_times[seq] = nil
+            if #rtts == count then
+                report()
+                return
+            end
+            if next_seq <= count then
+                send_next()
+            end
+        elseif evt.type == "onerror" then
+            log.error("rudp drop:%d%%, client error:%s", drop_rate, evt.data)
+        end
+    end)
+    err = client:connect("127.0.0.1", port)
+    if err then
+        log.error("rudp connect failed:%s", err)
+    end
+end
+
+run_round()
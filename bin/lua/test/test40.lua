@@ -0,0 +1,113 @@
+-- One way throughput of the TCP, unix domain socket and shared memory transports.
+--   ./tinynet --app=test --labels=id=test1,env=.${USER}
+-- The client streams 256 MB in 4 KB and in 64 KB writes, the server acks every MB it reads and the client
+-- keeps at most 8 MB unacked. Both ends live in one process here, the loop serves both sides; run the
+-- server and the client as two processes to see the cross process figure.
+local log = log
+local tcp = tinynet.socket.tcp
+local high_resolution_time = high_resolution_time
+local unpack = table.unpack or unpack
+
+local total = 256 * 1024 * 1024
+local ack_bytes = 1024 * 1024
+local max_unacked = 8 * ack_bytes
+local unix_path = "/tmp/tinynet.test40.sock"
+local transports = {
+    { name = "tcp", listen = 18040, connect = { "127.0.0.1", 18040 } },
+    { name = "unix", listen = { listen_path = unix_path }, connect = { "unix://" .. unix_path } },
+    { name = "shm", listen = "shm://test40", connect = { "shm://test40" } },
+}
+local write_sizes = { 4096, 65536 }
+
+local rounds = {}
+for _, transport in ipairs(transports) do
+    for _, size in ipairs(write_sizes) do
+        rounds[#rounds + 1] = { transport = transport, size = size }
+    end
+end
+
+local round_index = 0
+local run_round
+
+run_round = function()
+    round_index = round_index + 1
+    local round = rounds[round_index]
+    if not round then
+        return
+    end
+    local transport = round.transport
+    local chunk = string.rep("x", round.size)
+
+    local server = tcp.new()
+    local peers = {}
+    server:on_event(function(evt)
+        if evt.type ~= "onaccept" then
+            return
+        end
+        local peer = evt.data
+        local received = 0
+        local acked = 0
+        peers[peer] = true
+        peer:on_event(function(e)
+            if e.type == "onread" then
+                received = received + #e.data
+                local acks = math.floor(received / ack_bytes) - acked
+                if acks > 0 then
+                    acked = acked + acks
+                    peer:send(string.rep("a", acks))
+                end
+            elseif e.type == "onerror" then
+                peers[peer] = nil
+            end
+        end)
+    end)
+    --The path of the previous round is left behind
+    os.remove(unix_path)
+    local err = server:listen(transport.listen)
+    if err then
+        log.error("%s listen failed:%s", transport.name, err)
+        return
+    end
+
+    local client = tcp.new()
+    local sent = 0
+    local acked = 0
+    local begin_time = 0
+
+    local function pump()
+        while sent < total and sent - acked < max_unacked do
+            local send_err = client:send(chunk)
+            if send_err then
+                log.error("%s send failed:%s", transport.name, send_err)
+                return
+            end
+            sent = sent + #chunk
+        end
+    end
+
+    client:on_event(function(evt)
+        if evt.type == "onopen" then
+            begin_time = high_resolution_time()
+            pump()
+        elseif evt.type == "onread" then
+            acked = acked + #evt.data * ack_bytes
+            if acked >= total then
+                local cost = high_resolution_time() - begin_time
+                log.warning("%s writes:%d B, %.1f MB/s", transport.name, round.size, total / cost / 1048576)
+                client:close()
+                server:close()
+                run_round()
+                return
+            end
+            pump()
+        elseif evt.type == "onerror" then
+            log.error("%s client error:%s", transport.name, evt.data)
+        end
+    end)
+    err = client:connect(unpack(transport.connect))
+    if err then
+        log.error("%s connect failed:%s", transport.name, err)
+    end
+end
+
+run_round()
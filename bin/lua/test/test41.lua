@@ -0,0 +1,89 @@
+-- TDC messages between two apps, inside one process and across two processes.
+-- Start the naming service first (naming_service.sh start), then compare
+--   ./tinynet --app="test|test" --labels="id=test1,env=.${USER},role=pong|id=test2,env=.${USER},role=ping"
+-- with the same two apps as two processes:
+--   ./tinynet --app=test --labels=id=test1,env=.${USER},role=pong
+--   ./tinynet --app=test --labels=id=test2,env=.${USER},role=ping
+-- Inside one process the channel delivers through the loop mailbox of the target, across processes it
+-- goes through naming and Tdc.Transfer. The ping side keeps a window of messages in flight, checks the
+-- echoes come back in order and reports messages per second and round trip percentiles.
+local log = log
+local c_cluster = tinynet.cluster
+local AppUtil = require("tinynet/util/app_util")
+local high_resolution_time = high_resolution_time
+local string_format = string.format
+
+local role = env.meta.labels.role
+local count = 100000
+local window = 16
+local padding = string.rep("x", 120)
+
+local config = AppUtil.require_config("cluster")
+config.bytesAsString = true
+
+local function on_sent(err)
+    if err then
+        log.error("%s send failed:%s", role, err)
+    end
+end
+
+if role == "pong" then
+    local err = c_cluster.start("bench41-pong", config, function(data)
+        c_cluster.send_message("bench41-ping", data, on_sent)
+    end)
+    if err then
+        log.error("pong start failed:%s", err)
+    end
+    return
+end
+if role ~= "ping" then
+    log.error("label role=ping or role=pong expected")
+    return
+end
+
+local sent_times = {}
+local rtts = {}
+local next_seq = 1
+local expected = 1
+local begin_time = 0
+
+local function send_next()
+    local seq = next_seq
+    next_seq = next_seq + 1
+    sent_times[seq] = high_resolution_time()
+    c_cluster.send_message("bench41-pong", string_format("%08d", seq) .. padding, on_sent)
+end
+
+local function on_reply(data)
+    local seq = tonumber(string.sub(data, 1, 8))
+    if seq ~= expected then
+        log.error("message %s arrived, %d expected", seq, expected)
+    end
+    expected = expected + 1
+    rtts[#rtts + 1] = high_resolution_time() - sent_times[seq]
+    sent_times[seq] = nil
+    if #rtts == count then
+        local cost = high_resolution_time() - begin_time
+        table.sort(rtts)
+        log.warning("tdc messages:%d, window:%d, %.0f msg/s, p50:%.1f us, p99:%.1f us, max:%.1f us",
+            count, window, count / cost, rtts[math.floor(count * 0.5)] * 1e6,
+            rtts[math.floor(count * 0.99)] * 1e6, rtts[count] * 1e6)
+        return
+    end
+    if next_seq <= count then
+        send_next()
+    end
+end
+
+local err = c_cluster.start("bench41-ping", config, on_reply)
+if err then
+    log.error("ping start failed:%s", err)
+    return
+end
+--Leaves the pong app time to register
+tinynet.timer.start(2000, 0, function()
+    begin_time = high_resolution_time()
+    for _ = 1, window do
+        send_next()
+    end
+end)
@@ -0,0 +1,106 @@
+-- Cost of an RPC on the client side: latency and heap bytes allocated per call.
+-- Start the naming service first (naming_service.sh start), then
+--   ./tinynet --app=test --labels=id=test1,env=.${USER}
+-- Every cluster.get is one Naming.Get call. The loop keeps a window of calls in flight, reusing one
+-- callback and one key so the script itself allocates as little as it can, and reports calls per
+-- second, latency percentiles and, with jemalloc, bytes allocated per call by the loop thread.
+-- The bytes include the protobuf messages and the resolver callback, the rest of the send path
+-- should add nothing once the first round has warmed the pools up.
+local log = log
+local c_cluster = tinynet.cluster
+local AppUtil = require("tinynet/util/app_util")
+local high_resolution_time = high_resolution_time
+local jemalloc = allocator and allocator.jemalloc
+
+local key = "bench42/key"
+local count = 50000
+local windows = { 1, 1, 32 }
+
+local config = AppUtil.require_config("cluster")
+config.bytesAsString = true
+
+local function thread_allocated()
+    if jemalloc and jemalloc.thread_allocated then
+        return jemalloc.thread_allocated()
+    end
+    return 0
+end
+
+local window_index = 0
+local window = 0
+local started = 0
+local done = 0
+local latencies = {}
+local sent_times = {}
+local begin_time, begin_bytes
+local on_get
+
+local function call_next()
+    started = started + 1
+    sent_times[started] = high_resolution_time()
+    local err = c_cluster.get(key, on_get)
+    if err then
+        log.error("get failed:%s", err)
+    end
+end
+
+local function start_round()
+    window_index = window_index + 1
+    window = windows[window_index]
+    if not window then
+        return
+    end
+    started = 0
+    done = 0
+    for i = 1, count do
+        latencies[i] = 0
+        sent_times[i] = 0
+    end
+    begin_bytes = thread_allocated()
+    begin_time = high_resolution_time()
+    for _ = 1, window do
+        call_next()
+    end
+end
+
+on_get = function(value, err)
+    done = done + 1
+    --The resolver spreads calls over two connections, so above one call in flight the replies may
+    --come back out of call order and only the mean latency is reported
+    latencies[done] = high_resolution_time() - sent_times[done]
+    if err then
+        log.error("get reply failed:%s", err)
+    end
+    if started < count then
+        call_next()
+    end
+    if done < count then
+        return
+    end
+    local cost = high_resolution_time() - begin_time
+    local bytes = thread_allocated() - begin_bytes
+    local note = window_index == 1 and " (warm up)" or ""
+    if window == 1 then
+        table.sort(latencies)
+        log.warning("rpc window:%d, %.0f calls/s, p50:%.1f us, p99:%.1f us, %.1f bytes allocated per call%s",
+            window, count / cost, latencies[math.floor(count * 0.5)] * 1e6,
+            latencies[math.floor(count * 0.99)] * 1e6, bytes / count, note)
+    else
+        log.warning("rpc window:%d, %.0f calls/s, mean:%.1f us, %.1f bytes allocated per call%s",
+            window, count / cost, cost * window / count * 1e6, bytes / count, note)
+    end
+    start_round()
+end
+
+local err = c_cluster.start("bench42", config, function() end)
+if err then
+    log.error("cluster start failed:%s", err)
+    return
+end
+c_cluster.put(key, string.rep("x", 64), 3600000, function(put_err)
+    if put_err then
+        log.error("put failed:%s", put_err)
+        return
+    end
+    start_round()
+end)
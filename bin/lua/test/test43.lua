@@ -0,0 +1,93 @@
+-- Listing a large naming key space, which the naming service streams in batches of 1000 keys.
+-- Start the naming service first (naming_service.sh start), then
+--   ./tinynet --app=test --labels=id=test1,env=.${USER}
+-- The script puts 10k and then 50k keys under one prefix and times cluster.keys on each, reporting
+-- keys per second and, with jemalloc, how much the resident memory of this process grew while the
+-- listing ran. The resolver still hands the whole list to the callback, so the saving shows on the
+-- naming service side: watch its resident memory, which no longer holds the full reply at once.
+-- The keys expire ten minutes after the run.
+local log = log
+local c_cluster = tinynet.cluster
+local AppUtil = require("tinynet/util/app_util")
+local high_resolution_time = high_resolution_time
+local string_format = string.format
+local jemalloc = allocator and allocator.jemalloc
+
+local prefix = "bench43/"
+local sizes = { 10000, 50000 }
+local window = 64
+local ttl = 600000
+local value = string.rep("x", 64)
+
+local config = AppUtil.require_config("cluster")
+config.bytesAsString = true
+
+local function resident()
+    if jemalloc then
+        return jemalloc.memory_stats().resident
+    end
+    return 0
+end
+
+local size_index = 0
+local put_count = 0
+local run_size
+
+local function list_keys(size)
+    local begin_resident = resident()
+    local begin_time = high_resolution_time()
+    local err = c_cluster.keys(prefix, function(keys, list_err)
+        local cost = high_resolution_time() - begin_time
+        if list_err then
+            log.error("keys failed:%s", list_err)
+            return
+        end
+        log.warning("keys listed:%d of %d, %.1f ms, %.0f keys/s, resident grew by %.1f MB",
+            #keys, size, cost * 1000, #keys / cost, (resident() - begin_resident) / 1048576)
+        run_size()
+    end)
+    if err then
+        log.error("keys failed:%s", err)
+    end
+end
+
+local function put_keys(size)
+    local started = put_count
+    local on_put
+    local function put_next()
+        started = started + 1
+        local err = c_cluster.put(string_format("%s%08d", prefix, started), value, ttl, on_put)
+        if err then
+            log.error("put failed:%s", err)
+        end
+    end
+    on_put = function(err)
+        if err then
+            log.error("put reply failed:%s", err)
+        end
+        put_count = put_count + 1
+        if put_count == size then
+            list_keys(size)
+        elseif started < size then
+            put_next()
+        end
+    end
+    for _ = 1, math.min(window, size - started) do
+        put_next()
+    end
+end
+
+run_size = function()
+    size_index = size_index + 1
+    local size = sizes[size_index]
+    if size then
+        put_keys(size)
+    end
+end
+
+local err = c_cluster.start("bench43", config, function() end)
+if err then
+    log.error("cluster start failed:%s", err)
+    return
+end
+run_size()
@@ -0,0 +1,116 @@
+-- Latency of small naming calls while large key listings run on the same resolver.
+-- Start the naming service first (naming_service.sh start), then
+--   ./tinynet --app=test --labels=id=test1,env=.${USER}
+-- The script puts 50k keys under one prefix, then times one get at a time, first with nothing else in
+-- flight and then while listings of the 50k keys run back to back. The resolver keeps two connections
+-- per naming server and picks the one with the fewest calls in flight, so the gets should not queue
+-- behind the listings. The keys expire ten minutes after the run.
+local log = log
+local c_cluster = tinynet.cluster
+local AppUtil = require("tinynet/util/app_util")
+local high_resolution_time = high_resolution_time
+local string_format = string.format
+
+local prefix = "bench44/"
+local key_count = 50000
+local get_count = 2000
+local window = 64
+local ttl = 600000
+local value = string.rep("x", 64)
+local get_key = prefix .. "00000001"
+
+local config = AppUtil.require_config("cluster")
+config.bytesAsString = true
+
+local listing = false
+local listings = 0
+local list_keys
+
+list_keys = function()
+    local err = c_cluster.keys(prefix, function(_, list_err)
+        if list_err then
+            log.error("keys failed:%s", list_err)
+        end
+        listings = listings + 1
+        if listing then
+            list_keys()
+        end
+    end)
+    if err then
+        log.error("keys failed:%s", err)
+    end
+end
+
+local function run_gets(name, on_done)
+    local latencies = {}
+    local begin_time
+    local on_get
+    local function get_next()
+        begin_time = high_resolution_time()
+        local err = c_cluster.get(get_key, on_get)
+        if err then
+            log.error("get failed:%s", err)
+        end
+    end
+    on_get = function(_, err)
+        latencies[#latencies + 1] = high_resolution_time() - begin_time
+        if err then
+            log.error("get reply failed:%s", err)
+        end
+        if #latencies < get_count then
+            get_next()
+            return
+        end
+        table.sort(latencies)
+        log.warning("gets %s, p50:%.1f us, p99:%.1f us, max:%.1f us",
+            name, latencies[math.floor(get_count * 0.5)] * 1e6, latencies[math.floor(get_count * 0.99)] * 1e6,
+            latencies[get_count] * 1e6)
+        on_done()
+    end
+    get_next()
+end
+
+local function run_bench()
+    run_gets("alone", function()
+        listing = true
+        list_keys()
+        run_gets("during listings", function()
+            listing = false
+            log.warning("listings of %d keys completed meanwhile:%d", key_count, listings)
+        end)
+    end)
+end
+
+local function put_keys()
+    local started = 0
+    local done = 0
+    local on_put
+    local function put_next()
+        started = started + 1
+        local err = c_cluster.put(string_format("%s%08d", prefix, started), value, ttl, on_put)
+        if err then
+            log.error("put failed:%s", err)
+        end
+    end
+    on_put = function(err)
+        if err then
+            log.error("put reply failed:%s", err)
+        end
+        done = done + 1
+        if done == key_count then
+            run_bench()
+        elseif started < key_count then
+            put_next()
+        end
+    end
+    for _ = 1, window do
+        put_next()
+    end
+end
+
+local err = c_cluster.start("bench44", config, function() end)
+if err then
+    log.error("cluster start failed:%s", err)
+    return
+end
+put_keys()
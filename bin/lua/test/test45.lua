@@ -0,0 +1,100 @@
+-- How long a slow handler running on the event loop holds up the timers of its app.
+-- Start the naming service first (naming_service.sh start), then
+--   ./tinynet --app="test|test" --labels="id=test1,env=.${USER},role=pong|id=test2,env=.${USER},role=ping"
+-- The pong app runs a 1 ms timer and records how late it fires, first while idle and then while the
+-- ping app keeps it busy with messages whose handler burns about 2 ms of CPU each. Lua handlers always
+-- run on the loop; this is the stall a C++ service avoids by registering its slow methods with an
+-- RpcWorkerPool, and the figure to compare against once one does.
+local log = log
+local c_cluster = tinynet.cluster
+local AppUtil = require("tinynet/util/app_util")
+local high_resolution_time = high_resolution_time
+
+local role = env.meta.labels.role
+local ticks = 2000
+local work_ms = 2
+local window = 4
+
+local config = AppUtil.require_config("cluster")
+config.bytesAsString = true
+
+local function on_sent(err)
+    if err then
+        log.error("%s send failed:%s", role, err)
+    end
+end
+
+if role == "ping" then
+    local busy = true
+    local err = c_cluster.start("bench45-ping", config, function(data)
+        if data == "stop" then
+            busy = false
+        elseif busy then
+            c_cluster.send_message("bench45-pong", data, on_sent)
+        end
+    end)
+    if err then
+        log.error("ping start failed:%s", err)
+    end
+    return
+end
+if role ~= "pong" then
+    log.error("label role=ping or role=pong expected")
+    return
+end
+
+local function burn(ms)
+    local deadline = high_resolution_time() + ms / 1000
+    local n = 0
+    while high_resolution_time() < deadline do
+        n = n + 1
+    end
+    return n
+end
+
+local loaded = false
+
+local function measure(name, on_done)
+    local lateness = {}
+    local last_time = high_resolution_time()
+    local timer_id
+    timer_id = tinynet.timer.start(1, 1, function()
+        local now = high_resolution_time()
+        lateness[#lateness + 1] = math.max(0, now - last_time - 0.001)
+        last_time = now
+        if #lateness < ticks then
+            return
+        end
+        tinynet.timer.stop(timer_id)
+        table.sort(lateness)
+        log.warning("timer %s, late by p50:%.2f ms, p99:%.2f ms, max:%.2f ms",
+            name, lateness[math.floor(ticks * 0.5)] * 1000, lateness[math.floor(ticks * 0.99)] * 1000,
+            lateness[ticks] * 1000)
+        on_done()
+    end)
+end
+
+local err = c_cluster.start("bench45-pong", config, function(data)
+    if not loaded then
+        return
+    end
+    burn(work_ms)
+    c_cluster.send_message("bench45-ping", data, on_sent)
+end)
+if err then
+    log.error("pong start failed:%s", err)
+    return
+end
+--Leaves the ping app time to register
+tinynet.timer.start(1000, 0, function()
+    measure("idle", function()
+        loaded = true
+        for _ = 1, window do
+            c_cluster.send_message("bench45-ping", "work", on_sent)
+        end
+        measure(string.format("with %d ms handlers", work_ms), function()
+            loaded = false
+            c_cluster.send_message("bench45-ping", "stop", on_sent)
+        end)
+    end)
+end)
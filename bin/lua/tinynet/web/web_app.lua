@@ -27,6 +27,9 @@ function WebApp:constructor()
 
     --http server对象
     self.server = nil
+
+    --连接事件处理函数, 收到 {type = "onhighwater"|"ondrain", guid = 连接}
+    self.eventHandler = nil
 end
 
 --@brief 使用中间件
@@ -34,6 +37,15 @@ function WebApp:use(middleware)
     table.insert(self.middlewares, middleware)
 end
 
+--@brief 设置连接事件处理函数, 待发送的响应超过高水位时收到 onhighwater, 回落到低水位时收到 ondrain
+--@param {function} handler
+function WebApp:onEvent(handler)
+    self.eventHandler = handler
+    if self.server then
+        self.server:on_event(handler)
+    end
+end
+
 --@brief 服务启动
 --@param {string} address  地址
 function WebApp:start(address)
@@ -48,6 +60,9 @@ function WebApp:start(address)
     if err ~= nil then
         throw(exception.HttpServerStartFailedException, "Http server start failed, err:%s", err)
     end
+    if self.eventHandler then
+        self.server:on_event(self.eventHandler)
+    end
 end
 
 function WebApp:stop()
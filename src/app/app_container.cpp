@@ -9,10 +9,18 @@
 #include "net/http/http_client.h"
 #include "cluster/cluster_service.h"
 #include "tfs/tfs_service.h"
+#include "net/hot_upgrade.h"
+#include "base/application.h"
+#include "base/error_code.h"
 
 namespace tinynet {
 namespace app {
 
+static const int kUpgradeTimeout = 5000;
+
+//Apps still serving a handoff, the process quits once every app handed over its sockets
+static std::atomic<int> s_upgrading{ 0 };
+
 AppContainer::AppContainer(int64_t id, const AppMeta &meta) :
     id_(id),
     meta_(meta) {
@@ -20,8 +28,41 @@ AppContainer::AppContainer(int64_t id, const AppMeta &meta) :
 
 AppContainer::~AppContainer() = default;
 
+static void ParseLoopOptions(const AppMeta& meta, EventLoopOptions* opts) {
+    auto it = meta.labels.find("timer_backend");
+    if (it != meta.labels.end() && it->second == "wheel") {
+        opts->timer_backend = TimerBackend::TB_WHEEL;
+    }
+    it = meta.labels.find("max_poll_events");
+    if (it != meta.labels.end()) {
+        opts->max_poll_events = std::atoi(it->second.c_str());
+    }
+    it = meta.labels.find("timer_budget_us");
+    if (it != meta.labels.end()) {
+        opts->timer_budget_us = std::atoi(it->second.c_str());
+    }
+    it = meta.labels.find("task_budget_us");
+    if (it != meta.labels.end()) {
+        opts->task_budget_us = std::atoi(it->second.c_str());
+    }
+    it = meta.labels.find("poller_backend");
+    if (it != meta.labels.end() && it->second == "io_uring") {
+        opts->poller_backend = net::PollerBackend::PB_IO_URING;
+    }
+    it = meta.labels.find("edge_once");
+    if (it != meta.labels.end()) {
+        opts->edge_once = it->second == "1" || it->second == "true";
+    }
+    it = meta.labels.find("buffer_pool_limit");
+    if (it != meta.labels.end()) {
+        opts->buffer_pool_limit = (size_t)std::atoll(it->second.c_str());
+    }
+}
+
 template<> EventLoop* AppContainer::get() { return event_loop_.get(); }
 
+template<> net::HotUpgrade* AppContainer::get() { return upgrade_.get(); }
+
 template<> cluster::ClusterService* AppContainer::get() { return cluster_.get(); }
 
 template<> http::HttpClient* AppContainer::get() { return http_.get(); }
@@ -33,7 +74,9 @@ template<> tfs::TfsService* AppContainer::get() { return tfs_.get(); }
 template<> lua_State* AppContainer::get() { return script_->get<lua_State>(); }
 
 int AppContainer::Init() {
-    event_loop_.reset(new(std::nothrow) EventLoop());
+    EventLoopOptions loop_opts;
+    ParseLoopOptions(meta_, &loop_opts);
+    event_loop_.reset(new(std::nothrow) EventLoop(loop_opts));
     if (!event_loop_) return 1;
 
     int ret = event_loop_->Init();
@@ -52,6 +95,13 @@ int AppContainer::Init() {
     if (!http_) return 1;
 
     http_->Init();
+    //The servers started by the script take over the sockets of the process being upgraded
+    auto it = meta_.labels.find("upgrade_path");
+    if (it != meta_.labels.end()) {
+        upgrade_ = event_loop_->NewObject<net::HotUpgrade>();
+        if (!upgrade_) return 1;
+        upgrade_->Inherit(it->second, kUpgradeTimeout);
+    }
     script_.reset(new(std::nothrow) lua::LuaScript(this));
     if (!script_) return 1;
 
@@ -63,10 +113,27 @@ int AppContainer::Init() {
     } else {
         script_->Require(meta_.name);
     }
+    if (upgrade_) {
+        if (upgrade_->get_inherited_size() > 0) {
+            log_warning("App %s left %d sockets of the upgraded process unclaimed",
+                        meta_.name.c_str(), (int)upgrade_->get_inherited_size());
+        }
+        int err = upgrade_->Listen(it->second);
+        if (err != ERROR_OK) {
+            log_error("App %s failed to serve upgrades on %s, err:%d, msg:%s",
+                      meta_.name.c_str(), it->second.c_str(), err, tinynet_strerror(err));
+        } else {
+            ++s_upgrading;
+            upgrade_->set_upgrade_callback([]() {
+                if (--s_upgrading == 0) g_App->Shutdown();
+            });
+        }
+    }
     return 0;
 }
 
 void AppContainer::Stop() {
+    if (upgrade_) upgrade_->Close();
     cluster_->Stop();
     http_->Stop();
     script_->Stop();
@@ -18,6 +18,9 @@ class HttpClient;
 namespace lua {
 class LuaScript;
 }
+namespace net {
+class HotUpgrade;
+}
 namespace tfs {
 class TfsService;
 }
@@ -47,6 +50,7 @@ class AppContainer {
     AppMeta	 meta_;
   private:
     std::unique_ptr<EventLoop>			event_loop_;
+    std::shared_ptr<net::HotUpgrade>			upgrade_;
     std::unique_ptr<tinynet::tfs::TfsService>	tfs_;
     std::unique_ptr <cluster::ClusterService>	cluster_;
     std::unique_ptr<http::HttpClient>			http_;
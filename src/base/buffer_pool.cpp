@@ -0,0 +1,89 @@
+// Copyright (C), Xianfeng Shang.  All rights reserved.
+// Author: Xianfeng Shang (shangxianfeng@outlook.com)
+#include "buffer_pool.h"
+#include <new>
+namespace tinynet {
+
+BufferPool::BufferPool(size_t limit) {
+    for (int i = 0; i < NUM_CLASSES; ++i) {
+        free_[i] = nullptr;
+    }
+    stats_.limit = limit;
+}
+
+BufferPool::~BufferPool() {
+    Trim(0);
+}
+
+int BufferPool::SizeClass(size_t size) {
+    int cls = 0;
+    size_t cls_size = MIN_CLASS_SIZE;
+    while (cls_size < size) {
+        cls_size <<= 1;
+        ++cls;
+    }
+    return cls;
+}
+
+void* BufferPool::Allocate(size_t* size) noexcept {
+    size_t n = *size;
+    if (n > MAX_CLASS_SIZE) {
+        //Oversized blocks bypass the free lists
+        stats_.misses++;
+        stats_.inuse_bytes += n;
+        if (stats_.inuse_bytes > stats_.high_water) stats_.high_water = stats_.inuse_bytes;
+        return ::operator new(n);
+    }
+    int cls = SizeClass(n);
+    n = MIN_CLASS_SIZE << cls;
+    void* p = nullptr;
+    if (free_[cls]) {
+        FreeBlock* b = free_[cls];
+        free_[cls] = b->next;
+        stats_.pooled_bytes -= n;
+        stats_.hits++;
+        p = b;
+    } else {
+        stats_.misses++;
+        p = ::operator new(n);
+    }
+    stats_.inuse_bytes += n;
+    if (stats_.inuse_bytes > stats_.high_water) stats_.high_water = stats_.inuse_bytes;
+    *size = n;
+    return p;
+}
+
+void BufferPool::Release(void* p, size_t size) noexcept {
+    if (!p) return;
+    stats_.inuse_bytes -= size;
+    if (size > MAX_CLASS_SIZE || stats_.pooled_bytes + size > stats_.limit) {
+        stats_.trimmed_bytes += size;
+        ::operator delete(p);
+        return;
+    }
+    int cls = SizeClass(size);
+    FreeBlock* b = static_cast<FreeBlock*>(p);
+    b->next = free_[cls];
+    free_[cls] = b;
+    stats_.pooled_bytes += size;
+}
+
+void BufferPool::Trim(size_t limit) noexcept {
+    //Large classes first, they are the least likely to be reused
+    for (int cls = NUM_CLASSES - 1; cls >= 0 && stats_.pooled_bytes > limit; --cls) {
+        size_t cls_size = MIN_CLASS_SIZE << cls;
+        while (free_[cls] && stats_.pooled_bytes > limit) {
+            FreeBlock* b = free_[cls];
+            free_[cls] = b->next;
+            stats_.pooled_bytes -= cls_size;
+            stats_.trimmed_bytes += cls_size;
+            ::operator delete(b);
+        }
+    }
+}
+
+void BufferPool::set_limit(size_t limit) {
+    stats_.limit = limit;
+    Trim(limit);
+}
+}
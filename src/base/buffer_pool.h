@@ -0,0 +1,67 @@
+// Copyright (C), Xianfeng Shang.  All rights reserved.
+// Author: Xianfeng Shang (shangxianfeng@outlook.com)
+#pragma once
+#include <cstddef>
+#include <cstdint>
+namespace tinynet {
+/**
+ * @brief Buffer pool statistics
+ *
+ */
+struct BufferPoolStats {
+    size_t pooled_bytes{ 0 }; ///< Bytes kept in the free lists
+    size_t inuse_bytes{ 0 }; ///< Bytes handed out to buffers
+    size_t high_water{ 0 }; ///< Peak of inuse_bytes
+    size_t limit{ 0 }; ///< Upper bound of pooled_bytes
+    uint64_t hits{ 0 }; ///< Allocations served from the free lists
+    uint64_t misses{ 0 }; ///< Allocations served by the system allocator
+    uint64_t trimmed_bytes{ 0 }; ///< Bytes given back to the system allocator
+};
+
+//Block pool with power of two size classes shared by the socket buffers of one event loop.
+//Not thread safe, blocks must be allocated and released on the owning loop thread.
+class BufferPool {
+  public:
+    static const size_t MIN_CLASS_SIZE = 4096;
+    static const size_t MAX_CLASS_SIZE = 1024 * 1024;
+    static const int NUM_CLASSES = 9;
+  public:
+    explicit BufferPool(size_t limit);
+    ~BufferPool();
+  private:
+    BufferPool(const BufferPool&) = delete;
+    BufferPool& operator=(const BufferPool&) = delete;
+  public:
+    /**
+     * @brief Allocates at least *size bytes, *size is rounded up to the size class actually handed out
+     *
+     * @param size
+     * @return void*
+     */
+    void* Allocate(size_t* size) noexcept;
+    /**
+     * @brief Gives back a block returned by Allocate() with the rounded size
+     *
+     * @param p
+     * @param size
+     */
+    void Release(void* p, size_t size) noexcept;
+    /**
+     * @brief Frees pooled blocks until no more than limit bytes are kept
+     *
+     * @param limit
+     */
+    void Trim(size_t limit) noexcept;
+  public:
+    void set_limit(size_t limit);
+    const BufferPoolStats& get_stats() const { return stats_; }
+  private:
+    struct FreeBlock {
+        FreeBlock* next;
+    };
+    static int SizeClass(size_t size);
+  private:
+    FreeBlock* free_[NUM_CLASSES];
+    BufferPoolStats stats_;
+};
+}
@@ -9,4 +9,5 @@ int64_t Time_ns();
 double Time();
 
 int64_t STime_ms();
+int64_t STime_us();
 }
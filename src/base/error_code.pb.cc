@@ -58,7 +58,7 @@ void protobuf_AddDesc_error_5fcode_2eproto() {
   GOOGLE_PROTOBUF_VERIFY_VERSION;
 
   ::google::protobuf::DescriptorPool::InternalAddGeneratedFile(
-    "\n\020error_code.proto\022\007tinynet*\255\027\n\tErrorCod"
+    "\n\020error_code.proto\022\007tinynet*\251\031\n\tErrorCod"
     "e\022\014\n\010ERROR_OK\020\000\022\031\n\014ERROR_FAILED\020\377\377\377\377\377\377\377\377"
     "\377\001\022\030\n\013ERROR_INVAL\020\352\377\377\377\377\377\377\377\377\001\022\031\n\014ERROR_OS"
     "_OOM\020\367\330\377\377\377\377\377\377\377\001\022!\n\024ERROR_OS_ADAPTERINFO\020"
@@ -103,37 +103,43 @@ void protobuf_AddDesc_error_5fcode_2eproto() {
     "R_RPC_REQUESTCANCELED\020\377\324\377\377\377\377\377\377\377\001\022\"\n\025ERRO"
     "R_RPC_ENCODEERROR\020\376\324\377\377\377\377\377\377\377\001\022\"\n\025ERROR_RP"
     "C_DECODEERROR\020\375\324\377\377\377\377\377\377\377\001\022%\n\030ERROR_RPC_ME"
-    "SSAGETOOLONG\020\374\324\377\377\377\377\377\377\377\001\022\"\n\025ERROR_RAFT_NO"
-    "SUCHNODE\020\237\324\377\377\377\377\377\377\377\001\022#\n\026ERROR_RAFT_CLUSTE"
-    "RDOWN\020\236\324\377\377\377\377\377\377\377\001\022%\n\030ERROR_RAFT_CONFIGURA"
-    "TION\020\235\324\377\377\377\377\377\377\377\001\022)\n\034ERROR_RAFT_SNAPSHOTLO"
-    "ADERROR\020\234\324\377\377\377\377\377\377\377\001\022$\n\027ERROR_RAFT_WALLOAD"
-    "ERROR\020\233\324\377\377\377\377\377\377\377\001\022\035\n\020ERROR_TNS_NOSTUB\020\273\323\377"
-    "\377\377\377\377\377\377\001\022)\n\034ERROR_TNS_SERVICEUNAVAILABLE\020"
-    "\272\323\377\377\377\377\377\377\377\001\022&\n\031ERROR_TNS_SERVICEREDIRECT\020"
-    "\271\323\377\377\377\377\377\377\377\001\022\"\n\025ERROR_TNS_MAXREDIRECT\020\270\323\377\377"
-    "\377\377\377\377\377\001\022#\n\026ERROR_TNS_NAMENOTFOUND\020\267\323\377\377\377\377\377"
-    "\377\377\001\022)\n\034ERROR_TNS_UNRECOGNIZEDFORMAT\020\266\323\377\377"
-    "\377\377\377\377\377\001\022\"\n\025ERROR_TNS_NAMEEXPIRED\020\265\323\377\377\377\377\377\377"
-    "\377\001\022%\n\030ERROR_TNS_METHODNOTFOUND\020\264\323\377\377\377\377\377\377\377"
-    "\001\022)\n\034ERROR_TDC_SERVICEUNAVAILABLE\020\327\322\377\377\377\377"
-    "\377\377\377\001\022+\n\036ERROR_TDC_MESSAGEQUEUEOVERFLOW\020\326"
-    "\322\377\377\377\377\377\377\377\001\022#\n\026ERROR_TDC_SERVICEMOVED\020\325\322\377\377"
-    "\377\377\377\377\377\001\022+\n\036ERROR_TDC_MESSAGEOUTOFSEQUENCE"
-    "\020\324\322\377\377\377\377\377\377\377\001\022\035\n\020ERROR_TDC_NOSTUB\020\323\322\377\377\377\377\377\377"
-    "\377\001\022&\n\031ERROR_MYSQL_UNINITIALIZED\020\363\321\377\377\377\377\377\377"
-    "\377\001\022(\n\033ERROR_MYSQL_PROTOCOLVERSION\020\362\321\377\377\377\377"
-    "\377\377\377\001\022\'\n\032ERROR_MYSQL_CONNECTTIMEOUT\020\361\321\377\377\377"
-    "\377\377\377\377\001\022\"\n\025ERROR_MYSQL_HANDSHAKE\020\360\321\377\377\377\377\377\377\377"
-    "\001\022\"\n\025ERROR_MYSQL_QUERYBUSY\020\357\321\377\377\377\377\377\377\377\001\022&\n"
-    "\031ERROR_MYSQL_READINGPACKET\020\356\321\377\377\377\377\377\377\377\001\022\'\n"
-    "\032ERROR_REDIS_CONNECTTIMEOUT\020\301\321\377\377\377\377\377\377\377\001\022\""
-    "\n\025ERROR_REDIS_HANDSHAKE\020\300\321\377\377\377\377\377\377\377\001\022%\n\030ER"
-    "ROR_REDIS_READINGREPLY\020\277\321\377\377\377\377\377\377\377\001\022)\n\034ERR"
-    "OR_REDIS_CONNECTIONCLOSED\020\276\321\377\377\377\377\377\377\377\001\022\"\n\025"
-    "ERROR_REDIS_SUBSCRIBE\020\275\321\377\377\377\377\377\377\377\001\022 \n\023ERRO"
-    "R_PROCESS_SPAWN\020\217\321\377\377\377\377\377\377\377\001\022\037\n\022ERROR_PROC"
-    "ESS_KILL\020\216\321\377\377\377\377\377\377\377\001", 3019);
+    "SSAGETOOLONG\020\374\324\377\377\377\377\377\377\377\001\022\036\n\021ERROR_RPC_TIM"
+    "EOUT\020\373\324\377\377\377\377\377\377\377\001\022#\n\026ERROR_RPC_STREAMCLOSE"
+    "D\020\372\324\377\377\377\377\377\377\377\001\022!\n\024ERROR_RPC_STREAMFULL\020\371\324\377"
+    "\377\377\377\377\377\377\001\022$\n\027ERROR_RPC_STREAMREFUSED\020\370\324\377\377\377"
+    "\377\377\377\377\001\022!\n\024ERROR_RPC_SERVERBUSY\020\367\324\377\377\377\377\377\377\377\001"
+    "\022(\n\033ERROR_RPC_STREAMUNSUPPORTED\020\366\324\377\377\377\377\377\377"
+    "\377\001\022\"\n\025ERROR_RAFT_NOSUCHNODE\020\237\324\377\377\377\377\377\377\377\001\022#"
+    "\n\026ERROR_RAFT_CLUSTERDOWN\020\236\324\377\377\377\377\377\377\377\001\022%\n\030E"
+    "RROR_RAFT_CONFIGURATION\020\235\324\377\377\377\377\377\377\377\001\022)\n\034ER"
+    "ROR_RAFT_SNAPSHOTLOADERROR\020\234\324\377\377\377\377\377\377\377\001\022$\n"
+    "\027ERROR_RAFT_WALLOADERROR\020\233\324\377\377\377\377\377\377\377\001\022\035\n\020E"
+    "RROR_TNS_NOSTUB\020\273\323\377\377\377\377\377\377\377\001\022)\n\034ERROR_TNS_"
+    "SERVICEUNAVAILABLE\020\272\323\377\377\377\377\377\377\377\001\022&\n\031ERROR_T"
+    "NS_SERVICEREDIRECT\020\271\323\377\377\377\377\377\377\377\001\022\"\n\025ERROR_T"
+    "NS_MAXREDIRECT\020\270\323\377\377\377\377\377\377\377\001\022#\n\026ERROR_TNS_N"
+    "AMENOTFOUND\020\267\323\377\377\377\377\377\377\377\001\022)\n\034ERROR_TNS_UNRE"
+    "COGNIZEDFORMAT\020\266\323\377\377\377\377\377\377\377\001\022\"\n\025ERROR_TNS_N"
+    "AMEEXPIRED\020\265\323\377\377\377\377\377\377\377\001\022%\n\030ERROR_TNS_METHO"
+    "DNOTFOUND\020\264\323\377\377\377\377\377\377\377\001\022)\n\034ERROR_TDC_SERVIC"
+    "EUNAVAILABLE\020\327\322\377\377\377\377\377\377\377\001\022+\n\036ERROR_TDC_MES"
+    "SAGEQUEUEOVERFLOW\020\326\322\377\377\377\377\377\377\377\001\022#\n\026ERROR_TD"
+    "C_SERVICEMOVED\020\325\322\377\377\377\377\377\377\377\001\022+\n\036ERROR_TDC_M"
+    "ESSAGEOUTOFSEQUENCE\020\324\322\377\377\377\377\377\377\377\001\022\035\n\020ERROR_"
+    "TDC_NOSTUB\020\323\322\377\377\377\377\377\377\377\001\022\037\n\022ERROR_TDC_NOMEM"
+    "BER\020\322\322\377\377\377\377\377\377\377\001\022&\n\031ERROR_MYSQL_UNINITIALI"
+    "ZED\020\363\321\377\377\377\377\377\377\377\001\022(\n\033ERROR_MYSQL_PROTOCOLVE"
+    "RSION\020\362\321\377\377\377\377\377\377\377\001\022\'\n\032ERROR_MYSQL_CONNECTT"
+    "IMEOUT\020\361\321\377\377\377\377\377\377\377\001\022\"\n\025ERROR_MYSQL_HANDSHA"
+    "KE\020\360\321\377\377\377\377\377\377\377\001\022\"\n\025ERROR_MYSQL_QUERYBUSY\020\357"
+    "\321\377\377\377\377\377\377\377\001\022&\n\031ERROR_MYSQL_READINGPACKET\020\356"
+    "\321\377\377\377\377\377\377\377\001\022\'\n\032ERROR_REDIS_CONNECTTIMEOUT\020"
+    "\301\321\377\377\377\377\377\377\377\001\022\"\n\025ERROR_REDIS_HANDSHAKE\020\300\321\377\377"
+    "\377\377\377\377\377\001\022%\n\030ERROR_REDIS_READINGREPLY\020\277\321\377\377\377"
+    "\377\377\377\377\001\022)\n\034ERROR_REDIS_CONNECTIONCLOSED\020\276\321"
+    "\377\377\377\377\377\377\377\001\022\"\n\025ERROR_REDIS_SUBSCRIBE\020\275\321\377\377\377\377"
+    "\377\377\377\001\022 \n\023ERROR_PROCESS_SPAWN\020\217\321\377\377\377\377\377\377\377\001\022\037"
+    "\n\022ERROR_PROCESS_KILL\020\216\321\377\377\377\377\377\377\377\001", 3271);
   ::google::protobuf::MessageFactory::InternalRegisterGeneratedFile(
     "error_code.proto", &protobuf_RegisterTypes);
   ::google::protobuf::internal::OnShutdown(&protobuf_ShutdownFile_error_5fcode_2eproto);
@@ -164,6 +170,7 @@ bool ErrorCode_IsValid(int value) {
     case -5903:
     case -5902:
     case -5901:
+    case -5806:
     case -5805:
     case -5804:
     case -5803:
@@ -182,6 +189,12 @@ bool ErrorCode_IsValid(int value) {
     case -5603:
     case -5602:
     case -5601:
+    case -5514:
+    case -5513:
+    case -5512:
+    case -5511:
+    case -5510:
+    case -5509:
     case -5508:
     case -5507:
     case -5506:
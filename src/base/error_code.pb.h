@@ -82,6 +82,12 @@ enum ErrorCode {
   ERROR_RPC_ENCODEERROR = -5506,
   ERROR_RPC_DECODEERROR = -5507,
   ERROR_RPC_MESSAGETOOLONG = -5508,
+  ERROR_RPC_TIMEOUT = -5509,
+  ERROR_RPC_STREAMCLOSED = -5510,
+  ERROR_RPC_STREAMFULL = -5511,
+  ERROR_RPC_STREAMREFUSED = -5512,
+  ERROR_RPC_SERVERBUSY = -5513,
+  ERROR_RPC_STREAMUNSUPPORTED = -5514,
   ERROR_RAFT_NOSUCHNODE = -5601,
   ERROR_RAFT_CLUSTERDOWN = -5602,
   ERROR_RAFT_CONFIGURATION = -5603,
@@ -100,6 +106,7 @@ enum ErrorCode {
   ERROR_TDC_SERVICEMOVED = -5803,
   ERROR_TDC_MESSAGEOUTOFSEQUENCE = -5804,
   ERROR_TDC_NOSTUB = -5805,
+  ERROR_TDC_NOMEMBER = -5806,
   ERROR_MYSQL_UNINITIALIZED = -5901,
   ERROR_MYSQL_PROTOCOLVERSION = -5902,
   ERROR_MYSQL_CONNECTTIMEOUT = -5903,
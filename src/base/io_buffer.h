@@ -8,6 +8,7 @@
 #include <cstring>
 #include <cstdio>
 #include "base.h"
+#include "buffer_pool.h"
 
 namespace tinynet {
 
@@ -30,7 +31,8 @@ class IOBuffer {
     static const size_t npos = static_cast<size_t>(-1);
   public:
     IOBuffer() = default;
-    ~IOBuffer() = default;
+    explicit IOBuffer(BufferPool* pool) : pool_(pool) {}
+    ~IOBuffer() { free_block(block_, cap_); }
   private:
     IOBuffer(const IOBuffer&);
     void operator=(const IOBuffer&);
@@ -91,18 +93,18 @@ class IOBuffer {
             return;
         }
         size_t sz = size();
-        if (block_.size() >= n && begin_ > 0) {
+        if (cap_ >= n && begin_ > 0) {
             if (sz > 0) {
-                std::memmove(&block_[0], begin(), sz);
+                std::memmove(block_, begin(), sz);
             }
             begin_ = 0;
             end_ = sz;
             return;
         }
-        size_t new_size = (std::max)(block_.size(), MIN_BLOCK_SIZE);
+        size_t new_size = (std::max)(cap_, MIN_BLOCK_SIZE);
         while (new_size < n)
             new_size += new_size;
-        block_.resize(new_size);
+        realloc_block(new_size);
     }
 
     TINYNET_FORCEINLINE char* prepare(size_t n) noexcept {
@@ -118,7 +120,7 @@ class IOBuffer {
     }
 
     TINYNET_FORCEINLINE void commit(size_t n) noexcept {
-        end_ = (std::min)(end_ + n, block_.size());
+        end_ = (std::min)(end_ + n, cap_);
     }
 
     TINYNET_FORCEINLINE void consume(size_t n) noexcept {
@@ -128,6 +130,20 @@ class IOBuffer {
         }
     }
 
+    /**
+     * @brief Removes n bytes starting at pos, the bytes behind them move forward
+     */
+    void erase(size_t pos, size_t n) noexcept {
+        if (pos >= size()) return;
+        n = (std::min)(n, size() - pos);
+        char* p = begin() + pos;
+        std::memmove(p, p + n, size() - pos - n);
+        end_ -= n;
+        if (begin_ == end_) {
+            begin_ = end_ = 0;
+        }
+    }
+
     TINYNET_FORCEINLINE size_t find(char ch, size_t pos = 0) {
         if (pos < size()) {
             char* p = (char*)std::memchr(begin() + pos, ch, size());
@@ -137,36 +153,41 @@ class IOBuffer {
 
     }
 
-    TINYNET_FORCEINLINE char* begin() noexcept { return &block_[0] + begin_; }
+    TINYNET_FORCEINLINE char* begin() noexcept { return block_ + begin_; }
 
 
-    TINYNET_FORCEINLINE char* end() noexcept { return &block_[0] + end_; }
+    TINYNET_FORCEINLINE char* end() noexcept { return block_ + end_; }
 
     TINYNET_FORCEINLINE char *data() noexcept { return begin(); }
 
     void shrink_to_fit() noexcept {
         size_t sz = size();
-        if (block_.size() <= MIN_BLOCK_SIZE || block_.size() < (sz << 2)) {
+        if (cap_ <= MIN_BLOCK_SIZE || cap_ < (sz << 2)) {
             return;
         }
-        if (sz > 0 && begin_ > 0) {
-            std::memmove(&block_[0], begin(), sz);
-        }
-        begin_ = 0;
-        end_ = sz;
-        block_.resize(block_.size() >> 1);
-        block_.shrink_to_fit();
+        realloc_block(cap_ >> 1);
+    }
+
+    /**
+     * @brief Gives the storage back to the pool once the buffer is drained
+     */
+    void release() noexcept {
+        if (!empty() || !block_) return;
+        free_block(block_, cap_);
+        block_ = nullptr;
+        cap_ = 0;
+        begin_ = end_ = 0;
     }
 
     TINYNET_FORCEINLINE size_t size() const noexcept { return (size_t)(end_ - begin_); }
 
     TINYNET_FORCEINLINE bool empty() const noexcept { return begin_ == end_; }
 
-    TINYNET_FORCEINLINE size_t capacity() const noexcept { return block_.size() - begin_; }
+    TINYNET_FORCEINLINE size_t capacity() const noexcept { return cap_ - begin_; }
 
     TINYNET_FORCEINLINE void clear() noexcept { begin_ = end_ = 0; }
 
-    TINYNET_FORCEINLINE size_t max_size() const noexcept { return block_.max_size(); }
+    TINYNET_FORCEINLINE size_t max_size() const noexcept { return (std::numeric_limits<size_t>::max)() >> 1; }
 
     TINYNET_FORCEINLINE char& operator[] (size_t pos) noexcept { return block_[begin_ + pos]; }
 
@@ -182,13 +203,44 @@ class IOBuffer {
 
     void swap(IOBuffer& other) {
         std::swap(this->block_, other.block_);
+        std::swap(this->cap_, other.cap_);
         std::swap(this->begin_, other.begin_);
         std::swap(this->end_, other.end_);
+        std::swap(this->pool_, other.pool_);
+    }
+  private:
+    void realloc_block(size_t n) noexcept {
+        char* block = nullptr;
+        if (pool_) {
+            block = static_cast<char*>(pool_->Allocate(&n));
+        } else {
+            block = new char[n];
+        }
+        size_t sz = size();
+        if (sz > 0) {
+            std::memcpy(block, begin(), sz);
+        }
+        free_block(block_, cap_);
+        block_ = block;
+        cap_ = n;
+        begin_ = 0;
+        end_ = sz;
+    }
+
+    void free_block(char* block, size_t n) noexcept {
+        if (!block) return;
+        if (pool_) {
+            pool_->Release(block, n);
+        } else {
+            delete[] block;
+        }
     }
   private:
-    std::vector<char> block_;
+    char* block_{ nullptr };
+    size_t cap_{ 0 };
     size_t begin_{ 0 };
     size_t end_{ 0 };
+    BufferPool* pool_{ nullptr };
 };
 
 }
\ No newline at end of file
@@ -0,0 +1,55 @@
+// Copyright (C), Xianfeng Shang.  All rights reserved.
+// Author: Xianfeng Shang (shangxianfeng@outlook.com)
+#include "io_buffer_chain.h"
+#include <new>
+
+namespace tinynet {
+
+void IOBufferChain::push_block(size_t cap) noexcept {
+    size_t n = sizeof(Block) + cap;
+    void* p = pool_ ? pool_->Allocate(&n) : ::operator new(n);
+    Block* b = static_cast<Block*>(p);
+    b->next = nullptr;
+    b->cap = n - sizeof(Block);
+    b->begin = b->end = 0;
+    if (tail_) {
+        tail_->next = b;
+    } else {
+        head_ = b;
+    }
+    tail_ = b;
+    ++nblocks_;
+}
+
+void IOBufferChain::erase(size_t pos, size_t n) noexcept {
+    if (pos >= size_) return;
+    n = (std::min)(n, size_ - pos);
+    size_ -= n;
+    for (Block* b = head_; b && n > 0; b = b->next) {
+        size_t len = b->end - b->begin;
+        if (pos >= len) {
+            pos -= len;
+            continue;
+        }
+        size_t cut = (std::min)(n, len - pos);
+        char* p = b->data() + b->begin + pos;
+        std::memmove(p, p + cut, len - pos - cut);
+        b->end -= cut;
+        n -= cut;
+        pos = 0;
+    }
+}
+
+void IOBufferChain::pop_block() noexcept {
+    Block* b = head_;
+    head_ = b->next;
+    if (!head_) tail_ = nullptr;
+    --nblocks_;
+    if (pool_) {
+        pool_->Release(b, sizeof(Block) + b->cap);
+    } else {
+        ::operator delete(b);
+    }
+}
+
+}
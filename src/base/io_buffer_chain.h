@@ -0,0 +1,148 @@
+// Copyright (C), Xianfeng Shang.  All rights reserved.
+// Author: Xianfeng Shang (shangxianfeng@outlook.com)
+#pragma once
+#include <cstring>
+#include <algorithm>
+#include "io_buffer.h"
+
+namespace tinynet {
+
+//Segmented byte buffer made of a singly linked list of blocks.
+//Appending never moves the bytes already queued and consuming releases whole blocks,
+//blocks are recycled through the buffer pool when one is given.
+class IOBufferChain {
+  public:
+    static const size_t BLOCK_SIZE = 16384;
+  public:
+    struct Block {
+        Block* next;
+        size_t cap;
+        size_t begin;
+        size_t end;
+        char* data() noexcept { return reinterpret_cast<char*>(this + 1); }
+    };
+  public:
+    IOBufferChain() = default;
+    explicit IOBufferChain(BufferPool* pool) : pool_(pool) {}
+    ~IOBufferChain() { clear(); }
+  private:
+    IOBufferChain(const IOBufferChain&);
+    void operator=(const IOBufferChain&);
+  public:
+    size_t append(const void* data, size_t len) noexcept {
+        const char* p = static_cast<const char*>(data);
+        size_t left = len;
+        while (left > 0) {
+            size_t avail = 0;
+            char* dst = prepare_some(&avail);
+            size_t n = (std::min)(avail, left);
+            std::memcpy(dst, p, n);
+            commit(n);
+            p += n;
+            left -= n;
+        }
+        return len;
+    }
+
+    /**
+     * @brief Returns n contiguous writable bytes at the tail, a larger block is allocated when the tail block is short
+     */
+    char* prepare(size_t n) noexcept {
+        if (!tail_ || tail_->cap - tail_->end < n) {
+            push_block((std::max)(n, BLOCK_SIZE - sizeof(Block)));
+        }
+        return tail_->data() + tail_->end;
+    }
+
+    /**
+     * @brief Returns whatever is writable in the tail block, a new block is allocated when the tail block is full
+     */
+    char* prepare_some(size_t* avail) noexcept {
+        if (!tail_ || tail_->cap == tail_->end) {
+            push_block(BLOCK_SIZE - sizeof(Block));
+        }
+        *avail = tail_->cap - tail_->end;
+        return tail_->data() + tail_->end;
+    }
+
+    void commit(size_t n) noexcept {
+        if (!tail_) return;
+        n = (std::min)(n, tail_->cap - tail_->end);
+        tail_->end += n;
+        size_ += n;
+    }
+
+    /**
+     * @brief Gives back the last n committed bytes of the tail block
+     */
+    void backup(size_t n) noexcept {
+        if (!tail_) return;
+        n = (std::min)(n, tail_->end - tail_->begin);
+        tail_->end -= n;
+        size_ -= n;
+    }
+
+    void consume(size_t n) noexcept {
+        n = (std::min)(n, size_);
+        size_ -= n;
+        while (n > 0 && head_) {
+            size_t len = head_->end - head_->begin;
+            if (n < len) {
+                head_->begin += n;
+                break;
+            }
+            n -= len;
+            pop_block();
+        }
+        //Drop drained blocks, but keep the tail when it still has room for appending
+        while (head_ && head_->begin == head_->end && (head_ != tail_ || head_->end == head_->cap)) {
+            pop_block();
+        }
+        if (size_ == 0 && head_) {
+            head_->begin = head_->end = 0;
+        }
+    }
+
+    /**
+     * @brief Removes n bytes starting at pos, blocks left empty are dropped by consume()
+     */
+    void erase(size_t pos, size_t n) noexcept;
+
+    /**
+     * @brief Fills up to max iovs with the readable segments, returns the number of iovs filled
+     */
+    int peek(iov_t* iovs, int max) const noexcept {
+        int n = 0;
+        for (Block* b = head_; b && n < max; b = b->next) {
+            if (b->begin == b->end) continue;
+            iovs[n].base = b->data() + b->begin;
+            iovs[n].len = static_cast<decltype(iovs[n].len)>(b->end - b->begin);
+            ++n;
+        }
+        return n;
+    }
+
+    void clear() noexcept {
+        while (head_) {
+            pop_block();
+        }
+        size_ = 0;
+    }
+
+    size_t size() const noexcept { return size_; }
+
+    bool empty() const noexcept { return size_ == 0; }
+
+    size_t blocks() const noexcept { return nblocks_; }
+  private:
+    void push_block(size_t cap) noexcept;
+    void pop_block() noexcept;
+  private:
+    Block* head_{ nullptr };
+    Block* tail_{ nullptr };
+    size_t size_{ 0 };
+    size_t nblocks_{ 0 };
+    BufferPool* pool_{ nullptr };
+};
+
+}
@@ -0,0 +1,61 @@
+// Copyright (C), Xianfeng Shang.  All rights reserved.
+// Author: Xianfeng Shang (shangxianfeng@outlook.com)
+#pragma once
+#include <atomic>
+namespace tinynet {
+struct MpscNode {
+    std::atomic<MpscNode*> next{ nullptr };
+};
+
+//Intrusive lock-free multi-producer single-consumer queue (Vyukov).
+//Push() may be called from any thread, Pop() and Empty() only from the consumer thread.
+class MpscQueue {
+  public:
+    MpscQueue() :
+        head_(&stub_),
+        tail_(&stub_) {
+    }
+    ~MpscQueue() = default;
+  private:
+    MpscQueue(const MpscQueue&) = delete;
+    MpscQueue& operator =(const MpscQueue&) = delete;
+  public:
+    void Push(MpscNode* node) {
+        node->next.store(nullptr, std::memory_order_relaxed);
+        MpscNode* prev = head_.exchange(node, std::memory_order_acq_rel);
+        prev->next.store(node, std::memory_order_release);
+    }
+
+    ///Returns nullptr if the queue is empty or a producer has not finished linking its node yet
+    MpscNode* Pop() {
+        MpscNode* tail = tail_;
+        MpscNode* next = tail->next.load(std::memory_order_acquire);
+        if (tail == &stub_) {
+            if (next == nullptr) return nullptr;
+            tail_ = next;
+            tail = next;
+            next = next->next.load(std::memory_order_acquire);
+        }
+        if (next) {
+            tail_ = next;
+            return tail;
+        }
+        if (tail != head_.load(std::memory_order_acquire)) return nullptr;
+        Push(&stub_);
+        next = tail->next.load(std::memory_order_acquire);
+        if (next) {
+            tail_ = next;
+            return tail;
+        }
+        return nullptr;
+    }
+
+    bool Empty() const {
+        return tail_ == &stub_ && head_.load(std::memory_order_seq_cst) == &stub_;
+    }
+  private:
+    std::atomic<MpscNode*> head_;
+    MpscNode* tail_;
+    MpscNode stub_;
+};
+}
@@ -11,6 +11,8 @@
 namespace tinynet {
 namespace cluster {
 
+static const int kGroupRefreshInterval = 5 * 1000;
+
 static raft::NodeConfig* BuildRaftConfig(const std::string& id, const ClusterOptions& opts, raft::NodeConfig *config) {
     config->id = -1;
     for (size_t i = 0; i < opts.namingService.servers.size(); ++i) {
@@ -34,6 +36,7 @@ static raft::NodeConfig* BuildRaftConfig(const std::string& id, const ClusterOpt
     config->snapshotCount = opts.namingService.snapshotCount;
     config->heartbeatInterval = opts.namingService.heartbeatInterval;
     config->electionTimeout = opts.namingService.electionTimeout;
+    config->compressThreshold = opts.namingService.compressThreshold;
     return config;
 }
 
@@ -102,6 +105,7 @@ int ClusterService::StartCluster(const std::string& id, const ClusterOptions& op
     tdc_opts.debugMode = opts.namingService.debugMode;
     tdc_opts.registrationInterval = opts.namingService.registrationInterval;
     tdc_opts.expiryTime = opts.namingService.expiryTime;
+    tdc_opts.compressThreshold = opts.namingService.compressThreshold;
     tdc->Init(tdc_opts);
     if ((err = tdc->Start(opts.servicePortRange))) {
         return err;
@@ -112,6 +116,9 @@ int ClusterService::StartCluster(const std::string& id, const ClusterOptions& op
 }
 
 void ClusterService::Stop() {
+    while (!groups_.empty()) {
+        Unwatch(groups_.begin()->first);
+    }
     for (auto& entry : tns_map_) {
         entry.second->Stop();
     }
@@ -182,10 +189,138 @@ int ClusterService::Delete(const std::string &name, naming::NamingResolver::Nami
     return tdc_map_.begin()->second->get_resolver()->Delete(name, std::move(callback));
 }
 
-int ClusterService::Keys(const std::string& name, naming::NamingResolver::NamingCallback callback) {
+int ClusterService::Keys(const std::string& name, naming::NamingResolver::NamingCallback callback, uint64_t digest) {
     if (tdc_map_.empty()) return ERROR_TDC_NOSTUB;
-    return tdc_map_.begin()->second->get_resolver()->Keys(name, std::move(callback));
+    return tdc_map_.begin()->second->get_resolver()->Keys(name, std::move(callback), digest);
+}
+
+ServiceGroupPtr ClusterService::Watch(const std::string& service) {
+    auto it = groups_.find(service);
+    if (it != groups_.end()) {
+        return it->second.group;
+    }
+    auto& entry = groups_[service];
+    entry.group = std::make_shared<ServiceGroup>(service);
+    entry.timer = event_loop_->AddTimer(0, kGroupRefreshInterval, std::bind(&ClusterService::RefreshGroup, this, service));
+    return entry.group;
 }
 
+void ClusterService::Unwatch(const std::string& service) {
+    auto it = groups_.find(service);
+    if (it == groups_.end()) {
+        return;
+    }
+    event_loop_->ClearTimer(it->second.timer);
+    for (auto& msg : it->second.pending) {
+        Fail(std::move(msg.callback), ERROR_TDC_SERVICEUNAVAILABLE);
+    }
+    groups_.erase(it);
+}
+
+void ClusterService::SendByKey(const std::string& service, const std::string& key, const void* body, size_t len,
+                               tdc::TdcMessageCallback callback) {
+    if (tdc_map_.empty()) {
+        Fail(std::move(callback), ERROR_TDC_NOSTUB);
+        return;
+    }
+    Watch(service);
+    SendToGroup(groups_[service], true, key, body, len, std::move(callback));
+}
+
+void ClusterService::SendBalanced(const std::string& service, const void* body, size_t len, tdc::TdcMessageCallback callback) {
+    if (tdc_map_.empty()) {
+        Fail(std::move(callback), ERROR_TDC_NOSTUB);
+        return;
+    }
+    Watch(service);
+    SendToGroup(groups_[service], false, std::string(), body, len, std::move(callback));
+}
+
+void ClusterService::SetWeight(const std::string& service, const std::string& member, int weight) {
+    Watch(service)->SetWeight(member, weight);
+}
+
+void ClusterService::SendToGroup(GroupEntry& entry, bool by_key, const std::string& key, const void* body, size_t len,
+                                 tdc::TdcMessageCallback callback) {
+    if (!entry.group->is_ready()) {
+        entry.pending.push_back(PendingMsg{ by_key, key, std::string((const char*)body, len), std::move(callback) });
+        return;
+    }
+    const std::string* member = by_key ? entry.group->PickByKey(key) : entry.group->PickNext();
+    if (!member) {
+        Fail(std::move(callback), ERROR_TDC_NOMEMBER);
+        return;
+    }
+    SendMsg(*member, body, len, std::move(callback));
+}
+
+void ClusterService::RefreshGroup(const std::string& service) {
+    auto it = groups_.find(service);
+    if (it == groups_.end() || it->second.refreshing || tdc_map_.empty()) {
+        return;
+    }
+    auto& root_dir = tdc_map_.begin()->second->get_root_dir();
+    std::string prefix;
+    if (!StringUtils::StartsWith(service, root_dir)) {
+        prefix.append(root_dir);
+    }
+    prefix.append(service);
+    it->second.refreshing = true;
+    int err = Keys(prefix, std::bind(&ClusterService::AfterRefreshGroup, this, service, it->second.group, std::placeholders::_1),
+                   it->second.group->is_ready() ? it->second.digest : 0);
+    if (err != ERROR_OK) {
+        it->second.refreshing = false;
+        log_warning("Service group %s refresh failed, err:%d, msg:%s", service.c_str(), err, tinynet_strerror(err));
+    }
+}
+
+void ClusterService::AfterRefreshGroup(const std::string& service, ServiceGroupPtr group, const naming::NamingReply& reply) {
+    auto it = groups_.find(service);
+    if (it == groups_.end() || it->second.group != group) {
+        //Unwatched meanwhile
+        return;
+    }
+    auto& entry = it->second;
+    entry.refreshing = false;
+    if (reply.err) {
+        log_warning("Service group %s refresh failed, err:%d, msg:%s", service.c_str(), reply.err, tinynet_strerror(reply.err));
+        if (!group->is_ready()) {
+            //Nothing to route the waiting messages with
+            for (auto& msg : entry.pending) {
+                Fail(std::move(msg.callback), reply.err);
+            }
+            entry.pending.clear();
+        }
+        return;
+    }
+    if (reply.unchanged) {
+        //Same members as the last listing, nothing was sent
+        return;
+    }
+    entry.digest = reply.digest;
+    //Instances are addressed by their names in the namespace, like SendMsg() does
+    auto& root_dir = tdc_map_.begin()->second->get_root_dir();
+    std::vector<std::string> names;
+    names.reserve(reply.keys.size());
+    for (auto& key : reply.keys) {
+        names.push_back(StringUtils::StartsWith(key, root_dir) ? key.substr(root_dir.size()) : key);
+    }
+    if (group->Update(std::move(names))) {
+        log_info("Service group %s changed, %zu members", service.c_str(), group->get_members().size());
+    }
+    std::vector<PendingMsg> pending;
+    pending.swap(entry.pending);
+    for (auto& msg : pending) {
+        SendToGroup(entry, msg.by_key, msg.key, msg.body.data(), msg.body.size(), std::move(msg.callback));
+    }
+}
+
+void ClusterService::Fail(tdc::TdcMessageCallback callback, int err) {
+    if (!callback) {
+        return;
+    }
+    //Never from inside the send, the callers may not expect it
+    event_loop_->AddTask([callback, err] { callback(err); });
+}
 }
 }
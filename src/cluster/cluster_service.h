@@ -5,6 +5,7 @@
 #include "cluster_types.h"
 #include "tdc/tdc_service.h"
 #include "tns/tns_service.h"
+#include "service_group.h"
 #include <map>
 
 namespace tinynet {
@@ -33,7 +34,55 @@ class ClusterService  {
 
     int Delete(const std::string &name, naming::NamingResolver::NamingCallback callback);
 
-    int Keys(const std::string& name, naming::NamingResolver::NamingCallback callback);
+    int Keys(const std::string& name, naming::NamingResolver::NamingCallback callback, uint64_t digest = 0);
+  public:
+    /**
+     * @brief Lists the instances registered under service, a name prefix, and refreshes them periodically.
+     * The naming service has no notifications, the group follows the registrations within kGroupRefreshInterval.
+     * A refresh only carries the keys when they changed since the last listing.
+     *
+     * @param service
+     * @return ServiceGroupPtr
+     */
+    ServiceGroupPtr Watch(const std::string& service);
+
+    void Unwatch(const std::string& service);
+    /**
+     * @brief Sends to the member of service owning key, the same one as long as it stays registered.
+     * Watches service on first use, the messages wait for the first listing.
+     * Errors, such as ERROR_TDC_NOMEMBER, are passed to callback from the loop.
+     *
+     * @param service
+     * @param key
+     * @param body
+     * @param len
+     * @param callback
+     */
+    void SendByKey(const std::string& service, const std::string& key, const void* body, size_t len,
+                   tdc::TdcMessageCallback callback);
+    //Sends to the next member of service by weighted round robin
+    void SendBalanced(const std::string& service, const void* body, size_t len, tdc::TdcMessageCallback callback);
+
+    void SetWeight(const std::string& service, const std::string& member, int weight);
+  private:
+    struct PendingMsg {
+        bool by_key;
+        std::string key;
+        std::string body;
+        tdc::TdcMessageCallback callback;
+    };
+    struct GroupEntry {
+        ServiceGroupPtr group;
+        TimerId timer{ INVALID_TIMER_ID };
+        bool refreshing{ false };
+        uint64_t digest{ 0 }; ///< Of the members listed last, see NamingResolver::Keys()
+        std::vector<PendingMsg> pending; ///< Sent before the first listing
+    };
+    void RefreshGroup(const std::string& service);
+    void AfterRefreshGroup(const std::string& service, ServiceGroupPtr group, const naming::NamingReply& reply);
+    void SendToGroup(GroupEntry& entry, bool by_key, const std::string& key, const void* body, size_t len,
+                     tdc::TdcMessageCallback callback);
+    void Fail(tdc::TdcMessageCallback callback, int err);
   public:
     const std::map<std::string, std::shared_ptr<tdc::TdcService>>& tdc_map() { return tdc_map_; }
     size_t tdc_size() const { return tdc_map_.size(); }
@@ -42,6 +91,7 @@ class ClusterService  {
     tinynet::EventLoop* event_loop_;
     std::map<std::string, std::shared_ptr<tns::TnsService>> tns_map_;
     std::map<std::string, std::shared_ptr<tdc::TdcService>> tdc_map_;
+    std::map<std::string, GroupEntry> groups_;
 };
 }
 }
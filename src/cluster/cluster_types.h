@@ -24,6 +24,7 @@ struct NamingServiceOptions {
     int snapshotCount{ 0 };
     int heartbeatInterval{ 0 };
     int electionTimeout{ 0 };
+    int compressThreshold{ 0 }; ///< RPC payloads of at least this many bytes are compressed, 0 disables it
     std::vector<NodeInfo> servers;
 };
 
@@ -90,6 +91,7 @@ inline const tinynet::json::Value& operator >> (const tinynet::json::Value& json
     JSON_READ_FIELD_EX(snapshotCount, 0);
     JSON_READ_FIELD_EX(heartbeatInterval, 0);
     JSON_READ_FIELD_EX(electionTimeout, 0);
+    JSON_READ_FIELD_EX(compressThreshold, 0);
     JSON_READ_FIELD(servers);
     return json_value;
 }
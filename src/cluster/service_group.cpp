@@ -0,0 +1,114 @@
+// Copyright (C), Xianfeng Shang.  All rights reserved.
+// Author: Xianfeng Shang (shangxianfeng@outlook.com)
+#include "service_group.h"
+#include "util/string_utils.h"
+#include <algorithm>
+
+namespace tinynet {
+namespace cluster {
+
+ServiceGroup::ServiceGroup(const std::string& prefix) :
+    prefix_(prefix) {
+}
+
+bool ServiceGroup::Update(std::vector<std::string> names) {
+    std::sort(names.begin(), names.end());
+    names.erase(std::unique(names.begin(), names.end()), names.end());
+    ready_ = true;
+    if (names == names_) {
+        return false;
+    }
+    names_ = std::move(names);
+    Populate();
+    return true;
+}
+
+void ServiceGroup::SetWeight(const std::string& name, int weight) {
+    weight = (std::max)(weight, 0);
+    if (weight == DEFAULT_WEIGHT) {
+        weights_.erase(name);
+    } else {
+        weights_[name] = weight;
+    }
+    if (std::binary_search(names_.begin(), names_.end(), name)) {
+        Populate();
+    }
+}
+
+const std::string* ServiceGroup::PickByKey(const std::string& key) const {
+    if (table_.empty()) {
+        return nullptr;
+    }
+    uint64_t hash = StringUtils::Hash3(key.c_str());
+    return &members_[table_[hash % TABLE_SIZE]].name;
+}
+
+const std::string* ServiceGroup::PickNext() {
+    if (members_.empty()) {
+        return nullptr;
+    }
+    //Smooth weighted round robin: heavy members are spread out instead of picked in a row
+    int total = 0;
+    Member* best = nullptr;
+    for (auto& member : members_) {
+        member.current += member.weight;
+        total += member.weight;
+        if (!best || member.current > best->current) {
+            best = &member;
+        }
+    }
+    best->current -= total;
+    return &best->name;
+}
+
+void ServiceGroup::Populate() {
+    members_.clear();
+    table_.clear();
+    int max_weight = 0;
+    for (auto& name : names_) {
+        auto it = weights_.find(name);
+        int weight = it == weights_.end() ? DEFAULT_WEIGHT : it->second;
+        if (weight == 0) {
+            continue;
+        }
+        members_.emplace_back();
+        members_.back().name = name;
+        members_.back().weight = weight;
+        max_weight = (std::max)(max_weight, weight);
+    }
+    size_t count = members_.size();
+    if (count == 0) {
+        return;
+    }
+    //Each member walks its own permutation of the slots and takes the first free one in its turn,
+    //members take turns in proportion to their weights
+    std::vector<uint64_t> offset(count), skip(count), next(count, 0);
+    std::vector<int> credit(count, 0);
+    for (size_t i = 0; i < count; ++i) {
+        uint64_t hash = StringUtils::Hash3(members_[i].name.c_str());
+        offset[i] = (hash >> 32) % TABLE_SIZE;
+        skip[i] = (hash & 0xFFFFFFFF) % (TABLE_SIZE - 1) + 1;
+    }
+    table_.assign(TABLE_SIZE, -1);
+    int32_t filled = 0;
+    for (;;) {
+        for (size_t i = 0; i < count; ++i) {
+            credit[i] += members_[i].weight;
+            if (credit[i] < max_weight) {
+                continue;
+            }
+            credit[i] -= max_weight;
+            uint64_t slot;
+            do {
+                slot = (offset[i] + next[i] * skip[i]) % TABLE_SIZE;
+                ++next[i];
+            } while (table_[slot] >= 0);
+            table_[slot] = (int32_t)i;
+            if (++filled == TABLE_SIZE) {
+                return;
+            }
+        }
+    }
+}
+}
+}
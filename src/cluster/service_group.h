@@ -0,0 +1,80 @@
+// Copyright (C), Xianfeng Shang.  All rights reserved.
+// Author: Xianfeng Shang (shangxianfeng@outlook.com)
+#pragma once
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace tinynet {
+namespace cluster {
+class ServiceGroup;
+typedef std::shared_ptr<ServiceGroup> ServiceGroupPtr;
+
+//Instances registered in the naming service under one prefix, see ClusterService::Watch().
+//Keys go to members through a Maglev lookup table: O(1) per key, and a change of membership
+//only moves the keys of the members added or removed. The table depends on the names and weights
+//alone, so every process listing the same members routes a key to the same one.
+class ServiceGroup {
+  public:
+    static const int32_t TABLE_SIZE = 65537; ///< Prime, at least 100 slots per member for an even spread
+    static const int DEFAULT_WEIGHT = 1;
+  public:
+    ServiceGroup(const std::string& prefix);
+  public:
+    /**
+     * @brief Replaces the members, the table is only rebuilt when they changed
+     *
+     * @param names instance names, in any order
+     * @return true the members changed
+     * @return false
+     */
+    bool Update(std::vector<std::string> names);
+    /**
+     * @brief Weight of member for both the keys and the round robin, 0 drains it.
+     * Kept while the member is away, every process must set the same weights to agree on the keys.
+     *
+     * @param name
+     * @param weight
+     */
+    void SetWeight(const std::string& name, int weight);
+    /**
+     * @brief Member owning key, nullptr when the group is empty
+     *
+     * @param key
+     * @return const std::string*
+     */
+    const std::string* PickByKey(const std::string& key) const;
+    /**
+     * @brief Next member of the smooth weighted round robin, nullptr when the group is empty
+     *
+     * @return const std::string*
+     */
+    const std::string* PickNext();
+  public:
+    const std::string& get_prefix() const { return prefix_; }
+
+    size_t size() const { return members_.size(); }
+    //Listed from the naming service at least once
+    bool is_ready() const { return ready_; }
+
+    const std::vector<std::string>& get_members() const { return names_; }
+  private:
+    void Populate();
+  private:
+    struct Member {
+        std::string name;
+        int weight{ DEFAULT_WEIGHT };
+        int current{ 0 }; ///< Credit of the round robin
+    };
+  private:
+    std::string prefix_;
+    bool ready_{ false };
+    std::vector<std::string> names_; ///< Sorted, as listed
+    std::vector<Member> members_; ///< Members of non-zero weight, sorted by name
+    std::vector<int32_t> table_; ///< Index of the member owning each slot
+    std::unordered_map<std::string, int> weights_; ///< Weights set apart from the default
+};
+}
+}
@@ -0,0 +1,100 @@
+// Copyright (C), Xianfeng Shang.  All rights reserved.
+// Author: Xianfeng Shang (shangxianfeng@outlook.com)
+#include "shm_listener.h"
+#include "logging/logging.h"
+#include "base/error_code.h"
+#include "util/net_utils.h"
+#include "util/fs_utils.h"
+
+namespace tinynet {
+namespace ipc {
+
+ShmListener::ShmListener(EventLoop *loop) :
+    net::Listener(loop) {
+}
+
+ShmListener::~ShmListener() = default;
+
+int ShmListener::Listen(const std::string& url) {
+#ifdef _WIN32
+    return ERROR_INVAL;
+#else
+    if (!ShmSocket::is_shm_url(url)) {
+        return ERROR_URI_UNRECOGNIZED;
+    }
+    std::string path = ShmSocket::get_rendezvous_path(url);
+    if (FileSystemUtils::exists(path)) {
+        int err = 0;
+        int s = NetUtils::ConnectUnix(path.c_str(), &err);
+        if (s != -1) {
+            NetUtils::Close(s);
+            return ERROR_SOCKET_BINDANDLISTEN;
+        }
+        //Left by a process which is gone
+        FileSystemUtils::remove(path);
+    }
+    int err = BindAndListen(path, net::ksomaxconn);
+    if (err == ERROR_OK) {
+        listen_address_ = url;
+    }
+    return err;
+#endif
+}
+
+void ShmListener::Close() {
+    for (auto& it : pending_) {
+        it.second->set_conn_callback(nullptr);
+        it.second->set_error_callback(nullptr);
+        it.second->Close();
+    }
+    pending_.clear();
+    net::Listener::Close();
+}
+
+void ShmListener::Readable() {
+    int err = 0;
+    for (;;) {
+        int accept_fd = NetUtils::Accept(fd_, nullptr, nullptr, &err);
+        if (accept_fd == -1) {
+            break;
+        }
+        auto sock = event_loop_->NewObject<ShmSocket>(accept_fd, &listen_address_);
+        sock->set_conn_callback(std::bind(&ShmListener::HandleSetup, this, accept_fd));
+        sock->set_error_callback(std::bind(&ShmListener::HandleSetupError, this, accept_fd, std::placeholders::_1));
+        if ((err = sock->Accept()) != ERROR_OK) {
+            sock->Close();
+            break;
+        }
+        pending_[accept_fd] = sock;
+    }
+    if (err) {
+        log_warning("ShmListener(%s) accepting incoming connection error, err:%d, msg:%s",
+                    listen_address_.c_str(), err, tinynet_strerror(err));
+    }
+    if (AddEvent(net::EVENT_READABLE) == -1) {
+        SetError(ERROR_EVENTLOOP_REGISTER);
+    }
+}
+
+void ShmListener::HandleSetup(int fd) {
+    auto it = pending_.find(fd);
+    if (it == pending_.end()) return;
+    auto sock = std::move(it->second);
+    pending_.erase(it);
+    sock->set_conn_callback(nullptr);
+    sock->set_error_callback(nullptr);
+    Invoke(conn_callback_, sock);
+}
+
+void ShmListener::HandleSetupError(int fd, int err) {
+    auto it = pending_.find(fd);
+    if (it == pending_.end()) return;
+    auto sock = std::move(it->second);
+    pending_.erase(it);
+    log_warning("ShmListener(%s) connection setup failed, err:%d, msg:%s",
+                listen_address_.c_str(), err, tinynet_strerror(err));
+    //Closed from the next task, the socket is still in its own callback
+    event_loop_->AddTask([sock] { sock->Close(); });
+}
+}
+}
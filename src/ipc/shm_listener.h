@@ -0,0 +1,37 @@
+// Copyright (C), Xianfeng Shang.  All rights reserved.
+// Author: Xianfeng Shang (shangxianfeng@outlook.com)
+#pragma once
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include "net/listener.h"
+#include "shm_socket.h"
+
+namespace tinynet {
+namespace ipc {
+//Listener for servers on "shm://name", the connections are handed out once their rings are mapped
+class ShmListener:
+    public net::Listener {
+  public:
+    ShmListener(EventLoop *loop);
+    ~ShmListener();
+  public:
+    /**
+     * @brief Listens on the unix domain socket of url, see ShmSocket::get_rendezvous_path()
+     *
+     * @param url
+     * @return int
+     */
+    int Listen(const std::string& url);
+
+    void Close() override;
+  private:
+    void Readable() override;
+    void HandleSetup(int fd);
+    void HandleSetupError(int fd, int err);
+  private:
+    std::unordered_map<int, ShmSocketPtr> pending_; ///< Accepted connections whose rings did not arrive yet
+};
+typedef std::shared_ptr<ShmListener> ShmListenerPtr;
+}
+}
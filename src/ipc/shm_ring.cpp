@@ -0,0 +1,123 @@
+// Copyright (C), Xianfeng Shang.  All rights reserved.
+// Author: Xianfeng Shang (shangxianfeng@outlook.com)
+#include "shm_ring.h"
+#include <algorithm>
+#include <cstring>
+#include <new>
+
+namespace tinynet {
+namespace ipc {
+
+void ShmRing::Init(void* addr, uint32_t capacity) {
+    header_ = new(addr) ShmRingHeader();
+    header_->magic = MAGIC;
+    header_->capacity = capacity;
+    header_->head.store(0, std::memory_order_relaxed);
+    header_->tail.store(0, std::memory_order_relaxed);
+    //Nobody has read yet, the first write rings the doorbell
+    header_->reader_waiting.store(1, std::memory_order_relaxed);
+    header_->writer_waiting.store(0, std::memory_order_relaxed);
+    data_ = (char*)addr + sizeof(ShmRingHeader);
+    capacity_ = capacity;
+}
+
+bool ShmRing::Attach(void* addr, size_t size) {
+    auto header = (ShmRingHeader*)addr;
+    if (size < sizeof(ShmRingHeader) || header->magic != MAGIC) {
+        return false;
+    }
+    uint32_t capacity = header->capacity;
+    if (capacity == 0 || (capacity & (capacity - 1)) != 0 || get_mapped_size(capacity) > size) {
+        return false;
+    }
+    header_ = header;
+    data_ = (char*)addr + sizeof(ShmRingHeader);
+    capacity_ = capacity;
+    return true;
+}
+
+size_t ShmRing::Write(const void* data, size_t len) {
+    iov_t iov;
+    iov.base = (char*)data;
+    iov.len = static_cast<decltype(iov.len)>(len);
+    return Write(&iov, 1);
+}
+
+size_t ShmRing::Write(const iov_t* iovs, int niov) {
+    uint64_t tail = header_->tail.load(std::memory_order_relaxed);
+    uint64_t head = header_->head.load(std::memory_order_acquire);
+    //The positions are shared with the peer, never trust them further than the capacity
+    size_t used = (std::min)((size_t)(tail - head), (size_t)capacity_);
+    size_t space = capacity_ - used;
+    size_t nbytes = 0;
+    for (int i = 0; i < niov && space > 0; ++i) {
+        const char* p = iovs[i].base;
+        size_t len = (std::min)((size_t)iovs[i].len, space);
+        size_t pos = (size_t)(tail & (capacity_ - 1));
+        size_t n = (std::min)(len, capacity_ - pos);
+        memcpy(data_ + pos, p, n);
+        memcpy(data_, p + n, len - n);
+        tail += len;
+        space -= len;
+        nbytes += len;
+    }
+    if (nbytes > 0) {
+        header_->tail.store(tail, std::memory_order_release);
+    }
+    return nbytes;
+}
+
+size_t ShmRing::Read(void* buf, size_t len) {
+    uint64_t head = header_->head.load(std::memory_order_relaxed);
+    uint64_t tail = header_->tail.load(std::memory_order_acquire);
+    len = (std::min)(len, (std::min)((size_t)(tail - head), (size_t)capacity_));
+    if (len == 0) {
+        return 0;
+    }
+    size_t pos = (size_t)(head & (capacity_ - 1));
+    size_t n = (std::min)(len, capacity_ - pos);
+    memcpy(buf, data_ + pos, n);
+    memcpy((char*)buf + n, data_, len - n);
+    header_->head.store(head + len, std::memory_order_release);
+    return len;
+}
+
+//The flag store and the position load on one side, the position store and the flag load on the other,
+//are ordered by full fences so that one side always sees what the other did: no wakeup is lost.
+bool ShmRing::ReaderSleep() {
+    header_->reader_waiting.store(1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (readable() == 0) {
+        return true;
+    }
+    header_->reader_waiting.store(0, std::memory_order_relaxed);
+    return false;
+}
+
+bool ShmRing::ReaderWakeup() {
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (header_->reader_waiting.load(std::memory_order_relaxed) == 0) {
+        return false;
+    }
+    return header_->reader_waiting.exchange(0, std::memory_order_relaxed) != 0;
+}
+
+bool ShmRing::WriterSleep() {
+    header_->writer_waiting.store(1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (writable() == 0) {
+        return true;
+    }
+    header_->writer_waiting.store(0, std::memory_order_relaxed);
+    return false;
+}
+
+bool ShmRing::WriterWakeup() {
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (header_->writer_waiting.load(std::memory_order_relaxed) == 0) {
+        return false;
+    }
+    return header_->writer_waiting.exchange(0, std::memory_order_relaxed) != 0;
+}
+}
+}
@@ -0,0 +1,126 @@
+// Copyright (C), Xianfeng Shang.  All rights reserved.
+// Author: Xianfeng Shang (shangxianfeng@outlook.com)
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include "base/io_buffer.h"
+
+namespace tinynet {
+namespace ipc {
+
+/**
+ * @brief Shared part of a ring, placed at the start of the mapping and followed by the data
+ *
+ */
+struct ShmRingHeader {
+    uint32_t magic;
+    uint32_t capacity; ///< Data bytes, a power of 2
+    alignas(64) std::atomic<uint64_t> head; ///< Read position, advanced by the consumer only
+    alignas(64) std::atomic<uint64_t> tail; ///< Write position, advanced by the producer only
+    alignas(64) std::atomic<uint32_t> reader_waiting; ///< The consumer drained the ring and waits for a doorbell
+    std::atomic<uint32_t> writer_waiting; ///< The producer found the ring full and waits for a doorbell
+};
+
+//Single producer single consumer byte ring living in memory shared by two processes.
+//The positions only grow, their difference is the number of bytes readable.
+//Neither side makes a system call while the other one is busy, a doorbell is only needed
+//when the peer announced it is going to sleep, see ReaderSleep() and WriterSleep().
+class ShmRing {
+  public:
+    static const uint32_t MAGIC = 0x52474e52; ///< "RNGR"
+  public:
+    /**
+     * @brief Bytes to map for a ring holding capacity bytes
+     *
+     * @param capacity a power of 2
+     * @return size_t
+     */
+    static size_t get_mapped_size(uint32_t capacity) { return sizeof(ShmRingHeader) + capacity; }
+    /**
+     * @brief Formats a new empty ring at addr
+     *
+     * @param addr
+     * @param capacity a power of 2
+     */
+    void Init(void* addr, uint32_t capacity);
+    /**
+     * @brief Uses the ring formatted by the peer at addr, fails when it does not fit into size bytes
+     *
+     * @param addr
+     * @param size
+     * @return true
+     * @return false
+     */
+    bool Attach(void* addr, size_t size);
+  public:
+    /**
+     * @brief Copies up to len bytes into the ring, returns the number of bytes copied
+     *
+     * @param data
+     * @param len
+     * @return size_t
+     */
+    size_t Write(const void* data, size_t len);
+    /**
+     * @brief Copies as many bytes of the iovs as fit into the ring
+     *
+     * @param iovs
+     * @param niov
+     * @return size_t
+     */
+    size_t Write(const iov_t* iovs, int niov);
+    /**
+     * @brief Moves up to len bytes out of the ring
+     *
+     * @param buf
+     * @param len
+     * @return size_t
+     */
+    size_t Read(void* buf, size_t len);
+    /**
+     * @brief Consumer side, announces the consumer is going to sleep.
+     * Returns false if data arrived meanwhile and the consumer has to read again.
+     *
+     * @return true
+     * @return false
+     */
+    bool ReaderSleep();
+    /**
+     * @brief Producer side, returns true if the consumer sleeps and must be woken up after a write
+     *
+     * @return true
+     * @return false
+     */
+    bool ReaderWakeup();
+    /**
+     * @brief Producer side, announces the producer waits for free space.
+     * Returns false if the consumer made room meanwhile and the producer has to write again.
+     *
+     * @return true
+     * @return false
+     */
+    bool WriterSleep();
+    /**
+     * @brief Consumer side, returns true if the producer waits for space and must be woken up after a read
+     *
+     * @return true
+     * @return false
+     */
+    bool WriterWakeup();
+  public:
+    size_t readable() const {
+        return (std::min)((size_t)(header_->tail.load(std::memory_order_acquire) - header_->head.load(std::memory_order_relaxed)), (size_t)capacity_);
+    }
+    size_t writable() const {
+        return capacity_ - (std::min)((size_t)(header_->tail.load(std::memory_order_relaxed) - header_->head.load(std::memory_order_acquire)), (size_t)capacity_);
+    }
+    uint32_t get_capacity() const { return capacity_; }
+  private:
+    ShmRingHeader* header_{ nullptr };
+    char* data_{ nullptr };
+    uint32_t capacity_{ 0 }; ///< Private copy, the peer can not change it under us
+};
+}
+}
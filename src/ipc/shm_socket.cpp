@@ -0,0 +1,428 @@
+// Copyright (C), Xianfeng Shang.  All rights reserved.
+// Author: Xianfeng Shang (shangxianfeng@outlook.com)
+#include "shm_socket.h"
+#include <cstring>
+#include "net/event_loop.h"
+#include "base/error_code.h"
+#include "logging/logging.h"
+#include "util/net_utils.h"
+#ifndef _WIN32
+#include <cerrno>
+#include <cstdio>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace tinynet {
+namespace ipc {
+
+static const char kShmScheme[] = "shm://";
+
+static const uint32_t kShmSetupMagic = 0x4d485354; ///< "TSHM"
+
+static const uint32_t kMinRingSize = 4096;
+
+static const uint32_t kMaxRingSize = 1u << 30;
+
+static int kSetupTimeout_ms = 5000; //A client sends its rings right after connecting
+
+//The first and only message sent by the client, the shared memory object travels with it
+struct ShmSetup {
+    uint32_t magic;
+    uint32_t ring_size;
+};
+
+//Each ring starts on its own cache line
+static size_t get_ring_stride(uint32_t ring_size) {
+    return (ShmRing::get_mapped_size(ring_size) + 63) & ~(size_t)63;
+}
+
+#ifndef _WIN32
+static int CreateSharedMemory(size_t size) {
+#if defined(__linux__) && defined(MFD_CLOEXEC)
+    int fd = memfd_create("tinynet-shm", MFD_CLOEXEC | MFD_ALLOW_SEALING);
+#else
+    static std::atomic<uint32_t> seq{ 0 };
+    char name[64];
+    snprintf(name, sizeof(name), "/tinynet-shm-%d-%u", (int)getpid(), seq.fetch_add(1));
+    int fd = shm_open(name, O_RDWR | O_CREAT | O_EXCL, 0600);
+    //Only the descriptors keep the object alive
+    if (fd != -1) shm_unlink(name);
+#endif
+    if (fd == -1) {
+        return -1;
+    }
+    if (ftruncate(fd, (off_t)size) == -1) {
+        ::close(fd);
+        return -1;
+    }
+#ifdef F_ADD_SEALS
+    //Neither side can resize the rings under the other one's mapping, which would SIGBUS it
+    if (fcntl(fd, F_ADD_SEALS, F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_SEAL) == -1) {
+        ::close(fd);
+        return -1;
+    }
+#endif
+    return fd;
+}
+
+//The client could still resize an object it did not seal
+static bool IsSealed(int fd) {
+#ifdef F_GET_SEALS
+    int seals = fcntl(fd, F_GET_SEALS);
+    return seals != -1 && (seals & (F_SEAL_SHRINK | F_SEAL_GROW)) == (F_SEAL_SHRINK | F_SEAL_GROW);
+#else
+    return true;
+#endif
+}
+#endif
+
+ShmSocket::ShmSocket(EventLoop* loop):
+    Socket(loop) {
+}
+
+ShmSocket::ShmSocket(EventLoop* loop, int fd, const std::string* peer_address):
+    Socket(loop, fd, AF_UNIX, peer_address) {
+}
+
+ShmSocket::~ShmSocket() {
+    Unmap();
+}
+
+bool ShmSocket::is_shm_url(const std::string& url) {
+    return url.size() > sizeof(kShmScheme) - 1 && url.compare(0, sizeof(kShmScheme) - 1, kShmScheme) == 0;
+}
+
+std::string ShmSocket::get_rendezvous_path(const std::string& url) {
+    std::string path("/tmp/tinynet.shm.");
+    path.append(url, sizeof(kShmScheme) - 1, std::string::npos);
+    return path;
+}
+
+int ShmSocket::Connect(const std::string& url, uint32_t ring_size) {
+#ifdef _WIN32
+    return ERROR_INVAL;
+#else
+    if (!is_shm_url(url)) {
+        return ERROR_URI_UNRECOGNIZED;
+    }
+    uint32_t capacity = kMinRingSize;
+    while (capacity < ring_size && capacity < kMaxRingSize) {
+        capacity <<= 1;
+    }
+    size_t stride = get_ring_stride(capacity);
+    int memfd = CreateSharedMemory(stride * 2);
+    if (memfd == -1) {
+        return ERROR_OS_OOM;
+    }
+    int err = Map(memfd, stride * 2);
+    if (err != ERROR_OK) {
+        ::close(memfd);
+        return err;
+    }
+    //The client writes to the first ring and reads from the second one
+    tx_.Init(map_, capacity);
+    rx_.Init((char*)map_ + stride, capacity);
+    fd_ = NetUtils::ConnectUnix(get_rendezvous_path(url).c_str(), &err);
+    if (fd_ == -1) {
+        ::close(memfd);
+        Unmap();
+        return ERROR_UNIX_SOCKET_CONNECT;
+    }
+    ShmSetup setup;
+    setup.magic = kShmSetupMagic;
+    setup.ring_size = capacity;
+    err = NetUtils::SendFd(fd_, memfd, &setup, sizeof(setup));
+    ::close(memfd);
+    if (err != ERROR_OK) {
+        NetUtils::Close(fd_);
+        fd_ = -1;
+        Unmap();
+        return err;
+    }
+    af_ = AF_UNIX;
+    if (AddEvent(net::EVENT_WRITABLE) == -1) {
+        return ERROR_EVENTLOOP_REGISTER;
+    }
+    status_ = net::SocketStatus::SS_CONNECTING;
+    flag_ |= FD_FLAGS_CLIENT_FD;
+    peer_address_ = url;
+    return ERROR_OK;
+#endif
+}
+
+int ShmSocket::Accept() {
+    if (AddEvent(net::EVENT_READABLE) == -1) {
+        return ERROR_EVENTLOOP_REGISTER;
+    }
+    status_ = net::SocketStatus::SS_CONNECTING;
+    connect_timer_ = event_loop_->AddTimer(kSetupTimeout_ms, 0,
+                                           std::bind(&Socket::SetError, this, ERROR_SOCKET_CONNECTTIMEOUT));
+    return ERROR_OK;
+}
+
+int ShmSocket::Setup() {
+#ifdef _WIN32
+    return ERROR_INVAL;
+#else
+    ShmSetup setup;
+    ssize_t n = ::recv(fd_, (char*)&setup, sizeof(setup), MSG_PEEK | MSG_DONTWAIT);
+    if (n == 0) {
+        return ERROR_SOCKET_READ_EOF;
+    }
+    if (n < 0) {
+        return (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR) ? ERROR_OK : ERROR_SOCKET_READ;
+    }
+    if ((size_t)n < sizeof(setup)) {
+        return ERROR_OK;
+    }
+    int memfd;
+    int err = NetUtils::RecvFd(fd_, &memfd, &setup, sizeof(setup));
+    if (err != ERROR_OK) {
+        return err;
+    }
+    struct stat st;
+    if (memfd == -1 || setup.magic != kShmSetupMagic || fstat(memfd, &st) == -1) {
+        if (memfd != -1) ::close(memfd);
+        return ERROR_SOCKET_READ;
+    }
+    if (!IsSealed(memfd)) {
+        log_warning("Shared memory from %s is not sealed against resizing, refused", peer_address_.c_str());
+        ::close(memfd);
+        return ERROR_SOCKET_READ;
+    }
+    size_t size = (size_t)st.st_size;
+    err = Map(memfd, size);
+    ::close(memfd);
+    if (err != ERROR_OK) {
+        return err;
+    }
+    size_t stride = get_ring_stride(setup.ring_size);
+    if (stride > size / 2 || !rx_.Attach(map_, stride) || !tx_.Attach((char*)map_ + stride, size - stride) ||
+            rx_.get_capacity() != setup.ring_size || tx_.get_capacity() != setup.ring_size) {
+        Unmap();
+        return ERROR_SOCKET_READ;
+    }
+    Open();
+    return ERROR_OK;
+#endif
+}
+
+int ShmSocket::Map(int memfd, size_t size) {
+#ifdef _WIN32
+    return ERROR_INVAL;
+#else
+    void* addr = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, memfd, 0);
+    if (addr == MAP_FAILED) {
+        return ERROR_OS_OOM;
+    }
+    map_ = addr;
+    map_size_ = size;
+    return ERROR_OK;
+#endif
+}
+
+void ShmSocket::Unmap() {
+    tx_ready_ = false;
+#ifndef _WIN32
+    if (map_) {
+        munmap(map_, map_size_);
+    }
+#endif
+    map_ = nullptr;
+    map_size_ = 0;
+}
+
+void ShmSocket::Open() {
+    Socket::Open();
+    tx_ready_ = true;
+    //The ring is empty, writes go straight into it
+    mask_ |= net::EVENT_WRITABLE;
+    if (flag_ & FD_FLAGS_CLIENT_FD) {
+        ClearEvent(net::EVENT_WRITABLE);
+    }
+    mask_ &= ~net::EVENT_READABLE;
+    if (AddEvent(net::EVENT_READABLE) == -1) {
+        SetError(ERROR_EVENTLOOP_REGISTER);
+        return;
+    }
+    Invoke(conn_callback_);
+    //The peer may have written before we were ready
+    if (tx_ready_ && !(mask_ & net::EVENT_ERROR)) {
+        Receive();
+    }
+}
+
+void ShmSocket::Close() {
+    Socket::Close();
+    Unmap();
+}
+
+void ShmSocket::Readable() {
+    if (mask_ & net::EVENT_ERROR)
+        return;
+    int err;
+    if (is_connecting()) {
+        if ((err = Setup()) != ERROR_OK) {
+            SetError(err);
+        } else if (is_connecting()) {
+            mask_ &= ~net::EVENT_READABLE;
+            if (AddEvent(net::EVENT_READABLE) == -1) {
+                SetError(ERROR_EVENTLOOP_REGISTER);
+            }
+        }
+        return;
+    }
+    if (!tx_ready_)
+        return;
+    //Bytes written before the peer went away are still delivered
+    err = DrainDoorbell();
+    Receive();
+    if (!tx_ready_ || (mask_ & net::EVENT_ERROR))
+        return;
+    //The doorbell also tells a waiting writer that the peer made room
+    Writable();
+    if (!tx_ready_ || (mask_ & net::EVENT_ERROR))
+        return;
+    if (err != ERROR_OK) {
+        SetError(err);
+        return;
+    }
+    mask_ &= ~net::EVENT_READABLE;
+    if (AddEvent(net::EVENT_READABLE) == -1) {
+        SetError(ERROR_EVENTLOOP_REGISTER);
+    }
+}
+
+void ShmSocket::Receive() {
+    size_t nbytes = 0;
+    for (;;) {
+        size_t n = rx_.readable();
+        if (n == 0) {
+            if (rx_.ReaderSleep()) break;
+            continue;
+        }
+        if (read_limit_ > 0 && n > read_limit_ - nbytes) {
+            n = read_limit_ - nbytes;
+        }
+        rbuf_.reserve(rbuf_.size() + n);
+        n = rx_.Read(rbuf_.end(), n);
+        rbuf_.commit(n);
+        nbytes += n;
+        if (read_limit_ > 0 && nbytes >= read_limit_) {
+            //The peer is not asked to ring, the rest is read on the next loop iteration
+            event_loop_->ReplayEvent(fd_, net::EVENT_READABLE);
+            break;
+        }
+    }
+    if (nbytes > 0 && rx_.WriterWakeup()) {
+        Notify();
+    }
+    if (nbytes > 0) {
+        Invoke(read_callback_);
+        rbuf_.release();
+    }
+}
+
+void ShmSocket::Writable() {
+    if (mask_ & net::EVENT_ERROR)
+        return;
+    if (is_connecting()) {
+        if ((mask_ & net::EVENT_WRITABLE) && (flag_ & FD_FLAGS_CLIENT_FD)) {
+            Open();
+        }
+        return;
+    }
+    if (!tx_ready_)
+        return;
+    size_t nbytes = 0;
+    for (;;) {
+        size_t n;
+        if (wchain_) {
+            if (!wbuf_.empty()) {
+                wchain_->append(wbuf_.begin(), wbuf_.size());
+                wbuf_.clear();
+            }
+            iov_t iovs[64];
+            int niov = wchain_->peek(iovs, 64);
+            n = tx_.Write(iovs, niov);
+            wchain_->consume(n);
+        } else {
+            n = tx_.Write(wbuf_.begin(), wbuf_.size());
+            wbuf_.consume(n);
+        }
+        //The reader is woken before we wait for it at the latest by the end of iteration doorbell
+        if (n > 0 && tx_.ReaderWakeup()) {
+            Notify();
+        }
+        nbytes += n;
+        if (get_pending_write() == 0) {
+            mask_ |= net::EVENT_WRITABLE;
+            break;
+        }
+        if (n == 0 && tx_.WriterSleep()) {
+            mask_ &= ~net::EVENT_WRITABLE;
+            break;
+        }
+    }
+    if (get_pending_write() == 0) {
+        if (wchain_) wchain_->clear();
+        wbuf_.release();
+    }
+    if (nbytes > 0) {
+        WriteProgress(nbytes);
+        Invoke(write_callback_);
+    }
+}
+
+int ShmSocket::WriteDirect(const void* data, size_t len, int* nwrite) {
+    *nwrite = (int)tx_.Write(data, len);
+    if (*nwrite > 0 && tx_.ReaderWakeup()) {
+        Notify();
+    }
+    return ERROR_OK;
+}
+
+int ShmSocket::DrainDoorbell() {
+    char buf[64];
+    for (;;) {
+        int nread = 0;
+        int err = NetUtils::ReadAll(fd_, buf, sizeof(buf), &nread);
+        if (err != ERROR_OK) {
+            return err;
+        }
+        if ((size_t)nread < sizeof(buf)) {
+            return ERROR_OK;
+        }
+    }
+}
+
+void ShmSocket::Notify() {
+    //Writes of one loop iteration are announced with one doorbell
+    bell_pending_ = true;
+    if (!dirty_) {
+        dirty_ = true;
+        event_loop_->AddDirty(std::static_pointer_cast<Socket>(shared_from_this()));
+    }
+}
+
+int ShmSocket::Uncork() {
+    int nwrites = Socket::Uncork();
+    if (bell_pending_) {
+        bell_pending_ = false;
+        if (tx_ready_) RingDoorbell();
+    }
+    return nwrites;
+}
+
+void ShmSocket::RingDoorbell() {
+    //A full socket buffer holds doorbells enough, errors show up on the read side
+    char bell = 0;
+    int nwrite = 0;
+    NetUtils::WriteAll(fd_, &bell, 1, &nwrite);
+}
+}
+}
@@ -0,0 +1,92 @@
+// Copyright (C), Xianfeng Shang.  All rights reserved.
+// Author: Xianfeng Shang (shangxianfeng@outlook.com)
+#pragma once
+#include <cstdint>
+#include <memory>
+#include <string>
+#include "net/socket.h"
+#include "shm_ring.h"
+
+namespace tinynet {
+namespace ipc {
+
+class ShmSocket;
+typedef std::shared_ptr<ShmSocket> ShmSocketPtr;
+
+//Stream socket between two processes of the same host over a pair of rings in shared memory.
+//The client connects to the unix domain socket of the server named by the url, maps a new shared memory
+//object holding both rings and passes it with SCM_RIGHTS. The connection stays open afterwards:
+//it is the doorbell rung at the end of a loop iteration when the peer sleeps, and it tells each side when the other one is gone.
+//The codecs and channels on top see an ordinary stream socket, see SocketChannel::Open().
+class ShmSocket final:
+    public net::Socket {
+    friend class ShmListener;
+  public:
+    static const uint32_t DEFAULT_RING_SIZE = 1 << 20;
+  public:
+    ShmSocket(EventLoop* loop);
+    ShmSocket(EventLoop* loop, int fd, const std::string* peer_address);
+    ~ShmSocket();
+  public:
+    /**
+     * @brief Connects to the server listening on url, "shm://name"
+     *
+     * @param url
+     * @param ring_size bytes of each direction, rounded up to a power of 2
+     * @return int
+     */
+    int Connect(const std::string& url, uint32_t ring_size = DEFAULT_RING_SIZE);
+
+    void Close() override;
+    /**
+     * @brief Sends the corked writes and rings the doorbell the writes of this iteration deferred
+     *
+     * @return int
+     */
+    int Uncork() override;
+  public:
+    /**
+     * @brief Whether the url names the shared memory transport, "shm://name"
+     *
+     * @param url
+     * @return true
+     * @return false
+     */
+    static bool is_shm_url(const std::string& url);
+    /**
+     * @brief Path of the unix domain socket the server of url is reached on
+     *
+     * @param url
+     * @return std::string
+     */
+    static std::string get_rendezvous_path(const std::string& url);
+  private:
+    void Open() override;
+    void Readable() override;
+    void Writable() override;
+    bool CanWriteDirect() override { return tx_ready_; }
+    int WriteDirect(const void* data, size_t len, int* nwrite) override;
+  private:
+    /**
+     * @brief Server side, waits for the rings of the client on the accepted connection
+     *
+     * @return int
+     */
+    int Accept();
+    int Setup();
+    int Map(int memfd, size_t size);
+    void Unmap();
+    int DrainDoorbell();
+    void Notify();
+    void RingDoorbell();
+    void Receive();
+  private:
+    void* map_{ nullptr };
+    size_t map_size_{ 0 };
+    ShmRing rx_;
+    ShmRing tx_;
+    bool tx_ready_{ false }; ///< The rings are mapped and the connection is open
+    bool bell_pending_{ false }; ///< The peer sleeps and is woken at the end of the loop iteration
+};
+}
+}
@@ -5,6 +5,7 @@
 #include "util/process_utils.h"
 #include "base/unique_id.h"
 #include "net/stream_socket.h"
+#include "ipc/shm_socket.h"
 #include "base/runtime_logger.h"
 #include "base/error_code.h"
 #include <functional>
@@ -35,7 +36,12 @@ rpc::RpcChannel* LoggerClient::CreateChannel(const std::string& name) {
     auto channel = new(std::nothrow) rpc::RpcChannel(event_loop_);
     net::ChannelOptions options;
     options.name = "Log";
-    options.path = name;
+    //A log server of the same host may be reached over shared memory
+    if (ipc::ShmSocket::is_shm_url(name)) {
+        options.url = name;
+    } else {
+        options.path = name;
+    }
     channel->Init(options);
     return channel;
 }
@@ -8,6 +8,30 @@
 #include "lua_common_types.h"
 #include "lua_proto_types.h"
 #include "base/allocator.h"
+#include "lua_helper.h"
+#include "app/app_container.h"
+
+static int lua_buffer_pool_stats(lua_State *L) {
+    auto app = lua_getapp(L);
+    LuaState S{ L };
+    S << app->event_loop()->get_buffer_pool()->get_stats();
+    return 1;
+}
+
+static int lua_buffer_pool_trim(lua_State *L) {
+    auto app = lua_getapp(L);
+    auto pool = app->event_loop()->get_buffer_pool();
+    size_t limit = (size_t)luaL_optinteger(L, 1, 0);
+    pool->Trim(limit);
+    return 0;
+}
+
+static void push_buffer_pool(lua_State *L) {
+    lua_pushcfunction(L, lua_buffer_pool_stats);
+    lua_setfield(L, -2, "buffer_pool_stats");
+    lua_pushcfunction(L, lua_buffer_pool_trim);
+    lua_setfield(L, -2, "buffer_pool_trim");
+}
 #if defined USE_TCMALLOC
 #include "gperftools/malloc_extension.h"
 
@@ -69,6 +93,7 @@ static const luaL_Reg methods[] = {
 
 LUALIB_API int luaopen_allocator(lua_State *L) {
     lua_newtable(L);
+    push_buffer_pool(L);
     luaL_newlib(L, methods);
     lua_setfield(L, -2, "tcmalloc");
     return 1;
@@ -172,6 +197,7 @@ static const luaL_Reg methods[] = {
 
 LUALIB_API int luaopen_allocator(lua_State *L) {
     lua_newtable(L);
+    push_buffer_pool(L);
 
     luaL_newlib(L, methods);
 
@@ -237,6 +263,18 @@ int lua_memory_stats(lua_State *L) {
     return 1;
 }
 
+//Bytes allocated and freed by the calling thread since it started
+int lua_thread_allocated(lua_State *L) {
+    uint64_t allocated = 0;
+    uint64_t deallocated = 0;
+    size_t sz = sizeof(uint64_t);
+    je_mallctl("thread.allocated", &allocated, &sz, NULL, 0);
+    je_mallctl("thread.deallocated", &deallocated, &sz, NULL, 0);
+    lua_pushinteger(L, (lua_Integer)allocated);
+    lua_pushinteger(L, (lua_Integer)deallocated);
+    return 2;
+}
+
 int lua_memory_purge(lua_State  *L) {
     unsigned narenas = 0;
     size_t sz = sizeof(narenas);
@@ -252,11 +290,13 @@ static const luaL_Reg methods[] = {
     {"malloc_stats_print", lua_malloc_stats_print},
     {"memory_stats", lua_memory_stats},
     {"memory_purge", lua_memory_purge},
+    {"thread_allocated", lua_thread_allocated},
     {0, 0}
 };
 
 LUALIB_API int luaopen_allocator(lua_State *L) {
     lua_newtable(L);
+    push_buffer_pool(L);
 
     luaL_newlib(L, methods);
 
@@ -266,6 +306,7 @@ LUALIB_API int luaopen_allocator(lua_State *L) {
 #else
 LUALIB_API int luaopen_allocator(lua_State *L) {
     lua_newtable(L);
+    push_buffer_pool(L);
     return 1;
 }
 #endif
\ No newline at end of file
@@ -119,6 +119,95 @@ static int cluster_send_message(lua_State *L) {
     }
 }
 
+//cluster.send_by_key(service, key, msg, callback), the member owning key gets msg
+static int cluster_send_by_key(lua_State *L) {
+    auto app = lua_getapp(L);
+    auto cluster = app->get<cluster::ClusterService>();
+    lua_State* LL = app->get<lua_State>();
+    if (cluster->tdc_size() == 0) {
+        return luaL_error(L, "Please init cluster node first!");
+    }
+    const char* service = luaL_checkstring(L, 1);
+    size_t key_len;
+    const char* key = luaL_checklstring(L, 2, &key_len);
+    luaL_argcheck(L, lua_type(L, 4) == LUA_TFUNCTION, 4, "function expected!");
+
+    const void* data;
+    size_t len;
+    switch (lua_type(L, 3)) {
+    case LUA_TSTRING:
+        data = luaL_checklstring(L, 3, &len);
+        break;
+    case LUA_TUSERDATA: {
+        auto bytes = luaL_checkbytes(L, 3);
+        data = bytes->data();
+        len = bytes->size();
+        break;
+    }
+    default:
+        return luaL_argerror(L, 3, "string or bytes expected");
+    }
+    lua_pushvalue(L, 4);
+    int nref = luaL_ref(L, LUA_REGISTRYINDEX);
+    auto callback = std::bind(cluster_send_message_callback, LL, nref, std::placeholders::_1);
+    cluster->SendByKey(service, std::string(key, key_len), data, len, callback);
+    return 0;
+}
+
+//cluster.send_balanced(service, msg, callback), the members get the messages in turn by weight
+static int cluster_send_balanced(lua_State *L) {
+    auto app = lua_getapp(L);
+    auto cluster = app->get<cluster::ClusterService>();
+    lua_State* LL = app->get<lua_State>();
+    if (cluster->tdc_size() == 0) {
+        return luaL_error(L, "Please init cluster node first!");
+    }
+    const char* service = luaL_checkstring(L, 1);
+    luaL_argcheck(L, lua_type(L, 3) == LUA_TFUNCTION, 3, "function expected!");
+
+    const void* data;
+    size_t len;
+    switch (lua_type(L, 2)) {
+    case LUA_TSTRING:
+        data = luaL_checklstring(L, 2, &len);
+        break;
+    case LUA_TUSERDATA: {
+        auto bytes = luaL_checkbytes(L, 2);
+        data = bytes->data();
+        len = bytes->size();
+        break;
+    }
+    default:
+        return luaL_argerror(L, 2, "string or bytes expected");
+    }
+    lua_pushvalue(L, 3);
+    int nref = luaL_ref(L, LUA_REGISTRYINDEX);
+    auto callback = std::bind(cluster_send_message_callback, LL, nref, std::placeholders::_1);
+    cluster->SendBalanced(service, data, len, callback);
+    return 0;
+}
+
+//cluster.set_weight(service, member, weight)
+static int cluster_set_weight(lua_State *L) {
+    auto app = lua_getapp(L);
+    auto cluster = app->get<cluster::ClusterService>();
+    const char* service = luaL_checkstring(L, 1);
+    const char* member = luaL_checkstring(L, 2);
+    int weight = luaL_checkint(L, 3);
+    luaL_argcheck(L, weight >= 0, 3, "non-negative weight expected");
+    cluster->SetWeight(service, member, weight);
+    return 0;
+}
+
+//cluster.members(service), the members listed last, empty until the first listing
+static int cluster_members(lua_State *L) {
+    auto app = lua_getapp(L);
+    auto cluster = app->get<cluster::ClusterService>();
+    const char* service = luaL_checkstring(L, 1);
+    LuaState S{ L };
+    S << cluster->Watch(service)->get_members();
+    return 1;
+}
 
 static void tns_callback(lua_State* L, int nref, const tinynet::naming::NamingReply& reply) {
     lua_rawgeti(L, LUA_REGISTRYINDEX, nref);
@@ -254,6 +343,10 @@ static const luaL_Reg methods[] = {
     { "start", cluster_start},
     { "stop", cluster_stop},
     { "send_message", cluster_send_message },
+    { "send_by_key", cluster_send_by_key },
+    { "send_balanced", cluster_send_balanced },
+    { "set_weight", cluster_set_weight },
+    { "members", cluster_members },
     { "get", tns_get},
     { "put", tns_put},
     { "delete", tns_delete},
@@ -9,12 +9,16 @@ struct ClientOptions {
     int ping_interval{ 0 };
 };
 struct ServerOptions {
-    std::string listen_url;
+    std::string listen_url; ///< "ip:port", or "shm://name" for the shared memory transport
+    std::string listen_path; ///< Unix domain socket
     std::string listen_ip;
     int listen_port{ 0 };
     int keepalive_timeout{ 0 };
     bool reuseport{ false };
     bool ipv6only{ false };
+    int high_watermark{ 0 };
+    int low_watermark{ 0 };
+    std::string overflow_policy;
 };
 
 struct JsonCodecOptions {
@@ -21,10 +21,12 @@ class LuaHttpServer {
   public:
     LuaHttpServer(app::AppContainer* app) :
         app_(app),
-        nref_(LUA_REFNIL) {
+        nref_(LUA_REFNIL),
+        event_nref_(LUA_REFNIL) {
     }
     ~LuaHttpServer() {
         set_event_callback(LUA_REFNIL);
+        set_session_event_callback(LUA_REFNIL);
     }
   public:
     LuaHttpServer(const LuaHttpServer&) = delete;
@@ -40,6 +42,14 @@ class LuaHttpServer {
         }
         nref_ = nref;
     }
+
+    void set_session_event_callback(int nref) {
+        if (event_nref_ != LUA_REFNIL && event_nref_ != nref) {
+            lua_State *L = app_->get<lua_State>();
+            luaL_unref(L, LUA_REGISTRYINDEX, event_nref_);
+        }
+        event_nref_ = nref;
+    }
   public:
     int Start(net::ServerOptions& opts, int nref) {
         int err;
@@ -51,11 +61,14 @@ class LuaHttpServer {
                 return ERROR_URI_UNRECOGNIZED;
             }
         }
+        server_->set_hot_upgrade(app_->get<net::HotUpgrade>());
         if ((err = server_->Start(opts))) {
             server_.reset();
             return err;
         }
         server_->set_http_callback(std::bind(&LuaHttpServer::HandleRequest, this, std::placeholders::_1));
+        server_->set_event_callback(std::bind(&LuaHttpServer::HandleEvent, this, std::placeholders::_1,
+                                              std::placeholders::_2));
         set_event_callback(nref);
         return ERROR_OK;
     }
@@ -65,6 +78,7 @@ class LuaHttpServer {
             server_->Stop();
         }
         set_event_callback(LUA_REFNIL);
+        set_session_event_callback(LUA_REFNIL);
     }
   private:
     void HandleRequest(const http::HttpMessage &request) {
@@ -81,10 +95,29 @@ class LuaHttpServer {
         S << request;
         luaL_pcall(L, 1, 0);
     }
+
+    void HandleEvent(int64_t session_guid, http::server::HttpSessionEventType type) {
+        if (event_nref_ == LUA_REFNIL) return;
+
+        lua_State *L = app_->get<lua_State>();
+        lua_rawgeti(L, LUA_REGISTRYINDEX, event_nref_);
+        if (!lua_isfunction(L, -1)) {
+            log_warning("Http server emit event can not found callback function!");
+            lua_pop(L, 1);
+            return;
+        }
+        lua_newtable(L);
+        lua_pushstring(L, type == http::server::HTTP_SESSION_EVENT_ON_HIGHWATER ? "onhighwater" : "ondrain");
+        lua_setfield(L, -2, "type");
+        lua_pushidentifier(L, session_guid);
+        lua_setfield(L, -2, "guid");
+        luaL_pcall(L, 1, 0);
+    }
   private:
     app::AppContainer * app_;
     std::unique_ptr<http::HttpServer> server_;
     int nref_;
+    int event_nref_; ///< Receives {type = "onhighwater"|"ondrain", guid = session}
 };
 
 static void http_response_callback(lua_State* L, int nref, const http::client::Response &response) {
@@ -188,6 +221,18 @@ static int http_server_stop(lua_State *L) {
     return 0;
 }
 
+static int http_server_on_event(lua_State *L) {
+    auto server = luaL_checkserver(L, 1);
+    if (lua_isnoneornil(L, 2)) {
+        server->set_session_event_callback(LUA_REFNIL);
+        return 0;
+    }
+    luaL_argcheck(L, lua_type(L, 2) == LUA_TFUNCTION, 2, "function expected");
+    lua_pushvalue(L, 2);
+    server->set_session_event_callback(luaL_ref(L, LUA_REGISTRYINDEX));
+    return 0;
+}
+
 static int http_server_send_response(lua_State *L) {
     auto server = luaL_checkserver(L, 1);
     luaL_argcheck(L, lua_type(L, 2) == LUA_TTABLE, 2, "table expected");
@@ -209,6 +254,7 @@ static const luaL_Reg http_server_meta_methods[] = {
     {"start", http_server_start},
     {"stop", http_server_stop},
     {"send_response", http_server_send_response },
+    {"on_event", http_server_on_event },
     {"__gc", http_server_delete },
     { 0, 0 }
 };
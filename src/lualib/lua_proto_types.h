@@ -21,6 +21,9 @@
 #include "lua_common_types.h"
 #include "net/socket_channel.h"
 #include "net/socket_server.h"
+#include "net/event_loop.h"
+#include "net/rudp_session.h"
+#include "rpc/rpc_metrics.h"
 #include "base/vector3.h"
 #include "base/vector2.h"
 #include "base/vector3int.h"
@@ -395,11 +398,15 @@ inline const LuaState& operator >> (const LuaState& L, tinynet::lua::ClientOptio
 inline const LuaState& operator >> (const LuaState& L, tinynet::lua::ServerOptions & o) {
     LUA_READ_BEGIN();
     LUA_READ_FIELD_EX(listen_url, "");
-    LUA_READ_FIELD_COND(listen_ip, o.listen_url.empty());
-    LUA_READ_FIELD_COND(listen_port, o.listen_url.empty());
+    LUA_READ_FIELD_EX(listen_path, "");
+    LUA_READ_FIELD_COND(listen_ip, o.listen_url.empty() && o.listen_path.empty());
+    LUA_READ_FIELD_COND(listen_port, o.listen_url.empty() && o.listen_path.empty());
     LUA_READ_FIELD_EX(keepalive_timeout, 0);
     LUA_READ_FIELD_EX(reuseport, false);
     LUA_READ_FIELD_EX(ipv6only, false);
+    LUA_READ_FIELD_EX(high_watermark, 0);
+    LUA_READ_FIELD_EX(low_watermark, 0);
+    LUA_READ_FIELD_EX(overflow_policy, "");
     LUA_READ_END();
 }
 
@@ -431,6 +438,71 @@ inline LuaState& operator << (LuaState& L, const tinynet::lua::MemoryStats & o)
     LUA_WRITE_END();
 }
 
+inline LuaState& operator << (LuaState& L, const tinynet::EventLoopStats & o) {
+    LUA_WRITE_BEGIN();
+    LUA_WRITE_FIELD(loops);
+    LUA_WRITE_FIELD(events);
+    LUA_WRITE_FIELD(timers);
+    LUA_WRITE_FIELD(tasks);
+    LUA_WRITE_FIELD(wakeups);
+    LUA_WRITE_FIELD(cork_flushes);
+    LUA_WRITE_FIELD(saved_writes);
+    LUA_WRITE_FIELD(poll_us);
+    LUA_WRITE_FIELD(io_us);
+    LUA_WRITE_FIELD(timer_us);
+    LUA_WRITE_FIELD(task_us);
+    LUA_WRITE_FIELD(last_events);
+    LUA_WRITE_FIELD(last_timers);
+    LUA_WRITE_FIELD(last_tasks);
+    LUA_WRITE_FIELD(last_poll_us);
+    LUA_WRITE_FIELD(last_io_us);
+    LUA_WRITE_FIELD(last_timer_us);
+    LUA_WRITE_FIELD(last_task_us);
+    LUA_WRITE_END();
+}
+
+inline LuaState& operator << (LuaState& L, const tinynet::SSLHandshakeStats & o) {
+    LUA_WRITE_BEGIN();
+    LUA_WRITE_FIELD(full);
+    LUA_WRITE_FIELD(resumed);
+    LUA_WRITE_FIELD(failed);
+    LUA_WRITE_FIELD(early_data);
+    LUA_WRITE_FIELD(histogram);
+    LUA_WRITE_FIELD_EX(bucket_bounds_ms, std::vector<int64_t>(tinynet::SSLHandshakeCounters::BUCKET_BOUNDS_MS,
+                       tinynet::SSLHandshakeCounters::BUCKET_BOUNDS_MS + tinynet::SSLHandshakeCounters::BUCKETS - 1));
+    LUA_WRITE_END();
+}
+
+inline LuaState& operator << (LuaState& L, const tinynet::BufferPoolStats & o) {
+    LUA_WRITE_BEGIN();
+    LUA_WRITE_FIELD(pooled_bytes);
+    LUA_WRITE_FIELD(inuse_bytes);
+    LUA_WRITE_FIELD(high_water);
+    LUA_WRITE_FIELD(limit);
+    LUA_WRITE_FIELD(hits);
+    LUA_WRITE_FIELD(misses);
+    LUA_WRITE_FIELD(trimmed_bytes);
+    LUA_WRITE_END();
+}
+
+inline LuaState& operator << (LuaState& L, const tinynet::rpc::RpcMethodStats & o) {
+    LUA_WRITE_BEGIN();
+    LUA_WRITE_FIELD(name);
+    LUA_WRITE_FIELD(method_id);
+    LUA_WRITE_FIELD(server);
+    LUA_WRITE_FIELD(calls);
+    LUA_WRITE_FIELD(errors);
+    LUA_WRITE_FIELD(in_flight);
+    LUA_WRITE_FIELD(request_bytes);
+    LUA_WRITE_FIELD(response_bytes);
+    LUA_WRITE_FIELD(total_us);
+    LUA_WRITE_FIELD(p50_us);
+    LUA_WRITE_FIELD(p99_us);
+    LUA_WRITE_FIELD(p999_us);
+    LUA_WRITE_FIELD(max_us);
+    LUA_WRITE_END();
+}
+
 inline const LuaState& operator >> (const LuaState& L, tinynet::net::ServerOptions & o) {
     LUA_READ_BEGIN();
     LUA_READ_FIELD_EX(name, "");
@@ -445,6 +517,37 @@ inline const LuaState& operator >> (const LuaState& L, tinynet::net::ServerOptio
     LUA_READ_FIELD_EX(ipv6only, false);
     LUA_READ_FIELD_EX(debug, false);
     LUA_READ_FIELD_EX(max_packet_size, 0);
+    LUA_READ_FIELD_EX(chained_write, false);
+    LUA_READ_FIELD_EX(corked_write, false);
+    LUA_READ_FIELD_EX(cork_flush_bytes, 65536);
+    LUA_READ_FIELD_EX(max_read_bytes, 0);
+    LUA_READ_FIELD_EX(high_watermark, 0);
+    LUA_READ_FIELD_EX(low_watermark, 0);
+    LUA_READ_FIELD_EX(overflow_policy, "");
+    LUA_READ_FIELD_EX(io_threads, 0);
+    LUA_READ_FIELD_EX(session_cache_size, 20480);
+    LUA_READ_FIELD_EX(session_timeout, 300);
+    LUA_READ_FIELD_EX(session_tickets, true);
+    LUA_READ_FIELD_EX(ticket_rotate_sec, 3600);
+    LUA_READ_FIELD_EX(ticket_key_file, "");
+    LUA_READ_FIELD_EX(early_data, false);
+    LUA_READ_END();
+}
+
+inline const LuaState& operator >> (const LuaState& L, tinynet::net::RudpOptions & o) {
+    LUA_READ_BEGIN();
+    LUA_READ_FIELD_EX(mtu, 1400);
+    LUA_READ_FIELD_EX(interval, 10);
+    LUA_READ_FIELD_EX(nodelay, false);
+    LUA_READ_FIELD_EX(resend, 0);
+    LUA_READ_FIELD_EX(nocwnd, false);
+    LUA_READ_FIELD_EX(snd_wnd, 32);
+    LUA_READ_FIELD_EX(rcv_wnd, 128);
+    LUA_READ_FIELD_EX(dead_link, 20);
+    LUA_READ_FIELD_EX(timeout_ms, 10000);
+    LUA_READ_FIELD_EX(max_sessions, 10000);
+    LUA_READ_FIELD_EX(connect_cookie, true);
+    LUA_READ_FIELD_EX(drop_rate, 0);
     LUA_READ_END();
 }
 
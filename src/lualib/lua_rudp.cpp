@@ -0,0 +1,358 @@
+// Copyright (C), Xianfeng Shang.  All rights reserved.
+// Author: Xianfeng Shang (shangxianfeng@outlook.com)
+#include "lua_rudp.h"
+#include "net/rudp_endpoint.h"
+#include "net/event_loop.h"
+#include "app/app_container.h"
+#include "lua_helper.h"
+#include "lua_compat.h"
+#include "lua_socket_types.h"
+#include "lua_types.h"
+#include "lua_proto_types.h"
+#include "base/error_code.h"
+#include "logging/logging.h"
+#include "util/uri_utils.h"
+#include "util/net_utils.h"
+#include "lua_common_types.h"
+
+using namespace tinynet;
+#define  RUDP_SOCKET_META_TABLE "rudp_socket_meta_table"
+
+//A listening endpoint, a client endpoint with its session, or a session accepted by a listening endpoint
+class LuaRudp {
+  public:
+    LuaRudp(app::AppContainer* app, const net::RudpOptions& opts):
+        app_(app),
+        opts_(opts),
+        nref_(LUA_REFNIL) {
+    }
+    LuaRudp(app::AppContainer* app, net::RudpEndpointPtr endpoint, net::RudpSessionPtr session):
+        app_(app),
+        opts_(endpoint->get_options()),
+        endpoint_(std::move(endpoint)),
+        nref_(LUA_REFNIL) {
+        set_session(std::move(session));
+    }
+    ~LuaRudp() {
+        set_session(nullptr);
+        set_event_callback(LUA_REFNIL);
+    }
+  public:
+    LuaRudp(const LuaRudp &o) = delete;
+    LuaRudp& operator = (const LuaRudp &o) = delete;
+  public:
+    void HandleAccept(net::RudpSessionPtr session) {
+        if (nref_ == LUA_REFNIL) {
+            return;
+        }
+        lua_State *L = app_->get<lua_State>();
+        lua_rawgeti(L, LUA_REGISTRYINDEX, nref_);
+        if (!lua_isfunction(L, -1)) {
+            lua_pop(L, 1);
+            return;
+        }
+        lua_newtable(L);
+        lua_pushstring(L, "type");
+        lua_pushstring(L, "onaccept");
+        lua_rawset(L, -3);
+        lua_pushstring(L, "data");
+        auto ptr = lua_newuserdata(L, sizeof(LuaRudp));
+        new(ptr) LuaRudp(app_, endpoint_, session);
+        luaL_getmetatable(L, RUDP_SOCKET_META_TABLE);
+        lua_setmetatable(L, -2);
+        lua_rawset(L, -3);
+        luaL_pcall(L, 1, 0);
+    }
+    void HandleConnect() {
+        tinynet::lua::TcpSocketEvent event;
+        event.type = "onopen";
+        emit(event);
+    }
+    void HandleRead() {
+        //The callbacks may close the session
+        auto session = session_;
+        tinynet::lua::TcpSocketEvent event;
+        event.type = "onread";
+        while (session && session == session_ && session->Recv(&event.data)) {
+            emit(event);
+        }
+    }
+    void HandleError(int err) {
+        tinynet::lua::TcpSocketEvent event;
+        event.type = "onerror";
+        event.data = tinynet_strerror(err);
+        emit(event);
+    }
+  public:
+    int Connect(const std::string& host, int port) {
+        if (endpoint_) return ERROR_SOCKET_CONNECT;
+        auto endpoint = app_->event_loop()->NewObject<net::RudpEndpoint>(opts_);
+        if (!endpoint) return ERROR_OS_OOM;
+        int err = ERROR_OK;
+        auto session = endpoint->Connect(host, port, &err);
+        if (err != ERROR_OK) {
+            return err;
+        }
+        endpoint->set_error_callback(std::bind(&LuaRudp::HandleError, this, std::placeholders::_1));
+        endpoint_ = std::move(endpoint);
+        set_session(std::move(session));
+        return ERROR_OK;
+    }
+    int Listen(const lua::ServerOptions& opts) {
+        if (endpoint_) return ERROR_SERVER_STARTED;
+        std::string listen_ip;
+        int listen_port;
+        if (opts.listen_url.empty()) {
+            listen_ip = opts.listen_ip;
+            listen_port = opts.listen_port;
+        } else {
+            if (!UriUtils::parse_address(opts.listen_url, &listen_ip, &listen_port)) {
+                return ERROR_URI_UNRECOGNIZED;
+            }
+        }
+        int flags = 0;
+        if (opts.reuseport) flags |= TCP_FLAGS_REUSEPORT;
+        if (opts.ipv6only) flags |= TCP_FLAGS_IPV6ONLY;
+        auto endpoint = app_->event_loop()->NewObject<net::RudpEndpoint>(opts_);
+        if (!endpoint) return ERROR_OS_OOM;
+        int err = endpoint->Listen(listen_ip, listen_port, flags);
+        if (err == ERROR_OK) {
+            endpoint->set_accept_callback(std::bind(&LuaRudp::HandleAccept, this, std::placeholders::_1));
+            endpoint->set_error_callback(std::bind(&LuaRudp::HandleError, this, std::placeholders::_1));
+            endpoint_ = std::move(endpoint);
+        }
+        return err;
+    }
+    int Send(const char* data, size_t len, bool unreliable) {
+        if (!session_ || !session_->is_connected()) {
+            return ERROR_SOCKET_NOT_CONNECTED;
+        }
+        return unreliable ? session_->SendUnreliable(data, len) : session_->Send(data, len);
+    }
+    void Close() {
+        if (!endpoint_) return;
+        if (session_ && endpoint_->get_listen_port() != 0) {
+            //An accepted session, the endpoint belongs to the listener
+            endpoint_->CloseSession(session_->get_conv());
+            set_session(nullptr);
+            return;
+        }
+        set_session(nullptr);
+        endpoint_->Close();
+    }
+  public:
+    void emit(const tinynet::lua::TcpSocketEvent& event) {
+        if (nref_ == LUA_REFNIL) {
+            return;
+        }
+        lua_State *L = app_->get<lua_State>();
+        lua_rawgeti(L, LUA_REGISTRYINDEX, nref_);
+        if (!lua_isfunction(L, -1)) {
+            log_warning("Rudp socket emit event can not found callback function!");
+            lua_pop(L, 1);
+            return;
+        }
+        LuaState S = { L };
+        S << event;
+        luaL_pcall(L, 1, 0);
+    }
+  public:
+    net::RudpState get_state() {
+        if (session_) {
+            return session_->get_state();
+        }
+        if (endpoint_ && endpoint_->get_fd() != -1) {
+            return net::RudpState::RS_CONNECTED;
+        }
+        return endpoint_ ? net::RudpState::RS_CLOSED : net::RudpState::RS_INIT;
+    }
+    const net::RudpSessionPtr& get_session() const { return session_; }
+    void set_event_callback(int nref) {
+        if (nref_ != LUA_REFNIL && nref_ != nref) {
+            lua_State *L = app_->get<lua_State>();
+            luaL_unref(L, LUA_REGISTRYINDEX, nref_);
+        }
+        nref_ = nref;
+    }
+  private:
+    void set_session(net::RudpSessionPtr session) {
+        if (session_) {
+            session_->set_conn_callback(nullptr);
+            session_->set_read_callback(nullptr);
+            session_->set_error_callback(nullptr);
+        }
+        if (session) {
+            session->set_conn_callback(std::bind(&LuaRudp::HandleConnect, this));
+            session->set_read_callback(std::bind(&LuaRudp::HandleRead, this));
+            session->set_error_callback(std::bind(&LuaRudp::HandleError, this, std::placeholders::_1));
+        }
+        session_ = std::move(session);
+    }
+  protected:
+    app::AppContainer* app_;
+    net::RudpOptions opts_;
+    net::RudpEndpointPtr endpoint_;
+    net::RudpSessionPtr session_;
+    int nref_;
+};
+
+static LuaRudp* luaL_checkrudp(lua_State* L, int idx) {
+    return (LuaRudp*)luaL_checkudata(L, idx, RUDP_SOCKET_META_TABLE);
+}
+
+static int rudp_socket_new(lua_State* L) {
+    auto app = lua_getapp(L);
+    net::RudpOptions opts;
+    if (lua_istable(L, 1)) {
+        LuaState S{ L };
+        lua_pushvalue(L, 1);
+        S >> opts;
+        lua_pop(L, 1);
+    }
+    auto ptr = lua_newuserdata(L, sizeof(LuaRudp));
+    new(ptr) LuaRudp(app, opts);
+    luaL_getmetatable(L, RUDP_SOCKET_META_TABLE);
+    lua_setmetatable(L, -2);
+    return 1;
+}
+
+static int rudp_socket_delete(lua_State* L) {
+    LuaRudp* socket = luaL_checkrudp(L, 1);
+    socket->~LuaRudp();
+    return 0;
+}
+
+static int rudp_socket_on_event(lua_State *L) {
+    auto socket = luaL_checkrudp(L, 1);
+    int type = lua_type(L, 2);
+    luaL_argcheck(L, type == LUA_TNIL || type == LUA_TFUNCTION, 2, "function expected!");
+
+    int nref = LUA_REFNIL;
+    if (type == LUA_TFUNCTION) {
+        lua_pushvalue(L, 2);
+        nref = luaL_ref(L, LUA_REGISTRYINDEX);
+    }
+    socket->set_event_callback(nref);
+    return 0;
+}
+
+static int rudp_socket_close(lua_State* L) {
+    auto socket = luaL_checkrudp(L, 1);
+    socket->Close();
+    return 0;
+}
+
+static const char* RUDP_STATE_STRINGS[] = {
+    "unspec",
+    "connecting",
+    "connected",
+    "closed"
+};
+
+static int rudp_socket_get_status(lua_State* L) {
+    auto socket = luaL_checkrudp(L, 1);
+    lua_pushstring(L, RUDP_STATE_STRINGS[(int)socket->get_state()]);
+    return 1;
+}
+
+//Transport counters of the session, nil for a listening socket
+static int rudp_socket_get_stats(lua_State* L) {
+    auto socket = luaL_checkrudp(L, 1);
+    auto& session = socket->get_session();
+    if (!session) {
+        lua_pushnil(L);
+        return 1;
+    }
+    lua_newtable(L);
+    lua_pushinteger(L, (lua_Integer)session->get_rto());
+    lua_setfield(L, -2, "rto");
+    lua_pushinteger(L, (lua_Integer)session->get_retransmits());
+    lua_setfield(L, -2, "retransmits");
+    lua_pushinteger(L, (lua_Integer)session->get_wait_send());
+    lua_setfield(L, -2, "wait_send");
+    return 1;
+}
+
+static int rudp_socket_send(lua_State* L) {
+    auto socket = luaL_checkrudp(L, 1);
+    size_t dataLen{ 0 };
+    const char* data = luaL_checklstring(L, 2, &dataLen);
+    bool unreliable = lua_toboolean(L, 3) != 0;
+    int err = socket->Send(data, dataLen, unreliable);
+    if (err) {
+        lua_pushstring(L, tinynet_strerror(err));
+        return 1;
+    }
+    return 0;
+}
+
+static int rudp_socket_connect(lua_State* L) {
+    auto socket = luaL_checkrudp(L, 1);
+    const char* host = luaL_checkstring(L, 2);
+    int port = (int)luaL_checknumber(L, 3);
+    int err = socket->Connect(host, port);
+    if (err) {
+        lua_pushstring(L, tinynet_strerror(err));
+        return 1;
+    }
+    return 0;
+}
+
+static int rudp_socket_listen(lua_State* L) {
+    auto socket = luaL_checkrudp(L, 1);
+    lua::ServerOptions opts;
+    int type = lua_type(L, 2);
+    switch (type) {
+    case LUA_TNUMBER: {
+        opts.listen_port = luaL_checkint(L, 2);
+        opts.listen_ip = "0.0.0.0";
+        break;
+    }
+    case LUA_TSTRING: {
+        size_t len;
+        const char *addr = luaL_checklstring(L, 2, &len);
+        opts.listen_url.assign(addr, len);
+        break;
+    }
+    case LUA_TTABLE: {
+        LuaState S{ L };
+        S >> opts;
+        break;
+    }
+    default:
+        return luaL_argerror(L, 2, "[port] number or [url] string or [options] table expected");
+    }
+    int err = socket->Listen(opts);
+    if (err == ERROR_OK) {
+        return 0;
+    }
+    lua_pushstring(L, tinynet_strerror(err));
+    return 1;
+}
+
+static luaL_Reg meta_methods[] = {
+    {"__gc", rudp_socket_delete},
+    {"on_event", rudp_socket_on_event},
+    {"connect", rudp_socket_connect},
+    {"send", rudp_socket_send},
+    {"close", rudp_socket_close},
+    {"get_status", rudp_socket_get_status},
+    {"get_stats", rudp_socket_get_stats},
+    {"listen", rudp_socket_listen},
+    {0, 0}
+};
+
+static luaL_Reg methods[] = {
+    {"new", rudp_socket_new},
+    {0, 0}
+};
+
+LUALIB_API int luaopen_rudp(lua_State *L) {
+    luaL_newmetatable(L, RUDP_SOCKET_META_TABLE);
+    lua_pushvalue(L, -1);
+    lua_setfield(L, -2, "__index");
+    luaL_setfuncs(L, meta_methods, 0);
+    lua_pop(L, 1);
+    luaL_newlib(L, methods);
+    return 1;
+}
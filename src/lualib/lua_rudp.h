@@ -0,0 +1,6 @@
+// Copyright (C), Xianfeng Shang.  All rights reserved.
+// Author: Xianfeng Shang (shangxianfeng@outlook.com)
+#pragma once
+#include "lua.hpp"
+
+LUALIB_API int luaopen_rudp(lua_State *L);
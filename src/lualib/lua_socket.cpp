@@ -2,9 +2,11 @@
 // Author: Xianfeng Shang (shangxianfeng@outlook.com)
 #include "lua_socket.h"
 #include "lua_tcp.h"
+#include "lua_rudp.h"
 
 static const luaL_Reg socket_members[] {
     {"tcp", luaopen_tcp},
+    {"rudp", luaopen_rudp},
     {0, 0}
 };
 
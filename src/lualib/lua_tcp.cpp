@@ -3,6 +3,8 @@
 #include "lua_tcp.h"
 #include "net/stream_socket.h"
 #include "net/stream_listener.h"
+#include "ipc/shm_listener.h"
+#include "ipc/shm_socket.h"
 #include "app/app_container.h"
 #include "lua_helper.h"
 #include "lua_compat.h"
@@ -45,6 +47,9 @@ class LuaSocket {
         if (nref_ == LUA_REFNIL) {
             return;
         }
+        if (high_watermark_ > 0) {
+            sock->set_watermarks(high_watermark_, low_watermark_, overflow_policy_);
+        }
         lua_State *L = app_->get<lua_State>();
         lua_rawgeti(L, LUA_REGISTRYINDEX, nref_);
         if (!lua_isfunction(L, -1)) {
@@ -88,6 +93,17 @@ class LuaSocket {
         emit(event);
     }
 
+    void HandleHighWater() {
+        tinynet::lua::TcpSocketEvent event;
+        event.type = "onhighwater";
+        emit(event);
+    }
+    void HandleDrain() {
+        tinynet::lua::TcpSocketEvent event;
+        event.type = "ondrain";
+        emit(event);
+    }
+
     void HandleError(int err) {
         tinynet::lua::TcpSocketEvent event;
         event.type = "onerror";
@@ -105,20 +121,82 @@ class LuaSocket {
         return err;
     }
 
-    int Send(const void* buffer, size_t len) {
+    //"shm://name" for the shared memory transport, "unix:///path" for a unix domain socket
+    int Connect(const std::string& url) {
+        if (socket_) return ERROR_SOCKET_CONNECT;
+        static const char kUnixScheme[] = "unix://";
+        int err;
+        if (ipc::ShmSocket::is_shm_url(url)) {
+            auto socket = app_->event_loop()->NewObject<ipc::ShmSocket>();
+            if (!socket) return ERROR_OS_OOM;
+            if ((err = socket->Connect(url)) == ERROR_OK) {
+                set_socket(socket);
+            }
+            return err;
+        }
+        if (!StringUtils::StartsWith(url, kUnixScheme)) {
+            return ERROR_URI_UNRECOGNIZED;
+        }
+        auto socket = app_->event_loop()->NewObject<tinynet::net::StreamSocket>();
+        if (!socket) return ERROR_OS_OOM;
+        if ((err = socket->Connect(url.substr(sizeof(kUnixScheme) - 1))) == ERROR_OK) {
+            set_socket(socket);
+        }
+        return err;
+    }
+
+    int Send(const void* buffer, size_t len, bool droppable) {
         auto socket = get_socket();
         if (!socket || !socket->is_connected()) {
             return ERROR_SOCKET_NOT_CONNECTED;
         }
+        if (!socket->Admit(len)) {
+            return ERROR_SOCKET_WRITE;
+        }
+        size_t offset = socket->get_write_offset();
         socket->Write(buffer, len);
+        if (droppable) {
+            socket->MarkDroppable(offset);
+        }
         return ERROR_OK;
     }
+    void SetWatermarks(size_t high, size_t low, net::OverflowPolicy policy) {
+        high_watermark_ = high;
+        low_watermark_ = low;
+        overflow_policy_ = policy;
+        //A listener keeps them for the sockets it accepts
+        if (socket_) {
+            socket_->set_watermarks(high, low, policy);
+        }
+    }
     void Close() {
         if (socket_)socket_->Close();
     }
 
     int Listen(const lua::ServerOptions& opts) {
         if (socket_) return ERROR_SERVER_STARTED;
+        int err;
+        if (ipc::ShmSocket::is_shm_url(opts.listen_url) || !opts.listen_path.empty()) {
+            tinynet::net::ListenerPtr listener;
+            if (!opts.listen_path.empty()) {
+                auto stream_listener = app_->event_loop()->NewObject<tinynet::net::StreamListener>();
+                if (!stream_listener) return ERROR_OS_OOM;
+                err = stream_listener->BindAndListen(opts.listen_path, tinynet::net::ksomaxconn);
+                listener = stream_listener;
+            } else {
+                auto shm_listener = app_->event_loop()->NewObject<ipc::ShmListener>();
+                if (!shm_listener) return ERROR_OS_OOM;
+                err = shm_listener->Listen(opts.listen_url);
+                listener = shm_listener;
+            }
+            if (err == ERROR_OK) {
+                set_listener(listener);
+                high_watermark_ = (size_t)opts.high_watermark;
+                low_watermark_ = (size_t)opts.low_watermark;
+                overflow_policy_ = net::ParseOverflowPolicy(opts.overflow_policy);
+            }
+            return err;
+        }
         std::string listen_ip;
         int listen_port;
         if (opts.listen_url.empty()) {
@@ -134,9 +212,12 @@ class LuaSocket {
         if (opts.ipv6only) flags |= TCP_FLAGS_IPV6ONLY;
         auto listener = app_->event_loop()->NewObject<tinynet::net::StreamListener>();
         if (!listener) return ERROR_OS_OOM;
-        int err =  listener->BindAndListen(listen_ip, listen_port, tinynet::net::ksomaxconn, flags);
+        err =  listener->BindAndListen(listen_ip, listen_port, tinynet::net::ksomaxconn, flags);
         if (err == ERROR_OK) {
             set_listener(listener);
+            high_watermark_ = (size_t)opts.high_watermark;
+            low_watermark_ = (size_t)opts.low_watermark;
+            overflow_policy_ = net::ParseOverflowPolicy(opts.overflow_policy);
         }
         return err;
     }
@@ -175,12 +256,13 @@ class LuaSocket {
         return guid_;
     }
 
-    tinynet::net::StreamSocketPtr get_socket() {
-        return std::static_pointer_cast<tinynet::net::StreamSocket>(socket_);
+    //A stream socket or a shared memory one
+    tinynet::net::SocketPtr get_socket() {
+        return socket_;
     }
 
-    tinynet::net::StreamListenerPtr get_listener() {
-        return std::static_pointer_cast<tinynet::net::StreamListener> (socket_);
+    tinynet::net::ListenerPtr get_listener() {
+        return std::static_pointer_cast<tinynet::net::Listener> (socket_);
     }
   private:
     void set_socket(tinynet::net::SocketPtr sock) {
@@ -189,6 +271,8 @@ class LuaSocket {
             sock->set_write_callback(std::bind(&LuaSocket::HandleWrite, this));
             sock->set_conn_callback(std::bind(&LuaSocket::HandleConnect, this));
             sock->set_error_callback(std::bind(&LuaSocket::HandleError, this, std::placeholders::_1));
+            sock->set_highwater_callback(std::bind(&LuaSocket::HandleHighWater, this));
+            sock->set_drain_callback(std::bind(&LuaSocket::HandleDrain, this));
         }
         socket_ = std::move(sock);
     }
@@ -204,6 +288,9 @@ class LuaSocket {
     app::AppContainer* app_;
     std::shared_ptr<tinynet::net::Socket> socket_;
     int nref_;
+    size_t high_watermark_{ 0 };
+    size_t low_watermark_{ 0 };
+    net::OverflowPolicy overflow_policy_{ net::OverflowPolicy::OP_NONE };
 };
 
 static LuaSocket* luaL_checktcp(lua_State* L, int idx) {
@@ -265,7 +352,8 @@ static int tcp_socket_send(lua_State* L) {
     auto socket = luaL_checktcp(L, 1);
     size_t dataLen{ 0 };
     const char* data = luaL_checklstring(L, 2, &dataLen);
-    int err = socket->Send(data, dataLen);
+    bool droppable = lua_toboolean(L, 3) != 0;
+    int err = socket->Send(data, dataLen, droppable);
     if (err) {
         lua_pushstring(L, tinynet_strerror(err));
         return 1;
@@ -273,12 +361,27 @@ static int tcp_socket_send(lua_State* L) {
     return 0;
 }
 
+static int tcp_socket_set_watermarks(lua_State* L) {
+    auto socket = luaL_checktcp(L, 1);
+    lua_Integer high = luaL_checkinteger(L, 2);
+    lua_Integer low = luaL_optinteger(L, 3, high / 2);
+    const char* policy = luaL_optstring(L, 4, "");
+    luaL_argcheck(L, high >= 0 && low >= 0, 2, "watermarks must not be negative");
+    socket->SetWatermarks((size_t)high, (size_t)low, net::ParseOverflowPolicy(policy));
+    return 0;
+}
+
 static int tcp_socket_connect(lua_State* L) {
     auto socket = luaL_checktcp(L, 1);
     const char* host_str = luaL_checkstring(L, 2);
-    int port = (int)luaL_checknumber(L, 3);
     std::string host(host_str);
-    int err = socket->Connect(host, port);
+    int err;
+    if (lua_isnoneornil(L, 3)) {
+        err = socket->Connect(host);
+    } else {
+        int port = (int)luaL_checknumber(L, 3);
+        err = socket->Connect(host, port);
+    }
     if (err) {
         lua_pushstring(L, tinynet_strerror(err));
         return 1;
@@ -323,6 +426,7 @@ static luaL_Reg meta_methods[] = {
     {"on_event", tcp_socket_on_event},
     {"connect", tcp_socket_connect},
     {"send", tcp_socket_send},
+    {"set_watermarks", tcp_socket_set_watermarks},
     {"close", tcp_socket_close},
     {"get_status", tcp_socket_get_status},
     {"listen", tcp_socket_listen},
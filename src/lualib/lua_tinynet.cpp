@@ -449,6 +449,28 @@ static int lua_next_tick(lua_State *L) {
     return 1;
 }
 
+static int lua_get_loop_stats(lua_State *L) {
+    auto app = lua_getapp(L);
+    LuaState S{ L };
+    S << app->event_loop()->get_stats();
+    return 1;
+}
+
+static int lua_get_rpc_stats(lua_State *L) {
+    std::vector<tinynet::rpc::RpcMethodStats> stats;
+    tinynet::rpc::RpcMetrics::Instance()->Collect(&stats);
+    LuaState S{ L };
+    S << stats;
+    return 1;
+}
+
+static int lua_dump_rpc_stats(lua_State *L) {
+    std::string output;
+    tinynet::rpc::RpcMetrics::Instance()->Dump(&output);
+    lua_pushlstring(L, output.data(), output.size());
+    return 1;
+}
+
 static int lua_tinynet_strerror(lua_State *L) {
     int code = (int)luaL_checkinteger(L, 1);
     auto err = tinynet_strerror(code);
@@ -505,6 +527,9 @@ static const luaL_Reg global_funcs[] = {
     {"openssl_encrypt", lua_openssl_encrypt},
     {"openssl_decrypt", lua_openssl_decrypt},
     {"next_tick", lua_next_tick},
+    {"get_loop_stats", lua_get_loop_stats},
+    {"get_rpc_stats", lua_get_rpc_stats},
+    {"dump_rpc_stats", lua_dump_rpc_stats},
     {"tinynet_strerror", lua_tinynet_strerror},
     {0, 0}
 };
@@ -138,7 +138,9 @@ class LuaWebSocketServer {
         tinynet::lua::WebSocketEvent event;
         event.guid = evt.guid;
         tinynet::websocket::WebSocketPtr session;
-        if (server_ && (session = server_->GetChannel<tinynet::websocket::WebSocket>(evt.guid))) {
+        if (evt.addr) {
+            event.addr = *evt.addr;
+        } else if (server_ && (session = server_->GetChannel<tinynet::websocket::WebSocket>(evt.guid))) {
             event.addr = session->get_peer_ip();
         }
         switch (evt.type) {
@@ -165,6 +167,14 @@ class LuaWebSocketServer {
             event.type = "onclose";
             break;
         }
+        case websocket::server::WEBSOCKET_SESSION_EVENT_ON_HIGHWATER: {
+            event.type = "onhighwater";
+            break;
+        }
+        case websocket::server::WEBSOCKET_SESSION_EVENT_ON_DRAIN: {
+            event.type = "ondrain";
+            break;
+        }
         default:
             break;
         }
@@ -200,6 +210,7 @@ class LuaWebSocketServer {
                 return ERROR_URI_UNRECOGNIZED;
             }
         }
+        server_->set_hot_upgrade(app_->get<net::HotUpgrade>());
         if ((err = server_->Start(opts))) {
             server_.reset();
             return err;
@@ -310,6 +321,7 @@ static int ws_server_send_bytes(lua_State *L) {
     } else {
         return luaL_argerror(L, 2, "string or bytes expected");
     }
+    msg.droppable = lua_toboolean(L, 4) != 0;
     auto result = server->Send(session_guid, msg);
     lua_pushboolean(L, result);
     return 1;
@@ -321,6 +333,7 @@ static int ws_server_send_text(lua_State *L) {
     websocket::WebSocketMessage msg;
     msg.opcode = websocket::Opcode::Text;
     msg.data_ref = luaL_checklstring(L, 3, &msg.data_len);
+    msg.droppable = lua_toboolean(L, 4) != 0;
     auto result = server->Send(session_guid, msg);
     lua_pushboolean(L, result);
     return 1;
@@ -331,6 +344,7 @@ static int ws_server_broadcast_msg(lua_State *L) {
     websocket::WebSocketMessage msg;
     msg.opcode = websocket::Opcode::Binary;
     msg.data_ref = luaL_checklstring(L, 2, &msg.data_len);
+    msg.droppable = lua_toboolean(L, 3) != 0;
     server->Broadcast(msg);
     return 0;
 }
@@ -340,24 +354,32 @@ static int ws_server_broadcast_text(lua_State *L) {
     websocket::WebSocketMessage msg;
     msg.opcode = websocket::Opcode::Text;
     msg.data_ref = luaL_checklstring(L, 2, &msg.data_len);
+    msg.droppable = lua_toboolean(L, 3) != 0;
     server->Broadcast(msg);
     return 0;
 }
 
 static int ws_server_get_session_size(lua_State *L) {
     auto server = luaL_checkserver(L, 1);
-    lua_pushnumber(L, static_cast<lua_Number>(server->get_server()->channel_size()));
+    lua_pushnumber(L, static_cast<lua_Number>(server->get_server()->get_session_size()));
+    return 1;
+}
+
+static int ws_server_get_tls_stats(lua_State *L) {
+    auto server = luaL_checkserver(L, 1);
+    SSLHandshakeStats stats;
+    if (server->get_server()) {
+        server->get_server()->CollectHandshakeStats(&stats);
+    }
+    LuaState S{ L };
+    S << stats;
     return 1;
 }
 
 static int ws_server_get_client_ip(lua_State *L) {
     auto server = luaL_checkserver(L, 1);
     int64_t session_guid = luaL_checkidentifier(L, 2);
-    auto session = server->get_server()->GetChannel<tinynet::websocket::WebSocket>(session_guid);
-    std::string client_ip;
-    if (session) {
-        client_ip = session->get_peer_ip();
-    }
+    std::string client_ip = server->get_server()->GetPeerIp(session_guid);
     lua_pushstring(L, client_ip.c_str());
     return 1;
 }
@@ -518,6 +540,7 @@ static const luaL_Reg ws_server_meta_methods[] = {
     {"broadcast_msg", ws_server_broadcast_msg },
     {"broadcast_text", ws_server_broadcast_text },
     {"get_session_size", ws_server_get_session_size},
+    {"get_tls_stats", ws_server_get_tls_stats},
     {"get_client_ip", ws_server_get_client_ip},
     {"close_session", ws_server_close_session},
     {"__gc", ws_server_delete },
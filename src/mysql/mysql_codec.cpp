@@ -146,15 +146,14 @@ Packet* MysqlCodec::Read(tinynet::net::SocketPtr& sock) {
 
 void MysqlCodec::Write(tinynet::net::SocketPtr& sock, Packet* packet) {
     size_t packetSize = packet->len + 4;
-    sock->wbuf()->reserve(sock->wbuf()->size() + packetSize);
-    char* first = sock->wbuf()->end();
+    char* first = sock->PrepareWrite(packetSize);
     char* p = first;
     tinynet::EncodeFixed24(p, packet->len);
     p[3] = packet->seq & 0xff;
     p += 4;
     memcpy(p, &packet->data[0], packet->len);
     p += packet->len;
-    sock->wbuf()->commit(p - first);
+    sock->CommitWrite(p - first);
     sock->Flush();
 }
 
@@ -256,8 +256,9 @@ void protobuf_AssignDesc_naming_2eproto() {
       ::google::protobuf::MessageFactory::generated_factory(),
       sizeof(ClientDelRes));
   ClientKeysReq_descriptor_ = file->message_type(11);
-  static const int ClientKeysReq_offsets_[1] = {
+  static const int ClientKeysReq_offsets_[2] = {
     GOOGLE_PROTOBUF_GENERATED_MESSAGE_FIELD_OFFSET(ClientKeysReq, key_),
+    GOOGLE_PROTOBUF_GENERATED_MESSAGE_FIELD_OFFSET(ClientKeysReq, digest_),
   };
   ClientKeysReq_reflection_ =
     new ::google::protobuf::internal::GeneratedMessageReflection(
@@ -271,8 +272,9 @@ void protobuf_AssignDesc_naming_2eproto() {
       ::google::protobuf::MessageFactory::generated_factory(),
       sizeof(ClientKeysReq));
   ClientKeysRes_descriptor_ = file->message_type(12);
-  static const int ClientKeysRes_offsets_[1] = {
+  static const int ClientKeysRes_offsets_[2] = {
     GOOGLE_PROTOBUF_GENERATED_MESSAGE_FIELD_OFFSET(ClientKeysRes, keys_),
+    GOOGLE_PROTOBUF_GENERATED_MESSAGE_FIELD_OFFSET(ClientKeysRes, digest_),
   };
   ClientKeysRes_reflection_ =
     new ::google::protobuf::internal::GeneratedMessageReflection(
@@ -430,29 +432,30 @@ void protobuf_AddDesc_naming_2eproto() {
     "\001(\005\"\033\n\014ClientGetReq\022\013\n\003key\030\001 \001(\t\"*\n\014Clie"
     "ntGetRes\022\013\n\003key\030\001 \001(\t\022\r\n\005value\030\002 \001(\t\"\033\n\014"
     "ClientDelReq\022\013\n\003key\030\001 \001(\t\"\033\n\014ClientDelRe"
-    "s\022\013\n\003key\030\001 \001(\t\"\034\n\rClientKeysReq\022\013\n\003key\030\001"
-    " \001(\t\"\035\n\rClientKeysRes\022\014\n\004keys\030\001 \003(\t\"\373\001\n\r"
-    "ClientRequest\022,\n\006opcode\030\001 \001(\0162\034.tinynet."
-    "naming.ClientOpcode\022-\n\007put_req\030\002 \001(\0132\034.t"
-    "inynet.naming.ClientPutReq\022-\n\007get_req\030\003 "
-    "\001(\0132\034.tinynet.naming.ClientGetReq\022-\n\007del"
-    "_req\030\004 \001(\0132\034.tinynet.naming.ClientDelReq"
-    "\022/\n\010keys_req\030\005 \001(\0132\035.tinynet.naming.Clie"
-    "ntKeysReq\"\251\002\n\016ClientResponse\022\031\n\nerror_co"
-    "de\030\001 \001(\005:\005-5702\022\020\n\010redirect\030\002 \001(\t\022,\n\006opc"
-    "ode\030\003 \001(\0162\034.tinynet.naming.ClientOpcode\022"
-    "-\n\007put_res\030\004 \001(\0132\034.tinynet.naming.Client"
-    "PutRes\022-\n\007get_res\030\005 \001(\0132\034.tinynet.naming"
-    ".ClientGetRes\022-\n\007del_res\030\006 \001(\0132\034.tinynet"
-    ".naming.ClientDelRes\022/\n\010keys_res\030\007 \001(\0132\035"
-    ".tinynet.naming.ClientKeysRes*+\n\rCluster"
-    "Opcode\022\014\n\010PUT_DATA\020\001\022\014\n\010DEL_DATA\020\002*x\n\014Cl"
-    "ientOpcode\022\013\n\007GET_REQ\020\001\022\013\n\007GET_RES\020\002\022\013\n\007"
-    "PUT_REQ\020\003\022\013\n\007PUT_RES\020\004\022\013\n\007DEL_REQ\020\005\022\013\n\007D"
-    "EL_RES\020\006\022\014\n\010KEYS_REQ\020\007\022\014\n\010KEYS_RES\020\0102[\n\020"
-    "NamingRpcService\022G\n\006Invoke\022\035.tinynet.nam"
-    "ing.ClientRequest\032\036.tinynet.naming.Clien"
-    "tResponseB\003\200\001\001", 1534);
+    "s\022\013\n\003key\030\001 \001(\t\",\n\rClientKeysReq\022\013\n\003key\030\001"
+    " \001(\t\022\016\n\006digest\030\002 \001(\004\"-\n\rClientKeysRes\022\014\n"
+    "\004keys\030\001 \003(\t\022\016\n\006digest\030\002 \001(\004\"\373\001\n\rClientRe"
+    "quest\022,\n\006opcode\030\001 \001(\0162\034.tinynet.naming.C"
+    "lientOpcode\022-\n\007put_req\030\002 \001(\0132\034.tinynet.n"
+    "aming.ClientPutReq\022-\n\007get_req\030\003 \001(\0132\034.ti"
+    "nynet.naming.ClientGetReq\022-\n\007del_req\030\004 \001"
+    "(\0132\034.tinynet.naming.ClientDelReq\022/\n\010keys"
+    "_req\030\005 \001(\0132\035.tinynet.naming.ClientKeysRe"
+    "q\"\251\002\n\016ClientResponse\022\031\n\nerror_code\030\001 \001(\005"
+    ":\005-5702\022\020\n\010redirect\030\002 \001(\t\022,\n\006opcode\030\003 \001("
+    "\0162\034.tinynet.naming.ClientOpcode\022-\n\007put_r"
+    "es\030\004 \001(\0132\034.tinynet.naming.ClientPutRes\022-"
+    "\n\007get_res\030\005 \001(\0132\034.tinynet.naming.ClientG"
+    "etRes\022-\n\007del_res\030\006 \001(\0132\034.tinynet.naming."
+    "ClientDelRes\022/\n\010keys_res\030\007 \001(\0132\035.tinynet"
+    ".naming.ClientKeysRes*+\n\rClusterOpcode\022\014"
+    "\n\010PUT_DATA\020\001\022\014\n\010DEL_DATA\020\002*x\n\014ClientOpco"
+    "de\022\013\n\007GET_REQ\020\001\022\013\n\007GET_RES\020\002\022\013\n\007PUT_REQ\020"
+    "\003\022\013\n\007PUT_RES\020\004\022\013\n\007DEL_REQ\020\005\022\013\n\007DEL_RES\020\006"
+    "\022\014\n\010KEYS_REQ\020\007\022\014\n\010KEYS_RES\020\0102[\n\020NamingRp"
+    "cService\022G\n\006Invoke\022\035.tinynet.naming.Clie"
+    "ntRequest\032\036.tinynet.naming.ClientRespons"
+    "eB\003\200\001\001", 1566);
   ::google::protobuf::MessageFactory::InternalRegisterGeneratedFile(
     "naming.proto", &protobuf_RegisterTypes);
   KeyValuePair::default_instance_ = new KeyValuePair();
@@ -3718,6 +3721,7 @@ void ClientDelRes::Swap(ClientDelRes* other) {
 
 #ifndef _MSC_VER
 const int ClientKeysReq::kKeyFieldNumber;
+const int ClientKeysReq::kDigestFieldNumber;
 #endif  // !_MSC_VER
 
 ClientKeysReq::ClientKeysReq()
@@ -3740,6 +3744,7 @@ void ClientKeysReq::SharedCtor() {
   ::google::protobuf::internal::GetEmptyString();
   _cached_size_ = 0;
   key_ = const_cast< ::std::string*>(&::google::protobuf::internal::GetEmptyStringAlreadyInited());
+  digest_ = GOOGLE_ULONGLONG(0);
   ::memset(_has_bits_, 0, sizeof(_has_bits_));
 }
 
@@ -3778,10 +3783,13 @@ ClientKeysReq* ClientKeysReq::New() const {
 }
 
 void ClientKeysReq::Clear() {
-  if (has_key()) {
-    if (key_ != &::google::protobuf::internal::GetEmptyStringAlreadyInited()) {
-      key_->clear();
+  if (_has_bits_[0 / 32] & 3) {
+    if (has_key()) {
+      if (key_ != &::google::protobuf::internal::GetEmptyStringAlreadyInited()) {
+        key_->clear();
+      }
     }
+    digest_ = GOOGLE_ULONGLONG(0);
   }
   ::memset(_has_bits_, 0, sizeof(_has_bits_));
   mutable_unknown_fields()->Clear();
@@ -3809,6 +3817,21 @@ bool ClientKeysReq::MergePartialFromCodedStream(
         } else {
           goto handle_unusual;
         }
+        if (input->ExpectTag(16)) goto parse_digest;
+        break;
+      }
+
+      // optional uint64 digest = 2;
+      case 2: {
+        if (tag == 16) {
+         parse_digest:
+          DO_((::google::protobuf::internal::WireFormatLite::ReadPrimitive<
+                   ::google::protobuf::uint64, ::google::protobuf::internal::WireFormatLite::TYPE_UINT64>(
+                 input, &digest_)));
+          set_has_digest();
+        } else {
+          goto handle_unusual;
+        }
         if (input->ExpectAtEnd()) goto success;
         break;
       }
@@ -3848,6 +3871,11 @@ void ClientKeysReq::SerializeWithCachedSizes(
       1, this->key(), output);
   }
 
+  // optional uint64 digest = 2;
+  if (has_digest()) {
+    ::google::protobuf::internal::WireFormatLite::WriteUInt64(2, this->digest(), output);
+  }
+
   if (!unknown_fields().empty()) {
     ::google::protobuf::internal::WireFormat::SerializeUnknownFields(
         unknown_fields(), output);
@@ -3869,6 +3897,11 @@ void ClientKeysReq::SerializeWithCachedSizes(
         1, this->key(), target);
   }
 
+  // optional uint64 digest = 2;
+  if (has_digest()) {
+    target = ::google::protobuf::internal::WireFormatLite::WriteUInt64ToArray(2, this->digest(), target);
+  }
+
   if (!unknown_fields().empty()) {
     target = ::google::protobuf::internal::WireFormat::SerializeUnknownFieldsToArray(
         unknown_fields(), target);
@@ -3888,6 +3921,13 @@ int ClientKeysReq::ByteSize() const {
           this->key());
     }
 
+    // optional uint64 digest = 2;
+    if (has_digest()) {
+      total_size += 1 +
+        ::google::protobuf::internal::WireFormatLite::UInt64Size(
+          this->digest());
+    }
+
   }
   if (!unknown_fields().empty()) {
     total_size +=
@@ -3918,6 +3958,9 @@ void ClientKeysReq::MergeFrom(const ClientKeysReq& from) {
     if (from.has_key()) {
       set_key(from.key());
     }
+    if (from.has_digest()) {
+      set_digest(from.digest());
+    }
   }
   mutable_unknown_fields()->MergeFrom(from.unknown_fields());
 }
@@ -3942,6 +3985,7 @@ bool ClientKeysReq::IsInitialized() const {
 void ClientKeysReq::Swap(ClientKeysReq* other) {
   if (other != this) {
     std::swap(key_, other->key_);
+    std::swap(digest_, other->digest_);
     std::swap(_has_bits_[0], other->_has_bits_[0]);
     _unknown_fields_.Swap(&other->_unknown_fields_);
     std::swap(_cached_size_, other->_cached_size_);
@@ -3961,6 +4005,7 @@ void ClientKeysReq::Swap(ClientKeysReq* other) {
 
 #ifndef _MSC_VER
 const int ClientKeysRes::kKeysFieldNumber;
+const int ClientKeysRes::kDigestFieldNumber;
 #endif  // !_MSC_VER
 
 ClientKeysRes::ClientKeysRes()
@@ -3982,6 +4027,7 @@ ClientKeysRes::ClientKeysRes(const ClientKeysRes& from)
 void ClientKeysRes::SharedCtor() {
   ::google::protobuf::internal::GetEmptyString();
   _cached_size_ = 0;
+  digest_ = GOOGLE_ULONGLONG(0);
   ::memset(_has_bits_, 0, sizeof(_has_bits_));
 }
 
@@ -4017,6 +4063,7 @@ ClientKeysRes* ClientKeysRes::New() const {
 }
 
 void ClientKeysRes::Clear() {
+  digest_ = GOOGLE_ULONGLONG(0);
   keys_.Clear();
   ::memset(_has_bits_, 0, sizeof(_has_bits_));
   mutable_unknown_fields()->Clear();
@@ -4047,6 +4094,21 @@ bool ClientKeysRes::MergePartialFromCodedStream(
           goto handle_unusual;
         }
         if (input->ExpectTag(10)) goto parse_keys;
+        if (input->ExpectTag(16)) goto parse_digest;
+        break;
+      }
+
+      // optional uint64 digest = 2;
+      case 2: {
+        if (tag == 16) {
+         parse_digest:
+          DO_((::google::protobuf::internal::WireFormatLite::ReadPrimitive<
+                   ::google::protobuf::uint64, ::google::protobuf::internal::WireFormatLite::TYPE_UINT64>(
+                 input, &digest_)));
+          set_has_digest();
+        } else {
+          goto handle_unusual;
+        }
         if (input->ExpectAtEnd()) goto success;
         break;
       }
@@ -4086,6 +4148,11 @@ void ClientKeysRes::SerializeWithCachedSizes(
       1, this->keys(i), output);
   }
 
+  // optional uint64 digest = 2;
+  if (has_digest()) {
+    ::google::protobuf::internal::WireFormatLite::WriteUInt64(2, this->digest(), output);
+  }
+
   if (!unknown_fields().empty()) {
     ::google::protobuf::internal::WireFormat::SerializeUnknownFields(
         unknown_fields(), output);
@@ -4106,6 +4173,11 @@ void ClientKeysRes::SerializeWithCachedSizes(
       WriteStringToArray(1, this->keys(i), target);
   }
 
+  // optional uint64 digest = 2;
+  if (has_digest()) {
+    target = ::google::protobuf::internal::WireFormatLite::WriteUInt64ToArray(2, this->digest(), target);
+  }
+
   if (!unknown_fields().empty()) {
     target = ::google::protobuf::internal::WireFormat::SerializeUnknownFieldsToArray(
         unknown_fields(), target);
@@ -4117,6 +4189,15 @@ void ClientKeysRes::SerializeWithCachedSizes(
 int ClientKeysRes::ByteSize() const {
   int total_size = 0;
 
+  if (_has_bits_[1 / 32] & (0xffu << (1 % 32))) {
+    // optional uint64 digest = 2;
+    if (has_digest()) {
+      total_size += 1 +
+        ::google::protobuf::internal::WireFormatLite::UInt64Size(
+          this->digest());
+    }
+
+  }
   // repeated string keys = 1;
   total_size += 1 * this->keys_size();
   for (int i = 0; i < this->keys_size(); i++) {
@@ -4150,6 +4231,11 @@ void ClientKeysRes::MergeFrom(const ::google::protobuf::Message& from) {
 void ClientKeysRes::MergeFrom(const ClientKeysRes& from) {
   GOOGLE_CHECK_NE(&from, this);
   keys_.MergeFrom(from.keys_);
+  if (from._has_bits_[1 / 32] & (0xffu << (1 % 32))) {
+    if (from.has_digest()) {
+      set_digest(from.digest());
+    }
+  }
   mutable_unknown_fields()->MergeFrom(from.unknown_fields());
 }
 
@@ -4173,6 +4259,7 @@ bool ClientKeysRes::IsInitialized() const {
 void ClientKeysRes::Swap(ClientKeysRes* other) {
   if (other != this) {
     keys_.Swap(&other->keys_);
+    std::swap(digest_, other->digest_);
     std::swap(_has_bits_[0], other->_has_bits_[0]);
     _unknown_fields_.Swap(&other->_unknown_fields_);
     std::swap(_cached_size_, other->_cached_size_);
@@ -1219,16 +1219,26 @@ class ClientKeysReq : public ::google::protobuf::Message {
   inline ::std::string* release_key();
   inline void set_allocated_key(::std::string* key);
 
+  // optional uint64 digest = 2;
+  inline bool has_digest() const;
+  inline void clear_digest();
+  static const int kDigestFieldNumber = 2;
+  inline ::google::protobuf::uint64 digest() const;
+  inline void set_digest(::google::protobuf::uint64 value);
+
   // @@protoc_insertion_point(class_scope:tinynet.naming.ClientKeysReq)
  private:
   inline void set_has_key();
   inline void clear_has_key();
+  inline void set_has_digest();
+  inline void clear_has_digest();
 
   ::google::protobuf::UnknownFieldSet _unknown_fields_;
 
   ::google::protobuf::uint32 _has_bits_[1];
   mutable int _cached_size_;
   ::std::string* key_;
+  ::google::protobuf::uint64 digest_;
   friend void  protobuf_AddDesc_naming_2eproto();
   friend void protobuf_AssignDesc_naming_2eproto();
   friend void protobuf_ShutdownFile_naming_2eproto();
@@ -1307,14 +1317,24 @@ class ClientKeysRes : public ::google::protobuf::Message {
   inline const ::google::protobuf::RepeatedPtrField< ::std::string>& keys() const;
   inline ::google::protobuf::RepeatedPtrField< ::std::string>* mutable_keys();
 
+  // optional uint64 digest = 2;
+  inline bool has_digest() const;
+  inline void clear_digest();
+  static const int kDigestFieldNumber = 2;
+  inline ::google::protobuf::uint64 digest() const;
+  inline void set_digest(::google::protobuf::uint64 value);
+
   // @@protoc_insertion_point(class_scope:tinynet.naming.ClientKeysRes)
  private:
+  inline void set_has_digest();
+  inline void clear_has_digest();
 
   ::google::protobuf::UnknownFieldSet _unknown_fields_;
 
   ::google::protobuf::uint32 _has_bits_[1];
   mutable int _cached_size_;
   ::google::protobuf::RepeatedPtrField< ::std::string> keys_;
+  ::google::protobuf::uint64 digest_;
   friend void  protobuf_AddDesc_naming_2eproto();
   friend void protobuf_AssignDesc_naming_2eproto();
   friend void protobuf_ShutdownFile_naming_2eproto();
@@ -3084,6 +3104,30 @@ inline void ClientKeysReq::set_allocated_key(::std::string* key) {
   // @@protoc_insertion_point(field_set_allocated:tinynet.naming.ClientKeysReq.key)
 }
 
+// optional uint64 digest = 2;
+inline bool ClientKeysReq::has_digest() const {
+  return (_has_bits_[0] & 0x00000002u) != 0;
+}
+inline void ClientKeysReq::set_has_digest() {
+  _has_bits_[0] |= 0x00000002u;
+}
+inline void ClientKeysReq::clear_has_digest() {
+  _has_bits_[0] &= ~0x00000002u;
+}
+inline void ClientKeysReq::clear_digest() {
+  digest_ = GOOGLE_ULONGLONG(0);
+  clear_has_digest();
+}
+inline ::google::protobuf::uint64 ClientKeysReq::digest() const {
+  // @@protoc_insertion_point(field_get:tinynet.naming.ClientKeysReq.digest)
+  return digest_;
+}
+inline void ClientKeysReq::set_digest(::google::protobuf::uint64 value) {
+  set_has_digest();
+  digest_ = value;
+  // @@protoc_insertion_point(field_set:tinynet.naming.ClientKeysReq.digest)
+}
+
 // -------------------------------------------------------------------
 
 // ClientKeysRes
@@ -3142,6 +3186,30 @@ ClientKeysRes::mutable_keys() {
   return &keys_;
 }
 
+// optional uint64 digest = 2;
+inline bool ClientKeysRes::has_digest() const {
+  return (_has_bits_[0] & 0x00000002u) != 0;
+}
+inline void ClientKeysRes::set_has_digest() {
+  _has_bits_[0] |= 0x00000002u;
+}
+inline void ClientKeysRes::clear_has_digest() {
+  _has_bits_[0] &= ~0x00000002u;
+}
+inline void ClientKeysRes::clear_digest() {
+  digest_ = GOOGLE_ULONGLONG(0);
+  clear_has_digest();
+}
+inline ::google::protobuf::uint64 ClientKeysRes::digest() const {
+  // @@protoc_insertion_point(field_get:tinynet.naming.ClientKeysRes.digest)
+  return digest_;
+}
+inline void ClientKeysRes::set_digest(::google::protobuf::uint64 value) {
+  set_has_digest();
+  digest_ = value;
+  // @@protoc_insertion_point(field_set:tinynet.naming.ClientKeysRes.digest)
+}
+
 // -------------------------------------------------------------------
 
 // ClientRequest
@@ -17,6 +17,15 @@ const int kMaxRetryCount = 3;
 
 const int kMaxRedirectCount = 3;
 
+//Attempts not answered by then go to the next address, the service skips those it reads too late
+const int64_t kCallTimeout = 3 * 1000;
+
+//Key listings stream the whole prefix
+const int64_t kKeysTimeout = 30 * 1000;
+
+//A long key listing leaves a connection to the gets and puts
+const int kChannelPoolSize = 2;
+
 NamingResolver::NamingResolver(EventLoop *loop) :
     event_loop_(loop) {
 }
@@ -48,7 +57,7 @@ void NamingResolver::Stop() {
         stubs_.swap(empty);
     }
     {
-        std::vector<rpc::RpcChannelPtr> empty;
+        std::vector<rpc::RpcChannelPoolPtr> empty;
         channels_.swap(empty);
     }
 }
@@ -65,9 +74,14 @@ NamingResolver::StubPtr NamingResolver::GetStub(size_t addr_hint) {
     return stubs_[addrs_[index]];
 }
 
-rpc::RpcChannelPtr NamingResolver::CreateChannel(const std::string& ip, int port) {
-    auto channel = std::make_shared<rpc::RpcChannel>(event_loop_);
-    channel->Init(ip, port);
+rpc::RpcChannelPoolPtr NamingResolver::CreateChannel(const std::string& ip, int port) {
+    auto channel = std::make_shared<rpc::RpcChannelPool>(event_loop_);
+    channel->set_compress_threshold(compress_threshold_);
+    net::ChannelOptions opts;
+    opts.host = ip;
+    opts.port = port;
+    opts.pool_size = kChannelPoolSize;
+    channel->Init(opts);
     return channel;
 }
 
@@ -132,7 +146,7 @@ int NamingResolver::Delete(const std::string &name, NamingCallback callback) {
     return Invoke(ctx);
 }
 
-int NamingResolver::Keys(const std::string &name, NamingCallback callback) {
+int NamingResolver::Keys(const std::string &name, NamingCallback callback, uint64_t digest) {
     if (stubs_.size() == 0) {
         return ERROR_TNS_NOSTUB;
     }
@@ -140,6 +154,9 @@ int NamingResolver::Keys(const std::string &name, NamingCallback callback) {
     ctx->request.set_opcode(KEYS_REQ);
     auto keys_req = ctx->request.mutable_keys_req();
     keys_req->set_key(name);
+    if (digest) {
+        keys_req->set_digest(digest);
+    }
     ctx->callback = std::move(callback);
 
     return Invoke(ctx);
@@ -147,6 +164,26 @@ int NamingResolver::Keys(const std::string &name, NamingCallback callback) {
 
 int NamingResolver::Invoke(TnsContextPtr ctx) {
     ctx->controller.Reset();
+    ctx->controller.SetTimeout(ctx->request.opcode() == KEYS_REQ ? kKeysTimeout : kCallTimeout);
+    if (ctx->request.opcode() == KEYS_REQ && !ctx->noStream) {
+        //The service writes the keys in batches on a stream and answers once they are all sent
+        ctx->keys.clear();
+        auto stream = std::make_shared<rpc::RpcStream>();
+        std::weak_ptr<TnsContext> weak_ctx = ctx;
+        stream->set_message_callback([weak_ctx](const char* data, size_t len) {
+            auto ctx = weak_ctx.lock();
+            ClientKeysRes batch;
+            if (!ctx || !batch.ParseFromArray(data, static_cast<int>(len))) return;
+            for (int i = 0; i < batch.keys_size(); ++i) {
+                ctx->keys.emplace_back(std::move(*batch.mutable_keys(i)));
+            }
+        });
+        rpc::RpcStream* s = stream.get();
+        stream->set_close_callback([s](int err) {
+            if (err == ERROR_OK) s->Close();
+        });
+        ctx->controller.set_stream(std::move(stream));
+    }
     auto stub = GetStub(ctx->retryCount);
     if (!stub) {
         return ERROR_TNS_NOSTUB;
@@ -158,6 +195,12 @@ int NamingResolver::Invoke(TnsContextPtr ctx) {
 
 void NamingResolver::HandleInvoke(TnsContextPtr ctx) {
     NamingReply reply;
+    if (ctx->controller.ErrorCode() == ERROR_RPC_STREAMUNSUPPORTED && !ctx->noStream) {
+        //A server predating the streams, failed before anything was sent. Asked again for the whole list at once.
+        ctx->noStream = true;
+        Invoke(ctx);
+        return;
+    }
     if (ctx->controller.Failed()) {
         CacheAddr("");
         if (ctx->retryCount < kMaxRetryCount) {
@@ -211,7 +254,11 @@ void NamingResolver::HandleInvoke(TnsContextPtr ctx) {
     }
     case KEYS_RES: {
         reply.type = NamingReplyType::KEYS;
+        reply.keys = std::move(ctx->keys);
         auto& keys_res = ctx->response.keys_res();
+        reply.digest = keys_res.digest();
+        //A server without digests always lists the keys and sends none back
+        reply.unchanged = keys_res.has_digest() && keys_res.digest() == ctx->request.keys_req().digest();
         for (int i = 0; i < keys_res.keys_size(); ++i) {
             auto& key = keys_res.keys(i);
             reply.keys.push_back(key);
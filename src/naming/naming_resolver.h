@@ -7,7 +7,7 @@
 #include <vector>
 #include <unordered_map>
 #include "net/event_loop.h"
-#include "rpc/rpc_channel.h"
+#include "rpc/rpc_channel_pool.h"
 #include "rpc/rpc_controller.h"
 #include "naming.pb.h"
 
@@ -24,6 +24,8 @@ struct NamingReply {
     int err{ 0 };
     std::string value;
     std::vector<std::string> keys;
+    uint64_t digest{ 0 }; ///< KEYS, digest of the keys listed
+    bool unchanged{ false }; ///< KEYS, the keys are those of the digest passed, none was sent
 };
 
 //TinyNet naming service client
@@ -34,6 +36,8 @@ class NamingResolver {
   public:
     void Init(const std::vector<std::string> &addrs);
     void Stop();
+    //Set before Init(), the key lists of the naming service are large
+    void set_compress_threshold(size_t threshold) { compress_threshold_ = threshold; }
   private:
     using StubPtr = std::shared_ptr<NamingRpcService_Stub>;
 
@@ -52,7 +56,15 @@ class NamingResolver {
 
     int Delete(const std::string &name, NamingCallback callback);
 
-    int Keys(const std::string& name, NamingCallback callback);
+    /**
+     * @brief Lists the keys starting with name
+     *
+     * @param name
+     * @param callback
+     * @param digest of the keys listed last time, the reply is unchanged and carries no key while it matches. 0 always lists.
+     * @return int
+     */
+    int Keys(const std::string& name, NamingCallback callback, uint64_t digest = 0);
   private:
     struct TnsContext {
         naming::ClientRequest request;
@@ -61,9 +73,11 @@ class NamingResolver {
         size_t retryCount{ 0 };
         size_t redirectCount{ 0 };
         NamingCallback callback;
+        std::vector<std::string> keys; ///< Listed so far on the stream of a KEYS_REQ
+        bool noStream{ false }; ///< The server takes no stream, the keys come in the response
     };
     using TnsContextPtr = std::shared_ptr<TnsContext>;
-    rpc::RpcChannelPtr CreateChannel(const std::string& ip, int port);
+    rpc::RpcChannelPoolPtr CreateChannel(const std::string& ip, int port);
 
     int Invoke(TnsContextPtr ctx);
     void HandleInvoke(TnsContextPtr ctx);
@@ -71,8 +85,9 @@ class NamingResolver {
     EventLoop * event_loop_;
     std::vector<std::string> addrs_;
     std::string cached_addr_;
-    std::vector<rpc::RpcChannelPtr> channels_;
+    std::vector<rpc::RpcChannelPoolPtr> channels_;
     std::unordered_map<std::string, StubPtr> stubs_;
+    size_t compress_threshold_{ 0 };
 };
 }
 }
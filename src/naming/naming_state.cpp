@@ -9,6 +9,7 @@
 #include "naming.pb.h"
 #include "base/error_code.h"
 #include "rpc/rpc_helper.h"
+#include "rpc/rpc_controller.h"
 #include "util/string_utils.h"
 
 #define TRACE_LOG(fmt, ...) node_->Trace(__FILE__, __LINE__, fmt, ##__VA_ARGS__)
@@ -16,6 +17,48 @@
 namespace tinynet {
 namespace naming {
 
+static const size_t kKeysBatchCount = 1000;
+
+//FNV-1a over the keys in the order listed, the same on every node for the same keys
+static uint64_t DigestKeys(const std::vector<std::string>& keys) {
+    uint64_t digest = 14695981039346656037ULL;
+    for (auto& key : keys) {
+        for (unsigned char c : key) {
+            digest = (digest ^ c) * 1099511628211ULL;
+        }
+        //Tells {"ab"} from {"a", "b"}
+        digest = (digest ^ 0xff) * 1099511628211ULL;
+    }
+    return digest;
+}
+
+namespace {
+//Keys listed for a stream, written as the client grants credit
+struct KeysStream {
+    std::vector<std::string> keys;
+    size_t next{ 0 };
+    ::google::protobuf::Closure* done{ nullptr };
+};
+
+void WriteKeys(rpc::RpcStream* stream, KeysStream* state) {
+    ClientKeysRes batch;
+    while (state->next < state->keys.size() && stream->is_writable()) {
+        batch.Clear();
+        size_t end = (std::min)(state->next + kKeysBatchCount, state->keys.size());
+        for (; state->next < end; ++state->next) {
+            batch.add_keys(std::move(state->keys[state->next]));
+        }
+        stream->Write(batch);
+    }
+    if (state->next >= state->keys.size() && state->done) {
+        //The response follows the last batch
+        stream->Close();
+        rpc::ClosureGuard guard(state->done);
+        state->done = nullptr;
+    }
+}
+}
+
 NamingState::NamingState(raft::RaftService* raft_service):
     raft_(raft_service) {
 }
@@ -193,7 +236,31 @@ void NamingState::Keys(::google::protobuf::RpcController* controller, const ::ti
 
     std::vector<std::string> output;
     db_.keys(key_prefix, &output, node_->Time());
+    uint64_t digest = DigestKeys(output);
+    response->mutable_keys_res()->set_digest(digest);
+    if (request->keys_req().digest() == digest) {
+        //The client holds these keys already
+        output.clear();
+    }
 
+    auto stream = static_cast<rpc::RpcController*>(controller)->AcceptStream();
+    if (stream) {
+        //Sent in batches, the response only tells the list is complete
+        auto state = std::make_shared<KeysStream>();
+        state->keys = std::move(output);
+        state->done = done;
+        guard.callback = nullptr;
+        rpc::RpcStream* s = stream.get();
+        stream->set_writable_callback([s, state] { WriteKeys(s, state.get()); });
+        stream->set_close_callback([state](int err) {
+            if (err != ERROR_OK && state->done) {
+                rpc::ClosureGuard guard(state->done);
+                state->done = nullptr;
+            }
+        });
+        WriteKeys(s, state.get());
+        return;
+    }
     auto key_res = response->mutable_keys_res();
     for (auto key: output) {
         key_res->add_keys(key);
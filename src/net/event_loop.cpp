@@ -1,27 +1,43 @@
 // Copyright (C), Xianfeng Shang.  All rights reserved.
 // Author: Xianfeng Shang (shangxianfeng@outlook.com)
 #include "event_loop.h"
+#include "socket.h"
 #include "base/unique_id.h"
+#include "base/clock.h"
 #include "logging/logging.h"
 #include "util/net_utils.h"
 #include "util/process_utils.h"
+#ifdef __linux__
+#include <unistd.h>
+#include <sys/eventfd.h>
+#endif
 namespace tinynet {
 
 EventLoop::EventLoop():
+    buffer_pool_(opts_.buffer_pool_limit),
     delete_id_alloc_(true),
     stop_(0),
+    parked_(false),
+    wakeup_pending_(false),
+    wakeups_(0),
     time_(STime_ms()),
     thread_id_(ProcessUtils::get_tid()) {
     wakeup_fds[0] = -1;
     wakeup_fds[1] = -1;
 }
 
+EventLoop::EventLoop(const EventLoopOptions& opts) :
+    EventLoop() {
+    opts_ = opts;
+    buffer_pool_.set_limit(opts_.buffer_pool_limit);
+}
+
 EventLoop::~EventLoop() {
     if (!delete_id_alloc_) id_alloc_.release();
 }
 
 int EventLoop::Init() {
-    timer_.reset(new(std::nothrow) TimerManager(this));
+    timer_.reset(new(std::nothrow) TimerManager(this, opts_.timer_backend));
     if (!timer_) return 1;
     timer_->Init();
 
@@ -33,8 +49,14 @@ int EventLoop::Init() {
     if (!task_) return 1;
     task_->Init();
 
-#ifdef _WIN32
+    read_spill_.reset(new(std::nothrow) char[READ_SPILL_SIZE]);
+    if (!read_spill_) return 1;
+
+#if defined(_WIN32)
     int ret = NetUtils::SocketPair(AF_INET, SOCK_STREAM, 0, wakeup_fds);
+#elif defined(__linux__)
+    int ret = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    wakeup_fds[0] = wakeup_fds[1] = ret;
 #else
     int ret = NetUtils::SocketPair(AF_UNIX, SOCK_STREAM, 0, wakeup_fds);
 #endif
@@ -58,7 +80,7 @@ int64_t EventLoop::NewUniqueId() {
 }
 
 void EventLoop::Stop() {
-    if (wakeup_fds[0] != -1)
+    if (wakeup_fds[0] != -1 && wakeup_fds[0] != wakeup_fds[1])
         NetUtils::Close(wakeup_fds[0]);
     if (wakeup_fds[1] != -1) {
         poller_->Del(wakeup_fds[1], net::EVENT_READABLE);
@@ -68,6 +90,7 @@ void EventLoop::Stop() {
     timer_->Stop();
     poller_->Stop();
     task_->Stop();
+    dirty_.clear();
 }
 
 TimerId EventLoop::AddTimer(uint64_t timeout, uint64_t repeat, TimerCallback callback) {
@@ -80,14 +103,28 @@ void EventLoop::ClearTimer(TimerId& timerId) {
 
 int EventLoop::Run(int mode /* = RUN_FOREVER */) noexcept {
     if (mode == RUN_FOREVER)
-        thread_id_ = ProcessUtils::get_tid();
+        thread_id_.store(ProcessUtils::get_tid(), std::memory_order_relaxed);
     while (!stop_) {
         time_ = STime_ms();
-        int timeout_ms = mode == RUN_NOWAIT ? 0 : GetBackendTimeout();
-        poller_->Poll(timeout_ms);
-        time_ = STime_ms();
-        timer_->Run();
-        task_->Run();
+        int timeout_ms = 0;
+        if (mode != RUN_NOWAIT) {
+            //Publish parking before checking the queues, pairs with the fence in Wakeup()
+            parked_.store(true, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            timeout_ms = GetBackendTimeout();
+            if (timeout_ms == 0) parked_.store(false, std::memory_order_relaxed);
+        }
+        int64_t poll_start = STime_us();
+        int nevents = poller_->Poll(timeout_ms);
+        parked_.store(false, std::memory_order_relaxed);
+        int64_t timer_start = STime_us();
+        time_ = timer_start / 1000;
+        int ntimers = timer_->Run(opts_.timer_budget_us > 0 ? timer_start + opts_.timer_budget_us : 0);
+        int64_t task_start = STime_us();
+        int ntasks = task_->Run(opts_.task_budget_us > 0 ? task_start + opts_.task_budget_us : 0);
+        if (!dirty_.empty()) FlushDirty();
+        int64_t task_end = STime_us();
+        UpdateStats(nevents, ntimers, ntasks, poll_start, timer_start, task_start, task_end);
         if (mode != RUN_FOREVER) break;
     }
     return 0;
@@ -97,13 +134,21 @@ int EventLoop::AddEvent(int fd, int mask, net::EventCallback callback) {
     return poller_->Add(fd, mask, callback);
 }
 
+int EventLoop::AddEvent(int fd, int mask) {
+    return poller_->Add(fd, mask);
+}
+
 void EventLoop::ClearEvent(int fd, int mask) {
     poller_->Del(fd, mask);
 }
 
+void EventLoop::ReplayEvent(int fd, int mask) {
+    poller_->Replay(fd, mask);
+}
+
 TaskId EventLoop::AddTask(TaskFunc task_func) {
     auto taskId = task_->AddTask(task_func);
-    if (thread_id_ != ProcessUtils::get_tid())
+    if (thread_id() != ProcessUtils::get_tid())
         Wakeup();
     return taskId;
 }
@@ -123,18 +168,29 @@ void EventLoop::ClearSignal(int signum, TaskId& sigtid) {
 void EventLoop::Signal(int signum) {
     task_->Signal(signum);
 
-    if (thread_id_ != ProcessUtils::get_tid())
+    if (thread_id() != ProcessUtils::get_tid())
         Wakeup();
 }
 
-void EventLoop::Wakeup() {
+void EventLoop::Wakeup(bool force) {
     if (wakeup_fds[0] == -1) return;
+    //Only a loop blocked in the poller needs a wakeup, and one pending wakeup is enough
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (!force && !parked_.load(std::memory_order_relaxed)) return;
+    if (wakeup_pending_.exchange(true)) return;
+    wakeups_.fetch_add(1, std::memory_order_relaxed);
+#ifdef __linux__
+    uint64_t one = 1;
+    NetUtils::Write(wakeup_fds[0], &one, sizeof(one));
+#else
     char buf[1] = { 0 };
     NetUtils::Write(wakeup_fds[0], buf, sizeof(buf));
+#endif
 }
 
 int EventLoop::GetBackendTimeout() {
-    if (!task_->Empty()) return 0;
+    //Sockets dirtied again while flushing are flushed in the next iteration, without waiting
+    if (!task_->Empty() || !dirty_.empty()) return 0;
     int timeout = timer_->NearestTimeout();
     if (timeout < 0) {
         return MAX_BACKEND_TIMEOUT;
@@ -145,12 +201,54 @@ int EventLoop::GetBackendTimeout() {
     }
 }
 
+void EventLoop::AddDirty(std::weak_ptr<net::Socket> sock) {
+    dirty_.push_back(std::move(sock));
+}
+
+void EventLoop::CountCorkFlush(int nwrites) {
+    ++stats_.cork_flushes;
+    if (nwrites > 1) stats_.saved_writes += nwrites - 1;
+}
+
+void EventLoop::FlushDirty() {
+    //Flushing may write more data and mark sockets dirty again, they wait for the next iteration
+    std::vector<std::weak_ptr<net::Socket>> dirty;
+    dirty.swap(dirty_);
+    for (auto& weak_sock : dirty) {
+        if (auto sock = weak_sock.lock()) {
+            sock->Uncork();
+        }
+    }
+}
+
+void EventLoop::UpdateStats(int nevents, int ntimers, int ntasks,
+                            int64_t poll_start, int64_t timer_start, int64_t task_start, int64_t task_end) {
+    stats_.last_events = nevents;
+    stats_.last_timers = ntimers;
+    stats_.last_tasks = ntasks;
+    stats_.last_poll_us = poller_->last_wait_us();
+    stats_.last_io_us = (timer_start - poll_start) - stats_.last_poll_us;
+    stats_.last_timer_us = task_start - timer_start;
+    stats_.last_task_us = task_end - task_start;
+
+    ++stats_.loops;
+    stats_.events += nevents;
+    stats_.timers += ntimers;
+    stats_.tasks += ntasks;
+    stats_.wakeups = wakeups_.load(std::memory_order_relaxed);
+    stats_.poll_us += stats_.last_poll_us;
+    stats_.io_us += stats_.last_io_us;
+    stats_.timer_us += stats_.last_timer_us;
+    stats_.task_us += stats_.last_task_us;
+}
+
 void EventLoop::OnWakeup() {
     char buf[16];
     for (;;) {
         int nread = NetUtils::Read(wakeup_fds[1], buf, sizeof(buf));
         if (nread < (int)sizeof(buf)) break;
     }
-    poller_->Add(wakeup_fds[1], net::EVENT_READABLE, std::bind(&EventLoop::OnWakeup, this));
+    wakeup_pending_.store(false);
+    poller_->Add(wakeup_fds[1], net::EVENT_READABLE);
 }
 }
@@ -5,16 +5,61 @@
 #include <string>
 #include <atomic>
 #include <functional>
+#include <vector>
 #include "base/id_allocator.h"
+#include "base/buffer_pool.h"
 #include "base/net_types.h"
 #include "timer_manager.h"
 #include "poller.h"
 #include "task_manager.h"
 #include "ssl_context.h"
 namespace tinynet {
+namespace net {
+class Socket;
+}
+/**
+ * @brief Event loop options
+ *
+ */
+struct EventLoopOptions {
+    TimerBackend timer_backend{ TimerBackend::TB_SET }; ///< Timer storage engine
+    int max_poll_events{ net::Poller::MAX_POLL_EVENT }; ///< Upper bound of io events fetched by one poll
+    int timer_budget_us{ 5000 }; ///< Time budget for firing timers per iteration, 0 means unlimited
+    int task_budget_us{ 5000 }; ///< Time budget for executing tasks per iteration, 0 means unlimited
+    bool edge_once{ false }; ///< Register fds once for both directions with edge trigger, never re-arm (epoll only)
+    net::PollerBackend poller_backend{ net::PollerBackend::PB_DEFAULT }; ///< Io multiplexing backend
+    size_t buffer_pool_limit{ 32 * 1024 * 1024 }; ///< Bytes of free socket buffer blocks kept for reuse
+};
+
+/**
+ * @brief Event loop statistics, the last_* fields describe the latest iteration
+ *
+ */
+struct EventLoopStats {
+    uint64_t loops{ 0 }; ///< Iterations run
+    uint64_t events{ 0 }; ///< Io events dispatched
+    uint64_t timers{ 0 }; ///< Timers fired
+    uint64_t tasks{ 0 }; ///< Tasks executed
+    uint64_t wakeups{ 0 }; ///< Cross thread wakeups written
+    uint64_t cork_flushes{ 0 }; ///< Flushes of corked sockets
+    uint64_t saved_writes{ 0 }; ///< Write syscalls avoided by coalescing corked writes
+    int64_t poll_us{ 0 }; ///< Time spent waiting in the poller backend
+    int64_t io_us{ 0 }; ///< Time spent in io callbacks
+    int64_t timer_us{ 0 }; ///< Time spent in timer callbacks
+    int64_t task_us{ 0 }; ///< Time spent in tasks
+    int last_events{ 0 };
+    int last_timers{ 0 };
+    int last_tasks{ 0 };
+    int64_t last_poll_us{ 0 };
+    int64_t last_io_us{ 0 };
+    int64_t last_timer_us{ 0 };
+    int64_t last_task_us{ 0 };
+};
+
 class EventLoop {
   public:
     EventLoop();
+    explicit EventLoop(const EventLoopOptions& opts);
     ~EventLoop();
   public:
     enum RunMode {
@@ -23,6 +68,7 @@ class EventLoop {
         RUN_NOWAIT
     };
     static const int MAX_BACKEND_TIMEOUT = 100;
+    static const size_t READ_SPILL_SIZE = 65536;
 
     int Init();
     void Stop();
@@ -45,8 +91,12 @@ class EventLoop {
 
     int AddEvent(int fd, int events, net::EventCallback callback);
 
+    int AddEvent(int fd, int events);
+
     void ClearEvent(int fd, int mask);
 
+    void ReplayEvent(int fd, int mask);
+
     TaskId AddTask(TaskFunc task_func);
 
     void CancelTask(TaskId& taskId);
@@ -57,24 +107,58 @@ class EventLoop {
 
     void Signal(int signum);
 
-    void Wakeup();
+    /**
+     * @brief Wake the loop up from another thread
+     *
+     * @param force write the wakeup even if the loop is not parked yet, for Exit() which is only
+     * checked at the top of the iteration
+     */
+    void Wakeup(bool force = false);
+    /**
+     * @brief Queues a corked socket to be flushed once at the end of the current iteration
+     */
+    void AddDirty(std::weak_ptr<net::Socket> sock);
+    /**
+     * @brief Accounts a flush covering nwrites corked writes
+     */
+    void CountCorkFlush(int nwrites);
   public:
     TimerManager* get_timer() { return timer_.get(); }
     net::Poller* get_poller() { return poller_.get(); }
     TaskManager* get_task() { return task_.get(); }
-    int thread_id() { return thread_id_; }
+    int thread_id() { return thread_id_.load(std::memory_order_relaxed); }
+    IdAllocator* get_id_allocator() { return id_alloc_.get(); }
+    BufferPool* get_buffer_pool() { return &buffer_pool_; }
+    /**
+     * @brief Scratch area of READ_SPILL_SIZE bytes shared by the sockets of this loop, reads overflow there
+     * and only the bytes actually received are appended to the socket read buffer
+     */
+    char* get_read_spill() { return read_spill_.get(); }
+    const EventLoopOptions& get_options() const { return opts_; }
+    const EventLoopStats& get_stats() const { return stats_; }
   private:
     int GetBackendTimeout();
+    void UpdateStats(int nevents, int ntimers, int ntasks,
+                     int64_t poll_start, int64_t timer_start, int64_t task_start, int64_t task_end);
     void OnWakeup();
+    void FlushDirty();
   private:
+    EventLoopOptions opts_;
+    EventLoopStats  stats_;
+    BufferPool      buffer_pool_; ///< Declared first among the owners so it outlives every buffer
     std::unique_ptr<TimerManager> timer_;
     std::unique_ptr<net::Poller>  poller_;
     std::unique_ptr<TaskManager>  task_;
     std::unique_ptr<IdAllocator>  id_alloc_;
+    std::unique_ptr<char[]>       read_spill_;
     bool			delete_id_alloc_;
     std::atomic_int	stop_;
+    std::atomic_bool parked_;	///< The loop may be blocked in the poller
+    std::atomic_bool wakeup_pending_;	///< A wakeup was written and not yet consumed
+    std::atomic<uint64_t> wakeups_;
     int64_t         time_;
+    std::vector<std::weak_ptr<net::Socket>> dirty_; ///< Corked sockets waiting for the end of iteration flush
     int				wakeup_fds[2];
-    int				thread_id_;
+    std::atomic_int	thread_id_; ///< Set by Run() on the loop thread, read by producers on others
 };
 }
@@ -23,6 +23,10 @@ FileDescriptor::~FileDescriptor() {
 }
 
 int FileDescriptor::AddEvent(int mask) {
+    //Re-arming a registered fd keeps its handler, no need to bind a new one
+    if (event_loop_->get_poller()->GetEvents(fd_) != EVENT_NONE) {
+        return event_loop_->AddEvent(fd_, mask);
+    }
     return event_loop_->AddEvent(fd_, mask, std::bind(handle_event, weak_from_this(), std::placeholders::_1, std::placeholders::_2));
 }
 
@@ -0,0 +1,460 @@
+// Copyright (C), Xianfeng Shang.  All rights reserved.
+// Author: Xianfeng Shang (shangxianfeng@outlook.com)
+#include "hot_upgrade.h"
+#include <algorithm>
+#include <cstring>
+#include <iterator>
+#include "socket_server.h"
+#include "event_loop.h"
+#include "base/error_code.h"
+#include "logging/logging.h"
+#include "util/net_utils.h"
+#include "util/fs_utils.h"
+#ifndef _WIN32
+#include <fcntl.h>
+#include <errno.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+#endif
+
+namespace tinynet {
+namespace net {
+
+#ifndef _WIN32
+//Frame: body length, then the kind, the address family and the length prefixed strings
+static void PutString(std::string* out, const std::string& s) {
+    uint32_t len = (uint32_t)s.size();
+    out->append((const char*)&len, sizeof(len));
+    out->append(s);
+}
+
+static bool GetString(const char** p, const char* end, std::string* s) {
+    uint32_t len;
+    if ((size_t)(end - *p) < sizeof(len)) return false;
+    memcpy(&len, *p, sizeof(len));
+    *p += sizeof(len);
+    if ((size_t)(end - *p) < len) return false;
+    s->assign(*p, len);
+    *p += len;
+    return true;
+}
+
+static void EncodeSocket(const HandoffSocket& sock, std::string* frame) {
+    frame->assign(sizeof(uint32_t), '\0');
+    int32_t head[2] = { sock.kind, sock.af };
+    frame->append((const char*)head, sizeof(head));
+    PutString(frame, sock.server);
+    PutString(frame, sock.address);
+    PutString(frame, sock.state);
+    PutString(frame, sock.rdata);
+    PutString(frame, sock.wdata);
+    uint32_t len = (uint32_t)(frame->size() - sizeof(uint32_t));
+    memcpy(&(*frame)[0], &len, sizeof(len));
+}
+
+static bool DecodeSocket(const std::string& body, HandoffSocket* sock) {
+    const char* p = body.data();
+    const char* end = p + body.size();
+    int32_t head[2];
+    if (body.size() < sizeof(head)) return false;
+    memcpy(head, p, sizeof(head));
+    p += sizeof(head);
+    sock->kind = head[0];
+    sock->af = head[1];
+    return GetString(&p, end, &sock->server) &&
+           GetString(&p, end, &sock->address) &&
+           GetString(&p, end, &sock->state) &&
+           GetString(&p, end, &sock->rdata) &&
+           GetString(&p, end, &sock->wdata);
+}
+
+//The handoff is a short exchange done with blocking calls bounded by timeouts
+static int SetBlocking(int fd, int timeout_ms) {
+    int flags = fcntl(fd, F_GETFL, NULL);
+    if (flags < 0 || fcntl(fd, F_SETFL, flags & ~O_NONBLOCK) == -1) {
+        return ERROR_SOCKET_SETNONBLOCKING;
+    }
+    struct timeval tv;
+    tv.tv_sec = timeout_ms / 1000;
+    tv.tv_usec = (timeout_ms % 1000) * 1000;
+    setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+    return ERROR_OK;
+}
+
+//The descriptors handed over give full control of the servers, only the user running them may take them
+static bool IsSameUser(int s) {
+#ifdef SO_PEERCRED
+    struct ucred cred;
+    socklen_t len = sizeof(cred);
+    if (getsockopt(s, SOL_SOCKET, SO_PEERCRED, &cred, &len) != 0) {
+        return false;
+    }
+    return cred.uid == geteuid();
+#else
+    uid_t uid;
+    gid_t gid;
+    if (getpeereid(s, &uid, &gid) != 0) {
+        return false;
+    }
+    return uid == geteuid();
+#endif
+}
+
+//One sendmsg of what is left of a frame, *nsent is 0 when the socket is full
+static int SendFrame(int s, int fd, const char* data, size_t len, size_t* nsent) {
+    union {
+        char buf[CMSG_SPACE(sizeof(int))];
+        struct cmsghdr align;
+    } control;
+    struct iovec iov;
+    iov.iov_base = (void*)data;
+    iov.iov_len = len;
+    struct msghdr msg;
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    if (fd != -1) {
+        memset(&control, 0, sizeof(control));
+        msg.msg_control = control.buf;
+        msg.msg_controllen = sizeof(control.buf);
+        struct cmsghdr* cmsg = CMSG_FIRSTHDR(&msg);
+        cmsg->cmsg_level = SOL_SOCKET;
+        cmsg->cmsg_type = SCM_RIGHTS;
+        cmsg->cmsg_len = CMSG_LEN(sizeof(int));
+        memcpy(CMSG_DATA(cmsg), &fd, sizeof(int));
+    }
+    int flags = MSG_DONTWAIT;
+#ifdef MSG_NOSIGNAL
+    flags |= MSG_NOSIGNAL;
+#endif
+    *nsent = 0;
+    for (;;) {
+        ssize_t n = ::sendmsg(s, &msg, flags);
+        if (n >= 0) {
+            *nsent = (size_t)n;
+            return ERROR_OK;
+        }
+        if (errno == EINTR) continue;
+        if (errno == EAGAIN || errno == EWOULDBLOCK) return ERROR_OK;
+        return ERROR_SOCKET_WRITE;
+    }
+}
+
+static void CloseSockets(std::vector<HandoffSocket>* socks) {
+    for (auto& sock : *socks) {
+        NetUtils::Close(sock.fd);
+    }
+    socks->clear();
+}
+#endif
+
+HotUpgrade::HotUpgrade(EventLoop* loop):
+    FileDescriptor(loop, -1) {
+}
+
+HotUpgrade::~HotUpgrade() {
+    FinishHandoff(ERROR_SOCKET_CLOSEDBYSERVER);
+    for (auto& sock : inherited_) {
+        NetUtils::Close(sock.fd);
+    }
+}
+
+int HotUpgrade::Inherit(const std::string& path, int timeout_ms) {
+#ifdef _WIN32
+    return ERROR_OK;
+#else
+    if (!FileSystemUtils::exists(path)) {
+        return ERROR_OK;
+    }
+    int err = 0;
+    int s = NetUtils::ConnectUnix(path.c_str(), &err);
+    if (s == -1) {
+        //A socket file left by a process which is gone
+        log_info("HotUpgrade(%s) no process to take over", path.c_str());
+        return ERROR_OK;
+    }
+    if (!IsSameUser(s)) {
+        log_warning("HotUpgrade(%s) is served by a process of another user, not taken over", path.c_str());
+        NetUtils::Close(s);
+        return ERROR_OK;
+    }
+    std::vector<HandoffSocket> socks;
+    if ((err = SetBlocking(s, timeout_ms)) == ERROR_OK) {
+        for (;;) {
+            uint32_t len;
+            int fd, extra_fd;
+            if ((err = NetUtils::RecvFd(s, &fd, &len, sizeof(len))) != 0) {
+                break;
+            }
+            HandoffSocket sock;
+            sock.fd = fd;
+            std::string body(len, '\0');
+            if (len > 0 && (err = NetUtils::RecvFd(s, &extra_fd, &body[0], len)) == 0) {
+                NetUtils::Close(extra_fd);
+            }
+            if (err == ERROR_OK && !DecodeSocket(body, &sock)) {
+                err = ERROR_SOCKET_READ;
+            }
+            if (err != ERROR_OK) {
+                NetUtils::Close(sock.fd);
+                break;
+            }
+            if (sock.kind == HANDOFF_END) {
+                NetUtils::Close(sock.fd);
+                break;
+            }
+            if (sock.fd != -1) {
+                socks.emplace_back(std::move(sock));
+            }
+        }
+    }
+    if (err == ERROR_OK) {
+        //The old process stops serving the sockets once it reads the ack
+        char ack = 1;
+        err = NetUtils::SendFd(s, -1, &ack, sizeof(ack));
+    }
+    NetUtils::Close(s);
+    if (err != ERROR_OK) {
+        log_error("HotUpgrade(%s) taking over the sockets failed, err:%d, msg:%s",
+                  path.c_str(), err, tinynet_strerror(err));
+        CloseSockets(&socks);
+        return err;
+    }
+    log_info("HotUpgrade(%s) inherited %d sockets", path.c_str(), (int)socks.size());
+    for (auto& sock : socks) {
+        inherited_.emplace_back(std::move(sock));
+    }
+    return ERROR_OK;
+#endif
+}
+
+int HotUpgrade::Listen(const std::string& path) {
+#ifdef _WIN32
+    return ERROR_INVAL;
+#else
+    if (fd_ != -1) {
+        return ERROR_SERVER_STARTED;
+    }
+    //The socket file of the process taken over
+    FileSystemUtils::remove(path);
+    int err = 0;
+    fd_ = NetUtils::BindAndListenUnix(path.c_str(), 1, &err);
+    if (fd_ == -1) {
+        return err;
+    }
+    if (AddEvent(EVENT_READABLE) == -1) {
+        return ERROR_EVENTLOOP_REGISTER;
+    }
+    path_ = path;
+    return ERROR_OK;
+#endif
+}
+
+void HotUpgrade::Close() {
+    FinishHandoff(ERROR_SOCKET_CLOSEDBYSERVER);
+    for (auto& sock : inherited_) {
+        NetUtils::Close(sock.fd);
+    }
+    inherited_.clear();
+    //The socket file belongs to the next process by now, it is not removed
+    FileDescriptor::Close();
+}
+
+void HotUpgrade::AddServer(SocketServer* server) {
+    if (std::find(servers_.begin(), servers_.end(), server) == servers_.end()) {
+        servers_.push_back(server);
+    }
+}
+
+void HotUpgrade::RemoveServer(SocketServer* server) {
+    //The frames left may carry descriptors the server is about to close
+    FinishHandoff(ERROR_SOCKET_CLOSEDBYSERVER);
+    servers_.erase(std::remove(servers_.begin(), servers_.end(), server), servers_.end());
+}
+
+bool HotUpgrade::TakeListener(const std::string& server, HandoffSocket* sock) {
+    for (auto it = inherited_.begin(); it != inherited_.end(); ++it) {
+        if (it->kind == HANDOFF_LISTENER && it->server == server) {
+            *sock = std::move(*it);
+            inherited_.erase(it);
+            return true;
+        }
+    }
+    return false;
+}
+
+void HotUpgrade::TakeChannels(const std::string& server, std::vector<HandoffSocket>* socks) {
+    auto it = std::stable_partition(inherited_.begin(), inherited_.end(), [&server](const HandoffSocket & sock) {
+        return sock.kind != HANDOFF_CHANNEL || sock.server != server;
+    });
+    std::move(it, inherited_.end(), std::back_inserter(*socks));
+    inherited_.erase(it, inherited_.end());
+}
+
+void HotUpgrade::Readable() {
+#ifndef _WIN32
+    int err = 0;
+    for (;;) {
+        int s = NetUtils::Accept(fd_, nullptr, nullptr, &err);
+        if (s == -1) {
+            break;
+        }
+        if (peer_fd_ != -1) {
+            log_warning("HotUpgrade(%s) refused a process, a handoff is running", path_.c_str());
+            NetUtils::Close(s);
+            continue;
+        }
+        if (!IsSameUser(s)) {
+            log_warning("HotUpgrade(%s) refused a process of another user", path_.c_str());
+            NetUtils::Close(s);
+            continue;
+        }
+        Handoff(s);
+    }
+    if (err) {
+        log_warning("HotUpgrade(%s) accepting incoming connection error, err:%d, msg:%s",
+                    path_.c_str(), err, tinynet_strerror(err));
+    }
+    if (fd_ != -1 && AddEvent(EVENT_READABLE) == -1) {
+        SetError(ERROR_EVENTLOOP_REGISTER);
+    }
+#endif
+}
+
+void HotUpgrade::Handoff(int s) {
+#ifndef _WIN32
+    peer_fd_ = s;
+    if (NetUtils::SetNonBlocking(s) != 0) {
+        FinishHandoff(ERROR_SOCKET_SETNONBLOCKING);
+        return;
+    }
+    //Nothing is detached before the new process acknowledges, a failed handoff resumes the servers
+    std::vector<HandoffSocket> socks;
+    for (auto server : servers_) {
+        server->Export(&socks);
+    }
+    //Sockets inherited but never taken by a server are passed on as well
+    socks.insert(socks.end(), inherited_.begin(), inherited_.end());
+    HandoffSocket end;
+    end.kind = HANDOFF_END;
+    socks.push_back(end);
+    frames_.resize(socks.size());
+    for (size_t i = 0; i < socks.size(); ++i) {
+        frames_[i].first = socks[i].fd;
+        EncodeSocket(socks[i], &frames_[i].second);
+    }
+    frame_index_ = 0;
+    frame_offset_ = 0;
+    peer_timer_ = event_loop_->AddTimer(timeout_ms_, 0, [this]() {
+        peer_timer_ = INVALID_TIMER_ID;
+        log_warning("HotUpgrade(%s) handoff timed out after %d ms", path_.c_str(), timeout_ms_);
+        FinishHandoff(frame_index_ < frames_.size() ? ERROR_SOCKET_WRITE : ERROR_SOCKET_READ);
+    });
+    if (event_loop_->AddEvent(s, EVENT_READABLE | EVENT_WRITABLE,
+                              std::bind(&HotUpgrade::HandlePeer, this, std::placeholders::_2)) == -1) {
+        FinishHandoff(ERROR_EVENTLOOP_REGISTER);
+        return;
+    }
+    HandlePeer(EVENT_WRITABLE);
+#endif
+}
+
+void HotUpgrade::HandlePeer(int mask) {
+#ifndef _WIN32
+    if (peer_fd_ == -1) {
+        return;
+    }
+    if (frame_index_ < frames_.size()) {
+        bool done = false;
+        int err = SendFrames(&done);
+        if (err != ERROR_OK) {
+            FinishHandoff(err);
+            return;
+        }
+        if (!done) {
+            if (event_loop_->AddEvent(peer_fd_, EVENT_WRITABLE) == -1) {
+                FinishHandoff(ERROR_EVENTLOOP_REGISTER);
+            }
+            return;
+        }
+        event_loop_->ClearEvent(peer_fd_, EVENT_WRITABLE);
+    }
+    //The old process stops serving the sockets once it reads the ack
+    char ack;
+    ssize_t n;
+    do {
+        n = ::recv(peer_fd_, &ack, sizeof(ack), MSG_DONTWAIT);
+    } while (n == -1 && errno == EINTR);
+    if (n == 1) {
+        FinishHandoff(ERROR_OK);
+    } else if (n == 0) {
+        FinishHandoff(ERROR_SOCKET_CLOSEDBYPEER);
+    } else if (errno != EAGAIN && errno != EWOULDBLOCK) {
+        FinishHandoff(ERROR_SOCKET_READ);
+    } else if (event_loop_->AddEvent(peer_fd_, EVENT_READABLE) == -1) {
+        FinishHandoff(ERROR_EVENTLOOP_REGISTER);
+    }
+#endif
+}
+
+int HotUpgrade::SendFrames(bool* done) {
+#ifdef _WIN32
+    return ERROR_INVAL;
+#else
+    *done = false;
+    while (frame_index_ < frames_.size()) {
+        auto& frame = frames_[frame_index_];
+        size_t nsent = 0;
+        int fd = frame_offset_ == 0 ? frame.first : -1;
+        int err = SendFrame(peer_fd_, fd, frame.second.data() + frame_offset_,
+                            frame.second.size() - frame_offset_, &nsent);
+        if (err != ERROR_OK) {
+            return err;
+        }
+        if (nsent == 0) {
+            return ERROR_OK;
+        }
+        frame_offset_ += nsent;
+        if (frame_offset_ == frame.second.size()) {
+            ++frame_index_;
+            frame_offset_ = 0;
+        }
+    }
+    *done = true;
+    return ERROR_OK;
+#endif
+}
+
+void HotUpgrade::FinishHandoff(int err) {
+#ifndef _WIN32
+    if (peer_fd_ == -1) {
+        return;
+    }
+    if (peer_timer_ != INVALID_TIMER_ID) {
+        event_loop_->ClearTimer(peer_timer_);
+    }
+    event_loop_->ClearEvent(peer_fd_, EVENT_FULL_MASK);
+    NetUtils::Close(peer_fd_);
+    peer_fd_ = -1;
+    frames_.clear();
+    if (err != ERROR_OK) {
+        for (auto server : servers_) {
+            server->Restore();
+        }
+        log_error("HotUpgrade(%s) handing over the sockets failed, err:%d, msg:%s",
+                  path_.c_str(), err, tinynet_strerror(err));
+        return;
+    }
+    for (auto server : servers_) {
+        server->Detach();
+    }
+    CloseSockets(&inherited_);
+    log_info("HotUpgrade(%s) handed over the sockets to the new process", path_.c_str());
+    Close();
+    Invoke(upgrade_callback_);
+#endif
+}
+}
+}
@@ -0,0 +1,130 @@
+// Copyright (C), Xianfeng Shang.  All rights reserved.
+// Author: Xianfeng Shang (shangxianfeng@outlook.com)
+#pragma once
+#include <functional>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+#include "file_descriptor.h"
+
+namespace tinynet {
+namespace net {
+
+class SocketServer;
+
+/**
+ * @brief A socket handed from the process being upgraded to its successor
+ *
+ */
+struct HandoffSocket {
+    int kind{ 0 }; ///< HotUpgrade::HANDOFF_LISTENER or HotUpgrade::HANDOFF_CHANNEL
+    int fd{ -1 };
+    int af{ 0 }; ///< Address family
+    std::string server; ///< Name of the server owning the socket
+    std::string address; ///< Listen address of a listener, peer address of a channel
+    std::string state; ///< Protocol state of a channel, see SocketChannel::Export()
+    std::string rdata; ///< Received bytes the channel has not consumed yet
+    std::string wdata; ///< Queued bytes not sent yet
+};
+
+class HotUpgrade;
+typedef std::shared_ptr<HotUpgrade> HotUpgradePtr;
+
+//Zero downtime restart.
+//The running process listens on a unix domain socket, the new process connects to it before starting its servers
+//and receives the listening sockets and the established connections of the registered servers with SCM_RIGHTS.
+//The servers of the new process adopt the sockets with the same server name, the clients do not notice the restart.
+//Only a process of the same user is served. The running process sends without blocking its loop,
+//the connections handed over stay frozen until the new process acknowledges or the handoff times out.
+class HotUpgrade final:
+    public FileDescriptor {
+  public:
+    enum HandoffKind {
+        HANDOFF_END = 0,
+        HANDOFF_LISTENER = 1,
+        HANDOFF_CHANNEL = 2
+    };
+    typedef std::function<void()> UpgradeCallback;
+  public:
+    HotUpgrade(EventLoop* loop);
+    ~HotUpgrade();
+  public:
+    /**
+     * @brief Takes over the sockets of the process serving the handoff on path.
+     * Returns ERROR_OK without any socket when no process serves it.
+     *
+     * @param path
+     * @param timeout_ms
+     * @return int
+     */
+    int Inherit(const std::string& path, int timeout_ms);
+    /**
+     * @brief Serves the handoff to the next process on path
+     *
+     * @param path
+     * @return int
+     */
+    int Listen(const std::string& path);
+    /**
+     * @brief Closes the handoff socket, the sockets inherited but never taken are closed too
+     *
+     */
+    void Close() override;
+  public:
+    void AddServer(SocketServer* server);
+
+    void RemoveServer(SocketServer* server);
+    /**
+     * @brief Moves an inherited listening socket of the server into sock
+     *
+     * @param server
+     * @param sock
+     * @return true
+     * @return false
+     */
+    bool TakeListener(const std::string& server, HandoffSocket* sock);
+    /**
+     * @brief Moves the inherited connections of the server into socks
+     *
+     * @param server
+     * @param socks
+     */
+    void TakeChannels(const std::string& server, std::vector<HandoffSocket>* socks);
+
+    size_t get_inherited_size() const { return inherited_.size(); }
+    /**
+     * @brief Set the upgrade callback object, raised once the next process took the sockets
+     *
+     * @param cb
+     */
+    void set_upgrade_callback(UpgradeCallback cb) { upgrade_callback_ = std::move(cb); }
+  private:
+    void Readable() override;
+    /**
+     * @brief Exports the sockets of the servers and starts sending them to the process connected on s
+     *
+     * @param s
+     */
+    void Handoff(int s);
+    void HandlePeer(int mask);
+    /**
+     * @brief Sends what the peer socket takes of the frames left, returns ERROR_OK with *done false when it is full
+     *
+     */
+    int SendFrames(bool* done);
+    void FinishHandoff(int err);
+  private:
+    std::string path_;
+    int timeout_ms_{ 5000 }; ///< Time given to the whole handoff, send and acknowledgement
+    std::vector<SocketServer*> servers_;
+    std::vector<HandoffSocket> inherited_;
+    UpgradeCallback upgrade_callback_;
+    int peer_fd_{ -1 }; ///< Connection of the next process while a handoff runs
+    int64_t peer_timer_{ 0 }; ///< Fails the handoff running once timeout_ms_ elapsed
+    std::vector<std::pair<int, std::string> > frames_; ///< Descriptor and frame of each socket handed over
+    size_t frame_index_{ 0 }; ///< First frame not sent completely
+    size_t frame_offset_{ 0 }; ///< Bytes of that frame sent, its descriptor went with the first one
+};
+}
+}
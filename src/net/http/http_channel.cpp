@@ -1,6 +1,7 @@
 #include "http_channel.h"
 #include "http_codec.h"
 #include "http_server.h"
+#include "base/error_code.h"
 #include "util/string_utils.h"
 #include "util/uri_utils.h"
 namespace tinynet {
@@ -35,7 +36,7 @@ void HttpChannel::OnRead() {
 }
 
 bool HttpChannel::SendResponse(const HttpMessage& resp) {
-    if (socket_->is_closed()) {
+    if (socket_->is_closed() || !Admit(resp.body.size())) {
         return false;
     }
     codec_->Write(socket_, &resp);
@@ -43,13 +44,39 @@ bool HttpChannel::SendResponse(const HttpMessage& resp) {
 }
 
 bool HttpChannel::SendResponse(const ZeroCopyHttpMessage& resp) {
-    if (socket_->is_closed()) {
+    if (socket_->is_closed() || !Admit(resp.body.size())) {
         return false;
     }
     codec_->Write(socket_, &resp);
     return true;
 }
 
+void HttpChannel::OnHighWater() {
+    auto server = get_server<HttpServer>();
+    if (server) {
+        server->HandleEvent(get_guid(), server::HTTP_SESSION_EVENT_ON_HIGHWATER);
+    }
+}
+
+void HttpChannel::OnDrain() {
+    auto server = get_server<HttpServer>();
+    if (server) {
+        server->HandleEvent(get_guid(), server::HTTP_SESSION_EVENT_ON_DRAIN);
+    }
+}
+
+bool HttpChannel::Admit(size_t len) {
+    if (socket_->Admit(len)) {
+        return true;
+    }
+    //Responses pair with requests in order, a dropped one would leave the client waiting
+    //and shift every later response onto the wrong request, so the connection goes instead
+    if (!socket_->is_closed()) {
+        Close(ERROR_SOCKET_CLOSEDBYSERVER);
+    }
+    return false;
+}
+
 void HttpChannel::ParseAddress(const tinynet::http::HttpMessage& msg) {
     auto it = msg.headers.find("x-real-ip");
     if (it != msg.headers.end()) {
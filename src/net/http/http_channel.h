@@ -14,11 +14,14 @@ class HttpChannel :
     ~HttpChannel();
   public:
     void OnRead() override;
+    void OnHighWater() override;
+    void OnDrain() override;
   public:
     bool SendResponse(const HttpMessage& resp);
     bool SendResponse(const ZeroCopyHttpMessage& resp);
   private:
     void ParseAddress(const tinynet::http::HttpMessage& msg);
+    bool Admit(size_t len);
   private:
     std::unique_ptr<HttpCodec> codec_;
     std::string peer_ip_;
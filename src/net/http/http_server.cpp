@@ -44,5 +44,9 @@ bool HttpServer::SendResponse(const ZeroCopyHttpMessage& resp) {
 void HttpServer::HandleRequest(int64_t session_guid, const HttpMessage& request ) {
     Invoke(http_callback_, request);
 }
+
+void HttpServer::HandleEvent(int64_t session_guid, server::HttpSessionEventType type) {
+    Invoke(event_callback_, session_guid, type);
+}
 }
 }
@@ -13,6 +13,13 @@ namespace server {
 
 typedef std::function<void(const HttpMessage& req)> HttpCallback;
 
+enum HttpSessionEventType {
+    HTTP_SESSION_EVENT_ON_HIGHWATER = 1, ///< The pending responses of the session reached the high watermark
+    HTTP_SESSION_EVENT_ON_DRAIN = 2 ///< The pending responses fell back to the low watermark
+};
+
+typedef std::function<void(int64_t session_guid, HttpSessionEventType type)> HttpEventCallback;
+
 }
 
 class HttpServer :
@@ -25,12 +32,15 @@ class HttpServer :
     bool SendResponse(const HttpMessage& resp);
     bool SendResponse(const ZeroCopyHttpMessage& resp);
     void HandleRequest(int64_t session_guid, const HttpMessage& request);
+    void HandleEvent(int64_t session_guid, server::HttpSessionEventType type);
   public:
     void set_http_callback(server::HttpCallback cb) { http_callback_ = std::move(cb); }
+    void set_event_callback(server::HttpEventCallback cb) { event_callback_ = std::move(cb); }
   public:
     net::SocketChannelPtr CreateChannel(net::SocketPtr sock) override;
   private:
     server::HttpCallback http_callback_;
+    server::HttpEventCallback event_callback_;
 };
 }
 }
@@ -0,0 +1,53 @@
+// Copyright (C), Xianfeng Shang.  All rights reserved.
+// Author: Xianfeng Shang (shangxianfeng@outlook.com)
+#include "io_loop_group.h"
+#include "base/error_code.h"
+
+namespace tinynet {
+namespace net {
+
+IoLoopGroup::IoLoopGroup() :
+    next_(0) {
+}
+
+IoLoopGroup::~IoLoopGroup() {
+    Join();
+    for (auto& loop : loops_) {
+        loop->Stop();
+    }
+}
+
+int IoLoopGroup::Init(int nloops, EventLoop* parent) {
+    if (!loops_.empty()) return ERROR_SERVER_STARTED;
+    for (int i = 0; i < nloops; ++i) {
+        std::unique_ptr<EventLoop> loop(new(std::nothrow) EventLoop(parent->get_options()));
+        if (!loop) return ERROR_OS_OOM;
+        if (loop->Init() != 0) return ERROR_EVENTLOOP_REGISTER;
+        if (parent->get_id_allocator()) {
+            loop->SetIdAllocator(parent->get_id_allocator(), false);
+        }
+        loops_.push_back(std::move(loop));
+    }
+    return ERROR_OK;
+}
+
+void IoLoopGroup::Start() {
+    for (auto& loop : loops_) {
+        EventLoop* pLoop = loop.get();
+        threads_.emplace_back([pLoop]() { pLoop->Run(); });
+    }
+}
+
+void IoLoopGroup::Join() {
+    for (auto& loop : loops_) {
+        loop->Exit();
+        //The loop may be about to park without having seen the exit flag
+        loop->Wakeup(true);
+    }
+    for (auto& thread : threads_) {
+        if (thread.joinable()) thread.join();
+    }
+    threads_.clear();
+}
+}
+}
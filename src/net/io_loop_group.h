@@ -0,0 +1,53 @@
+// Copyright (C), Xianfeng Shang.  All rights reserved.
+// Author: Xianfeng Shang (shangxianfeng@outlook.com)
+#pragma once
+#include <memory>
+#include <thread>
+#include <vector>
+#include "event_loop.h"
+
+namespace tinynet {
+namespace net {
+/**
+ * @brief A group of event loops, each running on its own thread
+ *
+ */
+class IoLoopGroup {
+  public:
+    IoLoopGroup();
+    ~IoLoopGroup();
+  private:
+    IoLoopGroup(const IoLoopGroup&) = delete;
+    IoLoopGroup& operator = (const IoLoopGroup&) = delete;
+  public:
+    /**
+     * @brief Create and initialize the loops without running them
+     *
+     * @param nloops Number of loops
+     * @param parent Loop whose options and id allocator the io loops share
+     * @return int ERROR_OK on success
+     */
+    int Init(int nloops, EventLoop* parent);
+    /**
+     * @brief Run every loop on a new thread
+     *
+     */
+    void Start();
+    /**
+     * @brief Ask every loop to exit and wait for the threads, the loops stay initialized
+     *
+     */
+    void Join();
+  public:
+    size_t size() const { return loops_.size(); }
+
+    EventLoop* get_loop(size_t index) { return loops_[index].get(); }
+
+    EventLoop* Next() { return loops_[next_++ % loops_.size()].get(); }
+  private:
+    std::vector<std::unique_ptr<EventLoop>> loops_;
+    std::vector<std::thread> threads_;
+    size_t next_;
+};
+}
+}
@@ -68,5 +68,25 @@ int Listener::BindAndListen(const std::string &unix_path, int backlog) {
     UriUtils::format_address(listen_address_, "unix", unix_path, nullptr);
     return err;
 }
+
+int Listener::Attach(int fd, int af, const std::string &listen_address) {
+    int err;
+    af_ = af;
+    fd_ = fd;
+    listen_address_ = listen_address;
+    if ((err = NetUtils::SetNonBlocking(fd_)) != 0) {
+        return err;
+    }
+    if (AddEvent(EVENT_READABLE) == -1) {
+        err = ERROR_EVENTLOOP_REGISTER;
+        return err;
+    }
+    if (af_ == AF_INET || af_ == AF_INET6) {
+        NetUtils::GetSockName(fd_, nullptr, &listen_port_);
+    } else {
+        flag_ |= FD_FLAGS_LISTEN_FD;
+    }
+    return err;
+}
 }
 }
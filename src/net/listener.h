@@ -27,11 +27,15 @@ class Listener:
     int BindAndListen(const std::string &ip, int port, int backlog, int flags);
     //Unix domain socket server bind and listen
     int BindAndListen(const std::string &unix_path, int backlog);
+    //Serves a socket already listening on listen_address, e.g. one handed over by the process being upgraded
+    int Attach(int fd, int af, const std::string &listen_address);
   public:
     const std::string& get_listen_address() const { return listen_address_; }
 
     int get_listen_port() const { return listen_port_; }
 
+    int get_af() const { return af_; }
+
     void set_conn_callback(ConnectionCallback cb) { conn_callback_ = std::move(cb); }
   protected:
     std::string		   listen_address_;
@@ -5,10 +5,15 @@
 #include "socket.h"
 #include "event_loop.h"
 #include "base/error_code.h"
+#include "base/clock.h"
+#include "logging/logging.h"
+#include <algorithm>
+#include <string.h>
 #if defined(_WIN32)
 #include "poller_iocp.h"
 #elif defined(__linux__)
 #include "poller_epoll.h"
+#include "poller_io_uring.h"
 #elif defined(__FreeBSD__)
 #include "poller_kqueue.h"
 #else
@@ -22,7 +27,12 @@ Poller::Poller(tinynet::EventLoop* loop):
 #if defined(_WIN32)
     pImpl = new(std::nothrow) PollerIocp(loop);
 #elif defined(__linux__)
-    pImpl = new(std::nothrow) PollerEpoll(loop);
+#ifdef HAS_IO_URING
+    if (loop->get_options().poller_backend == PollerBackend::PB_IO_URING) {
+        pImpl = new(std::nothrow) PollerIoUring(loop);
+    }
+#endif
+    if (!pImpl) pImpl = new(std::nothrow) PollerEpoll(loop);
 #elif defined(__FreeBSD__)
     pImpl = new(std::nothrow) PollerKqueue(loop);
 #else
@@ -34,7 +44,19 @@ Poller::Poller(tinynet::EventLoop* loop):
 Poller::~Poller() = default;
 
 void Poller::Init() {
-    impl_->Init();
+    int max_events = event_loop_->get_options().max_poll_events;
+    if (max_events > 0) max_poll_events_ = max_events;
+    poll_events_.resize((std::min)(max_poll_events_, (int)INIT_POLL_EVENT));
+    edge_once_ = event_loop_->get_options().edge_once;
+    if (!impl_->Init()) {
+#ifdef __linux__
+        if (strcmp(impl_->name(), "epoll") != 0) {
+            log_warning("Poller backend %s is not available, fall back to epoll", impl_->name());
+            impl_.reset(new(std::nothrow) PollerEpoll(event_loop_));
+            impl_->Init();
+        }
+#endif
+    }
 }
 
 void Poller::Stop() {
@@ -46,51 +68,141 @@ const char* Poller::name() {
 }
 
 int Poller::Poll(int timeout_ms) {
-    int nevents = impl_->Poll(&poll_events_[0], MAX_POLL_EVENT, timeout_ms);
+    if (!rearmed_.empty()) timeout_ms = 0;
+    int maxevents = (int)poll_events_.size();
+    int64_t wait_start = STime_us();
+    int nevents = impl_->Poll(&poll_events_[0], maxevents, timeout_ms);
+    last_wait_us_ = STime_us() - wait_start;
+    int ndispatched = 0;
     for (int i = 0; i < nevents; ++i) {
-        int fd = poll_events_[i].fd;
-        int mask = poll_events_[i].mask;
-        auto it = events_.find(fd);
-        if (it != events_.end()) {
-            Invoke(it->second.callback, fd, mask);
+        poll_event& pe = poll_events_[i];
+        fd_event* ev = pe.ud ? static_cast<fd_event*>(pe.ud) : GetSlot(pe.fd, false);
+        if (ev) {
+            //Dispatched now, a replay of the same direction would run the handler twice this iteration
+            ev->rearm &= ~(pe.mask & ev->mask);
+        }
+        ndispatched += Dispatch(ev, pe.mask);
+    }
+    //A full batch means more events are likely pending, grow the batch for the next poll
+    if (nevents == maxevents && maxevents < max_poll_events_) {
+        poll_events_.resize((std::min)(maxevents * 2, max_poll_events_));
+    }
+    if (!rearmed_.empty()) {
+        std::vector<int> rearmed;
+        rearmed.swap(rearmed_);
+        for (auto fd : rearmed) {
+            fd_event* ev = GetSlot(fd, false);
+            if (!ev) continue;
+            int mask = ev->rearm;
+            ev->rearm = EVENT_NONE;
+            if (mask == EVENT_NONE) continue;
+            ndispatched += Dispatch(ev, mask);
         }
     }
+    return ndispatched;
+}
+
+int Poller::Dispatch(fd_event* ev, int mask) {
+    if (!ev || ev->mask == EVENT_NONE) return 0;
+    if (edge_once_) {
+        //The fd stays registered for both directions, so remember edges nobody is waiting for
+        ev->ready |= mask & ~ev->mask & (EVENT_READABLE | EVENT_WRITABLE);
+        mask &= ev->mask | EVENT_ERROR;
+        if (mask == EVENT_NONE) return 0;
+    }
+    dispatching_ = ev;
+    Invoke(ev->callback, ev->fd, mask);
+    dispatching_ = nullptr;
+    if (ev->mask == EVENT_NONE) {
+        //Deleted by its own callback, release what it captured now that it returned
+        ev->callback = nullptr;
+    }
+    return 1;
+}
+
+Poller::fd_event* Poller::GetSlot(int fd, bool create) {
+    if (fd < 0) return nullptr;
+    size_t page = (size_t)fd >> FD_PAGE_BITS;
+    if (page >= fd_pages_.size()) {
+        if (!create) return nullptr;
+        fd_pages_.resize(page + 1);
+    }
+    if (!fd_pages_[page]) {
+        if (!create) return nullptr;
+        fd_pages_[page].reset(new(std::nothrow) FD_EVENT_PAGE());
+        if (!fd_pages_[page]) return nullptr;
+    }
+    return &(*fd_pages_[page])[fd & (FD_PAGE_SIZE - 1)];
+}
+
+int Poller::AddSlot(fd_event* ev, int fd, int mask) {
+    if (impl_->Add(fd, ev->mask, mask, ev) != 0) {
+        return -1;
+    }
+    if (edge_once_ && (ev->ready & mask)) {
+        //The edge was consumed before anyone subscribed it, replay it on the next poll
+        if (ev->rearm == EVENT_NONE) rearmed_.push_back(fd);
+        ev->rearm |= ev->ready & mask;
+        ev->ready &= ~mask;
+    }
+    ev->mask |= mask;
     return 0;
 }
 
 int Poller::Add(int fd, int mask, EventCallback callback) {
-    if (impl_->Add(fd, mask) != 0) {
+    fd_event* ev = GetSlot(fd, true);
+    if (!ev) return -1;
+    bool fresh = ev->mask == EVENT_NONE;
+    if (AddSlot(ev, fd, mask) != 0) {
         return -1;
     }
-    auto& ev = events_[fd];
-    ev.mask |= mask;
-    ev.callback = std::move(callback);
+    ev->fd = fd;
+    if (fresh || callback) {
+        ev->callback = std::move(callback);
+    }
     return 0;
 }
 
+int Poller::Add(int fd, int mask) {
+    fd_event* ev = GetSlot(fd, false);
+    if (!ev || ev->mask == EVENT_NONE) return -1;
+    return AddSlot(ev, fd, mask);
+}
+
 int Poller::Del(int fd, int mask) {
-    auto it = events_.find(fd);
-    if (it == events_.end()) {
+    fd_event* ev = GetSlot(fd, false);
+    if (!ev || ev->mask == EVENT_NONE) {
         return -1;
     }
-    impl_->Del(fd, mask);
+    impl_->Del(fd, ev->mask, mask, ev);
 
-    auto& ev = it->second;
+    ev->mask &= ~mask;
 
-    ev.mask &= ~mask;
-
-    if (ev.mask == EVENT_NONE) {
-        events_.erase(it);
+    if (ev->mask == EVENT_NONE) {
+        ev->ready = EVENT_NONE;
+        ev->rearm = EVENT_NONE;
+        //The callback running now is released by Dispatch() once it returns
+        if (ev != dispatching_) {
+            ev->callback = nullptr;
+        }
     }
     return 0;
 }
 
+int Poller::Replay(int fd, int mask) {
+    fd_event* ev = GetSlot(fd, false);
+    if (!ev || ev->mask == EVENT_NONE) return -1;
+    if (ev->rearm == EVENT_NONE) rearmed_.push_back(fd);
+    ev->rearm |= mask;
+    return 0;
+}
+
 int Poller::GetEvents(int fd) {
-    auto it = events_.find(fd);
-    if (it == events_.end()) {
+    fd_event* ev = GetSlot(fd, false);
+    if (!ev) {
         return EVENT_NONE;
     }
-    return it->second.mask;
+    return ev->mask;
 }
 
 }
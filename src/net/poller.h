@@ -6,7 +6,6 @@
 #include <memory>
 #include <vector>
 #include <array>
-#include <unordered_map>
 #include <functional>
 #include "base/string_view.h"
 
@@ -17,9 +16,19 @@ class PollerImpl;
 
 typedef std::function<void(int fd, int mask)> EventCallback;
 
+/**
+ * @brief Poller backends selectable at runtime
+ *
+ */
+enum class PollerBackend {
+    PB_DEFAULT = 0, ///< epoll, kqueue, iocp or select, chosen at compile time
+    PB_IO_URING = 1 ///< io_uring readiness polls on Linux (>= 5.13), reads and writes stay syscalls. Falls back to epoll when unavailable
+};
+
 struct poll_event {
     int fd{ -1 };
     int mask{ 0 };
+    void* ud{ nullptr }; ///< Dispatch slot registered with the backend, if the backend carries it
 };
 
 class Poller {
@@ -33,25 +42,63 @@ class Poller {
 
     const char* name();
 
+    /**
+     * @brief Wait for io events and dispatch them
+     *
+     * @param timeout_ms Maximum time to wait for events
+     * @return int The number of events dispatched
+     */
     int Poll(int timeout_ms);
 
     int Add(int fd, int mask, EventCallback callback);
 
+    /**
+     * @brief Subscribe more events on a registered fd, keeping its callback
+     *
+     * @return int 0 on success, -1 if the fd is not registered or the backend fails
+     */
+    int Add(int fd, int mask);
+
     int Del(int fd, int mask);
 
+    /**
+     * @brief Dispatch mask to a registered fd again after the next poll, regardless of the backend readiness
+     *
+     * @return int 0 on success, -1 if the fd is not registered
+     */
+    int Replay(int fd, int mask);
+
     int GetEvents(int fd);
+
+    int64_t last_wait_us() const { return last_wait_us_; }
   private:
     struct fd_event {
+        int fd{ -1 };
         int mask{ 0 };
+        int ready{ 0 }; ///< Edges reported while the direction was not subscribed (edge once mode)
+        int rearm{ 0 }; ///< Edges to replay on the next poll (edge once mode)
         EventCallback callback;
     };
+    fd_event* GetSlot(int fd, bool create);
+    int AddSlot(fd_event* ev, int fd, int mask);
+    int Dispatch(fd_event* ev, int mask);
   public:
-    static const int MAX_POLL_EVENT = 16;
-    using POLL_EVENT_ARRAY = std::array<poll_event, MAX_POLL_EVENT>;
-    using FD_EVENT_MAP = std::unordered_map<int, fd_event>;
+    static const int INIT_POLL_EVENT = 64;
+    static const int MAX_POLL_EVENT = 4096;
+    static const int FD_PAGE_BITS = 10;
+    static const int FD_PAGE_SIZE = 1 << FD_PAGE_BITS;
+    using POLL_EVENT_VECTOR = std::vector<poll_event>;
+    //Slots are allocated in pages so their addresses stay valid for the backend
+    using FD_EVENT_PAGE = std::array<fd_event, FD_PAGE_SIZE>;
+    using FD_EVENT_PAGES = std::vector<std::unique_ptr<FD_EVENT_PAGE>>;
   private:
-    FD_EVENT_MAP events_;
-    POLL_EVENT_ARRAY  poll_events_;
+    FD_EVENT_PAGES fd_pages_;
+    std::vector<int> rearmed_;
+    fd_event* dispatching_{ nullptr }; ///< Slot whose callback is running
+    bool edge_once_{ false };
+    POLL_EVENT_VECTOR  poll_events_;
+    int max_poll_events_{ MAX_POLL_EVENT };
+    int64_t last_wait_us_{ 0 };
     std::unique_ptr<PollerImpl> impl_;
     EventLoop* event_loop_;
 };
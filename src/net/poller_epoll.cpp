@@ -12,10 +12,12 @@ namespace tinynet {
 namespace net {
 PollerEpoll::PollerEpoll(EventLoop* loop)
     :PollerImpl(loop),
-     efd_(-1) {
+     efd_(-1),
+     edge_once_(false) {
 }
 
 bool PollerEpoll::Init() {
+    edge_once_ = event_loop_->get_options().edge_once;
     efd_ = epoll_create(MAX_EPOLL_EVENTS);
     if (efd_ == -1) {
         return false;
@@ -35,7 +37,9 @@ const char* PollerEpoll::name() {
 }
 
 int PollerEpoll::Poll(poll_event* events, int maxevents, int timeout_ms) {
-    maxevents = (std::min)((int)MAX_EPOLL_EVENTS, maxevents);
+    if ((int)events_.size() < maxevents) {
+        events_.resize(maxevents);
+    }
     int res = epoll_wait(efd_, &events_[0], maxevents, timeout_ms);
     if (res <= 0) {
         return 0;
@@ -50,18 +54,22 @@ int PollerEpoll::Poll(poll_event* events, int maxevents, int timeout_ms) {
         if (event.events & EPOLLRDHUP) mask |= EVENT_READABLE;
         if (event.events & EPOLLHUP) mask |= EVENT_READABLE | EVENT_WRITABLE | EVENT_ERROR;
         if (event.events & EPOLLERR) mask |= EVENT_READABLE | EVENT_WRITABLE | EVENT_ERROR;
-        events[i].fd = event.data.fd;
+        events[i].ud = event.data.ptr;
         events[i].mask = mask;
     }
     return nevents;
 }
 
-int PollerEpoll::Add(int fd, int mask) {
+int PollerEpoll::Add(int fd, int old_mask, int mask, void* ud) {
     struct epoll_event event = { 0 };
     event.events = EPOLLET;
-    event.data.fd = fd;
-    int old_mask = event_loop_->get_poller()->GetEvents(fd);
+    event.data.ptr = ud;
     int op = old_mask == EVENT_NONE ? EPOLL_CTL_ADD : EPOLL_CTL_MOD;
+    if (edge_once_) {
+        //Registered once for both directions, nothing to re-arm
+        if (old_mask != EVENT_NONE) return 0;
+        mask = EVENT_READABLE | EVENT_WRITABLE;
+    }
     mask |= old_mask;
     if (mask & EVENT_READABLE) event.events |= (EPOLLIN | EPOLLRDHUP);
     if (mask & EVENT_WRITABLE) event.events |= EPOLLOUT;
@@ -72,12 +80,12 @@ int PollerEpoll::Add(int fd, int mask) {
     return err;
 }
 
-int PollerEpoll::Del(int fd, int mask) {
+int PollerEpoll::Del(int fd, int old_mask, int mask, void* ud) {
     struct epoll_event event = { 0 };
     event.events = EPOLLET;
-    event.data.fd = fd;
-    int old_mask = event_loop_->get_poller()->GetEvents(fd);
+    event.data.ptr = ud;
     int new_mask = old_mask & (~mask);
+    if (edge_once_ && new_mask != EVENT_NONE) return 0;
     if (new_mask & EVENT_READABLE) event.events |= (EPOLLIN | EPOLLRDHUP);
     if (new_mask & EVENT_WRITABLE) event.events |= EPOLLOUT;
     int op = new_mask == EVENT_NONE ? EPOLL_CTL_DEL : EPOLL_CTL_MOD;
@@ -3,7 +3,7 @@
 #pragma once
 #ifdef __linux__
 #include <string>
-#include <array>
+#include <vector>
 #include <sys/epoll.h>
 #include "poller_impl.h"
 
@@ -18,15 +18,16 @@ class PollerEpoll : public PollerImpl {
     virtual bool Init() override;
     virtual void Stop() override;
     virtual const char* name() override;
-    virtual int Add(int fd, int mask) override;
-    virtual int Del(int fd, int mask)  override;
+    virtual int Add(int fd, int old_mask, int mask, void* ud) override;
+    virtual int Del(int fd, int old_mask, int mask, void* ud)  override;
   public:
     int Poll(poll_event* events, int maxevents, int timeout_ms) override;
   private:
     const static size_t MAX_EPOLL_EVENTS = 1024;
   private:
-    std::array<struct epoll_event, MAX_EPOLL_EVENTS> events_;
+    std::vector<struct epoll_event> events_;
     int efd_;
+    bool edge_once_;
 };
 }
 }
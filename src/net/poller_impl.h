@@ -17,8 +17,16 @@ class PollerImpl {
     virtual void Stop() = 0;
     virtual const char* name() = 0;
     virtual int Poll(poll_event* events, int maxevents, int timeout_ms) = 0;
-    virtual int Add(int fd, int mask) = 0;
-    virtual int Del(int fd, int mask) = 0;
+    /**
+     * @brief Subscribe events of the fd
+     *
+     * @param fd The file descriptor
+     * @param old_mask Events already subscribed
+     * @param mask Events to add
+     * @param ud Dispatch slot of the fd, backends able to carry user data return it in poll_event::ud
+     */
+    virtual int Add(int fd, int old_mask, int mask, void* ud) = 0;
+    virtual int Del(int fd, int old_mask, int mask, void* ud) = 0;
   protected:
     tinynet::EventLoop* event_loop_{ nullptr };
 };
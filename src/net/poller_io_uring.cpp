@@ -0,0 +1,227 @@
+// Copyright (C), Xianfeng Shang.  All rights reserved.
+// Author: Xianfeng Shang (shangxianfeng@outlook.com)
+#include "poller_io_uring.h"
+#ifdef HAS_IO_URING
+#include <unistd.h>
+#include <errno.h>
+#include <poll.h>
+#include <signal.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include "event_loop.h"
+#include "poller.h"
+#include "base/net_types.h"
+#include "util/net_utils.h"
+
+namespace tinynet {
+namespace net {
+PollerIoUring::PollerIoUring(EventLoop* loop)
+    :PollerImpl(loop),
+     ring_fd_(-1),
+     ring_ptr_(MAP_FAILED),
+     ring_size_(0),
+     sqes_(nullptr),
+     sqes_size_(0),
+     sq_head_(nullptr),
+     sq_tail_(nullptr),
+     sq_mask_(nullptr),
+     sq_array_(nullptr),
+     sq_entries_(0),
+     cq_head_(nullptr),
+     cq_tail_(nullptr),
+     cq_mask_(nullptr),
+     cqes_(nullptr) {
+}
+
+PollerIoUring::~PollerIoUring() {
+    Stop();
+}
+
+bool PollerIoUring::Init() {
+    struct io_uring_params params;
+    memset(&params, 0, sizeof(params));
+    ring_fd_ = (int)syscall(__NR_io_uring_setup, URING_ENTRIES, &params);
+    if (ring_fd_ == -1) {
+        return false;
+    }
+    //IORING_FEAT_RSRC_TAGS came with 5.13 as did IORING_POLL_ADD_MULTI, which has no flag of its own
+    if ((params.features & IORING_FEAT_SINGLE_MMAP) == 0 ||
+            (params.features & IORING_FEAT_EXT_ARG) == 0 ||
+            (params.features & IORING_FEAT_RSRC_TAGS) == 0) {
+        Stop();
+        return false;
+    }
+    size_t sq_size = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    size_t cq_size = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+    ring_size_ = sq_size > cq_size ? sq_size : cq_size;
+    ring_ptr_ = mmap(NULL, ring_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd_, IORING_OFF_SQ_RING);
+    if (ring_ptr_ == MAP_FAILED) {
+        Stop();
+        return false;
+    }
+    sqes_size_ = params.sq_entries * sizeof(struct io_uring_sqe);
+    void* sqes = mmap(NULL, sqes_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd_, IORING_OFF_SQES);
+    if (sqes == MAP_FAILED) {
+        Stop();
+        return false;
+    }
+    char* ring = static_cast<char*>(ring_ptr_);
+    sqes_ = static_cast<struct io_uring_sqe*>(sqes);
+    sq_head_ = reinterpret_cast<unsigned*>(ring + params.sq_off.head);
+    sq_tail_ = reinterpret_cast<unsigned*>(ring + params.sq_off.tail);
+    sq_mask_ = reinterpret_cast<unsigned*>(ring + params.sq_off.ring_mask);
+    sq_array_ = reinterpret_cast<unsigned*>(ring + params.sq_off.array);
+    sq_entries_ = params.sq_entries;
+    cq_head_ = reinterpret_cast<unsigned*>(ring + params.cq_off.head);
+    cq_tail_ = reinterpret_cast<unsigned*>(ring + params.cq_off.tail);
+    cq_mask_ = reinterpret_cast<unsigned*>(ring + params.cq_off.ring_mask);
+    cqes_ = reinterpret_cast<struct io_uring_cqe*>(ring + params.cq_off.cqes);
+    return true;
+}
+
+void PollerIoUring::Stop() {
+    if (sqes_) {
+        munmap(sqes_, sqes_size_);
+        sqes_ = nullptr;
+    }
+    if (ring_ptr_ != MAP_FAILED) {
+        munmap(ring_ptr_, ring_size_);
+        ring_ptr_ = MAP_FAILED;
+    }
+    if (ring_fd_ != -1) {
+        close(ring_fd_);
+        ring_fd_ = -1;
+    }
+}
+
+const char* PollerIoUring::name() {
+    return "io_uring";
+}
+
+PollerIoUring::uring_fd* PollerIoUring::GetFd(int fd) {
+    if (fd < 0) return nullptr;
+    if ((size_t)fd >= fds_.size()) {
+        fds_.resize(fd + 1);
+    }
+    return &fds_[fd];
+}
+
+struct io_uring_sqe* PollerIoUring::GetSqe() {
+    unsigned tail = *sq_tail_;
+    if (tail - __atomic_load_n(sq_head_, __ATOMIC_ACQUIRE) >= sq_entries_) {
+        //Submission ring is full, flush it without waiting
+        Submit(0, 0);
+        if (tail - __atomic_load_n(sq_head_, __ATOMIC_ACQUIRE) >= sq_entries_) {
+            return nullptr;
+        }
+    }
+    unsigned index = tail & *sq_mask_;
+    struct io_uring_sqe* sqe = &sqes_[index];
+    memset(sqe, 0, sizeof(*sqe));
+    sq_array_[index] = index;
+    return sqe;
+}
+
+static inline void PublishSqe(unsigned* sq_tail) {
+    __atomic_store_n(sq_tail, *sq_tail + 1, __ATOMIC_RELEASE);
+}
+
+int PollerIoUring::Submit(int min_complete, int timeout_ms) {
+    struct __kernel_timespec ts;
+    struct io_uring_getevents_arg arg;
+    memset(&arg, 0, sizeof(arg));
+    unsigned flags = IORING_ENTER_EXT_ARG;
+    if (min_complete > 0) {
+        flags |= IORING_ENTER_GETEVENTS;
+        if (timeout_ms >= 0) {
+            ts.tv_sec = timeout_ms / 1000;
+            ts.tv_nsec = (timeout_ms % 1000) * 1000 * 1000;
+            arg.ts = (uint64_t)(uintptr_t)&ts;
+        }
+    }
+    unsigned to_submit = *sq_tail_ - __atomic_load_n(sq_head_, __ATOMIC_ACQUIRE);
+    return (int)syscall(__NR_io_uring_enter, ring_fd_, to_submit, min_complete, flags, &arg, sizeof(arg));
+}
+
+int PollerIoUring::Poll(poll_event* events, int maxevents, int timeout_ms) {
+    unsigned head = *cq_head_;
+    bool ready = head != __atomic_load_n(cq_tail_, __ATOMIC_ACQUIRE);
+    bool pending = *sq_tail_ != __atomic_load_n(sq_head_, __ATOMIC_ACQUIRE);
+    if (pending || (!ready && timeout_ms != 0)) {
+        Submit(ready ? 0 : 1, timeout_ms);
+    }
+    int nevents = 0;
+    unsigned tail = __atomic_load_n(cq_tail_, __ATOMIC_ACQUIRE);
+    for (; head != tail && nevents < maxevents; ++head) {
+        struct io_uring_cqe& cqe = cqes_[head & *cq_mask_];
+        if (cqe.user_data == 0 || cqe.res < 0) continue; //Poll removals and cancelled polls
+        int fd = (int)(cqe.user_data >> 32);
+        uint16_t gen = (uint16_t)(cqe.user_data >> 16);
+        int dir = (int)(cqe.user_data & 0xffff);
+        uring_fd* state = GetFd(fd);
+        if (!state || state->gen != gen) continue;
+        //A multishot poll stops without IORING_CQE_F_MORE, the next Add() submits it again
+        if ((cqe.flags & IORING_CQE_F_MORE) == 0) state->armed &= ~dir;
+        int mask = 0;
+        if (cqe.res & (POLLIN | POLLPRI | POLLRDHUP)) mask |= EVENT_READABLE;
+        if (cqe.res & POLLOUT) mask |= EVENT_WRITABLE;
+        if (cqe.res & (POLLHUP | POLLERR)) mask |= EVENT_READABLE | EVENT_WRITABLE | EVENT_ERROR;
+        events[nevents].fd = fd;
+        events[nevents].mask = mask;
+        ++nevents;
+    }
+    __atomic_store_n(cq_head_, head, __ATOMIC_RELEASE);
+    return nevents;
+}
+
+int PollerIoUring::Add(int fd, int old_mask, int mask, void* ud) {
+    uring_fd* state = GetFd(fd);
+    if (!state) return -1;
+    if (old_mask == EVENT_NONE) {
+        if (NetUtils::SetNonBlocking(fd) != 0) return -1;
+    }
+    static const int dirs[] = { EVENT_READABLE, EVENT_WRITABLE };
+    for (int dir : dirs) {
+        if ((mask & dir) == 0 || (state->armed & dir)) continue;
+        struct io_uring_sqe* sqe = GetSqe();
+        if (!sqe) return -1;
+        sqe->opcode = IORING_OP_POLL_ADD;
+        sqe->fd = fd;
+        sqe->poll32_events = dir == EVENT_READABLE ? (POLLIN | POLLRDHUP) : POLLOUT;
+        if (dir == EVENT_READABLE) sqe->len = IORING_POLL_ADD_MULTI;
+#if __BYTE_ORDER == __BIG_ENDIAN
+        sqe->poll32_events = __builtin_bswap32(sqe->poll32_events);
+#endif
+        sqe->user_data = Encode(fd, state->gen, dir);
+        PublishSqe(sq_tail_);
+        state->armed |= dir;
+    }
+    return 0;
+}
+
+int PollerIoUring::Del(int fd, int old_mask, int mask, void* ud) {
+    uring_fd* state = GetFd(fd);
+    if (!state) return -1;
+    static const int dirs[] = { EVENT_READABLE, EVENT_WRITABLE };
+    for (int dir : dirs) {
+        if ((mask & dir) == 0 || (state->armed & dir) == 0) continue;
+        struct io_uring_sqe* sqe = GetSqe();
+        if (!sqe) break;
+        sqe->opcode = IORING_OP_POLL_REMOVE;
+        sqe->fd = -1;
+        sqe->addr = Encode(fd, state->gen, dir);
+        sqe->user_data = 0;
+        PublishSqe(sq_tail_);
+        state->armed &= ~dir;
+    }
+    if ((old_mask & ~mask) == EVENT_NONE) {
+        //The fd may be closed and reused right away, drop whatever is still in flight for it
+        state->armed = 0;
+        ++state->gen;
+    }
+    return 0;
+}
+}
+}
+#endif
@@ -0,0 +1,73 @@
+// Copyright (C), Xianfeng Shang.  All rights reserved.
+// Author: Xianfeng Shang (shangxianfeng@outlook.com)
+#pragma once
+#if defined(__linux__) && defined(__has_include)
+#if __has_include(<linux/io_uring.h>)
+#define HAS_IO_URING 1
+#endif
+#endif
+
+#ifdef HAS_IO_URING
+#include <stdint.h>
+#include <vector>
+#include <linux/io_uring.h>
+#include "poller_impl.h"
+
+namespace tinynet {
+class EventLoop;
+namespace net {
+
+//Readiness backend on io_uring: POLL_ADD requests are queued in the submission ring
+//and submitted together with the wait in Poll(). The read direction uses a multishot
+//poll which stays armed until Del(), so re-arming after each read queues nothing;
+//the write direction is one-shot since it is only subscribed while output is pending.
+//Init() fails on kernels without io_uring, IORING_FEAT_EXT_ARG or multishot polls (< 5.13),
+//the Poller then falls back to epoll.
+//Only the polling goes through the ring, Socket still reads and writes with a syscall each
+//once ready: no provided-buffer reads nor linked writes. The syscalls per message are those
+//of epoll in edge_once mode, one epoll_ctl per read pass fewer than the default epoll mode.
+class PollerIoUring : public PollerImpl {
+  public:
+    PollerIoUring(EventLoop* loop);
+    ~PollerIoUring();
+  public:
+    virtual bool Init() override;
+    virtual void Stop() override;
+    virtual const char* name() override;
+    virtual int Add(int fd, int old_mask, int mask, void* ud) override;
+    virtual int Del(int fd, int old_mask, int mask, void* ud)  override;
+  public:
+    int Poll(poll_event* events, int maxevents, int timeout_ms) override;
+  private:
+    struct uring_fd {
+        uint16_t gen{ 0 }; ///< Bumped when the fd is fully removed, completions of older polls are dropped
+        uint8_t armed{ 0 }; ///< Directions with a poll request in flight, the read one multishot
+    };
+    uring_fd* GetFd(int fd);
+    struct io_uring_sqe* GetSqe();
+    int Submit(int min_complete, int timeout_ms);
+    static uint64_t Encode(int fd, uint16_t gen, int dir) {
+        return ((uint64_t)(uint32_t)fd << 32) | ((uint64_t)gen << 16) | (uint64_t)dir;
+    }
+  private:
+    const static unsigned URING_ENTRIES = 1024;
+  private:
+    int ring_fd_;
+    void* ring_ptr_;
+    size_t ring_size_;
+    struct io_uring_sqe* sqes_;
+    size_t sqes_size_;
+    unsigned* sq_head_;
+    unsigned* sq_tail_;
+    unsigned* sq_mask_;
+    unsigned* sq_array_;
+    unsigned sq_entries_;
+    unsigned* cq_head_;
+    unsigned* cq_tail_;
+    unsigned* cq_mask_;
+    struct io_uring_cqe* cqes_;
+    std::vector<uring_fd> fds_;
+};
+}
+}
+#endif
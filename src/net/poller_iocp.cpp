@@ -141,7 +141,7 @@ int PollerIocp::Poll(poll_event* events, int maxevents, int timeout_ms) {
     return nevents;
 }
 
-int PollerIocp::Add(int fd, int mask) {
+int PollerIocp::Add(int fd, int old_mask, int mask, void* ud) {
     sock_t* sock = g_WinsockManager->GetSocket(fd);
     if (!sock) {
         errno = EBADF;
@@ -193,9 +193,8 @@ int PollerIocp::Add(int fd, int mask) {
     return 0;
 }
 
-int PollerIocp::Del(int fd, int mask) {
-    int events = event_loop_->get_poller()->GetEvents(fd);
-    int newmask = events & (~mask);
+int PollerIocp::Del(int fd, int old_mask, int mask, void* ud) {
+    int newmask = old_mask & (~mask);
     if (newmask == EVENT_NONE) {
         sock_t* sock = g_WinsockManager->GetSocket(fd);
         if (sock) {
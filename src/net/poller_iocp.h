@@ -18,8 +18,8 @@ class PollerIocp : public PollerImpl {
     virtual bool Init() override;
     virtual void Stop() override;
     virtual const char* name() override;
-    virtual int Add(int fd, int mask) override;
-    virtual int Del(int fd, int mask)  override;
+    virtual int Add(int fd, int old_mask, int mask, void* ud) override;
+    virtual int Del(int fd, int old_mask, int mask, void* ud)  override;
   public:
     int Poll(poll_event* events, int maxevents, int timeout_ms) override;
   private:
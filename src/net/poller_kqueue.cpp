@@ -38,7 +38,9 @@ int PollerKqueue::Poll(poll_event* events, int maxevents, int timeout_ms) {
     timeout.tv_sec = timeout_ms / 1000;
     timeout.tv_nsec = (timeout_ms % 1000) * 1000 * 1000;
 
-    maxevents = (std::min)((int)MAX_KQUEUE_EVENTS, maxevents);
+    if ((int)events_.size() < maxevents) {
+        events_.resize(maxevents);
+    }
     int res = kevent(kfd_, NULL, 0, &events_[0], maxevents, &timeout);
     if (res <= 0) {
         return 0;
@@ -55,8 +57,7 @@ int PollerKqueue::Poll(poll_event* events, int maxevents, int timeout_ms) {
     return nevents;
 }
 
-int PollerKqueue::Add(int fd, int mask) {
-    int old_mask = event_loop_->get_poller()->GetEvents(fd);
+int PollerKqueue::Add(int fd, int old_mask, int mask, void* ud) {
     if (old_mask == EVENT_NONE) {
         if (NetUtils::SetNonBlocking(fd) != 0) return -1;
     }
@@ -72,7 +73,7 @@ int PollerKqueue::Add(int fd, int mask) {
     return 0;
 }
 
-int PollerKqueue::Del(int fd, int mask) {
+int PollerKqueue::Del(int fd, int old_mask, int mask, void* ud) {
     struct kevent event;
     if (mask & EVENT_READABLE) {
         EV_SET(&event, fd, EVFILT_READ, EV_DELETE, 0, 0, NULL);
@@ -3,7 +3,7 @@
 #pragma once
 #ifdef __FreeBSD__
 #include <string>
-#include <array>
+#include <vector>
 #include <sys/types.h>
 #include <sys/event.h>
 #include "poller_impl.h"
@@ -19,14 +19,12 @@ class PollerKqueue : public PollerImpl {
     virtual bool Init() override;
     virtual void Stop() override;
     virtual const char* name() override;
-    virtual int Add(int fd, int mask) override;
-    virtual int Del(int fd, int mask)  override;
+    virtual int Add(int fd, int old_mask, int mask, void* ud) override;
+    virtual int Del(int fd, int old_mask, int mask, void* ud)  override;
   public:
     int Poll(poll_event* events, int maxevents, int timeout_ms) override;
   private:
-    const static size_t MAX_KQUEUE_EVENTS = 1024;
-  private:
-    std::array<struct kevent, MAX_KQUEUE_EVENTS> events_;
+    std::vector<struct kevent> events_;
     int kfd_;
 };
 }
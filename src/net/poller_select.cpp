@@ -52,7 +52,7 @@ int PollerSelect::Poll(poll_event* events, int maxevents, int timeout_ms) {
         return 0;
     }
     int nevents = 0;
-    for (int i = 0; i <= maxfd; ++i) {
+    for (int i = 0; i <= maxfd && nevents < maxevents; ++i) {
         int mask = 0;
         if (FD_ISSET(i, &rfd_)) {
             mask |= EVENT_READABLE;
@@ -69,9 +69,8 @@ int PollerSelect::Poll(poll_event* events, int maxevents, int timeout_ms) {
     return nevents;
 }
 
-int PollerSelect::Add(int fd, int mask) {
+int PollerSelect::Add(int fd, int old_mask, int mask, void* ud) {
     if (fd >= FD_SETSIZE_EXTEND) return -1;
-    int old_mask = event_loop_->get_poller()->GetEvents(fd);
     if (old_mask == EVENT_NONE) {
         if (NetUtils::SetNonBlocking(fd) != 0) return -1;
     }
@@ -80,7 +79,7 @@ int PollerSelect::Add(int fd, int mask) {
     return 0;
 }
 
-int PollerSelect::Del(int fd, int mask) {
+int PollerSelect::Del(int fd, int old_mask, int mask, void* ud) {
     if (mask & EVENT_READABLE) {
         rfd_set_.erase(fd);
     }
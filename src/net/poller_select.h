@@ -58,8 +58,8 @@ class PollerSelect : public PollerImpl {
     virtual void Stop();
     virtual const char* name() override;
     virtual int Poll(poll_event* events, int maxevents, int timeout_ms) override;
-    virtual int Add(int fd, int mask) override;
-    virtual int Del(int fd, int mask)  override;
+    virtual int Add(int fd, int old_mask, int mask, void* ud) override;
+    virtual int Del(int fd, int old_mask, int mask, void* ud)  override;
   private:
     struct select_fd {
         int64_t rtime{ 0 };
@@ -0,0 +1,410 @@
+// Copyright (C), Xianfeng Shang.  All rights reserved.
+// Author: Xianfeng Shang (shangxianfeng@outlook.com)
+#include "rudp_endpoint.h"
+#include "event_loop.h"
+#include "base/error_code.h"
+#include "util/random_utils.h"
+#include "util/uri_utils.h"
+#include "logging/logging.h"
+#include "openssl/hmac.h"
+#include "openssl/rand.h"
+#include <cstring>
+#ifndef _WIN32
+#include <sys/socket.h>
+#include <errno.h>
+#endif
+
+namespace tinynet {
+namespace net {
+
+static_assert(RudpEndpoint::MAX_BATCH * RudpEndpoint::MAX_DATAGRAM_SIZE <= EventLoop::READ_SPILL_SIZE,
+              "Receive batch must fit into the read spill area");
+
+static const int kMaxReadRounds = 8; //Batches received per readable event before other fds get their turn
+static const int64_t kCookiePeriod = 10000; //A cookie is accepted in the period it was made in and the next one, in ms
+
+RudpEndpoint::RudpEndpoint(EventLoop* loop, const RudpOptions& opts):
+    FileDescriptor(loop, -1),
+    opts_(opts),
+    update_timer_(INVALID_TIMER_ID),
+    flush_task_(INVALID_TASK_ID) {
+    if (opts_.mtu > (int)MAX_DATAGRAM_SIZE) opts_.mtu = (int)MAX_DATAGRAM_SIZE;
+    if (opts_.interval <= 0) opts_.interval = 10;
+}
+
+RudpEndpoint::~RudpEndpoint() {
+    if (update_timer_ != INVALID_TIMER_ID) {
+        event_loop_->ClearTimer(update_timer_);
+    }
+    for (auto& entry : sessions_) {
+        entry.second.session->set_output_callback(nullptr);
+    }
+}
+
+int RudpEndpoint::Listen(const std::string& ip, int port, int flags) {
+    if (fd_ != -1) return ERROR_SERVER_STARTED;
+    int err = ERROR_OK;
+    fd_ = NetUtils::BindUdp(ip.empty() ? nullptr : ip.c_str(), port, flags, &err);
+    if (fd_ == -1) {
+        return err;
+    }
+    NetUtils::GetSockName(fd_, nullptr, &listen_port_);
+    if (RAND_bytes(cookie_secret_, sizeof(cookie_secret_)) != 1) {
+        NetUtils::Close(fd_);
+        return ERROR_INVAL;
+    }
+    if (AddEvent(EVENT_READABLE) == -1) {
+        NetUtils::Close(fd_);
+        return ERROR_EVENTLOOP_REGISTER;
+    }
+    flag_ |= FD_FLAGS_LISTEN_FD;
+    update_timer_ = event_loop_->AddTimer(opts_.interval, opts_.interval, std::bind(&RudpEndpoint::Update, this));
+    return ERROR_OK;
+}
+
+RudpSessionPtr RudpEndpoint::Connect(const std::string& host, int port, int* err) {
+    if (fd_ != -1) {
+        *err = ERROR_SOCKET_CONNECT;
+        return nullptr;
+    }
+    fd_ = NetUtils::ConnectUdp(host.c_str(), port, err);
+    if (fd_ == -1) {
+        return nullptr;
+    }
+    if (AddEvent(EVENT_READABLE) == -1) {
+        NetUtils::Close(fd_);
+        *err = ERROR_EVENTLOOP_REGISTER;
+        return nullptr;
+    }
+    connected_ = true;
+    flag_ |= FD_FLAGS_CLIENT_FD;
+    uint32_t conv = 0;
+    while (conv == 0) {
+        conv = RandomUtils::Random32();
+    }
+    auto session = std::make_shared<RudpSession>(conv, opts_);
+    UriUtils::format_address(session->peer_address_, "udp", host, &port);
+    AddSession(session, nullptr, 0);
+    session->Connect(event_loop_->Time());
+    FlushOutput();
+    update_timer_ = event_loop_->AddTimer(opts_.interval, opts_.interval, std::bind(&RudpEndpoint::Update, this));
+    *err = ERROR_OK;
+    return session;
+}
+
+void RudpEndpoint::CloseSession(uint32_t conv) {
+    auto it = sessions_.find(conv);
+    if (it == sessions_.end()) return;
+    it->second.session->Close();
+    RemoveSession(conv);
+}
+
+void RudpEndpoint::Close() {
+    if (fd_ == -1) return;
+    for (auto& entry : sessions_) {
+        entry.second.session->Close();
+        entry.second.session->set_output_callback(nullptr);
+    }
+    FlushOutput();
+    sessions_.clear();
+    if (update_timer_ != INVALID_TIMER_ID) {
+        event_loop_->ClearTimer(update_timer_);
+    }
+    FileDescriptor::Close();
+}
+
+void RudpEndpoint::AddSession(RudpSessionPtr session, const sockaddr_storage* addr, socklen_t addrlen) {
+    uint32_t conv = session->get_conv();
+    Peer& peer = sessions_[conv];
+    peer.session = session;
+    peer.addrlen = addrlen;
+    peer.opened = !connected_;
+    if (addr) {
+        std::memcpy(&peer.addr, addr, addrlen);
+    }
+    session->set_output_callback(std::bind(&RudpEndpoint::Output, this, conv, std::placeholders::_1, std::placeholders::_2));
+}
+
+void RudpEndpoint::RemoveSession(uint32_t conv) {
+    auto it = sessions_.find(conv);
+    if (it == sessions_.end()) return;
+    //The close datagram may still be queued, it goes out with the next batch
+    it->second.session->set_output_callback(nullptr);
+    sessions_.erase(it);
+}
+
+void RudpEndpoint::Readable() {
+    char* spill = event_loop_->get_read_spill();
+    int err = ERROR_OK;
+    bool replay = false;
+    std::vector<uint32_t> touched;
+    for (int round = 0; ; ++round) {
+        touched.clear();
+        int n = 0;
+#ifdef __linux__
+        struct mmsghdr msgs[MAX_BATCH];
+        struct iovec iovs[MAX_BATCH];
+        sockaddr_storage addrs[MAX_BATCH];
+        for (int i = 0; i < MAX_BATCH; ++i) {
+            iovs[i].iov_base = spill + i * MAX_DATAGRAM_SIZE;
+            iovs[i].iov_len = MAX_DATAGRAM_SIZE;
+            std::memset(&msgs[i].msg_hdr, 0, sizeof(msgs[i].msg_hdr));
+            msgs[i].msg_hdr.msg_name = &addrs[i];
+            msgs[i].msg_hdr.msg_namelen = sizeof(addrs[i]);
+            msgs[i].msg_hdr.msg_iov = &iovs[i];
+            msgs[i].msg_hdr.msg_iovlen = 1;
+        }
+        n = recvmmsg(fd_, msgs, MAX_BATCH, MSG_DONTWAIT, nullptr);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            //A connected client socket reports icmp port unreachable here, the session timeout handles it
+            if (errno != EAGAIN && errno != EWOULDBLOCK && errno != ECONNREFUSED) err = ERROR_SOCKET_READ;
+            break;
+        }
+        for (int i = 0; i < n; ++i) {
+            if (msgs[i].msg_hdr.msg_flags & MSG_TRUNC) continue;
+            const char* data = spill + i * MAX_DATAGRAM_SIZE;
+            Dispatch(data, msgs[i].msg_len, addrs[i], msgs[i].msg_hdr.msg_namelen);
+            uint32_t conv = RudpSession::PeekConv(data, msgs[i].msg_len);
+            if (touched.empty() || touched.back() != conv) touched.push_back(conv);
+        }
+#else
+        for (; n < MAX_BATCH; ++n) {
+            sockaddr_storage addr;
+            socklen_t addrlen = sizeof(addr);
+            char* data = spill + n * MAX_DATAGRAM_SIZE;
+            int nread = (int)recvfrom(fd_, data, (int)MAX_DATAGRAM_SIZE, 0, (struct sockaddr*)&addr, &addrlen);
+            if (nread < 0) break;
+            Dispatch(data, (size_t)nread, addr, addrlen);
+            uint32_t conv = RudpSession::PeekConv(data, (size_t)nread);
+            if (touched.empty() || touched.back() != conv) touched.push_back(conv);
+        }
+#endif
+        for (auto conv : touched) {
+            auto it = sessions_.find(conv);
+            if (it == sessions_.end()) continue;
+            //Acks go out with this batch instead of waiting for the next update
+            if (opts_.nodelay) it->second.session->Flush();
+            Process(conv);
+        }
+        if (n < MAX_BATCH) break;
+        if (round + 1 >= kMaxReadRounds) {
+            event_loop_->ReplayEvent(fd_, EVENT_READABLE);
+            replay = true;
+            break;
+        }
+    }
+    FlushOutput();
+    mask_ &= ~EVENT_READABLE;
+    //Re-armed by the replayed pass once it reads all, see Socket::StreamReadable()
+    if (err == ERROR_OK && fd_ != -1 && !replay && AddEvent(EVENT_READABLE) == -1) {
+        err = ERROR_EVENTLOOP_REGISTER;
+    }
+    if (err != ERROR_OK) {
+        SetError(err);
+    }
+}
+
+void RudpEndpoint::Dispatch(const char* data, size_t len, const sockaddr_storage& addr, socklen_t addrlen) {
+    uint32_t conv = RudpSession::PeekConv(data, len);
+    if (conv == 0) return;
+    if (opts_.drop_rate > 0 && RandomUtils::Random32(0, 99) < (uint32_t)opts_.drop_rate) return;
+    auto it = sessions_.find(conv);
+    if (it == sessions_.end()) {
+        if (connected_ || !accept_callback_ || RudpSession::PeekCommand(data, len) != RudpSession::CMD_CONNECT) {
+            return;
+        }
+        Admit(conv, data, len, addr, addrlen);
+        return;
+    }
+    Peer& peer = it->second;
+    if (!connected_ && (peer.addrlen != addrlen || std::memcmp(&peer.addr, &addr, addrlen) != 0) &&
+            !Migrate(peer, data, len, addr, addrlen)) {
+        return;
+    }
+    peer.session->Input(data, len, event_loop_->Time());
+}
+
+bool RudpEndpoint::Migrate(Peer& peer, const char* data, size_t len, const sockaddr_storage& addr, socklen_t addrlen) {
+    //Anyone may send a datagram with a known conv from any address, so a new address is only taken
+    //once it echoes a cookie made for it, which proves the client receives there
+    int64_t period = event_loop_->Time() / kCookiePeriod;
+    uint32_t conv = peer.session->get_conv();
+    if (RudpSession::PeekCommand(data, len) == RudpSession::CMD_CONNECT) {
+        uint64_t cookie = RudpSession::PeekCookie(data, len);
+        if (cookie != 0 && (cookie == MakeCookie(conv, addr, addrlen, period) ||
+                            cookie == MakeCookie(conv, addr, addrlen, period - 1))) {
+            //Follow the client across NAT rebinding and network switches
+            std::memcpy(&peer.addr, &addr, addrlen);
+            peer.addrlen = addrlen;
+            return true;
+        }
+    }
+    //Nothing else from the new address reaches the session, a close included, the client retransmits
+    //its data once the address moved. The challenge is no larger than the datagram which asked for it.
+    if (RudpSession::PeekCommand(data, len) != RudpSession::CMD_CLOSE) {
+        Reply(conv, RudpSession::CMD_CHALLENGE, MakeCookie(conv, addr, addrlen, period), addr, addrlen);
+    }
+    return false;
+}
+
+void RudpEndpoint::Admit(uint32_t conv, const char* data, size_t len, const sockaddr_storage& addr, socklen_t addrlen) {
+    int64_t period = event_loop_->Time() / kCookiePeriod;
+    if (opts_.connect_cookie) {
+        //A spoofed source address never sees the challenge, so it can not make the endpoint keep a session
+        uint64_t cookie = RudpSession::PeekCookie(data, len);
+        if (cookie == 0 || (cookie != MakeCookie(conv, addr, addrlen, period) &&
+                            cookie != MakeCookie(conv, addr, addrlen, period - 1))) {
+            Reply(conv, RudpSession::CMD_CHALLENGE, MakeCookie(conv, addr, addrlen, period), addr, addrlen);
+            return;
+        }
+    }
+    if (opts_.max_sessions > 0 && sessions_.size() >= (size_t)opts_.max_sessions) {
+        //Refused right away rather than left to the connect timeout of the client
+        Reply(conv, RudpSession::CMD_CLOSE, 0, addr, addrlen);
+        return;
+    }
+    auto session = std::make_shared<RudpSession>(conv, opts_);
+    std::string ip;
+    int port = 0;
+    NetUtils::GetNameInfo((const struct sockaddr*)&addr, &ip, &port);
+    UriUtils::format_address(session->peer_address_, "udp", ip, &port);
+    AddSession(session, &addr, addrlen);
+    session->Accept(event_loop_->Time());
+    Invoke(accept_callback_, session);
+}
+
+uint64_t RudpEndpoint::MakeCookie(uint32_t conv, const sockaddr_storage& addr, socklen_t addrlen, int64_t period) const {
+    //HMAC-SHA256(secret, conv | period | source address) truncated to 64 bits
+    unsigned char msg[4 + 8 + sizeof(sockaddr_storage)];
+    std::memcpy(msg, &conv, 4);
+    std::memcpy(msg + 4, &period, 8);
+    std::memcpy(msg + 12, &addr, addrlen);
+    unsigned char md[EVP_MAX_MD_SIZE];
+    unsigned int md_len = 0;
+    if (HMAC(EVP_sha256(), cookie_secret_, (int)sizeof(cookie_secret_), msg, 12 + addrlen, md, &md_len) == NULL) {
+        return 0;
+    }
+    uint64_t cookie = 0;
+    std::memcpy(&cookie, md, sizeof(cookie));
+    //0 stands for no cookie
+    return cookie != 0 ? cookie : 1;
+}
+
+void RudpEndpoint::Reply(uint32_t conv, uint32_t cmd, uint64_t cookie, const sockaddr_storage& addr, socklen_t addrlen) {
+    //As large as the request, so the reply amplifies nothing
+    out_.emplace_back();
+    Datagram& dgram = out_.back();
+    dgram.offset = out_data_.size();
+    dgram.addrlen = addrlen;
+    std::memcpy(&dgram.addr, &addr, addrlen);
+    out_data_.resize(dgram.offset + RudpSession::OVERHEAD);
+    dgram.len = RudpSession::EncodeControl(&out_data_[dgram.offset], conv, cmd, cookie);
+    if (out_.size() >= (size_t)MAX_BATCH) {
+        FlushOutput();
+    } else {
+        ScheduleFlush();
+    }
+}
+
+void RudpEndpoint::Process(uint32_t conv) {
+    auto it = sessions_.find(conv);
+    if (it == sessions_.end()) return;
+    RudpSessionPtr session = it->second.session;
+    if (!it->second.opened && session->is_connected()) {
+        it->second.opened = true;
+        Invoke(session->conn_callback_);
+    }
+    if (session->has_message()) {
+        Invoke(session->read_callback_);
+    }
+    int err = session->Check(event_loop_->Time());
+    if (err != ERROR_OK && sessions_.count(conv)) {
+        RemoveSession(conv);
+        Invoke(session->error_callback_, err);
+    }
+}
+
+void RudpEndpoint::Update() {
+    int64_t now = event_loop_->Time();
+    std::vector<uint32_t> convs;
+    convs.reserve(sessions_.size());
+    for (auto& entry : sessions_) {
+        convs.push_back(entry.first);
+    }
+    for (auto conv : convs) {
+        auto it = sessions_.find(conv);
+        if (it == sessions_.end()) continue;
+        it->second.session->Update(now);
+        Process(conv);
+    }
+    FlushOutput();
+}
+
+void RudpEndpoint::Output(uint32_t conv, const char* data, size_t len) {
+    auto it = sessions_.find(conv);
+    if (it == sessions_.end() || fd_ == -1) return;
+    out_.emplace_back();
+    Datagram& dgram = out_.back();
+    dgram.offset = out_data_.size();
+    dgram.len = len;
+    dgram.addrlen = it->second.addrlen;
+    if (dgram.addrlen > 0) {
+        std::memcpy(&dgram.addr, &it->second.addr, dgram.addrlen);
+    }
+    out_data_.insert(out_data_.end(), data, data + len);
+    if (out_.size() >= (size_t)MAX_BATCH) {
+        FlushOutput();
+    } else {
+        ScheduleFlush();
+    }
+}
+
+void RudpEndpoint::ScheduleFlush() {
+    if (flush_task_ != INVALID_TASK_ID) return;
+    flush_task_ = event_loop_->AddTask(std::bind(handle_flush, weak_from_this()));
+}
+
+void RudpEndpoint::handle_flush(std::weak_ptr<FileDescriptor> weak_endpoint) {
+    if (auto endpoint = std::static_pointer_cast<RudpEndpoint>(weak_endpoint.lock())) {
+        endpoint->flush_task_ = INVALID_TASK_ID;
+        endpoint->FlushOutput();
+    }
+}
+
+void RudpEndpoint::FlushOutput() {
+    if (out_.empty()) return;
+    size_t i = 0;
+#ifdef __linux__
+    while (i < out_.size()) {
+        struct mmsghdr msgs[MAX_BATCH];
+        struct iovec iovs[MAX_BATCH];
+        int n = 0;
+        for (; n < MAX_BATCH && i + n < out_.size(); ++n) {
+            Datagram& dgram = out_[i + n];
+            iovs[n].iov_base = &out_data_[dgram.offset];
+            iovs[n].iov_len = dgram.len;
+            std::memset(&msgs[n].msg_hdr, 0, sizeof(msgs[n].msg_hdr));
+            msgs[n].msg_hdr.msg_name = dgram.addrlen > 0 ? &dgram.addr : nullptr;
+            msgs[n].msg_hdr.msg_namelen = dgram.addrlen;
+            msgs[n].msg_hdr.msg_iov = &iovs[n];
+            msgs[n].msg_hdr.msg_iovlen = 1;
+        }
+        int sent = sendmmsg(fd_, msgs, n, MSG_DONTWAIT);
+        if (sent < 0 && errno == EINTR) continue;
+        //Datagrams the socket can not take now are lost, the sessions retransmit them
+        if (sent <= 0) break;
+        i += sent;
+    }
+#else
+    for (; i < out_.size(); ++i) {
+        Datagram& dgram = out_[i];
+        sendto(fd_, &out_data_[dgram.offset], (int)dgram.len, 0,
+               dgram.addrlen > 0 ? (const struct sockaddr*)&dgram.addr : nullptr, dgram.addrlen);
+    }
+#endif
+    out_.clear();
+    out_data_.clear();
+}
+}
+}
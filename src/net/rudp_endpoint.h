@@ -0,0 +1,114 @@
+// Copyright (C), Xianfeng Shang.  All rights reserved.
+// Author: Xianfeng Shang (shangxianfeng@outlook.com)
+#pragma once
+#include "file_descriptor.h"
+#include "rudp_session.h"
+#include "util/net_utils.h"
+#include <unordered_map>
+#include <vector>
+
+namespace tinynet {
+namespace net {
+
+class RudpEndpoint;
+typedef std::shared_ptr<RudpEndpoint> RudpEndpointPtr;
+
+//UDP socket carrying reliable UDP sessions demultiplexed by conversation id.
+//A server endpoint accepts sessions from any peer, a client endpoint is connected to one server and carries one session.
+//Datagrams are received and sent in batches, sessions are driven by a repeating timer of the event loop.
+class RudpEndpoint final:
+    public FileDescriptor {
+  public:
+    static const size_t MAX_DATAGRAM_SIZE = 2048;
+    static const int MAX_BATCH = 32;
+    typedef std::function<void(RudpSessionPtr)> AcceptCallback;
+  public:
+    RudpEndpoint(EventLoop* loop, const RudpOptions& opts);
+    ~RudpEndpoint();
+  public:
+    /**
+     * @brief Binds the endpoint and accepts incoming sessions
+     *
+     * @param ip
+     * @param port
+     * @param flags TCP_FLAGS_REUSEPORT, TCP_FLAGS_IPV6ONLY
+     * @return int
+     */
+    int Listen(const std::string& ip, int port, int flags);
+    /**
+     * @brief Connects the endpoint to a server and starts a session with a random conversation id
+     *
+     * @param host
+     * @param port
+     * @param err
+     * @return RudpSessionPtr
+     */
+    RudpSessionPtr Connect(const std::string& host, int port, int* err);
+    /**
+     * @brief Closes one session and tells its peer
+     *
+     * @param conv
+     */
+    void CloseSession(uint32_t conv);
+    /**
+     * @brief Closes every session and the underlying socket
+     *
+     */
+    void Close() override;
+  public:
+    void set_accept_callback(AcceptCallback cb) { accept_callback_ = std::move(cb); }
+    size_t get_session_size() const { return sessions_.size(); }
+    int get_listen_port() const { return listen_port_; }
+    const RudpOptions& get_options() const { return opts_; }
+  private:
+    void Readable() override;
+    void Update();
+    void Dispatch(const char* data, size_t len, const sockaddr_storage& addr, socklen_t addrlen);
+    void Process(uint32_t conv);
+    void Output(uint32_t conv, const char* data, size_t len);
+    void FlushOutput();
+    void ScheduleFlush();
+    void AddSession(RudpSessionPtr session, const sockaddr_storage* addr, socklen_t addrlen);
+    void RemoveSession(uint32_t conv);
+    /**
+     * @brief Creates the session of a connection request once its cookie checks out and there is room for it,
+     * answers with a challenge or a close otherwise, without keeping any state
+     *
+     */
+    void Admit(uint32_t conv, const char* data, size_t len, const sockaddr_storage& addr, socklen_t addrlen);
+    uint64_t MakeCookie(uint32_t conv, const sockaddr_storage& addr, socklen_t addrlen, int64_t period) const;
+    void Reply(uint32_t conv, uint32_t cmd, uint64_t cookie, const sockaddr_storage& addr, socklen_t addrlen);
+    static void handle_flush(std::weak_ptr<FileDescriptor> weak_endpoint);
+  private:
+    struct Peer {
+        RudpSessionPtr session;
+        sockaddr_storage addr;
+        socklen_t addrlen{ 0 }; ///< 0 for the session of a connected client endpoint
+        bool opened{ false }; ///< The connect callback was raised
+    };
+    struct Datagram {
+        size_t offset;
+        size_t len;
+        sockaddr_storage addr;
+        socklen_t addrlen;
+    };
+    /**
+     * @brief Moves a session to the new source address of a datagram once it echoes a challenge made for that address,
+     * answers with the challenge otherwise. Returns true when the datagram may be fed to the session.
+     *
+     */
+    bool Migrate(Peer& peer, const char* data, size_t len, const sockaddr_storage& addr, socklen_t addrlen);
+  private:
+    RudpOptions opts_;
+    bool connected_{ false };
+    int listen_port_{ 0 };
+    int64_t update_timer_;
+    int64_t flush_task_;
+    std::unordered_map<uint32_t, Peer> sessions_;
+    std::vector<char> out_data_; ///< Payloads of the datagrams waiting for the next batch
+    std::vector<Datagram> out_; ///< Datagrams waiting for the next batch
+    AcceptCallback accept_callback_;
+    unsigned char cookie_secret_[32]; ///< Keys the cookies of the connection requests and address migrations
+};
+}
+}
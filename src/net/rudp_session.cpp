@@ -0,0 +1,620 @@
+// Copyright (C), Xianfeng Shang.  All rights reserved.
+// Author: Xianfeng Shang (shangxianfeng@outlook.com)
+#include "rudp_session.h"
+#include "base/error_code.h"
+#include <algorithm>
+#include <cstring>
+
+namespace tinynet {
+namespace net {
+
+static const int32_t kRtoNoDelay = 30;
+static const int32_t kRtoMin = 100;
+static const int32_t kRtoDefault = 200;
+static const int32_t kRtoMax = 60000;
+static const uint32_t kAskSend = 1; //Need to send CMD_WASK
+static const uint32_t kAskTell = 2; //Need to send CMD_WINS
+static const uint32_t kThreshInit = 2;
+static const uint32_t kThreshMin = 2;
+static const uint32_t kProbeInit = 7000;
+static const uint32_t kProbeLimit = 120000;
+static const uint32_t kFastackLimit = 5;
+
+static inline int32_t time_diff(uint32_t later, uint32_t earlier) {
+    return (int32_t)(later - earlier);
+}
+
+static inline char* encode8u(char* p, uint8_t c) {
+    *(uint8_t*)p++ = c;
+    return p;
+}
+
+static inline char* encode16u(char* p, uint16_t w) {
+    *(uint8_t*)(p + 0) = (uint8_t)(w & 0xff);
+    *(uint8_t*)(p + 1) = (uint8_t)(w >> 8);
+    return p + 2;
+}
+
+static inline char* encode32u(char* p, uint32_t l) {
+    *(uint8_t*)(p + 0) = (uint8_t)(l & 0xff);
+    *(uint8_t*)(p + 1) = (uint8_t)(l >> 8);
+    *(uint8_t*)(p + 2) = (uint8_t)(l >> 16);
+    *(uint8_t*)(p + 3) = (uint8_t)(l >> 24);
+    return p + 4;
+}
+
+static inline const char* decode8u(const char* p, uint8_t* c) {
+    *c = *(const uint8_t*)p++;
+    return p;
+}
+
+static inline const char* decode16u(const char* p, uint16_t* w) {
+    *w = (uint16_t)(*(const uint8_t*)(p + 0) | (*(const uint8_t*)(p + 1) << 8));
+    return p + 2;
+}
+
+static inline const char* decode32u(const char* p, uint32_t* l) {
+    *l = (uint32_t)(*(const uint8_t*)(p + 0)) |
+         ((uint32_t)(*(const uint8_t*)(p + 1)) << 8) |
+         ((uint32_t)(*(const uint8_t*)(p + 2)) << 16) |
+         ((uint32_t)(*(const uint8_t*)(p + 3)) << 24);
+    return p + 4;
+}
+
+RudpSession::RudpSession(uint32_t conv, const RudpOptions& opts):
+    conv_(conv),
+    ssthresh_(kThreshInit),
+    rx_rto_(kRtoDefault),
+    rx_minrto_(opts.nodelay ? kRtoNoDelay : kRtoMin),
+    snd_wnd_((uint32_t)(std::max)(opts.snd_wnd, 1)),
+    rcv_wnd_((uint32_t)(std::min)((std::max)(opts.rcv_wnd, 1), 0xffff)),
+    rmt_wnd_((uint32_t)(std::min)((std::max)(opts.rcv_wnd, 1), 0xffff)),
+    interval_((uint32_t)(std::min)((std::max)(opts.interval, 1), 5000)),
+    ts_flush_((uint32_t)(std::min)((std::max)(opts.interval, 1), 5000)),
+    dead_link_((uint32_t)(std::max)(opts.dead_link, 1)),
+    timeout_((uint32_t)(std::max)(opts.timeout_ms, 0)),
+    fastresend_((uint32_t)(std::max)(opts.resend, 0)),
+    nodelay_(opts.nodelay),
+    nocwnd_(opts.nocwnd) {
+    mtu_ = (uint32_t)(std::max)(opts.mtu, (int)OVERHEAD + 1);
+    mss_ = mtu_ - OVERHEAD;
+    buffer_.resize(mtu_ * 3);
+}
+
+RudpSession::~RudpSession() = default;
+
+uint32_t RudpSession::PeekConv(const char* data, size_t len) {
+    uint32_t conv = 0;
+    if (len >= OVERHEAD) decode32u(data, &conv);
+    return conv;
+}
+
+int RudpSession::PeekCommand(const char* data, size_t len) {
+    return len >= OVERHEAD ? *(const uint8_t*)(data + 4) : 0;
+}
+
+uint64_t RudpSession::PeekCookie(const char* data, size_t len) {
+    if (len < OVERHEAD) return 0;
+    uint32_t hi = 0, lo = 0;
+    decode32u(data + 12, &hi);
+    decode32u(data + 16, &lo);
+    return ((uint64_t)hi << 32) | lo;
+}
+
+size_t RudpSession::EncodeControl(char* buf, uint32_t conv, uint32_t cmd, uint64_t cookie) {
+    char* ptr = encode32u(buf, conv);
+    ptr = encode8u(ptr, (uint8_t)cmd);
+    ptr = encode8u(ptr, 0);
+    ptr = encode16u(ptr, 0);
+    ptr = encode32u(ptr, 0);
+    ptr = encode32u(ptr, (uint32_t)(cookie >> 32));
+    ptr = encode32u(ptr, (uint32_t)cookie);
+    encode32u(ptr, 0);
+    return OVERHEAD;
+}
+
+void RudpSession::Connect(int64_t current) {
+    current_ = (uint32_t)current;
+    ts_connect_ = current_;
+    ts_last_recv_ = current_;
+    state_ = RudpState::RS_CONNECTING;
+    SendControl(CMD_CONNECT);
+}
+
+void RudpSession::Accept(int64_t current) {
+    current_ = (uint32_t)current;
+    ts_last_recv_ = current_;
+    state_ = RudpState::RS_CONNECTED;
+    SendControl(CMD_ACCEPT);
+}
+
+void RudpSession::Close() {
+    if (state_ == RudpState::RS_CLOSED) return;
+    if (state_ != RudpState::RS_INIT) {
+        //Best effort, the idle timeout covers a lost close
+        SendControl(CMD_CLOSE);
+    }
+    state_ = RudpState::RS_CLOSED;
+}
+
+int RudpSession::Send(const char* data, size_t len) {
+    if (state_ == RudpState::RS_CLOSED) {
+        return ERROR_SOCKET_NOT_CONNECTED;
+    }
+    size_t count = len <= mss_ ? 1 : (len + mss_ - 1) / mss_;
+    //Fragments share one byte of numbering and must fit into the peer receive window
+    if (count >= (std::min)(rcv_wnd_, (uint32_t)255)) {
+        return ERROR_SOCKET_WRITE;
+    }
+    for (size_t i = 0; i < count; ++i) {
+        size_t size = (std::min)(len, (size_t)mss_);
+        snd_queue_.emplace_back();
+        Segment& seg = snd_queue_.back();
+        seg.data.assign(data, size);
+        seg.frg = (uint32_t)(count - i - 1);
+        data += size;
+        len -= size;
+    }
+    return ERROR_OK;
+}
+
+int RudpSession::SendUnreliable(const char* data, size_t len) {
+    if (state_ != RudpState::RS_CONNECTED) {
+        return ERROR_SOCKET_NOT_CONNECTED;
+    }
+    if (len > mss_) {
+        return ERROR_SOCKET_WRITE;
+    }
+    Segment seg;
+    seg.conv = conv_;
+    seg.cmd = CMD_UNRELIABLE;
+    seg.wnd = WndUnused();
+    seg.una = rcv_nxt_;
+    char* ptr = Encode(&buffer_[0], seg);
+    std::memcpy(ptr, data, len);
+    //The payload is not copied into the segment, patch the length field
+    encode32u(ptr - 4, (uint32_t)len);
+    Output(&buffer_[0], OVERHEAD + len);
+    return ERROR_OK;
+}
+
+bool RudpSession::Recv(std::string* msg) {
+    if (messages_.empty()) return false;
+    msg->swap(messages_.front());
+    messages_.pop_front();
+    return true;
+}
+
+char* RudpSession::Encode(char* ptr, const Segment& seg) {
+    ptr = encode32u(ptr, seg.conv);
+    ptr = encode8u(ptr, (uint8_t)seg.cmd);
+    ptr = encode8u(ptr, (uint8_t)seg.frg);
+    ptr = encode16u(ptr, (uint16_t)seg.wnd);
+    ptr = encode32u(ptr, seg.ts);
+    ptr = encode32u(ptr, seg.sn);
+    ptr = encode32u(ptr, seg.una);
+    ptr = encode32u(ptr, (uint32_t)seg.data.size());
+    return ptr;
+}
+
+void RudpSession::Output(const char* data, size_t len) {
+    if (len == 0) return;
+    ts_last_send_ = current_;
+    if (output_callback_) output_callback_(data, len);
+}
+
+void RudpSession::SendControl(uint32_t cmd) {
+    Segment seg;
+    seg.conv = conv_;
+    seg.cmd = cmd;
+    seg.wnd = WndUnused();
+    seg.ts = current_;
+    seg.una = rcv_nxt_;
+    if (cmd == CMD_CONNECT) {
+        seg.sn = (uint32_t)(cookie_ >> 32);
+        seg.una = (uint32_t)cookie_;
+    }
+    Encode(&buffer_[0], seg);
+    Output(&buffer_[0], OVERHEAD);
+}
+
+uint32_t RudpSession::WndUnused() const {
+    return rcv_queue_.size() < rcv_wnd_ ? rcv_wnd_ - (uint32_t)rcv_queue_.size() : 0;
+}
+
+void RudpSession::UpdateAck(int32_t rtt) {
+    if (rx_srtt_ == 0) {
+        rx_srtt_ = rtt;
+        rx_rttval_ = rtt / 2;
+    } else {
+        int32_t delta = rtt - rx_srtt_;
+        if (delta < 0) delta = -delta;
+        rx_rttval_ = (3 * rx_rttval_ + delta) / 4;
+        rx_srtt_ = (7 * rx_srtt_ + rtt) / 8;
+        if (rx_srtt_ < 1) rx_srtt_ = 1;
+    }
+    int32_t rto = rx_srtt_ + (std::max)((int32_t)interval_, 4 * rx_rttval_);
+    rx_rto_ = (std::min)((std::max)(rx_minrto_, rto), kRtoMax);
+}
+
+void RudpSession::ShrinkBuf() {
+    snd_una_ = snd_buf_.empty() ? snd_nxt_ : snd_buf_.front().sn;
+}
+
+void RudpSession::ParseAck(uint32_t sn) {
+    if (time_diff(sn, snd_una_) < 0 || time_diff(sn, snd_nxt_) >= 0) return;
+    for (auto it = snd_buf_.begin(); it != snd_buf_.end(); ++it) {
+        if (it->sn == sn) {
+            snd_buf_.erase(it);
+            break;
+        }
+        if (time_diff(sn, it->sn) < 0) break;
+    }
+}
+
+void RudpSession::ParseUna(uint32_t una) {
+    while (!snd_buf_.empty() && time_diff(una, snd_buf_.front().sn) > 0) {
+        snd_buf_.pop_front();
+    }
+}
+
+void RudpSession::ParseFastack(uint32_t sn) {
+    if (time_diff(sn, snd_una_) < 0 || time_diff(sn, snd_nxt_) >= 0) return;
+    for (auto& seg : snd_buf_) {
+        if (time_diff(sn, seg.sn) < 0) break;
+        if (sn != seg.sn) ++seg.fastack;
+    }
+}
+
+void RudpSession::ParseData(Segment& seg) {
+    uint32_t sn = seg.sn;
+    if (time_diff(sn, rcv_nxt_ + rcv_wnd_) >= 0 || time_diff(sn, rcv_nxt_) < 0) {
+        return;
+    }
+    //Keep rcv_buf_ sorted, new segments mostly land at the end
+    auto it = rcv_buf_.end();
+    bool repeat = false;
+    while (it != rcv_buf_.begin()) {
+        auto prev = it - 1;
+        if (prev->sn == sn) {
+            repeat = true;
+            break;
+        }
+        if (time_diff(sn, prev->sn) > 0) break;
+        it = prev;
+    }
+    if (!repeat) {
+        rcv_buf_.insert(it, std::move(seg));
+    }
+    while (!rcv_buf_.empty() && rcv_buf_.front().sn == rcv_nxt_ && rcv_queue_.size() < rcv_wnd_) {
+        rcv_queue_.push_back(std::move(rcv_buf_.front()));
+        rcv_buf_.pop_front();
+        ++rcv_nxt_;
+    }
+    Deliver();
+}
+
+void RudpSession::Deliver() {
+    //Assemble every complete message, only the fragments of a partial one stay queued
+    while (!rcv_queue_.empty()) {
+        size_t count = 0;
+        for (auto& seg : rcv_queue_) {
+            ++count;
+            if (seg.frg == 0) break;
+        }
+        if (rcv_queue_[count - 1].frg != 0) break;
+        std::string msg;
+        if (count == 1) {
+            msg.swap(rcv_queue_.front().data);
+        } else {
+            for (size_t i = 0; i < count; ++i) {
+                msg.append(rcv_queue_[i].data);
+            }
+        }
+        rcv_queue_.erase(rcv_queue_.begin(), rcv_queue_.begin() + count);
+        messages_.push_back(std::move(msg));
+    }
+}
+
+int RudpSession::Input(const char* data, size_t len, int64_t current) {
+    if (state_ == RudpState::RS_CLOSED) return -1;
+    current_ = (uint32_t)current;
+    if (data == nullptr || len < OVERHEAD) return -1;
+    uint32_t prev_una = snd_una_;
+    uint32_t maxack = 0;
+    bool has_ack = false;
+    while (len >= OVERHEAD) {
+        uint32_t conv, ts, sn, una, size;
+        uint16_t wnd;
+        uint8_t cmd, frg;
+        data = decode32u(data, &conv);
+        if (conv != conv_) return -1;
+        data = decode8u(data, &cmd);
+        data = decode8u(data, &frg);
+        data = decode16u(data, &wnd);
+        data = decode32u(data, &ts);
+        data = decode32u(data, &sn);
+        data = decode32u(data, &una);
+        data = decode32u(data, &size);
+        len -= OVERHEAD;
+        if (len < size) return -2;
+        if (cmd < CMD_PUSH || cmd > CMD_CHALLENGE) return -3;
+        ts_last_recv_ = current_;
+        switch (cmd) {
+        case CMD_CONNECT:
+            //The accept was lost, the client repeats its request
+            if (state_ == RudpState::RS_CONNECTED) SendControl(CMD_ACCEPT);
+            break;
+        case CMD_ACCEPT:
+            if (state_ == RudpState::RS_CONNECTING) state_ = RudpState::RS_CONNECTED;
+            break;
+        case CMD_CHALLENGE:
+            //A connected session is challenged when its address changed, the echo moves it on the server
+            if (state_ == RudpState::RS_CONNECTING || state_ == RudpState::RS_CONNECTED) {
+                cookie_ = ((uint64_t)sn << 32) | una;
+                SendControl(CMD_CONNECT);
+            }
+            break;
+        case CMD_CLOSE:
+            state_ = RudpState::RS_CLOSED;
+            error_ = ERROR_SOCKET_CLOSEDBYPEER;
+            return 0;
+        case CMD_UNRELIABLE:
+            messages_.emplace_back(data, size);
+            break;
+        default:
+            break;
+        }
+        if (cmd == CMD_CONNECT || cmd == CMD_ACCEPT || cmd == CMD_CHALLENGE || cmd == CMD_UNRELIABLE) {
+            data += size;
+            len -= size;
+            continue;
+        }
+        rmt_wnd_ = wnd;
+        ParseUna(una);
+        ShrinkBuf();
+        if (cmd == CMD_ACK) {
+            if (time_diff(current_, ts) >= 0) {
+                UpdateAck(time_diff(current_, ts));
+            }
+            ParseAck(sn);
+            ShrinkBuf();
+            if (!has_ack || time_diff(sn, maxack) > 0) {
+                has_ack = true;
+                maxack = sn;
+            }
+        } else if (cmd == CMD_PUSH) {
+            if (time_diff(sn, rcv_nxt_ + rcv_wnd_) < 0) {
+                acklist_.emplace_back(sn, ts);
+                if (time_diff(sn, rcv_nxt_) >= 0) {
+                    Segment seg;
+                    seg.conv = conv;
+                    seg.cmd = cmd;
+                    seg.frg = frg;
+                    seg.wnd = wnd;
+                    seg.ts = ts;
+                    seg.sn = sn;
+                    seg.una = una;
+                    seg.data.assign(data, size);
+                    ParseData(seg);
+                }
+            }
+        } else if (cmd == CMD_WASK) {
+            probe_ |= kAskTell;
+        }
+        data += size;
+        len -= size;
+    }
+    if (has_ack) {
+        ParseFastack(maxack);
+    }
+    //Grow the congestion window for the newly acked data
+    if (time_diff(snd_una_, prev_una) > 0 && cwnd_ < rmt_wnd_) {
+        if (cwnd_ < ssthresh_) {
+            ++cwnd_;
+            incr_ += mss_;
+        } else {
+            if (incr_ < mss_) incr_ = mss_;
+            incr_ += (mss_ * mss_) / incr_ + (mss_ / 16);
+            if ((cwnd_ + 1) * mss_ <= incr_) {
+                cwnd_ = (incr_ + mss_ - 1) / mss_;
+            }
+        }
+        if (cwnd_ > rmt_wnd_) {
+            cwnd_ = rmt_wnd_;
+            incr_ = rmt_wnd_ * mss_;
+        }
+    }
+    return 0;
+}
+
+void RudpSession::Flush() {
+    if (!updated_ || state_ == RudpState::RS_CLOSED) return;
+    char* begin = &buffer_[0];
+    char* ptr = begin;
+    Segment seg;
+    seg.conv = conv_;
+    seg.cmd = CMD_ACK;
+    seg.wnd = WndUnused();
+    seg.una = rcv_nxt_;
+
+    for (auto& ack : acklist_) {
+        if ((size_t)(ptr - begin) + OVERHEAD > mtu_) {
+            Output(begin, ptr - begin);
+            ptr = begin;
+        }
+        seg.sn = ack.first;
+        seg.ts = ack.second;
+        ptr = Encode(ptr, seg);
+    }
+    acklist_.clear();
+
+    //Probe the window while the peer has none
+    if (rmt_wnd_ == 0) {
+        if (probe_wait_ == 0) {
+            probe_wait_ = kProbeInit;
+            ts_probe_ = current_ + probe_wait_;
+        } else if (time_diff(current_, ts_probe_) >= 0) {
+            probe_wait_ = (std::max)(probe_wait_, kProbeInit);
+            probe_wait_ += probe_wait_ / 2;
+            probe_wait_ = (std::min)(probe_wait_, kProbeLimit);
+            ts_probe_ = current_ + probe_wait_;
+            probe_ |= kAskSend;
+        }
+    } else {
+        ts_probe_ = 0;
+        probe_wait_ = 0;
+    }
+    seg.sn = 0;
+    seg.ts = 0;
+    if (probe_ & kAskSend) {
+        seg.cmd = CMD_WASK;
+        if ((size_t)(ptr - begin) + OVERHEAD > mtu_) {
+            Output(begin, ptr - begin);
+            ptr = begin;
+        }
+        ptr = Encode(ptr, seg);
+    }
+    if (probe_ & kAskTell) {
+        seg.cmd = CMD_WINS;
+        if ((size_t)(ptr - begin) + OVERHEAD > mtu_) {
+            Output(begin, ptr - begin);
+            ptr = begin;
+        }
+        ptr = Encode(ptr, seg);
+    }
+    probe_ = 0;
+
+    if (state_ != RudpState::RS_CONNECTED) {
+        Output(begin, ptr - begin);
+        return;
+    }
+
+    uint32_t cwnd = (std::min)(snd_wnd_, rmt_wnd_);
+    if (!nocwnd_) cwnd = (std::min)(cwnd_, cwnd);
+    while (time_diff(snd_nxt_, snd_una_ + cwnd) < 0 && !snd_queue_.empty()) {
+        Segment& newseg = snd_queue_.front();
+        newseg.conv = conv_;
+        newseg.cmd = CMD_PUSH;
+        newseg.wnd = seg.wnd;
+        newseg.ts = current_;
+        newseg.sn = snd_nxt_++;
+        newseg.una = rcv_nxt_;
+        newseg.resendts = current_;
+        newseg.rto = (uint32_t)rx_rto_;
+        newseg.fastack = 0;
+        newseg.xmit = 0;
+        snd_buf_.push_back(std::move(newseg));
+        snd_queue_.pop_front();
+    }
+
+    uint32_t resent = fastresend_ > 0 ? fastresend_ : 0xffffffff;
+    uint32_t rtomin = nodelay_ ? 0 : (uint32_t)(rx_rto_ >> 3);
+    bool lost = false;
+    bool change = false;
+    for (auto& segment : snd_buf_) {
+        bool needsend = false;
+        if (segment.xmit == 0) {
+            needsend = true;
+            segment.xmit++;
+            segment.rto = (uint32_t)rx_rto_;
+            segment.resendts = current_ + segment.rto + rtomin;
+        } else if (time_diff(current_, segment.resendts) >= 0) {
+            needsend = true;
+            segment.xmit++;
+            xmit_++;
+            if (nodelay_) {
+                segment.rto += (uint32_t)rx_rto_ / 2;
+            } else {
+                segment.rto += (std::max)(segment.rto, (uint32_t)rx_rto_);
+            }
+            segment.resendts = current_ + segment.rto;
+            lost = true;
+        } else if (segment.fastack >= resent && segment.xmit <= kFastackLimit) {
+            needsend = true;
+            segment.xmit++;
+            xmit_++;
+            segment.fastack = 0;
+            segment.resendts = current_ + segment.rto;
+            change = true;
+        }
+        if (!needsend) continue;
+        segment.ts = current_;
+        segment.wnd = seg.wnd;
+        segment.una = rcv_nxt_;
+        size_t need = OVERHEAD + segment.data.size();
+        if ((size_t)(ptr - begin) + need > mtu_) {
+            Output(begin, ptr - begin);
+            ptr = begin;
+        }
+        ptr = Encode(ptr, segment);
+        if (!segment.data.empty()) {
+            std::memcpy(ptr, segment.data.data(), segment.data.size());
+            ptr += segment.data.size();
+        }
+        if (segment.xmit >= dead_link_) {
+            error_ = ERROR_SOCKET_WRITE;
+        }
+    }
+    Output(begin, ptr - begin);
+
+    //Shrink the congestion window on loss
+    if (change) {
+        uint32_t inflight = snd_nxt_ - snd_una_;
+        ssthresh_ = (std::max)(inflight / 2, kThreshMin);
+        cwnd_ = ssthresh_ + resent;
+        incr_ = cwnd_ * mss_;
+    }
+    if (lost) {
+        ssthresh_ = (std::max)(cwnd / 2, kThreshMin);
+        cwnd_ = 1;
+        incr_ = mss_;
+    }
+    if (cwnd_ < 1) {
+        cwnd_ = 1;
+        incr_ = mss_;
+    }
+}
+
+void RudpSession::Update(int64_t current) {
+    current_ = (uint32_t)current;
+    if (!updated_) {
+        updated_ = true;
+        ts_flush_ = current_;
+    }
+    int32_t slap = time_diff(current_, ts_flush_);
+    if (slap >= 10000 || slap < -10000) {
+        ts_flush_ = current_;
+        slap = 0;
+    }
+    if (slap < 0) return;
+    ts_flush_ += interval_;
+    if (time_diff(current_, ts_flush_) >= 0) {
+        ts_flush_ = current_ + interval_;
+    }
+    if (state_ == RudpState::RS_CONNECTING && time_diff(current_, ts_last_send_) >= rx_rto_) {
+        SendControl(CMD_CONNECT);
+    } else if (state_ == RudpState::RS_CONNECTED && timeout_ > 0 &&
+               time_diff(current_, ts_last_send_) >= (int32_t)(timeout_ / 3)) {
+        //Keepalive, so that a quiet session does not hit the peer idle timeout
+        probe_ |= kAskTell;
+    }
+    Flush();
+}
+
+int RudpSession::Check(int64_t current) {
+    if (error_ != ERROR_OK) return error_;
+    uint32_t now = (uint32_t)current;
+    if (state_ == RudpState::RS_CONNECTING) {
+        if (timeout_ > 0 && time_diff(now, ts_connect_) >= (int32_t)timeout_) {
+            error_ = ERROR_SOCKET_CONNECTTIMEOUT;
+        }
+    } else if (state_ == RudpState::RS_CONNECTED) {
+        if (timeout_ > 0 && time_diff(now, ts_last_recv_) >= (int32_t)timeout_) {
+            error_ = ERROR_SOCKET_READ;
+        }
+    }
+    return error_;
+}
+}
+}
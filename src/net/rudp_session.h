@@ -0,0 +1,252 @@
+// Copyright (C), Xianfeng Shang.  All rights reserved.
+// Author: Xianfeng Shang (shangxianfeng@outlook.com)
+#pragma once
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace tinynet {
+namespace net {
+
+/**
+ * @brief Reliable UDP session options
+ *
+ */
+struct RudpOptions {
+    int mtu{ 1400 }; ///< Largest datagram sent, messages above mtu are fragmented
+    int interval{ 10 }; ///< Update interval in ms
+    bool nodelay{ false }; ///< Lower minimum rto and linear rto backoff
+    int resend{ 0 }; ///< Fast retransmit once a segment is skipped by this many acks, 0 disables it
+    bool nocwnd{ false }; ///< Send up to the windows regardless of congestion control
+    int snd_wnd{ 32 }; ///< Send window in segments
+    int rcv_wnd{ 128 }; ///< Receive window in segments
+    int dead_link{ 20 }; ///< Transmissions of one segment before the session is considered dead
+    int timeout_ms{ 10000 }; ///< Idle time before the session is considered dead
+    int max_sessions{ 10000 }; ///< Sessions a server endpoint keeps, further connection requests are refused, 0 is unlimited
+    bool connect_cookie{ true }; ///< A server endpoint keeps no state for a connection request until the client echoes a stateless cookie
+    int drop_rate{ 0 }; ///< Percent of the received datagrams the endpoint drops, simulates a lossy network in tests
+};
+
+/**
+ * @brief Connection state of a reliable UDP session
+ *
+ */
+enum class RudpState {
+    RS_INIT = 0,
+    RS_CONNECTING = 1,
+    RS_CONNECTED = 2,
+    RS_CLOSED = 3
+};
+
+//KCP style ARQ over datagrams: selective acks carried per segment plus the cumulative una,
+//fast retransmit on skipped acks, windows and an optional congestion window.
+//The session does no IO, datagrams go out through the output callback and come in with Input().
+class RudpSession {
+    friend class RudpEndpoint;
+  public:
+    static const uint32_t OVERHEAD = 24;
+    enum Command {
+        CMD_PUSH = 81, ///< Reliable data segment
+        CMD_ACK = 82, ///< Ack of one segment
+        CMD_WASK = 83, ///< Window probe
+        CMD_WINS = 84, ///< Window size, also used as keepalive
+        CMD_UNRELIABLE = 85, ///< Unreliable datagram, delivered as it comes
+        CMD_CONNECT = 86, ///< Connection request, repeated until accepted
+        CMD_ACCEPT = 87, ///< Connection accepted
+        CMD_CLOSE = 88, ///< Connection closed
+        CMD_CHALLENGE = 89 ///< Cookie the client echoes in its next connection request
+    };
+    typedef std::function<void(const char* data, size_t len)> OutputCallback;
+    typedef std::function<void()> EventCallback;
+    typedef std::function<void(int)> ErrorCallback;
+  public:
+    RudpSession(uint32_t conv, const RudpOptions& opts);
+    ~RudpSession();
+  private:
+    RudpSession(const RudpSession&) = delete;
+    RudpSession& operator=(const RudpSession&) = delete;
+  public:
+    /**
+     * @brief Starts the client side handshake
+     *
+     * @param current
+     */
+    void Connect(int64_t current);
+    /**
+     * @brief Accepts a connection request received by a server endpoint
+     *
+     * @param current
+     */
+    void Accept(int64_t current);
+    /**
+     * @brief Tells the peer the session is closed and stops the session
+     *
+     */
+    void Close();
+    /**
+     * @brief Queues a reliable message, returns ERROR_OK or an error code when the message exceeds the window
+     *
+     * @param data
+     * @param len
+     * @return int
+     */
+    int Send(const char* data, size_t len);
+    /**
+     * @brief Sends an unreliable message right away, it must fit into one datagram
+     *
+     * @param data
+     * @param len
+     * @return int
+     */
+    int SendUnreliable(const char* data, size_t len);
+    /**
+     * @brief Feeds a received datagram, returns -1 when it is malformed or belongs to another session
+     *
+     * @param data
+     * @param len
+     * @param current
+     * @return int
+     */
+    int Input(const char* data, size_t len, int64_t current);
+    /**
+     * @brief Pops a delivered message
+     *
+     * @param msg
+     * @return true
+     * @return false
+     */
+    bool Recv(std::string* msg);
+    /**
+     * @brief Sends acks, new segments and retransmissions when the update interval elapsed
+     *
+     * @param current
+     */
+    void Update(int64_t current);
+    /**
+     * @brief Sends acks, new segments and retransmissions now
+     *
+     */
+    void Flush();
+    /**
+     * @brief Returns the error which killed the session, ERROR_OK while it is alive
+     *
+     * @param current
+     * @return int
+     */
+    int Check(int64_t current);
+  public:
+    static uint32_t PeekConv(const char* data, size_t len);
+    static int PeekCommand(const char* data, size_t len);
+    /**
+     * @brief Reads the cookie of a connection request or a challenge, carried in the sn and una fields
+     *
+     * @param data
+     * @param len
+     * @return uint64_t 0 when there is none
+     */
+    static uint64_t PeekCookie(const char* data, size_t len);
+    /**
+     * @brief Writes a control datagram of no session, a server endpoint answers with it before keeping any state
+     *
+     * @param buf OVERHEAD bytes at least
+     * @param conv
+     * @param cmd
+     * @param cookie
+     * @return size_t
+     */
+    static size_t EncodeControl(char* buf, uint32_t conv, uint32_t cmd, uint64_t cookie);
+  public:
+    uint32_t get_conv() const { return conv_; }
+    RudpState get_state() const { return state_; }
+    bool is_connected() const { return state_ == RudpState::RS_CONNECTED; }
+    bool has_message() const { return !messages_.empty(); }
+    size_t get_wait_send() const { return snd_buf_.size() + snd_queue_.size(); }
+    uint32_t get_rto() const { return rx_rto_; }
+    uint64_t get_retransmits() const { return xmit_; }
+    void set_output_callback(OutputCallback cb) { output_callback_ = std::move(cb); }
+    void set_conn_callback(EventCallback cb) { conn_callback_ = std::move(cb); }
+    void set_read_callback(EventCallback cb) { read_callback_ = std::move(cb); }
+    void set_error_callback(ErrorCallback cb) { error_callback_ = std::move(cb); }
+    const std::string& get_peer_address() const { return peer_address_; }
+  private:
+    struct Segment {
+        uint32_t conv{ 0 };
+        uint32_t cmd{ 0 };
+        uint32_t frg{ 0 };
+        uint32_t wnd{ 0 };
+        uint32_t ts{ 0 };
+        uint32_t sn{ 0 };
+        uint32_t una{ 0 };
+        uint32_t resendts{ 0 };
+        uint32_t rto{ 0 };
+        uint32_t fastack{ 0 };
+        uint32_t xmit{ 0 };
+        std::string data;
+    };
+    char* Encode(char* ptr, const Segment& seg);
+    void Output(const char* data, size_t len);
+    void SendControl(uint32_t cmd);
+    void UpdateAck(int32_t rtt);
+    void ShrinkBuf();
+    void ParseAck(uint32_t sn);
+    void ParseUna(uint32_t una);
+    void ParseFastack(uint32_t sn);
+    void ParseData(Segment& seg);
+    void Deliver();
+    uint32_t WndUnused() const;
+  private:
+    uint32_t conv_;
+    uint32_t mtu_;
+    uint32_t mss_;
+    RudpState state_{ RudpState::RS_INIT };
+    int error_{ 0 };
+    uint32_t snd_una_{ 0 };
+    uint32_t snd_nxt_{ 0 };
+    uint32_t rcv_nxt_{ 0 };
+    uint32_t ssthresh_;
+    int32_t rx_rttval_{ 0 };
+    int32_t rx_srtt_{ 0 };
+    int32_t rx_rto_;
+    int32_t rx_minrto_;
+    uint32_t snd_wnd_;
+    uint32_t rcv_wnd_;
+    uint32_t rmt_wnd_;
+    uint32_t cwnd_{ 0 };
+    uint32_t incr_{ 0 };
+    uint32_t probe_{ 0 };
+    uint32_t current_{ 0 };
+    uint32_t interval_;
+    uint32_t ts_flush_;
+    uint32_t ts_probe_{ 0 };
+    uint32_t probe_wait_{ 0 };
+    uint32_t ts_connect_{ 0 };
+    uint32_t ts_last_recv_{ 0 };
+    uint32_t ts_last_send_{ 0 };
+    uint32_t dead_link_;
+    uint32_t timeout_;
+    uint32_t fastresend_;
+    bool nodelay_;
+    bool nocwnd_;
+    bool updated_{ false };
+    uint64_t cookie_{ 0 }; ///< Echoed in the connection requests once the server challenged them
+    uint64_t xmit_{ 0 };
+    std::deque<Segment> snd_queue_; ///< Segments waiting for the window
+    std::deque<Segment> snd_buf_; ///< Segments sent and not acked yet
+    std::deque<Segment> rcv_buf_; ///< Out of order segments
+    std::deque<Segment> rcv_queue_; ///< In order fragments of an incomplete message
+    std::vector<std::pair<uint32_t, uint32_t> > acklist_; ///< sn and ts of the segments to ack
+    std::deque<std::string> messages_; ///< Complete messages ready for Recv()
+    std::vector<char> buffer_; ///< Datagram under construction
+    OutputCallback output_callback_;
+    EventCallback conn_callback_; ///< Raised by the endpoint once a client session is accepted
+    EventCallback read_callback_; ///< Raised by the endpoint when messages are ready
+    ErrorCallback error_callback_; ///< Raised by the endpoint when the session dies
+    std::string peer_address_;
+};
+
+typedef std::shared_ptr<RudpSession> RudpSessionPtr;
+}
+}
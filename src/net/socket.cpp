@@ -7,6 +7,7 @@
 #include "event_loop.h"
 #include "base/error_code.h"
 #include "base/io_buffer_stream.h"
+#include "logging/logging.h"
 
 namespace tinynet {
 namespace net {
@@ -15,10 +16,25 @@ static int kTcpKeepAlive_ms = 60000; //Default keepalive timeout
 
 static int kConnectTimeout_ms = 30000; //Default connect timeout
 
+#if defined(IOV_MAX) && IOV_MAX < 1024
+static const int kMaxWriteIovs = IOV_MAX;
+#else
+static const int kMaxWriteIovs = 1024;
+#endif
+
+OverflowPolicy ParseOverflowPolicy(const std::string& name) {
+    if (name == "drop_newest") return OverflowPolicy::OP_DROP_NEWEST;
+    if (name == "drop_oldest") return OverflowPolicy::OP_DROP_OLDEST;
+    if (name == "disconnect") return OverflowPolicy::OP_DISCONNECT;
+    return OverflowPolicy::OP_NONE;
+}
+
 Socket::Socket(EventLoop* loop):
     FileDescriptor(loop, -1),
     af_(AF_UNSPEC),
     status_(SocketStatus::SS_UNSPEC),
+    rbuf_(loop->get_buffer_pool()),
+    wbuf_(loop->get_buffer_pool()),
     connect_timer_(INVALID_TIMER_ID) {
 }
 
@@ -26,6 +42,8 @@ Socket::Socket(EventLoop* loop, int fd, int af, const std::string* peer_address)
     FileDescriptor(loop, fd),
     af_(af),
     status_(SocketStatus::SS_UNSPEC),
+    rbuf_(loop->get_buffer_pool()),
+    wbuf_(loop->get_buffer_pool()),
     connect_timer_(INVALID_TIMER_ID) {
     if (peer_address)
         peer_address_ = *peer_address;
@@ -72,24 +90,240 @@ void Socket::Write(const void *data, size_t len) {
     if (mask_ & EVENT_ERROR)
         return;
     int nwrite = 0;
-    if (mask_ & EVENT_WRITABLE) {
-        int err = NetUtils::WriteAll(fd_, data, len, &nwrite);
+    if ((mask_ & EVENT_WRITABLE) && !corked_ && get_pending_write() == 0 && CanWriteDirect()) {
+        int err = WriteDirect(data, len, &nwrite);
         if (err) {
             SetError(err);
             return;
         }
+        sent_bytes_ += nwrite;
         if ((size_t)nwrite >= len)
             return;
         mask_ &= ~EVENT_WRITABLE;
     }
-    wbuf_.append((const char*)data + nwrite, len - nwrite);
+    if (wchain_) {
+        wchain_->append((const char*)data + nwrite, len - nwrite);
+    } else {
+        wbuf_.append((const char*)data + nwrite, len - nwrite);
+    }
+    if (corked_) {
+        Cork();
+    } else {
+        Writable();
+    }
+    CheckHighWater();
+}
+
+void Socket::Suspend() {
+    if (fd_ == -1) return;
+    ClearEvent(EVENT_FULL_MASK);
+    //The readiness is unknown by the time it resumes, the poll reports it again
+    mask_ &= ~(EVENT_READABLE | EVENT_WRITABLE);
+}
+
+void Socket::Resume() {
+    if (fd_ == -1 || (mask_ & EVENT_ERROR)) return;
+    int mask = EVENT_READABLE;
+    if (get_pending_write() > 0) mask |= EVENT_WRITABLE;
+    if (AddEvent(mask) == -1) {
+        SetError(ERROR_EVENTLOOP_REGISTER);
+    }
+}
+
+int Socket::WriteDirect(const void* data, size_t len, int* nwrite) {
+    return NetUtils::WriteAll(fd_, data, len, nwrite);
+}
+
+void Socket::set_watermarks(size_t high, size_t low, OverflowPolicy policy) {
+    high_watermark_ = high;
+    low_watermark_ = (std::min)(low, high);
+    overflow_policy_ = policy;
+    if (policy != OverflowPolicy::OP_DROP_OLDEST) {
+        droppable_.clear();
+    }
+}
+
+bool Socket::Admit(size_t len) {
+    if (mask_ & EVENT_ERROR)
+        return false;
+    if (high_watermark_ == 0 || get_pending_write() + len <= high_watermark_)
+        return true;
+    switch (overflow_policy_) {
+    case OverflowPolicy::OP_DROP_NEWEST:
+        ++dropped_writes_;
+        return false;
+    case OverflowPolicy::OP_DROP_OLDEST:
+        if (CanDropQueued()) {
+            DropOldest(len);
+        } else {
+            //The head of the queue may be half way through the TLS record layer, drop the new one instead
+            ++dropped_writes_;
+            return false;
+        }
+        return true;
+    case OverflowPolicy::OP_DISCONNECT:
+        log_warning("Disconnect %s, %zu bytes pending output exceed the high watermark",
+                    peer_address_.c_str(), get_pending_write());
+        SetError(ERROR_SOCKET_CLOSEDBYSERVER);
+        return false;
+    default:
+        return true;
+    }
+}
+
+void Socket::MarkDroppable(size_t offset) {
+    if (overflow_policy_ != OverflowPolicy::OP_DROP_OLDEST)
+        return;
+    size_t end = get_write_offset();
+    //Partly sent messages can not be taken back
+    if (offset >= end || offset < sent_bytes_)
+        return;
+    droppable_.push_back(WriteSpan{ offset, end });
+}
+
+void Socket::DropOldest(size_t len) {
+    size_t i = 0;
+    while (i < droppable_.size() && get_pending_write() + len > high_watermark_) {
+        WriteSpan span = droppable_[i];
+        if (span.begin < sent_bytes_) {
+            ++i;
+            continue;
+        }
+        size_t n = span.end - span.begin;
+        EraseQueued(span.begin - sent_bytes_, n);
+        droppable_.erase(droppable_.begin() + i);
+        for (size_t j = i; j < droppable_.size(); ++j) {
+            droppable_[j].begin -= n;
+            droppable_[j].end -= n;
+        }
+        ++dropped_writes_;
+    }
+}
+
+void Socket::EraseQueued(size_t pos, size_t len) {
+    if (wchain_) {
+        //The chain holds the older bytes, frames staged in wbuf_ follow it
+        size_t chain_size = wchain_->size();
+        if (pos < chain_size) {
+            size_t n = (std::min)(len, chain_size - pos);
+            wchain_->erase(pos, n);
+            len -= n;
+            pos = 0;
+        } else {
+            pos -= chain_size;
+        }
+    }
+    if (len > 0) {
+        wbuf_.erase(pos, len);
+    }
+}
+
+void Socket::WriteProgress(size_t nbytes) {
+    sent_bytes_ += nbytes;
+    if (!droppable_.empty()) {
+        size_t n = 0;
+        while (n < droppable_.size() && droppable_[n].end <= sent_bytes_) {
+            ++n;
+        }
+        droppable_.erase(droppable_.begin(), droppable_.begin() + n);
+    }
+    if (above_high_ && get_pending_write() <= low_watermark_) {
+        above_high_ = false;
+        Invoke(drain_callback_);
+    }
+}
+
+void Socket::CheckHighWater() {
+    if (high_watermark_ == 0 || above_high_)
+        return;
+    if (get_pending_write() >= high_watermark_ && !(mask_ & EVENT_ERROR)) {
+        above_high_ = true;
+        Invoke(highwater_callback_);
+    }
+}
+
+void Socket::EnableCorkedWrite(size_t flush_bytes) {
+    corked_ = true;
+    cork_flush_bytes_ = flush_bytes;
+}
+
+void Socket::Cork() {
+    ++corked_writes_;
+    if (get_pending_write() >= cork_flush_bytes_) {
+        Uncork();
+        return;
+    }
+    if (!dirty_) {
+        dirty_ = true;
+        event_loop_->AddDirty(std::static_pointer_cast<Socket>(shared_from_this()));
+    }
+}
+
+int Socket::Uncork() {
+    dirty_ = false;
+    int nwrites = corked_writes_;
+    if (nwrites == 0) return 0;
+    corked_writes_ = 0;
+    if (is_closed() || (mask_ & EVENT_ERROR)) return 0;
+    event_loop_->CountCorkFlush(nwrites);
     Writable();
+    return nwrites;
+}
+
+void Socket::CopyPendingWrite(std::string* data) {
+    data->clear();
+    if (wchain_) {
+        //The chain goes first, codecs leave bytes in wbuf_ until the next flush moves them
+        std::vector<iov_t> iovs(kMaxWriteIovs);
+        int niov;
+        while ((niov = wchain_->peek(iovs.data(), (int)iovs.size())) == (int)iovs.size()) {
+            iovs.resize(iovs.size() * 2);
+        }
+        for (int i = 0; i < niov; ++i) {
+            data->append((const char*)iovs[i].base, iovs[i].len);
+        }
+    }
+    data->append(wbuf_.begin(), wbuf_.size());
+}
+
+void Socket::EnableChainedWrite() {
+    if (wchain_) return;
+    wchain_.reset(new(std::nothrow) IOBufferChain(event_loop_->get_buffer_pool()));
+    if (wchain_ && !wbuf_.empty()) {
+        wchain_->append(wbuf_.begin(), wbuf_.size());
+        wbuf_.clear();
+    }
+}
+
+char* Socket::PrepareWrite(size_t n) {
+    if (wchain_) {
+        if (!wbuf_.empty()) {
+            wchain_->append(wbuf_.begin(), wbuf_.size());
+            wbuf_.clear();
+        }
+        return wchain_->prepare(n);
+    }
+    wbuf_.reserve(wbuf_.size() + n);
+    return wbuf_.end();
+}
+
+void Socket::CommitWrite(size_t n) {
+    if (wchain_) {
+        wchain_->commit(n);
+    } else {
+        wbuf_.commit(n);
+    }
 }
 
 void Socket::Flush() {
     if (mask_ & EVENT_ERROR)
         return;
-    Writable();
+    if (corked_) {
+        Cork();
+    } else {
+        Writable();
+    }
+    CheckHighWater();
 }
 
 int Socket::Connect(const std::string &host, int port, int timeout) {
@@ -135,28 +369,59 @@ void Socket::StreamReadable() {
         return;
 
     int err = ERROR_OK;
+    bool replay = false;
     if (mask_ & EVENT_READABLE) {
-        int nbytes = 0;
+        size_t nbytes = 0;
+        char* spill = event_loop_->get_read_spill();
         for (;;) {
-            if (rbuf_.size() == rbuf_.capacity()) {
-                rbuf_.reserve(rbuf_.size() + 8196);
+            //Fill the spare capacity first, the overflow lands in the loop spill area
+            iov_t iovs[2];
+            int niov = 0;
+            size_t spare = rbuf_.capacity() - rbuf_.size();
+            size_t len = spare + EventLoop::READ_SPILL_SIZE;
+            if (read_limit_ > 0 && len > read_limit_ - nbytes) {
+                len = read_limit_ - nbytes;
+                spare = (std::min)(spare, len);
+            }
+            if (spare > 0) {
+                iovs[niov].base = rbuf_.end();
+                iovs[niov].len = static_cast<decltype(iovs[niov].len)>(spare);
+                ++niov;
+            }
+            if (len > spare) {
+                iovs[niov].base = spill;
+                iovs[niov].len = static_cast<decltype(iovs[niov].len)>(len - spare);
+                ++niov;
             }
-            size_t len = rbuf_.capacity() - rbuf_.size();
             int nread = 0;
-            err = NetUtils::ReadAll(fd_, rbuf_.end(), len, &nread);
+            err = NetUtils::ReadAll(fd_, iovs, niov, &nread);
             if (nread > 0) {
-                rbuf_.resize(rbuf_.size() + nread);
-                nbytes += nread;
+                size_t n = static_cast<size_t>(nread);
+                if (n <= spare) {
+                    rbuf_.resize(rbuf_.size() + n);
+                } else {
+                    rbuf_.resize(rbuf_.size() + spare);
+                    rbuf_.append(spill, n - spare);
+                }
+                nbytes += n;
+            }
+            if (err || (size_t)nread < len) break;
+            if (read_limit_ > 0 && nbytes >= read_limit_) {
+                //Leave the rest for the next iteration so that other sockets get their turn
+                event_loop_->ReplayEvent(fd_, EVENT_READABLE);
+                replay = true;
+                break;
             }
-            if (err || nread < (int)len) break;
         }
 
         if (nbytes > 0) {
             Invoke(read_callback_);
         }
+        rbuf_.release();
         mask_ &= ~EVENT_READABLE;
     }
-    if ((mask_ & EVENT_READABLE) == 0 && err == ERROR_OK) {
+    //A replayed pass re-arms once it reads all, re-arming now as well would dispatch twice
+    if ((mask_ & EVENT_READABLE) == 0 && err == ERROR_OK && !replay) {
         if (AddEvent(EVENT_READABLE) == -1) {
             err = ERROR_EVENTLOOP_REGISTER;
         }
@@ -169,6 +434,10 @@ void Socket::StreamReadable() {
 void Socket::StreamWritable() {
     if (mask_ & EVENT_ERROR)
         return;
+    if (wchain_) {
+        ChainWritable();
+        return;
+    }
 
     int err = ERROR_OK;
     if (mask_ & EVENT_WRITABLE) {
@@ -177,13 +446,16 @@ void Socket::StreamWritable() {
             err = NetUtils::WriteAll(fd_, wbuf_.begin(), wbuf_.size(), &nbytes);
             if (nbytes > 0) {
                 wbuf_.consume(static_cast<size_t>(nbytes));
+                WriteProgress(static_cast<size_t>(nbytes));
                 Invoke(write_callback_);
             }
         }
-        if (wbuf_.size() > 0)
+        if (wbuf_.size() > 0) {
             mask_ &= ~EVENT_WRITABLE;
-        else
+        } else {
+            wbuf_.release();
             ClearEvent(EVENT_WRITABLE);
+        }
     }
     if (err == ERROR_OK && wbuf_.size() > 0) {
         if (AddEvent(EVENT_WRITABLE) == -1) {
@@ -195,6 +467,43 @@ void Socket::StreamWritable() {
     }
 }
 
+void Socket::ChainWritable() {
+    if (!wbuf_.empty()) {
+        //Frames encoded straight into wbuf() by codecs
+        wchain_->append(wbuf_.begin(), wbuf_.size());
+        wbuf_.clear();
+    }
+    int err = ERROR_OK;
+    if (mask_ & EVENT_WRITABLE) {
+        if (!wchain_->empty()) {
+            iov_t iovs[kMaxWriteIovs];
+            int niov = wchain_->peek(iovs, kMaxWriteIovs);
+            int nbytes = 0;
+            err = NetUtils::WriteAll(fd_, iovs, niov, &nbytes);
+            if (nbytes > 0) {
+                wchain_->consume(static_cast<size_t>(nbytes));
+                WriteProgress(static_cast<size_t>(nbytes));
+                Invoke(write_callback_);
+            }
+        }
+        if (!wchain_->empty()) {
+            mask_ &= ~EVENT_WRITABLE;
+        } else {
+            wchain_->clear();
+            wbuf_.release();
+            ClearEvent(EVENT_WRITABLE);
+        }
+    }
+    if (err == ERROR_OK && !wchain_->empty()) {
+        if (AddEvent(EVENT_WRITABLE) == -1) {
+            err = ERROR_EVENTLOOP_REGISTER;
+        }
+    }
+    if (err != ERROR_OK) {
+        SetError(err);
+    }
+}
+
 void Socket::Dispose(bool disposed) noexcept {
     if (status_ == SocketStatus::SS_CONNECTING) {
         event_loop_->ClearTimer(connect_timer_);
@@ -207,6 +516,10 @@ void Socket::Dispose(bool disposed) noexcept {
     } else {
         rbuf_.clear();
         wbuf_.clear();
+        rbuf_.release();
+        wbuf_.release();
+        if (wchain_) wchain_->clear();
+        droppable_.clear();
     }
 }
 
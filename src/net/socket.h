@@ -2,10 +2,12 @@
 // Author: Xianfeng Shang (shangxianfeng@outlook.com)
 #pragma once
 #include "base/io_buffer.h"
+#include "base/io_buffer_chain.h"
 #include "base/net_types.h"
 #include "file_descriptor.h"
 #include <functional>
 #include <memory>
+#include <vector>
 
 namespace tinynet {
 /// Forward declaration of event loop class
@@ -24,6 +26,25 @@ enum class SocketStatus {
     SS_MAX = 4
 };
 
+/**
+ * @brief What a write crossing the high watermark does
+ *
+ */
+enum class OverflowPolicy {
+    OP_NONE = 0, ///< Queue anyway, only the watermark events are raised
+    OP_DROP_NEWEST = 1, ///< Discard the message being written
+    OP_DROP_OLDEST = 2, ///< Discard the oldest queued messages marked droppable which have not started sending
+    OP_DISCONNECT = 3 ///< Close the connection with ERROR_SOCKET_CLOSEDBYSERVER
+};
+
+/**
+ * @brief Map "drop_newest", "drop_oldest" and "disconnect" to the policy, anything else is OP_NONE
+ *
+ * @param name
+ * @return OverflowPolicy
+ */
+OverflowPolicy ParseOverflowPolicy(const std::string& name);
+
 /**
  * @brief Basic socket class
  *
@@ -62,6 +83,120 @@ class Socket:
      * @return IOBuffer*
      */
     IOBuffer* wbuf() { return &wbuf_; }
+    /**
+     * @brief Access the chained write buffer, nullptr unless chained writes are enabled
+     *
+     * @return IOBufferChain*
+     */
+    IOBufferChain* wchain() { return wchain_.get(); }
+    /**
+     * @brief Queue outgoing data in a chain of pooled blocks flushed with writev instead of the flat write buffer.
+     * Bytes left in wbuf() by codecs are moved to the chain on Flush().
+     */
+    void EnableChainedWrite();
+    /**
+     * @brief Returns n contiguous bytes at the end of the outgoing queue for a codec to encode into
+     *
+     * @param n
+     * @return char*
+     */
+    char* PrepareWrite(size_t n);
+    /**
+     * @brief Queues n bytes encoded into the region returned by PrepareWrite()
+     *
+     * @param n
+     */
+    void CommitWrite(size_t n);
+    /**
+     * @brief Defer writes and flushes to the end of the loop iteration, queued data is sent in one go.
+     * A flush happens right away once flush_bytes are queued.
+     *
+     * @param flush_bytes
+     */
+    void EnableCorkedWrite(size_t flush_bytes);
+    /**
+     * @brief Caps the bytes read per readable event, the rest is read on the next loop iteration
+     *
+     * @param max_bytes 0 means unlimited
+     */
+    void set_read_limit(size_t max_bytes) { read_limit_ = max_bytes; }
+    /**
+     * @brief Stops dispatching the events of the socket, the buffers are kept as they are.
+     * Nothing may be written meanwhile, a write registers the socket again.
+     *
+     */
+    void Suspend();
+    /**
+     * @brief Dispatches the events again after Suspend(), the data which came meanwhile is read on the next poll
+     *
+     */
+    void Resume();
+    /**
+     * @brief Sends the data queued by corked writes, returns the number of writes coalesced
+     *
+     * @return int
+     */
+    virtual int Uncork();
+    /**
+     * @brief Number of bytes queued for sending
+     *
+     * @return size_t
+     */
+    size_t get_pending_write() const { return wchain_ ? wchain_->size() + wbuf_.size() : wbuf_.size(); }
+    /**
+     * @brief Copies the bytes queued for sending in stream order
+     *
+     * @param data
+     */
+    void CopyPendingWrite(std::string* data);
+    /**
+     * @brief Stream offset right after the last queued byte, pass it to MarkDroppable() once a message is queued
+     *
+     * @return size_t
+     */
+    size_t get_write_offset() const { return sent_bytes_ + get_pending_write(); }
+    /**
+     * @brief Raise the high water callback once the pending output reaches high,
+     * and the drain callback when it falls back to low. high == 0 disables watermarks.
+     *
+     * @param high
+     * @param low
+     * @param policy
+     */
+    void set_watermarks(size_t high, size_t low, OverflowPolicy policy);
+    /**
+     * @brief Applies the overflow policy to a message of len bytes before it is encoded,
+     * returns false when the message must not be written
+     *
+     * @param len
+     * @return true
+     * @return false
+     */
+    bool Admit(size_t len);
+    /**
+     * @brief Marks the bytes queued since offset as one message OP_DROP_OLDEST may discard
+     *
+     * @param offset value of get_write_offset() before the message was written
+     */
+    void MarkDroppable(size_t offset);
+    /**
+     * @brief Set the high water callback object
+     *
+     * @param cb
+     */
+    void set_highwater_callback(EventCallback cb) { highwater_callback_ = std::move(cb); }
+    /**
+     * @brief Set the drain callback object
+     *
+     * @param cb
+     */
+    void set_drain_callback(EventCallback cb) { drain_callback_ = std::move(cb); }
+    /**
+     * @brief Number of messages discarded by the overflow policy
+     *
+     * @return uint64_t
+     */
+    uint64_t get_dropped_writes() const { return dropped_writes_; }
   public:
     /**
      * @brief Read() attempts to read up to len bytes from the read buffer into the buffer starting at buf.
@@ -158,6 +293,13 @@ class Socket:
      * @return const std::string&
      */
     const std::string& get_peer_address() const { return peer_address_; }
+
+    /**
+     * @brief Get the address family
+     *
+     * @return int
+     */
+    int get_af() const { return af_; }
   protected:
     /**
      * @brief Open() will be called after the connection made
@@ -174,13 +316,78 @@ class Socket:
      *
      */
     void StreamWritable();
+    /**
+     * @brief Write function for raw stream socket with chained write buffer
+     *
+     */
+    void ChainWritable();
+    /**
+     * @brief Flushes now in normal mode, marks the socket dirty in corked mode
+     *
+     */
+    void Cork();
+    /**
+     * @brief Accounts nbytes taken off the send queue, raises the drain callback below the low watermark
+     *
+     * @param nbytes
+     */
+    void WriteProgress(size_t nbytes);
+    /**
+     * @brief Raises the high water callback once the pending output reaches the high watermark
+     *
+     */
+    void CheckHighWater();
+    /**
+     * @brief Whether queued bytes not handed to the OS yet may be discarded
+     *
+     * @return true
+     * @return false
+     */
+    virtual bool CanDropQueued() { return true; }
+    /**
+     * @brief Whether Write() may hand data to the fd directly instead of going through Writable()
+     *
+     * @return true
+     * @return false
+     */
+    virtual bool CanWriteDirect() { return true; }
+    /**
+     * @brief Hands data to the transport right away, stores the number of bytes taken in nwrite
+     *
+     * @param data
+     * @param len
+     * @param nwrite
+     * @return int
+     */
+    virtual int WriteDirect(const void* data, size_t len, int* nwrite);
   private:
     void Dispose(bool disposed) noexcept;
+    void DropOldest(size_t len);
+    void EraseQueued(size_t pos, size_t len);
   protected:
     int			  af_; ///< Adress family
     SocketStatus  status_; ///< Socket status
     IOBuffer      rbuf_; ///< Read buffer
     IOBuffer      wbuf_; ///< Write buffer
+    std::unique_ptr<IOBufferChain> wchain_; ///< Chained write buffer, replaces wbuf_ as the send queue when set
+    bool          corked_{ false }; ///< Writes are deferred to the end of the loop iteration
+    bool          dirty_{ false }; ///< Queued in the event loop dirty list
+    int           corked_writes_{ 0 }; ///< Writes deferred since the last flush
+    size_t        cork_flush_bytes_{ 0 }; ///< Queued bytes forcing an immediate flush in corked mode
+    size_t        read_limit_{ 0 }; ///< Bytes read per readable event, 0 means unlimited
+    size_t        high_watermark_{ 0 }; ///< Pending output raising the high water callback, 0 disables watermarks
+    size_t        low_watermark_{ 0 }; ///< Pending output raising the drain callback
+    OverflowPolicy overflow_policy_{ OverflowPolicy::OP_NONE }; ///< Policy for writes crossing the high watermark
+    bool          above_high_{ false }; ///< High water was raised and drain was not yet
+    size_t        sent_bytes_{ 0 }; ///< Bytes handed to the OS since the socket was created
+    uint64_t      dropped_writes_{ 0 }; ///< Messages discarded by the overflow policy
+    struct WriteSpan {
+        size_t begin;
+        size_t end;
+    };
+    std::vector<WriteSpan> droppable_; ///< Queued droppable messages in stream order
+    EventCallback highwater_callback_; ///< High water callback
+    EventCallback drain_callback_; ///< Drain callback
     EventCallback conn_callback_; ///< Connection callback
     std::string   peer_address_; ///< Peer address
     int64_t       connect_timer_;
@@ -5,6 +5,7 @@
 #include "socket_server.h"
 #include "stream_socket.h"
 #include "ssl_socket.h"
+#include "ipc/shm_socket.h"
 #include "base/unique_id.h"
 #include "base/error_code.h"
 #include "util/uri_utils.h"
@@ -42,7 +43,9 @@ void SocketChannel::Init(ChannelOptions& opts) {
     opts_.timeout = opts_.timeout ? opts_.timeout : kConnectTimeout;
     if (opts.name.empty()) opts_.name = "Socket";
 
-    if (!opts_.url.empty()) {
+    if (ipc::ShmSocket::is_shm_url(opts_.url)) {
+        opts_.use_ssl = false;
+    } else if (!opts_.url.empty()) {
         UriUtils::uri_info info;
         if (UriUtils::parse_uri(opts_.url, info)) {
             opts_.host = info.host;
@@ -60,7 +63,9 @@ void SocketChannel::Init(ChannelOptions& opts) {
         ssl_ctx_->Init(ssl_opts);
     }
 
-    if (!opts_.path.empty()) {
+    if (ipc::ShmSocket::is_shm_url(opts_.url)) {
+        address_ = opts_.url;
+    } else if (!opts_.path.empty()) {
         UriUtils::format_address(address_, "unix", opts_.path, nullptr);
     } else {
         UriUtils::format_address(address_, "tcp", opts_.host, &opts.port);
@@ -104,11 +109,16 @@ void SocketChannel::set_socket(SocketPtr sock) {
     socket_->set_read_callback(std::bind(&SocketChannel::OnRead, this));
     socket_->set_error_callback(std::bind(&SocketChannel::HandleError, this, std::placeholders::_1));
     socket_->set_conn_callback(std::bind(&SocketChannel::HandleConnect, this));
+    socket_->set_highwater_callback(std::bind(&SocketChannel::OnHighWater, this));
+    socket_->set_drain_callback(std::bind(&SocketChannel::OnDrain, this));
 }
 
 int SocketChannel::Open() {
     SocketPtr sock;
-    if (opts_.use_ssl)
+    ipc::ShmSocketPtr shm_sock;
+    if (ipc::ShmSocket::is_shm_url(opts_.url))
+        sock = shm_sock = event_loop_->NewObject<ipc::ShmSocket>();
+    else if (opts_.use_ssl)
         sock = event_loop_->NewObject<SSLSocket>(ssl_ctx_.get());
     else
         sock = event_loop_->NewObject<StreamSocket>();
@@ -118,7 +128,11 @@ int SocketChannel::Open() {
 
     set_socket(sock);
 
-    int err = opts_.path.empty() ? socket_->Connect(opts_.host, opts_.port, opts_.timeout) : socket_->Connect(opts_.path);
+    int err;
+    if (shm_sock)
+        err = shm_sock->Connect(opts_.url, opts_.shm_ring_size);
+    else
+        err = opts_.path.empty() ? socket_->Connect(opts_.host, opts_.port, opts_.timeout) : socket_->Connect(opts_.path);
     if (err == ERROR_OK) {
         state_ = ChannelState::CS_CONNECTING;
         if (opts_.debug) {
@@ -3,6 +3,8 @@
 #pragma once
 #include <cstdint>
 #include <memory>
+#include <string>
+#include <vector>
 #include "socket.h"
 #include "net/event_loop.h"
 namespace tinynet {
@@ -24,13 +26,22 @@ enum class ChannelState {
     CS_CLOSED = 4,
 };
 
+/**
+ * @brief How a pool of connections to one endpoint picks the connection of a call
+ *
+ */
+enum class ChannelPoolStrategy {
+    LEAST_PENDING = 0, ///< The connection with the fewest calls in flight
+    HASH = 1, ///< By the hash key of the call, the calls without one as LEAST_PENDING
+};
+
 /**
  * @brief Options for socket channel
  *
  */
 struct ChannelOptions {
     std::string name;
-    std::string url;
+    std::string url; ///< "shm://name" selects the shared memory transport of co-located processes
     std::string host;
     int port{ 0 };
     std::string path;
@@ -42,6 +53,10 @@ struct ChannelOptions {
     std::string ssl_cert;
     std::string ssl_ca;
     std::string ssl_capath;
+    uint32_t shm_ring_size{ 1 << 20 }; ///< Bytes of each direction of a shared memory connection
+    int pool_size{ 1 }; ///< Connections of a channel pool to the endpoint, the bulk lane excluded
+    ChannelPoolStrategy pool_strategy{ ChannelPoolStrategy::LEAST_PENDING };
+    std::vector<std::string> bulk_methods; ///< Full names of the methods a channel pool sends on a connection of their own
     bool debug{ false };
 };
 
@@ -88,6 +103,26 @@ class SocketChannel :
     virtual void OnClose() {}
     virtual void OnRead() {}
     virtual void OnError(int err) {}
+    virtual void OnHighWater() {}
+    virtual void OnDrain() {}
+  protected:
+    /**
+     * @brief Saves the protocol state a channel of another process needs to go on serving the connection,
+     * returns false when the connection can not be handed over right now
+     *
+     * @param state
+     * @return true
+     * @return false
+     */
+    virtual bool Export(std::string* state) { return false; }
+    /**
+     * @brief Restores the state saved by Export() in the process being upgraded
+     *
+     * @param state
+     * @return true
+     * @return false
+     */
+    virtual bool Import(const std::string& state) { return false; }
   protected:
     void set_socket(SocketPtr sock);
   public:
@@ -3,7 +3,9 @@
 #include "socket_server.h"
 #include "stream_listener.h"
 #include "ssl_listener.h"
+#include "stream_socket.h"
 #include "socket_channel.h"
+#include "ipc/shm_listener.h"
 #include "logging/logging.h"
 #include "base/error_code.h"
 #include "util/net_utils.h"
@@ -15,19 +17,32 @@ namespace net {
 SocketServer::SocketServer(EventLoop *loop) :
     event_loop_(loop),
     removing_task_(INVALID_TASK_ID),
-    ssl_ctx_(nullptr) {
+    ssl_ctx_(nullptr),
+    hot_upgrade_(nullptr),
+    adopt_task_(INVALID_TASK_ID) {
 }
 
 SocketServer::SocketServer(EventLoop *loop, SSLContext* ctx) :
     event_loop_(loop),
     removing_task_(INVALID_TASK_ID),
-    ssl_ctx_(ctx) {
+    ssl_ctx_(ctx),
+    hot_upgrade_(nullptr),
+    adopt_task_(INVALID_TASK_ID) {
 }
 
 SocketServer::~SocketServer() {
     if (removing_task_) {
         event_loop_->CancelTask(removing_task_);
     }
+    if (adopt_task_) {
+        event_loop_->CancelTask(adopt_task_);
+    }
+    for (auto& sock : adopting_) {
+        NetUtils::Close(sock.fd);
+    }
+    if (hot_upgrade_) {
+        hot_upgrade_->RemoveServer(this);
+    }
 }
 
 int SocketServer::Start(ServerOptions& opts) {
@@ -39,19 +54,42 @@ int SocketServer::Start(ServerOptions& opts) {
     if (opts_.name.empty())
         opts_.name = "socket";
 
+    if (opts_.io_threads > 0) {
+        //Only the WebSocket server shards over io loops, see WebSocketServer::StartShards()
+        log_warning("Server %s serves on the app loop, io_threads only applies to tcp WebSocket servers",
+                    opts_.name.c_str());
+    }
+
+    int err = InitSSL();
+    if (err != ERROR_OK)
+        return err;
+
     auto listener = CreateListener();
     if (!listener)
         return ERROR_OS_OOM;
 
-    int err = ERROR_INVAL;
+    err = ERROR_INVAL;
     int flags = 0;
     if (opts_.reuseport) flags |= TCP_FLAGS_REUSEPORT;
     if (opts_.ipv6only) flags |= TCP_FLAGS_IPV6ONLY;
 
+    if (hot_upgrade_) {
+        hot_upgrade_->TakeListener(opts_.name, &inherited_listener_);
+    }
+    if (inherited_listener_.fd != -1) {
+        //The listener owns the socket from now on, even if it fails to serve it
+        err = listener->Attach(inherited_listener_.fd, inherited_listener_.af, inherited_listener_.address);
+        inherited_listener_.fd = -1;
+        goto FINAL;
+    }
     if (!opts_.listen_path.empty()) {
         err = listener->BindAndListen(opts_.listen_path, ksomaxconn);
         goto FINAL;
     }
+    if (ipc::ShmSocket::is_shm_url(opts_.listen_url)) {
+        err = std::static_pointer_cast<ipc::ShmListener>(listener)->Listen(opts_.listen_url);
+        goto FINAL;
+    }
     if (!opts_.listen_url.empty()) {
         if (!UriUtils::parse_address(opts_.listen_url, &opts_.listen_ip, &opts_.listen_port)) {
             err = ERROR_URI_UNRECOGNIZED;
@@ -69,6 +107,14 @@ int SocketServer::Start(ServerOptions& opts) {
 FINAL:
     if (err == ERROR_OK) {
         set_listener(listener);
+        if (hot_upgrade_) {
+            hot_upgrade_->AddServer(this);
+            //The owner installs its callbacks after Start(), the connections taken over are served from the next iteration
+            hot_upgrade_->TakeChannels(opts_.name, &adopting_);
+            if (!adopting_.empty() && adopt_task_ == INVALID_TASK_ID) {
+                adopt_task_ = event_loop_->AddTask(std::bind(&SocketServer::AdoptChannels, this));
+            }
+        }
     }
     return err;
 }
@@ -77,19 +123,49 @@ void SocketServer::Stop() {
     if (removing_task_) {
         event_loop_->CancelTask(removing_task_);
     }
+    if (adopt_task_) {
+        event_loop_->CancelTask(adopt_task_);
+        adopt_task_ = INVALID_TASK_ID;
+    }
+    for (auto& sock : adopting_) {
+        NetUtils::Close(sock.fd);
+    }
+    adopting_.clear();
+    if (hot_upgrade_) {
+        hot_upgrade_->RemoveServer(this);
+    }
     if (listener_) {
         listener_->Close();
     }
     channels_.clear();
+    exported_.clear();
 }
 
 void SocketServer::HandleAccept(SocketPtr sock) {
+    AcceptChannel(sock);
+}
+
+SocketChannelPtr SocketServer::AcceptChannel(SocketPtr sock) {
+    if (opts_.chained_write && !ssl_ctx_) {
+        sock->EnableChainedWrite();
+    }
+    if (opts_.max_read_bytes > 0) {
+        sock->set_read_limit((size_t)opts_.max_read_bytes);
+    }
+    if (opts_.corked_write) {
+        sock->EnableCorkedWrite((size_t)opts_.cork_flush_bytes);
+    }
+    if (opts_.high_watermark > 0) {
+        sock->set_watermarks((size_t)opts_.high_watermark, (size_t)opts_.low_watermark,
+                             ParseOverflowPolicy(opts_.overflow_policy));
+    }
     auto channel = CreateChannel(sock);
     channels_[channel->get_guid()] = channel;
     if (opts_.debug) {
         log_info("[%s] %s server accept new channel guid(%lld, %s)",
                  get_name(), get_name(), channel->get_guid(), channel->get_address().c_str());
     }
+    return channel;
 }
 
 void SocketServer::HandleError(int err) {
@@ -140,7 +216,137 @@ void SocketServer::set_listener(net::ListenerPtr listener) {
     listener_->set_error_callback(std::bind(&SocketServer::HandleError, this, std::placeholders::_1));
 }
 
+int SocketServer::InitSSL() {
+    if (ssl_ctx_ || opts_.cert_file.empty() || opts_.key_file.empty())
+        return ERROR_OK;
+    own_ssl_ctx_.reset(new(std::nothrow) SSLContext());
+    if (!own_ssl_ctx_)
+        return ERROR_OS_OOM;
+    SSLContext::Options ssl_opts;
+    ssl_opts.ssl_cert = opts_.cert_file;
+    ssl_opts.ssl_key = opts_.key_file;
+    ssl_opts.server = true;
+    ssl_opts.session_cache_size = opts_.session_cache_size;
+    ssl_opts.session_timeout = opts_.session_timeout;
+    ssl_opts.session_tickets = opts_.session_tickets;
+    ssl_opts.ticket_rotate_sec = opts_.ticket_rotate_sec;
+    ssl_opts.ticket_key_file = opts_.ticket_key_file;
+    ssl_opts.early_data = opts_.early_data;
+    if (!own_ssl_ctx_->Init(ssl_opts)) {
+        log_error("[%s] %s server failed to load the certificate %s or the key %s",
+                  get_name(), get_name(), opts_.cert_file.c_str(), opts_.key_file.c_str());
+        own_ssl_ctx_.reset();
+        return ERROR_INVAL;
+    }
+    ssl_ctx_ = own_ssl_ctx_.get();
+    return ERROR_OK;
+}
+
+void SocketServer::CollectHandshakeStats(SSLHandshakeStats* stats) {
+    if (ssl_ctx_ && listener_) {
+        std::static_pointer_cast<SSListener>(listener_)->CollectHandshakeStats(stats);
+    }
+}
+
+void SocketServer::Export(std::vector<HandoffSocket>* socks) {
+    Restore();
+    ExportListener(socks);
+    //TLS sessions can not leave the process, nor can the rings of shared memory connections
+    if (ssl_ctx_ || ipc::ShmSocket::is_shm_url(opts_.listen_url)) return;
+    for (auto& it : channels_) {
+        auto& channel = it.second;
+        auto& sock = channel->socket_;
+        if (channel->state_ != ChannelState::CS_CONNECTED || !sock || !sock->is_connected() ||
+                removing_channels_.count(it.first)) {
+            continue;
+        }
+        HandoffSocket handoff;
+        if (!channel->Export(&handoff.state)) {
+            continue;
+        }
+        handoff.kind = HotUpgrade::HANDOFF_CHANNEL;
+        handoff.fd = sock->get_fd();
+        handoff.af = sock->get_af();
+        handoff.server = opts_.name;
+        handoff.address = sock->get_peer_address();
+        handoff.rdata.assign(sock->rbuf()->begin(), sock->rbuf()->size());
+        sock->CopyPendingWrite(&handoff.wdata);
+        socks->emplace_back(std::move(handoff));
+        exported_.emplace(it.first, channel);
+    }
+    //Whatever the loop did with them until the next process acknowledges would be lost or done twice
+    for (auto& it : exported_) {
+        it.second->socket_->Suspend();
+        channels_.erase(it.first);
+    }
+}
+
+void SocketServer::Detach() {
+    if (listener_) {
+        listener_->Close();
+    }
+    //Closing our copy of the descriptor leaves the connection to the next process, no callback is raised
+    for (auto& it : exported_) {
+        it.second->socket_->Close();
+    }
+    if (!exported_.empty()) {
+        log_info("[%s] %s server handed over %d channels", get_name(), get_name(), (int)exported_.size());
+    }
+    exported_.clear();
+}
+
+void SocketServer::Restore() {
+    for (auto& it : exported_) {
+        channels_.emplace(it.first, it.second);
+        it.second->socket_->Resume();
+    }
+    exported_.clear();
+}
+
+void SocketServer::ExportListener(std::vector<HandoffSocket>* socks) {
+    if (!listener_ || listener_->get_fd() == -1) return;
+    HandoffSocket handoff;
+    handoff.kind = HotUpgrade::HANDOFF_LISTENER;
+    handoff.fd = listener_->get_fd();
+    handoff.af = listener_->get_af();
+    handoff.server = opts_.name;
+    handoff.address = listener_->get_listen_address();
+    socks->emplace_back(std::move(handoff));
+}
+
+void SocketServer::AdoptChannels() {
+    adopt_task_ = INVALID_TASK_ID;
+    std::vector<HandoffSocket> socks;
+    socks.swap(adopting_);
+    int adopted = 0;
+    for (auto& handoff : socks) {
+        if (ssl_ctx_) {
+            NetUtils::Close(handoff.fd);
+            continue;
+        }
+        auto sock = event_loop_->NewObject<StreamSocket>(handoff.fd, handoff.af, &handoff.address);
+        sock->rbuf()->append(handoff.rdata.data(), handoff.rdata.size());
+        sock->Open();
+        //Bytes queued by the old process go out before anything the new channel writes
+        if (!handoff.wdata.empty()) {
+            sock->Write(handoff.wdata.data(), handoff.wdata.size());
+        }
+        auto channel = AcceptChannel(sock);
+        if (!channel->Import(handoff.state)) {
+            channel->Close(ERROR_SOCKET_CLOSEDBYSERVER);
+            continue;
+        }
+        if (sock->rbuf()->size() > 0) {
+            channel->OnRead();
+        }
+        ++adopted;
+    }
+    log_info("[%s] %s server took over %d of %d channels", get_name(), get_name(), adopted, (int)socks.size());
+}
+
 ListenerPtr SocketServer::CreateListener() {
+    if (ipc::ShmSocket::is_shm_url(opts_.listen_url))
+        return event_loop()->NewObject<ipc::ShmListener>();
     if (ssl_ctx_)
         return event_loop()->NewObject<SSListener>(ssl_ctx_);
     else
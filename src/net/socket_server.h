@@ -10,6 +10,7 @@
 #include "listener.h"
 #include "socket_channel.h"
 #include "ssl_context.h"
+#include "hot_upgrade.h"
 
 namespace tinynet {
 namespace net {
@@ -19,10 +20,10 @@ namespace net {
  */
 struct ServerOptions {
     std::string name;
-    std::string cert_file;
-    std::string key_file;
+    std::string cert_file; ///< PEM certificate chain, the server speaks TLS when both files are set
+    std::string key_file; ///< PEM private key
     std::string listen_path; ///< Unix domain socket
-    std::string listen_url;
+    std::string listen_url; ///< "tcp://ip:port", or "shm://name" for the shared memory transport of co-located processes
     std::string listen_ip{"*"};
     int listen_port{ 0 };
     std::tuple<int, int> listen_ports; ///< Use as port range if listen_port == -1
@@ -31,6 +32,20 @@ struct ServerOptions {
     bool ipv6only{ false };
     bool debug{ false };
     int max_packet_size{ 0 };
+    bool chained_write{ false }; ///< Queue outgoing data in pooled blocks flushed with writev, ignored for TLS
+    bool corked_write{ false }; ///< Coalesce the writes of a loop iteration into one flush per socket
+    int cork_flush_bytes{ 65536 }; ///< Queued bytes forcing an immediate flush of a corked socket
+    int max_read_bytes{ 0 }; ///< Bytes read from one connection per loop iteration, 0 means unlimited
+    int high_watermark{ 0 }; ///< Pending output raising the high water event, 0 disables watermarks
+    int low_watermark{ 0 }; ///< Pending output raising the drain event once the high mark was crossed
+    std::string overflow_policy; ///< "drop_newest", "drop_oldest" or "disconnect" applied to writes crossing the high mark
+    int io_threads{ 0 }; ///< Serve connections on this many io loops with SO_REUSEPORT listeners, 0 serves on the app loop. Tcp WebSocket servers only, the others serve on the app loop
+    int session_cache_size{ 20480 }; ///< TLS sessions cached for resumption, 0 disables the cache
+    int session_timeout{ 300 }; ///< TLS session and ticket lifetime in seconds
+    bool session_tickets{ true }; ///< Stateless TLS resumption with session tickets
+    int ticket_rotate_sec{ 3600 }; ///< Session ticket key lifetime in seconds
+    std::string ticket_key_file; ///< Secret shared by the processes of a cluster to resume each other's tickets
+    bool early_data{ false }; ///< Accept TLS 1.3 early data from resumed clients
 };
 
 typedef std::shared_ptr<ServerOptions> ServerOptionsPtr;
@@ -128,17 +143,60 @@ class SocketServer {
     int get_listen_port() const { return listener_ ? listener_->get_listen_port() : opts_.listen_port; }
 
     const net::ServerOptions& get_opts() { return opts_; }
+    /**
+     * @brief Adds the TLS handshake statistics of the listener to stats
+     *
+     * @param stats
+     */
+    virtual void CollectHandshakeStats(SSLHandshakeStats* stats);
+    /**
+     * @brief Takes over the sockets of this server from the process being upgraded and hands them to the next one,
+     * call before Start()
+     *
+     * @param upgrade
+     */
+    void set_hot_upgrade(HotUpgrade* upgrade) { hot_upgrade_ = upgrade; }
+    /**
+     * @brief Appends the listening socket and the connections the next process can take over.
+     * The connections are frozen and left out of the server until Detach() or Restore().
+     *
+     * @param socks
+     */
+    virtual void Export(std::vector<HandoffSocket>* socks);
+    /**
+     * @brief Stops serving the exported sockets, the next process serves them from now on
+     *
+     */
+    virtual void Detach();
+    /**
+     * @brief Serves the connections frozen by Export() again, the handoff failed
+     *
+     */
+    virtual void Restore();
   protected:
     void RemoveChannels();
+    /**
+     * @brief Creates the TLS context from the certificate options unless one was given
+     *
+     * @return int
+     */
+    int InitSSL();
 
     void set_listener(net::ListenerPtr listener);
 
+    void ExportListener(std::vector<HandoffSocket>* socks);
+
+    void AdoptChannels();
+
   private:
     ListenerPtr CreateListener();
 
+    SocketChannelPtr AcceptChannel(SocketPtr sock);
+
   protected:
     using CHANNEL_MAP = std::unordered_map<ChannelID, SocketChannelPtr>;
     using CHANNEL_ID_SET = std::unordered_set<ChannelID>;
+    std::unique_ptr<SSLContext> own_ssl_ctx_; ///< Declared first to outlive the channels
     CHANNEL_MAP			channels_;
     ListenerPtr			listener_;
     EventLoop *			event_loop_;
@@ -146,6 +204,11 @@ class SocketServer {
     int64_t				removing_task_;
     SSLContext *		ssl_ctx_;
     ServerOptions		opts_;
+    HotUpgrade *		hot_upgrade_;
+    HandoffSocket		inherited_listener_; ///< Listening socket taken over by Start()
+    std::vector<HandoffSocket> adopting_; ///< Connections taken over, adopted on the next loop iteration
+    int64_t				adopt_task_;
+    CHANNEL_MAP			exported_; ///< Channels sent to the next process by the last Export(), frozen meanwhile
 };
 }
 }
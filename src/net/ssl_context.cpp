@@ -2,10 +2,116 @@
 // Author: Xianfeng Shang (shangxianfeng@outlook.com)
 #include "ssl_context.h"
 #include "base/at_exit.h"
+#include "base/singleton.h"
+#include "logging/logging.h"
+#include "openssl/hmac.h"
+#include "openssl/rand.h"
+#include <cstdio>
+#include <cstring>
+#if OPENSSL_VERSION_NUMBER >= 0x30000000L
+#include "openssl/core_names.h"
+#endif
 
 
 namespace tinynet {
 
+const int64_t SSLHandshakeCounters::BUCKET_BOUNDS_MS[SSLHandshakeCounters::BUCKETS - 1] = { 1, 5, 10, 50, 100, 500, 1000 };
+
+void SSLHandshakeCounters::Record(bool resumed, bool early_data, int64_t elapsed_us) {
+    if (resumed) {
+        resumed_.fetch_add(1, std::memory_order_relaxed);
+    } else {
+        full_.fetch_add(1, std::memory_order_relaxed);
+    }
+    if (early_data) {
+        early_data_.fetch_add(1, std::memory_order_relaxed);
+    }
+    int bucket = 0;
+    while (bucket < BUCKETS - 1 && elapsed_us >= BUCKET_BOUNDS_MS[bucket] * 1000) {
+        ++bucket;
+    }
+    histogram_[bucket].fetch_add(1, std::memory_order_relaxed);
+}
+
+void SSLHandshakeCounters::Collect(SSLHandshakeStats* stats) const {
+    stats->full += full_.load(std::memory_order_relaxed);
+    stats->resumed += resumed_.load(std::memory_order_relaxed);
+    stats->failed += failed_.load(std::memory_order_relaxed);
+    stats->early_data += early_data_.load(std::memory_order_relaxed);
+    stats->histogram.resize(BUCKETS);
+    for (int i = 0; i < BUCKETS; ++i) {
+        stats->histogram[i] += histogram_[i].load(std::memory_order_relaxed);
+    }
+}
+
+void SSLSessionStore::Reserve(size_t capacity) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (capacity > capacity_) capacity_ = capacity;
+}
+
+void SSLSessionStore::Add(const std::string& key, SSL_SESSION* session) {
+    int len = i2d_SSL_SESSION(session, NULL);
+    if (len <= 0) return;
+    std::string data(len, '\0');
+    unsigned char* p = reinterpret_cast<unsigned char*>(&data[0]);
+    if (i2d_SSL_SESSION(session, &p) != len) return;
+    time_t expire = (time_t)SSL_SESSION_get_time(session) + (time_t)SSL_SESSION_get_timeout(session);
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (capacity_ == 0) return;
+    auto it = sessions_.find(key);
+    if (it != sessions_.end()) {
+        Erase(it);
+    }
+    time_t now = time(NULL);
+    while (sessions_.size() >= capacity_) {
+        Erase(sessions_.find(order_.front()));
+    }
+    //Expired sessions at the front go first, they would fail the lookup anyway
+    while (!order_.empty()) {
+        auto oldest = sessions_.find(order_.front());
+        if (oldest->second.expire > now) break;
+        Erase(oldest);
+    }
+    Entry& entry = sessions_[key];
+    entry.data.swap(data);
+    entry.expire = expire;
+    entry.order = order_.insert(order_.end(), key);
+}
+
+SSL_SESSION* SSLSessionStore::Get(const std::string& key, bool once) {
+    std::string data;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = sessions_.find(key);
+        if (it == sessions_.end()) return NULL;
+        if (it->second.expire <= time(NULL)) {
+            Erase(it);
+            return NULL;
+        }
+        if (once) {
+            data.swap(it->second.data);
+            Erase(it);
+        } else {
+            data = it->second.data;
+        }
+    }
+    const unsigned char* p = reinterpret_cast<const unsigned char*>(data.data());
+    return d2i_SSL_SESSION(NULL, &p, (long)data.size());
+}
+
+void SSLSessionStore::Remove(const std::string& key) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = sessions_.find(key);
+    if (it != sessions_.end()) {
+        Erase(it);
+    }
+}
+
+void SSLSessionStore::Erase(std::unordered_map<std::string, Entry>::iterator it) {
+    order_.erase(it->second.order);
+    sessions_.erase(it);
+}
+
 std::once_flag SSLContext::once_flag_;
 
 void SSLContext::Initialize() {
@@ -43,11 +149,15 @@ SSLContext::~SSLContext() {
 
 bool SSLContext::Init(const Options& opts) {
     std::call_once(once_flag_, Initialize);
+    opts_ = opts;
 #if OPENSSL_VERSION_NUMBER < 0x10100000L
     ctx_ = SSL_CTX_new(SSLv23_method());
 #else
     ctx_ = SSL_CTX_new(TLS_method());
 #endif
+    if (ctx_ == NULL) {
+        return false;
+    }
 #if OPENSSL_VERSION_NUMBER >= 0x10100000L
     if (SSL_CTX_get_security_level(ctx_) > 1)
         SSL_CTX_set_security_level(ctx_, 1);
@@ -55,12 +165,230 @@ bool SSLContext::Init(const Options& opts) {
 
     SSL_CTX_set_verify(ctx_, SSL_VERIFY_NONE, NULL);
     SSL_CTX_set_cipher_list(ctx_, "DEFAULT:!DH");
-    //SSL_CTX_use_certificate_file(ctx_, "cert/client-cert.pem", SSL_FILETYPE_PEM);
-    //SSL_CTX_use_PrivateKey_file(ctx_, "cert/client-key.pem", SSL_FILETYPE_PEM);
-    //int ret = SSL_CTX_check_private_key(ctx_);
-    //TODO: Manipulate the ssl context
+    if (!opts_.ssl_cert.empty() &&
+            SSL_CTX_use_certificate_chain_file(ctx_, opts_.ssl_cert.c_str()) != 1) {
+        return false;
+    }
+    if (!opts_.ssl_key.empty()) {
+        if (SSL_CTX_use_PrivateKey_file(ctx_, opts_.ssl_key.c_str(), SSL_FILETYPE_PEM) != 1 ||
+                SSL_CTX_check_private_key(ctx_) != 1) {
+            return false;
+        }
+    }
+    if (!opts_.ssl_ca.empty() || !opts_.ssl_capath.empty()) {
+        if (SSL_CTX_load_verify_locations(ctx_, opts_.ssl_ca.empty() ? NULL : opts_.ssl_ca.c_str(),
+                                          opts_.ssl_capath.empty() ? NULL : opts_.ssl_capath.c_str()) != 1) {
+            return false;
+        }
+    }
+    if (opts_.server) {
+        return InitServer();
+    }
+    return true;
+}
+
+bool SSLContext::InitServer() {
+    static const unsigned char sid_ctx[] = "tinynet";
+    SSL_CTX_set_session_id_context(ctx_, sid_ctx, sizeof(sid_ctx) - 1);
+    SSL_CTX_set_app_data(ctx_, this);
+    //The cache lives in the process rather than the context, so every context of the process resumes the sessions
+    //of the others, nor does freeing a context flush them as it would flush its internal cache
+    if (opts_.session_cache_size > 0) {
+        Singleton<SSLSessionStore>::Instance()->Reserve(opts_.session_cache_size);
+        SSL_CTX_set_session_cache_mode(ctx_, SSL_SESS_CACHE_SERVER | SSL_SESS_CACHE_NO_INTERNAL);
+        SSL_CTX_sess_set_new_cb(ctx_, new_session);
+        SSL_CTX_sess_set_get_cb(ctx_, get_session);
+        SSL_CTX_sess_set_remove_cb(ctx_, remove_session);
+    } else {
+        SSL_CTX_set_session_cache_mode(ctx_, SSL_SESS_CACHE_OFF);
+    }
+    if (opts_.session_timeout > 0) {
+        SSL_CTX_set_timeout(ctx_, opts_.session_timeout);
+    }
+    if (!opts_.session_tickets) {
+        SSL_CTX_set_options(ctx_, SSL_OP_NO_TICKET);
+    } else {
+        if (!LoadTicketSecret()) {
+            return false;
+        }
+#if OPENSSL_VERSION_NUMBER >= 0x30000000L
+        SSL_CTX_set_tlsext_ticket_key_evp_cb(ctx_, handle_ticket_key);
+#else
+        SSL_CTX_set_tlsext_ticket_key_cb(ctx_, handle_ticket_key);
+#endif
+    }
+#if OPENSSL_VERSION_NUMBER >= 0x10101000L
+    //Early data is replayable, OpenSSL keeps its tickets single use in the session cache, so it needs the cache
+    bool early_data = opts_.early_data && opts_.session_cache_size > 0;
+    SSL_CTX_set_max_early_data(ctx_, early_data ? opts_.max_early_data : 0);
+#endif
     return true;
 }
 
+bool SSLContext::LoadTicketSecret() {
+    static const size_t kMinSecretSize = 32;
+    static const size_t kMaxSecretSize = 4096;
+    if (opts_.ticket_key_file.empty()) {
+        //Every context of the process derives its keys from one secret, so a ticket of a listener works on the others
+        static std::string process_secret;
+        static std::once_flag secret_once;
+        std::call_once(secret_once, []() {
+            std::string secret(kMinSecretSize, '\0');
+            if (RAND_bytes(reinterpret_cast<unsigned char*>(&secret[0]), (int)secret.size()) == 1) {
+                process_secret.swap(secret);
+            }
+        });
+        ticket_secret_ = process_secret;
+        return !ticket_secret_.empty();
+    }
+    FILE* fp = fopen(opts_.ticket_key_file.c_str(), "rb");
+    if (fp == NULL) {
+        log_error("Failed to open the ticket key file %s", opts_.ticket_key_file.c_str());
+        return false;
+    }
+    std::string secret(kMaxSecretSize, '\0');
+    size_t len = fread(&secret[0], 1, secret.size(), fp);
+    fclose(fp);
+    if (len < kMinSecretSize) {
+        log_error("The ticket key file %s holds %zu bytes, %zu at least are needed",
+                  opts_.ticket_key_file.c_str(), len, kMinSecretSize);
+        return false;
+    }
+    secret.resize(len);
+    ticket_secret_.swap(secret);
+    return true;
 }
 
+bool SSLContext::DeriveTicketKey(int64_t epoch, TicketKey* key) {
+    //HMAC-SHA256(secret, label | rotation | epoch), the same secret yields the same keys in every process
+    unsigned char msg[1 + 8 + 8];
+    uint64_t rotate = (uint64_t)opts_.ticket_rotate_sec;
+    for (int i = 0; i < 8; ++i) {
+        msg[1 + i] = (unsigned char)(rotate >> (56 - 8 * i));
+        msg[9 + i] = (unsigned char)((uint64_t)epoch >> (56 - 8 * i));
+    }
+    unsigned char* outs[3] = { key->name, key->hmac_key, key->aes_key };
+    size_t sizes[3] = { sizeof(key->name), sizeof(key->hmac_key), sizeof(key->aes_key) };
+    for (int i = 0; i < 3; ++i) {
+        unsigned char md[EVP_MAX_MD_SIZE];
+        unsigned int md_len = 0;
+        msg[0] = (unsigned char)('n' + i);
+        if (HMAC(EVP_sha256(), ticket_secret_.data(), (int)ticket_secret_.size(), msg, sizeof(msg), md, &md_len) == NULL ||
+                md_len < sizes[i]) {
+            return false;
+        }
+        memcpy(outs[i], md, sizes[i]);
+    }
+    key->epoch = epoch;
+    return true;
+}
+
+int SSLContext::GetTicketKey(const unsigned char* name, bool enc, TicketKey* key) {
+    int64_t epoch = opts_.ticket_rotate_sec > 0 ? (int64_t)time(NULL) / opts_.ticket_rotate_sec : 0;
+    std::lock_guard<std::mutex> lock(ticket_mutex_);
+    TicketKey& current = ticket_keys_[0];
+    TicketKey& previous = ticket_keys_[1];
+    if (current.epoch != epoch) {
+        if (current.epoch == epoch - 1) {
+            previous = current;
+        } else if (epoch > 0 && !DeriveTicketKey(epoch - 1, &previous)) {
+            previous.epoch = -1;
+        }
+        if (!DeriveTicketKey(epoch, &current)) {
+            current.epoch = -1;
+            return 0;
+        }
+    }
+    if (enc) {
+        *key = current;
+        return 1;
+    }
+    //Tickets outlive one rotation at most
+    for (int i = 0; i < 2; ++i) {
+        TicketKey& candidate = ticket_keys_[i];
+        if (candidate.epoch < 0 || memcmp(candidate.name, name, sizeof(candidate.name)) != 0) {
+            continue;
+        }
+        *key = candidate;
+        return i == 0 ? 1 : 2;
+    }
+    return 0;
+}
+
+#if OPENSSL_VERSION_NUMBER >= 0x30000000L
+int SSLContext::handle_ticket_key(SSL* s, unsigned char* name, unsigned char* iv,
+                                  EVP_CIPHER_CTX* cctx, EVP_MAC_CTX* hctx, int enc) {
+#else
+int SSLContext::handle_ticket_key(SSL* s, unsigned char* name, unsigned char* iv,
+                                  EVP_CIPHER_CTX* cctx, HMAC_CTX* hctx, int enc) {
+#endif
+    SSLContext* self = static_cast<SSLContext*>(SSL_CTX_get_app_data(SSL_get_SSL_CTX(s)));
+    if (!self) return -1;
+    TicketKey key;
+    int ret = self->GetTicketKey(name, enc != 0, &key);
+    if (ret == 0) {
+        //Unknown or expired key, fall back to a full handshake
+        return 0;
+    }
+    if (enc) {
+        if (RAND_bytes(iv, EVP_MAX_IV_LENGTH) != 1) return -1;
+        memcpy(name, key.name, sizeof(key.name));
+        if (EVP_EncryptInit_ex(cctx, EVP_aes_256_cbc(), NULL, key.aes_key, iv) != 1) return -1;
+    } else {
+        if (EVP_DecryptInit_ex(cctx, EVP_aes_256_cbc(), NULL, key.aes_key, iv) != 1) return -1;
+    }
+#if OPENSSL_VERSION_NUMBER >= 0x30000000L
+    OSSL_PARAM params[3];
+    params[0] = OSSL_PARAM_construct_octet_string(OSSL_MAC_PARAM_KEY, key.hmac_key, sizeof(key.hmac_key));
+    params[1] = OSSL_PARAM_construct_utf8_string(OSSL_MAC_PARAM_DIGEST, const_cast<char*>("SHA256"), 0);
+    params[2] = OSSL_PARAM_construct_end();
+    if (EVP_MAC_CTX_set_params(hctx, params) != 1) return -1;
+#else
+    if (HMAC_Init_ex(hctx, key.hmac_key, sizeof(key.hmac_key), EVP_sha256(), NULL) != 1) return -1;
+#endif
+    return ret;
+}
+
+std::string SSLContext::SessionKey(const unsigned char* id, unsigned int len) const {
+    //Sessions resume on the contexts of the same certificate only
+    std::string key(opts_.ssl_cert);
+    key.push_back('\0');
+    key.append(reinterpret_cast<const char*>(id), len);
+    return key;
+}
+
+int SSLContext::new_session(SSL* s, SSL_SESSION* session) {
+    SSLContext* self = static_cast<SSLContext*>(SSL_CTX_get_app_data(SSL_get_SSL_CTX(s)));
+    if (!self) return 0;
+    unsigned int len = 0;
+    const unsigned char* id = SSL_SESSION_get_id(session, &len);
+    Singleton<SSLSessionStore>::Instance()->Add(self->SessionKey(id, len), session);
+    //The store keeps a copy, OpenSSL keeps its reference
+    return 0;
+}
+
+#if OPENSSL_VERSION_NUMBER >= 0x10100000L
+SSL_SESSION* SSLContext::get_session(SSL* s, const unsigned char* id, int len, int* copy) {
+#else
+SSL_SESSION* SSLContext::get_session(SSL* s, unsigned char* id, int len, int* copy) {
+#endif
+    *copy = 0;
+    SSLContext* self = static_cast<SSLContext*>(SSL_CTX_get_app_data(SSL_get_SSL_CTX(s)));
+    if (!self || len <= 0) return NULL;
+    //A TLS 1.3 resumption may carry early data, the session is single use so it can not be replayed on another context
+    bool once = false;
+#if OPENSSL_VERSION_NUMBER >= 0x10101000L
+    once = SSL_version(s) >= TLS1_3_VERSION;
+#endif
+    return Singleton<SSLSessionStore>::Instance()->Get(self->SessionKey(id, (unsigned int)len), once);
+}
+
+void SSLContext::remove_session(SSL_CTX* ctx, SSL_SESSION* session) {
+    SSLContext* self = static_cast<SSLContext*>(SSL_CTX_get_app_data(ctx));
+    if (!self) return;
+    unsigned int len = 0;
+    const unsigned char* id = SSL_SESSION_get_id(session, &len);
+    Singleton<SSLSessionStore>::Instance()->Remove(self->SessionKey(id, len));
+}
+
+}
@@ -1,14 +1,97 @@
 // Copyright (C), Xianfeng Shang.  All rights reserved.
 // Author: Xianfeng Shang (shangxianfeng@outlook.com)
 #pragma once
+#include <atomic>
+#include <cstdint>
+#include <ctime>
 #include <memory>
 #include <mutex>
+#include <list>
+#include <string>
+#include <unordered_map>
+#include <vector>
 #include "openssl/ssl.h"
 #include "openssl/err.h"
 #include "openssl/engine.h"
 #include "openssl/conf.h"
 
 namespace tinynet {
+/**
+ * @brief TLS handshake statistics of a listener
+ *
+ */
+struct SSLHandshakeStats {
+    uint64_t full{ 0 }; ///< Handshakes completed with a full key exchange
+    uint64_t resumed{ 0 }; ///< Handshakes completed by resuming a cached session or a ticket
+    uint64_t failed{ 0 }; ///< Handshakes aborted by a protocol error
+    uint64_t early_data{ 0 }; ///< Resumed handshakes whose early data was accepted
+    std::vector<uint64_t> histogram; ///< Completed handshakes per time bucket, see SSLHandshakeCounters::BUCKET_BOUNDS_MS
+};
+
+/**
+ * @brief Handshake counters shared by a listener and the sockets it accepted, safe to read from other threads
+ *
+ */
+class SSLHandshakeCounters {
+  public:
+    static const int BUCKETS = 8;
+    static const int64_t BUCKET_BOUNDS_MS[BUCKETS - 1]; ///< Upper bounds of the buckets, the last bucket is unbounded
+  public:
+    void Record(bool resumed, bool early_data, int64_t elapsed_us);
+    void RecordFailure() { failed_.fetch_add(1, std::memory_order_relaxed); }
+    /**
+     * @brief Adds the counters to stats
+     *
+     * @param stats
+     */
+    void Collect(SSLHandshakeStats* stats) const;
+  private:
+    std::atomic<uint64_t> full_{ 0 };
+    std::atomic<uint64_t> resumed_{ 0 };
+    std::atomic<uint64_t> failed_{ 0 };
+    std::atomic<uint64_t> early_data_{ 0 };
+    std::atomic<uint64_t> histogram_[BUCKETS] {};
+};
+
+typedef std::shared_ptr<SSLHandshakeCounters> SSLHandshakeCountersPtr;
+
+/**
+ * @brief Server sessions shared by every SSLContext of the process, so a listener created after another one
+ * or on another io thread resumes its sessions
+ *
+ */
+class SSLSessionStore {
+  public:
+    /**
+     * @brief Grows the capacity to the largest cache size configured by the contexts
+     *
+     * @param capacity
+     */
+    void Reserve(size_t capacity);
+    void Add(const std::string& key, SSL_SESSION* session);
+    /**
+     * @brief Finds a session, the caller owns the returned reference
+     *
+     * @param key
+     * @param once removes the session, resumptions carrying early data must not be replayed
+     * @return SSL_SESSION*
+     */
+    SSL_SESSION* Get(const std::string& key, bool once);
+    void Remove(const std::string& key);
+  private:
+    struct Entry {
+        std::string data; ///< DER encoded session
+        time_t expire{ 0 };
+        std::list<std::string>::iterator order;
+    };
+    void Erase(std::unordered_map<std::string, Entry>::iterator it);
+  private:
+    std::mutex mutex_;
+    size_t capacity_{ 0 };
+    std::unordered_map<std::string, Entry> sessions_;
+    std::list<std::string> order_; ///< Oldest first, evicted when the store is full
+};
+
 class SSLContext  {
   public:
     struct Options {
@@ -16,6 +99,14 @@ class SSLContext  {
         std::string ssl_cert;
         std::string ssl_ca;
         std::string ssl_capath;
+        bool server{ false }; ///< Accepts connections, enables the session settings below
+        int session_cache_size{ 20480 }; ///< Sessions kept by the process-wide cache, 0 disables the cache
+        int session_timeout{ 300 }; ///< Lifetime in seconds of cached sessions and tickets
+        bool session_tickets{ true }; ///< Stateless resumption with session tickets
+        int ticket_rotate_sec{ 3600 }; ///< Ticket key lifetime, tickets of the previous key are still accepted, 0 never rotates
+        std::string ticket_key_file; ///< Secret the ticket keys derive from, processes sharing it resume each other's tickets, empty uses a random secret of the process
+        bool early_data{ false }; ///< Accept TLS 1.3 early data on resumed sessions, requires the session cache
+        uint32_t max_early_data{ 16384 }; ///< Early data accepted per connection
     };
   public:
     SSLContext();
@@ -24,11 +115,50 @@ class SSLContext  {
     bool Init(const Options& opts);
   public:
     SSL_CTX* get_ctx() { return ctx_; }
+    const Options& get_options() const { return opts_; }
   public:
     static std::once_flag once_flag_;
     static void Initialize();
     static void Finalize(void*);
+  private:
+    bool InitServer();
+    bool LoadTicketSecret();
+    struct TicketKey {
+        unsigned char name[16];
+        unsigned char hmac_key[32];
+        unsigned char aes_key[32];
+        int64_t epoch{ -1 }; ///< Rotation period the key belongs to
+    };
+    bool DeriveTicketKey(int64_t epoch, TicketKey* key);
+    /**
+     * @brief Finds the key of a received ticket or hands out the key of the current rotation period
+     *
+     * @param name
+     * @param enc
+     * @param key
+     * @return int 0 unknown key, 1 current key, 2 previous key and the ticket should be renewed
+     */
+    int GetTicketKey(const unsigned char* name, bool enc, TicketKey* key);
+#if OPENSSL_VERSION_NUMBER >= 0x30000000L
+    static int handle_ticket_key(SSL* s, unsigned char* name, unsigned char* iv,
+                                 EVP_CIPHER_CTX* cctx, EVP_MAC_CTX* hctx, int enc);
+#else
+    static int handle_ticket_key(SSL* s, unsigned char* name, unsigned char* iv,
+                                 EVP_CIPHER_CTX* cctx, HMAC_CTX* hctx, int enc);
+#endif
+    std::string SessionKey(const unsigned char* id, unsigned int len) const;
+    static int new_session(SSL* s, SSL_SESSION* session);
+#if OPENSSL_VERSION_NUMBER >= 0x10100000L
+    static SSL_SESSION* get_session(SSL* s, const unsigned char* id, int len, int* copy);
+#else
+    static SSL_SESSION* get_session(SSL* s, unsigned char* id, int len, int* copy);
+#endif
+    static void remove_session(SSL_CTX* ctx, SSL_SESSION* session);
   private:
     SSL_CTX* ctx_;
+    Options opts_;
+    std::string ticket_secret_;
+    std::mutex ticket_mutex_; ///< One context serves the listeners of every io thread
+    TicketKey ticket_keys_[2]; ///< Keys of the current and the previous period, derived again when the period changes
 };
-}
\ No newline at end of file
+}
@@ -15,7 +15,8 @@ namespace net {
 
 SSListener::SSListener(EventLoop *loop, SSLContext* ctx) :
     Listener(loop),
-    ssl_ctx_(ctx) {
+    ssl_ctx_(ctx),
+    handshake_stats_(std::make_shared<SSLHandshakeCounters>()) {
 }
 
 SSListener::~SSListener() = default;
@@ -35,6 +36,7 @@ void SSListener::Readable() {
                                  peer_ip, af_ == AF_UNIX ? nullptr : &peer_port);
 
         auto sock = event_loop_->NewObject<SSLSocket>(ssl_ctx_, accept_fd, af_, &peer_address);
+        sock->set_handshake_stats(handshake_stats_);
         sock->Open();
         Invoke(conn_callback_, sock);
     }
@@ -4,6 +4,7 @@
 #include <memory>
 #include "event_loop.h"
 #include "listener.h"
+#include "ssl_context.h"
 namespace tinynet {
 
 namespace net {
@@ -13,10 +14,18 @@ class SSListener:
   public:
     SSListener(EventLoop *loop, SSLContext* ctx);
     ~SSListener();
+  public:
+    /**
+     * @brief Adds the handshake statistics of the accepted connections to stats
+     *
+     * @param stats
+     */
+    void CollectHandshakeStats(SSLHandshakeStats* stats) const { handshake_stats_->Collect(stats); }
   private:
     virtual void Readable() override;
   private:
     SSLContext* ssl_ctx_;
+    SSLHandshakeCountersPtr handshake_stats_;
 };
 
 typedef std::shared_ptr<SSListener> SSListenerPtr;
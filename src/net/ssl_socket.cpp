@@ -1,10 +1,12 @@
 // Copyright (C), Xianfeng Shang.  All rights reserved.
 // Author: Xianfeng Shang (shangxianfeng@outlook.com)
 #include "ssl_socket.h"
+#include "event_loop.h"
 #include "base/error_code.h"
 #include "util/net_utils.h"
 #include "util/string_utils.h"
 #include "util/uri_utils.h"
+#include "base/clock.h"
 
 
 namespace tinynet {
@@ -72,7 +74,12 @@ void SSLSocket::Writable() {
     }
 }
 void SSLSocket::SSLOpen() {
-    Readable();
+    //Accepted sockets speak TLS from the first byte, clients start it with Handshake()
+    if ((flag_ & FD_FLAGS_SERVER_FD) && handshake_status_ == HS_NONE) {
+        Handshake();
+    } else {
+        Readable();
+    }
     Invoke(conn_callback_);
 }
 
@@ -81,15 +88,21 @@ void SSLSocket::Handshake() {
         return;
 
     handshake_status_ = HS_HANDHAKING;
+    handshake_start_ = STime_us();
     if (ssl_) {
         SSL_free(ssl_);
     }
     ssl_ = SSL_new(ssl_ctx_->get_ctx());
+    //Accepted fds turn non blocking on their first registration, which may come after the first handshake step
+    NetUtils::SetNonBlocking(fd_);
     SSL_set_fd(ssl_, fd_);
     if (flag_ & FD_FLAGS_CLIENT_FD) {
         SSL_set_connect_state(ssl_);
     } else {
         SSL_set_accept_state(ssl_);
+#if OPENSSL_VERSION_NUMBER >= 0x10101000L
+        early_data_ = ssl_ctx_->get_options().early_data;
+#endif
     }
     SSLHandshake();
 
@@ -97,7 +110,12 @@ void SSLSocket::Handshake() {
 
 void SSLSocket::SSLClose() {
     if (ssl_ != nullptr) {
-        SSL_CTX_remove_session(ssl_ctx_->get_ctx(), SSL_get0_session(ssl_));
+        if (handshake_status_ == HS_HANDSHAKED) {
+            //Keep the session resumable, OpenSSL already evicted it if the tunnel died of a fatal alert
+            SSL_set_shutdown(ssl_, SSL_SENT_SHUTDOWN | SSL_RECEIVED_SHUTDOWN);
+        } else {
+            SSL_CTX_remove_session(SSL_get_SSL_CTX(ssl_), SSL_get0_session(ssl_));
+        }
         SSL_free(ssl_);
         ssl_ = nullptr;
     }
@@ -111,14 +129,12 @@ void SSLSocket::SSLReadable() {
     int mask = EVENT_NONE;
     if (mask_ & EVENT_READABLE) {
         int nbytes = 0;
+        char* spill = event_loop_->get_read_spill();
         for (;;) {
-            if (rbuf_.size() == rbuf_.capacity()) {
-                rbuf_.reserve(rbuf_.size() + 8192);
-            }
-            int len = (int)(rbuf_.capacity() - rbuf_.size());
-            int nread = SSL_read(ssl_, rbuf_.end(), len);
+            //Decrypt into the loop spill area, only the plaintext received is appended
+            int nread = SSL_read(ssl_, spill, (int)EventLoop::READ_SPILL_SIZE);
             if (nread > 0) {
-                rbuf_.resize(rbuf_.size() + nread);
+                rbuf_.append(spill, nread);
                 nbytes += nread;
             } else {
                 int ssl_err = SSL_get_error(ssl_, nread);
@@ -136,6 +152,7 @@ void SSLSocket::SSLReadable() {
         if (nbytes > 0) {
             Invoke(read_callback_);
         }
+        rbuf_.release();
         mask_ &= ~EVENT_READABLE;
     }
     if (err == ERROR_OK && mask != EVENT_NONE) {
@@ -178,12 +195,18 @@ void SSLSocket::SSLWritable() {
             }
         }
         if (nbytes > 0) {
+            WriteProgress(static_cast<size_t>(nbytes));
             Invoke(write_callback_);
         }
         if (wbuf_.size() > 0) {
             mask |= EVENT_WRITABLE;
             mask_ &= ~EVENT_WRITABLE;
+        } else {
+            wbuf_.release();
         }
+    } else if (wbuf_.size() > 0) {
+        //Written while the fd was not known to be writable, wait for the next writable edge
+        mask |= EVENT_WRITABLE;
     }
     if (err == ERROR_OK) {
         if ((mask & EVENT_WRITABLE) == 0) {
@@ -203,11 +226,11 @@ void SSLSocket::SSLWritable() {
 void SSLSocket::SSLHandshake() {
     int ssl_ret, ssl_err, err;
     err = 0;
+    if (early_data_ && !SSLReadEarlyData()) {
+        return;
+    }
     if ((ssl_ret = SSL_do_handshake(ssl_)) == 1) {
-        handshake_status_ = HS_HANDSHAKED;
-        Readable();
-
-        Invoke(estab_callback_);
+        SSLHandshakeDone();
         return;
     }
     ERR_clear_error();
@@ -223,6 +246,7 @@ void SSLSocket::SSLHandshake() {
         }
     } else {
         err = -1;
+        if (handshake_stats_) handshake_stats_->RecordFailure();
 
         //const char* file = NULL;
         //int line, flag;
@@ -237,6 +261,65 @@ void SSLSocket::SSLHandshake() {
     }
 }
 
+bool SSLSocket::SSLReadEarlyData() {
+#if OPENSSL_VERSION_NUMBER >= 0x10101000L
+    char* spill = event_loop_->get_read_spill();
+    for (;;) {
+        size_t nread = 0;
+        int ret = SSL_read_early_data(ssl_, spill, EventLoop::READ_SPILL_SIZE, &nread);
+        if (nread > 0) {
+            rbuf_.append(spill, nread);
+            early_bytes_ += nread;
+        }
+        if (ret == SSL_READ_EARLY_DATA_SUCCESS) {
+            continue;
+        }
+        if (ret == SSL_READ_EARLY_DATA_FINISH) {
+            early_data_ = false;
+            return true;
+        }
+        int err = ERROR_OK;
+        int ssl_err = SSL_get_error(ssl_, -1);
+        ERR_clear_error();
+        if (ssl_err == SSL_ERROR_WANT_WRITE) {
+            if (AddEvent(EVENT_WRITABLE) == -1) err = ERROR_EVENTLOOP_REGISTER;
+        } else if (ssl_err == SSL_ERROR_WANT_READ) {
+            if (AddEvent(EVENT_READABLE) == -1) err = ERROR_EVENTLOOP_REGISTER;
+        } else {
+            err = -1;
+            if (handshake_stats_) handshake_stats_->RecordFailure();
+        }
+        if (err) {
+            SetError(err);
+        }
+        return false;
+    }
+#else
+    early_data_ = false;
+    return true;
+#endif
 }
+
+void SSLSocket::SSLHandshakeDone() {
+    handshake_status_ = HS_HANDSHAKED;
+    if (handshake_stats_) {
+        bool early_data = false;
+#if OPENSSL_VERSION_NUMBER >= 0x10101000L
+        early_data = SSL_get_early_data_status(ssl_) == SSL_EARLY_DATA_ACCEPTED;
+#endif
+        handshake_stats_->Record(SSL_session_reused(ssl_) != 0, early_data, STime_us() - handshake_start_);
+    }
+    //Early data precedes anything read after the handshake
+    if (early_bytes_ > 0) {
+        early_bytes_ = 0;
+        Invoke(read_callback_);
+    }
+    //The handshake consumed the readable edge and records may already wait in the ssl buffers
+    mask_ |= EVENT_READABLE;
+    Readable();
+
+    Invoke(estab_callback_);
 }
 
+}
+}
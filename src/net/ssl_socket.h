@@ -3,6 +3,7 @@
 #pragma once
 #include "event_loop.h"
 #include "socket.h"
+#include "ssl_context.h"
 #include <memory>
 
 namespace tinynet {
@@ -29,6 +30,8 @@ class SSLSocket final
     void Open() override;
     void Readable() override;
     void Writable() override;
+    bool CanDropQueued() override { return false; }
+    bool CanWriteDirect() override { return false; } ///< Plaintext must go through SSL_write
   public:
     //start ssl handshaking
     void Handshake();
@@ -45,11 +48,29 @@ class SSLSocket final
      * @param cb
      */
     void set_estab_callback(EventCallback cb) { estab_callback_ = std::move(cb); }
+    /**
+     * @brief Set the counters the handshake outcome is recorded into
+     *
+     * @param stats
+     */
+    void set_handshake_stats(SSLHandshakeCountersPtr stats) { handshake_stats_ = std::move(stats); }
+    /**
+     * @brief Whether the tunnel was established by resuming a previous session
+     *
+     */
+    bool is_resumed() const { return ssl_ && SSL_session_reused(ssl_); }
+  private:
+    bool SSLReadEarlyData();
+    void SSLHandshakeDone();
   protected:
     SSLContext*   ssl_ctx_;
     int           handshake_status_;
     SSL*          ssl_;
     EventCallback estab_callback_;
+    SSLHandshakeCountersPtr handshake_stats_;
+    int64_t       handshake_start_{ 0 }; ///< us
+    bool          early_data_{ false }; ///< Server still reading TLS 1.3 early data
+    size_t        early_bytes_{ 0 }; ///< Early data buffered until the handshake completes
 
 };
 
@@ -13,6 +13,7 @@ typedef std::shared_ptr<StreamSocket> StreamSocketPtr;
 class StreamSocket final
     : public Socket {
     friend class  StreamListener;
+    friend class  SocketServer;
   public:
     StreamSocket(tinynet::EventLoop *loop);
     StreamSocket(tinynet::EventLoop *loop, int fd, int af, const std::string* peer_address);
@@ -3,6 +3,7 @@
 #include "task_manager.h"
 #include "event_loop.h"
 #include <algorithm>
+#include "base/clock.h"
 
 namespace tinynet {
 
@@ -10,7 +11,9 @@ TaskManager::TaskManager(EventLoop* loop):
     event_loop_(loop) {
 }
 
-TaskManager::~TaskManager() = default;
+TaskManager::~TaskManager() {
+    Stop();
+}
 
 void TaskManager::Init() {
     for (size_t i = 0; i < bit_masks_.size(); ++i) {
@@ -19,31 +22,46 @@ void TaskManager::Init() {
 }
 
 void TaskManager::Stop() {
+    while (MpscNode* node = tasks_.Pop()) {
+        if (node != &marker_) delete static_cast<TaskNode*>(node);
+    }
+    marker_queued_ = false;
+    cancelled_.clear();
     for (size_t i = 0; i < MAX_TASK_QUEUE; ++i) {
         LOCK_GUARD lock(task_queues_[i].lock);
         task_queues_[i].tasks.clear();
     }
 }
 
-void TaskManager::Run() {
-    Execute(0, MAX_TASK_EXECUTED);
+int TaskManager::Run(int64_t deadline_us /* = 0 */) {
+    int ntasks = ExecuteTasks(deadline_us);
     for (int i = 1; i < MAX_TASK_QUEUE; ++i) {
         if ((bit_masks_[i / INTEGRAL_BITS] & (1 << (i % INTEGRAL_BITS)))) {
             {
                 LOCK_GUARD lock(task_queues_[i].lock);
                 bit_masks_[i / INTEGRAL_BITS] &= ~(1 << (i % INTEGRAL_BITS));
             }
-            Execute(i, 0);
+            ntasks += Execute(i);
         }
     }
+    return ntasks;
 }
 
 TaskId TaskManager::AddTask(TaskFunc taskfunc) {
-    return Add(0, taskfunc);
+    if (!taskfunc) return INVALID_TASK_ID;
+    TaskNode* node = new(std::nothrow) TaskNode();
+    if (!node) return INVALID_TASK_ID;
+    node->taskid = NextId();
+    node->func = std::move(taskfunc);
+    TaskId taskid = node->taskid;
+    tasks_.Push(node);
+    return taskid;
 }
 
 void TaskManager::CancelTask(TaskId& taskId) {
-    Remove(0, taskId);
+    if (taskId != INVALID_TASK_ID) {
+        cancelled_.insert(taskId);
+    }
     taskId = INVALID_TASK_ID;
 }
 
@@ -57,11 +75,11 @@ void TaskManager::ClearSignal(int signum, TaskId& sigtid) {
 }
 
 TaskId TaskManager::Add(int qid, TaskFunc taskfunc) {
-    if (qid < 0 || qid >= MAX_TASK_QUEUE) {
+    if (qid <= 0 || qid >= MAX_TASK_QUEUE) {
         return INVALID_TASK_ID;
     }
     if (!taskfunc) return INVALID_TASK_ID;
-    TaskId taskid = event_loop_->NewUniqueId();
+    TaskId taskid = NextId();
     TASK_QUEUE& task_queue = task_queues_[qid];
     {
         std::lock_guard<std::mutex> lock(task_queue.lock);
@@ -71,7 +89,7 @@ TaskId TaskManager::Add(int qid, TaskFunc taskfunc) {
 }
 
 void TaskManager::Remove(int qid, TaskId taskid) {
-    if (qid < 0 || qid >= MAX_TASK_QUEUE) {
+    if (qid <= 0 || qid >= MAX_TASK_QUEUE) {
         return;
     }
     TASK_QUEUE& task_queue = task_queues_[qid];
@@ -86,32 +104,47 @@ void TaskManager::Remove(int qid, TaskId taskid) {
     }
 }
 
-void TaskManager::Execute(int qid, int tasknum) {
-    if (qid < 0 || qid >= MAX_TASK_QUEUE) {
-        return;
+int TaskManager::ExecuteTasks(int64_t deadline_us) {
+    if (tasks_.Empty()) return 0;
+    if (!marker_queued_) {
+        tasks_.Push(&marker_);
+        marker_queued_ = true;
+    }
+    int ntasks = 0;
+    while (MpscNode* node = tasks_.Pop()) {
+        if (node == &marker_) {
+            marker_queued_ = false;
+            break;
+        }
+        TaskNode* task = static_cast<TaskNode*>(node);
+        if (cancelled_.empty() || cancelled_.erase(task->taskid) == 0) {
+            Invoke(task->func);
+            ++ntasks;
+        }
+        delete task;
+        //Out of time budget, the rest stays queued for the next run
+        if (deadline_us > 0 && STime_us() >= deadline_us) break;
+    }
+    //Every cancelled id left refers to a task that has already run
+    if (!cancelled_.empty() && tasks_.Empty()) cancelled_.clear();
+    return ntasks;
+}
+
+int TaskManager::Execute(int qid) {
+    if (qid <= 0 || qid >= MAX_TASK_QUEUE) {
+        return 0;
     }
     TASK_QUEUE& task_queue = task_queues_[qid];
-    if (task_queue.tasks.empty()) return;
+    if (task_queue.tasks.empty()) return 0;
     std::deque<TaskEntry> tasks;
     {
         LOCK_GUARD lock(task_queue.lock);
-        if (qid == 0) {
-            if (tasknum > 0 && tasknum < (int)task_queue.tasks.size()) {
-                for (int i = 0; i < tasknum; i++) {
-                    tasks.push_back(task_queue.tasks[i]);
-                }
-                task_queue.tasks.erase(task_queue.tasks.begin(), task_queue.tasks.begin() + tasknum);
-            } else {
-                tasks.swap(task_queue.tasks);
-            }
-        } else {
-            tasks.assign(task_queue.tasks.begin(), task_queue.tasks.end());
-        }
+        tasks.assign(task_queue.tasks.begin(), task_queue.tasks.end());
     }
-
     for (auto& task : tasks) {
         Invoke(task.second);
     }
+    return (int)tasks.size();
 }
 
 void TaskManager::Signal(int signum) {
@@ -131,6 +164,6 @@ bool TaskManager::Empty() {
             return false;
         }
     }
-    return task_queues_[0].tasks.empty();
+    return tasks_.Empty();
 }
 }
@@ -6,7 +6,10 @@
 #include <deque>
 #include <array>
 #include <mutex>
+#include <atomic>
 #include <utility>
+#include <unordered_set>
+#include "base/mpsc_queue.h"
 
 namespace tinynet {
 typedef int64_t TaskId;
@@ -22,9 +25,17 @@ class TaskManager {
   public:
     void Init();
     void Stop();
-    void Run();
+    /**
+     * @brief Execute queued tasks and raised signals
+     *
+     * @param deadline_us Stop executing tasks once the steady clock passes this point (microseconds), 0 means no limit
+     * @return int The number of tasks executed
+     */
+    int Run(int64_t deadline_us = 0);
   public:
+    ///Thread safe, the task is pushed to a lock-free queue
     TaskId AddTask(TaskFunc taskfunc);
+    ///Must be called from the loop thread
     void CancelTask(TaskId& taskid);
 
     TaskId AddSignal(int signum, TaskFunc sigfunc);
@@ -34,8 +45,14 @@ class TaskManager {
   private:
     TaskId Add(int qid, TaskFunc taskfunc);
     void Remove(int qid, TaskId taskid);
-    void Execute(int qid, int tasknum);
+    int Execute(int qid);
+    int ExecuteTasks(int64_t deadline_us);
+    TaskId NextId() { return ++next_id_; }
   private:
+    struct TaskNode : public MpscNode {
+        TaskId taskid{ INVALID_TASK_ID };
+        TaskFunc func;
+    };
     using TaskEntry = std::pair<TaskId, TaskFunc>;
     using LOCK_GUARD = std::lock_guard<std::mutex>;
     typedef struct TaskQueue {
@@ -43,13 +60,17 @@ class TaskManager {
         std::deque<TaskEntry> tasks;
     } TASK_QUEUE;
 
-    static const int MAX_TASK_EXECUTED = 16;
     static const int MAX_TASK_QUEUE = 64;
 
     static const int INTEGRAL_BITS = sizeof(uint32_t) / sizeof(char) * 8;
   private:
     EventLoop* event_loop_;
-    std::array<TASK_QUEUE, MAX_TASK_QUEUE> task_queues_;
+    MpscQueue tasks_;
+    MpscNode marker_; ///< Pushed at the start of a run, tasks queued behind it wait for the next run
+    bool marker_queued_{ false };
+    std::unordered_set<TaskId> cancelled_;
+    std::atomic<int64_t> next_id_{ 0 };
+    std::array<TASK_QUEUE, MAX_TASK_QUEUE> task_queues_; ///< Signal handlers, indexed by signal number
     std::array<uint32_t, MAX_TASK_QUEUE / INTEGRAL_BITS> bit_masks_;
 };
 }
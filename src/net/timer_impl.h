@@ -0,0 +1,25 @@
+// Copyright (C), Xianfeng Shang.  All rights reserved.
+// Author: Xianfeng Shang (shangxianfeng@outlook.com)
+#pragma once
+#include <stdint.h>
+#include "timer_manager.h"
+namespace tinynet {
+class EventLoop;
+class TimerImpl {
+  public:
+    TimerImpl(EventLoop* loop) : event_loop_(loop) {};
+    virtual ~TimerImpl() = default;
+  public:
+    virtual void Init() = 0;
+    virtual void Stop() = 0;
+    virtual const char* name() = 0;
+    virtual int Run(int64_t deadline_us) = 0;
+    virtual int NearestTimeout() = 0;
+    virtual TimerId AddTimer(uint64_t timeout, uint64_t repeat,
+                             TimerCallback ontimeout, TimerCallback onstop) = 0;
+    virtual void ClearTimer(TimerId timerId) = 0;
+    virtual size_t size() const = 0;
+  protected:
+    EventLoop* event_loop_{ nullptr };
+};
+}
@@ -1,51 +1,50 @@
 // Copyright (C), Xianfeng Shang.  All rights reserved.
 // Author: Xianfeng Shang (shangxianfeng@outlook.com)
 #pragma once
+#include <stdint.h>
 #include <functional>
 #include <memory>
-#include <unordered_map>
-#include <set>
-#include <array>
 
 namespace tinynet {
 class EventLoop;
+class TimerImpl;
 typedef std::function<void()> TimerCallback;
 typedef int64_t TimerId;
 
 constexpr TimerId INVALID_TIMER_ID = 0;
 
+/**
+ * @brief Timer storage engines
+ *
+ */
+enum class TimerBackend {
+    TB_SET = 0, ///< Ordered set keyed by deadline, O(log n) add/cancel
+    TB_WHEEL = 1 ///< Hierarchical timing wheel, O(1) add/cancel
+};
+
 class TimerManager {
   public:
-    TimerManager(EventLoop *loop);
+    TimerManager(EventLoop *loop, TimerBackend backend = TimerBackend::TB_SET);
     ~TimerManager();
   public:
     void Init();
     void Stop();
-    void Run();
+    /**
+     * @brief Fire expired timers
+     *
+     * @param deadline_us Stop firing once the steady clock passes this point (microseconds), 0 means no limit
+     * @return int The number of timers fired
+     */
+    int Run(int64_t deadline_us = 0);
     int NearestTimeout();
+    const char* name();
+    size_t size() const;
   public:
     TimerId AddTimer(uint64_t timeout, uint64_t repeat,
                      TimerCallback ontimeout,TimerCallback onstop = TimerCallback());
     void ClearTimer(TimerId& timerId);
   private:
-    struct TimerEvent {
-        TimerId timerid{ 0 };
-        uint64_t timeout{ 0 };
-        uint64_t interval{ 0 };
-        TimerCallback ontimeout;
-        TimerCallback onstop;
-    };
-    typedef std::shared_ptr<TimerEvent> TimerEventPtr;
-    typedef std::pair<uint64_t, TimerId> TimerEntry;
-  private:
-    static const size_t MAX_TIMER_EVENT = 16;
-    using TIMER_ENTRY_SET = std::set<TimerEntry>;
-    using TIMER_ID_ARRAY = std::array<TimerId, MAX_TIMER_EVENT>;
-    using TIMER_EVENT_MAP = std::unordered_map<TimerId, TimerEventPtr>;
-  private:
+    std::unique_ptr<TimerImpl> impl_;
     EventLoop * event_loop_;
-    TIMER_EVENT_MAP timers_;
-    TIMER_ENTRY_SET entries_;
-    TIMER_ID_ARRAY events_;
 };
 }
@@ -0,0 +1,112 @@
+// Copyright (C), Xianfeng Shang.  All rights reserved.
+// Author: Xianfeng Shang (shangxianfeng@outlook.com)
+#include "timer_set.h"
+#include "base/base.h"
+#include "base/clock.h"
+#include "event_loop.h"
+#include <algorithm>
+#include <limits>
+
+namespace tinynet {
+
+TimerSet::TimerSet(EventLoop *loop) :
+    TimerImpl(loop) {
+}
+
+TimerSet::~TimerSet() = default;
+
+void TimerSet::Init() {
+}
+
+void TimerSet::Stop() {
+    TIMER_ENTRY_SET entries(entries_);
+    entries.insert(events_.begin() + events_pos_, events_.end());
+    events_.clear();
+    events_pos_ = 0;
+    for (auto& entry: entries) {
+        ClearTimer(entry.second);
+    }
+}
+
+const char* TimerSet::name() {
+    return "set";
+}
+
+TimerId TimerSet::AddTimer(uint64_t timeout, uint64_t repeat, TimerCallback ontimeout,TimerCallback onstop) {
+    auto timeout_ms = event_loop_->Time() + timeout;
+    auto timer_id = event_loop_->NewUniqueId();
+    TimerEventPtr pEvent = std::make_shared<TimerEvent>();
+    if (!pEvent) return  INVALID_TIMER_ID;
+
+    pEvent->timerid = timer_id;
+    pEvent->interval = repeat;
+    pEvent->ontimeout = std::move(ontimeout);
+    pEvent->onstop = std::move(onstop);
+    pEvent->timeout = timeout_ms;
+
+    bool result = timers_.emplace(timer_id, std::move(pEvent)).second;
+    if (!result) return INVALID_TIMER_ID;
+    entries_.insert(std::make_pair(timeout_ms, timer_id));
+    return timer_id;
+}
+
+void TimerSet::ClearTimer(TimerId timerId) {
+    auto it = timers_.find(timerId);
+    if (it != timers_.end()) {
+        TimerEventPtr timer(it->second);
+        entries_.erase(std::make_pair(timer->timeout, timerId));
+        timers_.erase(it);
+
+        Invoke(timer->onstop);
+    }
+}
+
+
+int TimerSet::Run(int64_t deadline_us) {
+    //Timers left over by the previous run go first, otherwise take the expired ones
+    if (events_pos_ >= events_.size()) {
+        events_.clear();
+        events_pos_ = 0;
+        if (entries_.empty()) return 0;
+
+        uint64_t now = (uint64_t)event_loop_->Time();
+        if (now < entries_.begin()->first) return 0;
+
+        TIMER_ENTRY_SET::iterator first = entries_.begin();
+        TIMER_ENTRY_SET::iterator last = entries_.upper_bound(std::make_pair(now, (std::numeric_limits<TimerId>::max)()));
+        events_.assign(first, last);
+        entries_.erase(first, last);
+    }
+    int nfired = 0;
+    while (events_pos_ < events_.size()) {
+        if (deadline_us > 0 && nfired > 0 && STime_us() >= deadline_us) {
+            break;
+        }
+        auto timer_it = timers_.find(events_[events_pos_++].second);
+        if (timer_it == timers_.end()) continue;
+        std::weak_ptr<TimerEvent> week_timer(timer_it->second);
+        ++nfired;
+        Invoke(timer_it->second->ontimeout);
+        if (week_timer.expired()) continue;
+        auto pTimer = week_timer.lock();
+        if (pTimer->interval == 0) {
+            timers_.erase(pTimer->timerid);
+            Invoke(pTimer->onstop);
+        } else {
+            pTimer->timeout += pTimer->interval;
+            entries_.insert(std::make_pair(pTimer->timeout, pTimer->timerid));
+        }
+    }
+    return nfired;
+}
+
+int TimerSet::NearestTimeout() {
+    if (events_pos_ < events_.size()) return 0;
+    if (entries_.empty()) return EventLoop::MAX_BACKEND_TIMEOUT;
+    auto retval = (int64_t)entries_.begin()->first - event_loop_->Time();
+    if (retval <= 0) {
+        return 0;
+    }
+    return (int)retval;
+}
+}
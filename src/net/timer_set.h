@@ -0,0 +1,47 @@
+// Copyright (C), Xianfeng Shang.  All rights reserved.
+// Author: Xianfeng Shang (shangxianfeng@outlook.com)
+#pragma once
+#include <memory>
+#include <unordered_map>
+#include <set>
+#include <vector>
+#include "timer_impl.h"
+
+namespace tinynet {
+class EventLoop;
+//Timer engine backed by an ordered set of (deadline, timer id) pairs
+class TimerSet : public TimerImpl {
+  public:
+    TimerSet(EventLoop *loop);
+    ~TimerSet();
+  public:
+    virtual void Init() override;
+    virtual void Stop() override;
+    virtual const char* name() override;
+    virtual int Run(int64_t deadline_us) override;
+    virtual int NearestTimeout() override;
+    virtual TimerId AddTimer(uint64_t timeout, uint64_t repeat,
+                             TimerCallback ontimeout, TimerCallback onstop) override;
+    virtual void ClearTimer(TimerId timerId) override;
+    virtual size_t size() const override { return timers_.size(); }
+  private:
+    struct TimerEvent {
+        TimerId timerid{ 0 };
+        uint64_t timeout{ 0 };
+        uint64_t interval{ 0 };
+        TimerCallback ontimeout;
+        TimerCallback onstop;
+    };
+    typedef std::shared_ptr<TimerEvent> TimerEventPtr;
+    typedef std::pair<uint64_t, TimerId> TimerEntry;
+  private:
+    using TIMER_ENTRY_SET = std::set<TimerEntry>;
+    using TIMER_ENTRY_VECTOR = std::vector<TimerEntry>;
+    using TIMER_EVENT_MAP = std::unordered_map<TimerId, TimerEventPtr>;
+  private:
+    TIMER_EVENT_MAP timers_;
+    TIMER_ENTRY_SET entries_;
+    TIMER_ENTRY_VECTOR events_;
+    size_t events_pos_{ 0 };
+};
+}
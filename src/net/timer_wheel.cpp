@@ -0,0 +1,278 @@
+// Copyright (C), Xianfeng Shang.  All rights reserved.
+// Author: Xianfeng Shang (shangxianfeng@outlook.com)
+#include "timer_wheel.h"
+#include "base/base.h"
+#include "base/clock.h"
+#include "event_loop.h"
+#include <algorithm>
+
+namespace tinynet {
+
+TimerWheel::TimerWheel(EventLoop *loop) :
+    TimerImpl(loop),
+    running_(nullptr),
+    free_nodes_(nullptr),
+    current_((uint64_t)loop->Time()),
+    size_(0) {
+    for (auto& head : root_) {
+        ListInit(&head);
+    }
+    for (auto& wheel : wheels_) {
+        for (auto& head : wheel) {
+            ListInit(&head);
+        }
+    }
+    ListInit(&overflow_);
+    ListInit(&expired_);
+    ListInit(&pending_);
+}
+
+TimerWheel::~TimerWheel() = default;
+
+void TimerWheel::Init() {
+    current_ = (uint64_t)event_loop_->Time();
+}
+
+void TimerWheel::Stop() {
+    std::vector<TimerId> timers;
+    timers.reserve(size_);
+    for (auto& chunk : chunks_) {
+        for (size_t i = 0; i < NODE_CHUNK_SIZE; ++i) {
+            if (chunk[i].timerid != INVALID_TIMER_ID) {
+                timers.push_back(chunk[i].timerid);
+            }
+        }
+    }
+    for (auto timerId : timers) {
+        ClearTimer(timerId);
+    }
+}
+
+const char* TimerWheel::name() {
+    return "wheel";
+}
+
+TimerId TimerWheel::AddTimer(uint64_t timeout, uint64_t repeat, TimerCallback ontimeout, TimerCallback onstop) {
+    TimerNode* node = AllocNode();
+    if (!node) return INVALID_TIMER_ID;
+
+    node->interval = repeat;
+    node->ontimeout = std::move(ontimeout);
+    node->onstop = std::move(onstop);
+    node->timeout = (uint64_t)event_loop_->Time() + timeout;
+    Schedule(node);
+    ++size_;
+    return node->timerid;
+}
+
+void TimerWheel::ClearTimer(TimerId timerId) {
+    TimerNode* node = GetNode(timerId);
+    if (!node) return;
+
+    TimerCallback onstop(std::move(node->onstop));
+    if (node == running_) {
+        //The node is released by Expire() once its ontimeout callback returns
+        node->timerid = INVALID_TIMER_ID;
+    } else {
+        ListRemove(node);
+        FreeNode(node);
+    }
+    --size_;
+    Invoke(onstop);
+}
+
+int TimerWheel::Run(int64_t deadline_us) {
+    uint64_t now = (uint64_t)event_loop_->Time();
+    if (size_ == 0) {
+        current_ = (std::max)(current_, now + 1);
+        return 0;
+    }
+    int nfired = 0;
+    if (!ListEmpty(&expired_)) {
+        ListSplice(&expired_, &pending_);
+        if (!Expire(now, deadline_us, &nfired)) return nfired;
+    }
+    while (current_ <= now) {
+        size_t index = (size_t)(current_ & ROOT_MASK);
+        if (index == 0 && Cascade(0) == 0 && Cascade(1) == 0 && Cascade(2) == 0) {
+            CascadeOverflow();
+        }
+        ++current_;
+        if (!ListEmpty(&root_[index])) {
+            ListSplice(&root_[index], &pending_);
+            if (!Expire(now, deadline_us, &nfired)) break;
+        }
+    }
+    return nfired;
+}
+
+int TimerWheel::NearestTimeout() {
+    if (size_ == 0) return EventLoop::MAX_BACKEND_TIMEOUT;
+    if (!ListEmpty(&expired_)) return 0;
+
+    uint64_t now = (uint64_t)event_loop_->Time();
+    //Only the root wheel knows exact deadlines, so stop scanning at the next cascade point
+    uint64_t limit = (current_ & ROOT_MASK) ? (current_ | ROOT_MASK) + 1 : current_;
+    limit = (std::min)(limit, now + EventLoop::MAX_BACKEND_TIMEOUT);
+    uint64_t tick = current_;
+    while (tick < limit && ListEmpty(&root_[tick & ROOT_MASK])) {
+        ++tick;
+    }
+    auto retval = (int64_t)tick - (int64_t)now;
+    if (retval <= 0) {
+        return 0;
+    }
+    return (int)retval;
+}
+
+TimerWheel::TimerNode* TimerWheel::AllocNode() {
+    if (!free_nodes_) {
+        std::unique_ptr<TimerNode[]> chunk(new(std::nothrow) TimerNode[NODE_CHUNK_SIZE]);
+        if (!chunk) return nullptr;
+        uint32_t base = static_cast<uint32_t>(chunks_.size() * NODE_CHUNK_SIZE);
+        for (size_t i = NODE_CHUNK_SIZE; i > 0; --i) {
+            TimerNode* node = &chunk[i - 1];
+            node->index = base + static_cast<uint32_t>(i - 1);
+            node->next = free_nodes_;
+            free_nodes_ = node;
+        }
+        chunks_.emplace_back(std::move(chunk));
+    }
+    TimerNode* node = free_nodes_;
+    free_nodes_ = static_cast<TimerNode*>(node->next);
+    node->prev = node->next = nullptr;
+    node->seq = (node->seq + 1) & 0x7fffffff;
+    node->timerid = ((int64_t)node->seq << 32) | (int64_t)(node->index + 1);
+    return node;
+}
+
+void TimerWheel::FreeNode(TimerNode* node) {
+    node->timerid = INVALID_TIMER_ID;
+    node->ontimeout = nullptr;
+    node->onstop = nullptr;
+    node->prev = nullptr;
+    node->next = free_nodes_;
+    free_nodes_ = node;
+}
+
+TimerWheel::TimerNode* TimerWheel::GetNode(TimerId timerId) {
+    if (timerId <= INVALID_TIMER_ID) return nullptr;
+    size_t index = (size_t)(timerId & 0xffffffff) - 1;
+    size_t chunk = index / NODE_CHUNK_SIZE;
+    if (chunk >= chunks_.size()) return nullptr;
+    TimerNode* node = &chunks_[chunk][index % NODE_CHUNK_SIZE];
+    return node->timerid == timerId ? node : nullptr;
+}
+
+void TimerWheel::Schedule(TimerNode* node) {
+    uint64_t expires = node->timeout;
+    TimerLink* head;
+    if (expires < current_) {
+        head = &expired_;
+    } else {
+        uint64_t idx = expires - current_;
+        if (idx < ROOT_SIZE) {
+            head = &root_[expires & ROOT_MASK];
+        } else if (idx < (1ULL << (ROOT_BITS + WHEEL_BITS))) {
+            head = &wheels_[0][(expires >> ROOT_BITS) & WHEEL_MASK];
+        } else if (idx < (1ULL << (ROOT_BITS + 2 * WHEEL_BITS))) {
+            head = &wheels_[1][(expires >> (ROOT_BITS + WHEEL_BITS)) & WHEEL_MASK];
+        } else if (idx < (1ULL << (ROOT_BITS + 3 * WHEEL_BITS))) {
+            head = &wheels_[2][(expires >> (ROOT_BITS + 2 * WHEEL_BITS)) & WHEEL_MASK];
+        } else {
+            head = &overflow_;
+        }
+    }
+    ListAppend(head, node);
+}
+
+size_t TimerWheel::Cascade(int n) {
+    size_t index = (size_t)((current_ >> (ROOT_BITS + n * WHEEL_BITS)) & WHEEL_MASK);
+    TimerLink timers;
+    ListInit(&timers);
+    ListSplice(&wheels_[n][index], &timers);
+    while (!ListEmpty(&timers)) {
+        TimerLink* link = timers.next;
+        ListRemove(link);
+        Schedule(static_cast<TimerNode*>(link));
+    }
+    return index;
+}
+
+void TimerWheel::CascadeOverflow() {
+    TimerLink timers;
+    ListInit(&timers);
+    ListSplice(&overflow_, &timers);
+    while (!ListEmpty(&timers)) {
+        TimerLink* link = timers.next;
+        ListRemove(link);
+        Schedule(static_cast<TimerNode*>(link));
+    }
+}
+
+bool TimerWheel::Expire(uint64_t now, int64_t deadline_us, int* nfired) {
+    while (!ListEmpty(&pending_)) {
+        if (deadline_us > 0 && *nfired > 0 && STime_us() >= deadline_us) {
+            //Out of time budget, the rest will be fired by the next run
+            ListSplice(&pending_, &expired_);
+            return false;
+        }
+        ++*nfired;
+        TimerNode* node = static_cast<TimerNode*>(pending_.next);
+        ListRemove(node);
+        running_ = node;
+        Invoke(node->ontimeout);
+        running_ = nullptr;
+        if (node->timerid == INVALID_TIMER_ID) {
+            //Cleared by its own ontimeout callback, onstop has been invoked already
+            FreeNode(node);
+        } else if (node->interval == 0) {
+            TimerCallback onstop(std::move(node->onstop));
+            FreeNode(node);
+            --size_;
+            Invoke(onstop);
+        } else {
+            node->timeout += node->interval;
+            if (node->timeout <= now) {
+                //Fire at most once per Run(), a late repeating timer catches up on the following runs
+                ListAppend(&expired_, node);
+            } else {
+                Schedule(node);
+            }
+        }
+    }
+    return true;
+}
+
+void TimerWheel::ListInit(TimerLink* head) {
+    head->prev = head->next = head;
+}
+
+bool TimerWheel::ListEmpty(const TimerLink* head) {
+    return head->next == head;
+}
+
+void TimerWheel::ListAppend(TimerLink* head, TimerLink* link) {
+    link->prev = head->prev;
+    link->next = head;
+    head->prev->next = link;
+    head->prev = link;
+}
+
+void TimerWheel::ListRemove(TimerLink* link) {
+    link->prev->next = link->next;
+    link->next->prev = link->prev;
+    link->prev = link->next = nullptr;
+}
+
+void TimerWheel::ListSplice(TimerLink* from, TimerLink* to) {
+    if (ListEmpty(from)) return;
+    TimerLink* first = from->next;
+    TimerLink* last = from->prev;
+    first->prev = to->prev;
+    to->prev->next = first;
+    last->next = to;
+    to->prev = last;
+    ListInit(from);
+}
+}
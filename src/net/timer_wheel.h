@@ -0,0 +1,86 @@
+// Copyright (C), Xianfeng Shang.  All rights reserved.
+// Author: Xianfeng Shang (shangxianfeng@outlook.com)
+#pragma once
+#include <memory>
+#include <vector>
+#include <array>
+#include "timer_impl.h"
+
+namespace tinynet {
+class EventLoop;
+/**
+ * @brief Hierarchical timing wheel with a millisecond tick.
+ *
+ * The root wheel holds 256 one-millisecond slots, followed by three wheels of 64 slots each,
+ * which together cover 2^26 ms (about 18.6 hours). Longer timers wait in an overflow list and
+ * are re-scheduled whenever the outermost wheel wraps around.
+ * Timer nodes are intrusive list entries carved out of fixed-size chunks and recycled through
+ * a free list, and a timer id encodes the node index, so add and clear are both O(1).
+ */
+class TimerWheel : public TimerImpl {
+  public:
+    TimerWheel(EventLoop *loop);
+    ~TimerWheel();
+  public:
+    virtual void Init() override;
+    virtual void Stop() override;
+    virtual const char* name() override;
+    virtual int Run(int64_t deadline_us) override;
+    virtual int NearestTimeout() override;
+    virtual TimerId AddTimer(uint64_t timeout, uint64_t repeat,
+                             TimerCallback ontimeout, TimerCallback onstop) override;
+    virtual void ClearTimer(TimerId timerId) override;
+    virtual size_t size() const override { return size_; }
+  private:
+    struct TimerLink {
+        TimerLink* prev{ nullptr };
+        TimerLink* next{ nullptr };
+    };
+    struct TimerNode : public TimerLink {
+        TimerId timerid{ INVALID_TIMER_ID };
+        uint32_t index{ 0 };
+        uint32_t seq{ 0 };
+        uint64_t timeout{ 0 };
+        uint64_t interval{ 0 };
+        TimerCallback ontimeout;
+        TimerCallback onstop;
+    };
+  private:
+    static const int ROOT_BITS = 8;
+    static const int WHEEL_BITS = 6;
+    static const int WHEEL_NUM = 3;
+    static const size_t ROOT_SIZE = 1 << ROOT_BITS;
+    static const size_t WHEEL_SIZE = 1 << WHEEL_BITS;
+    static const uint64_t ROOT_MASK = ROOT_SIZE - 1;
+    static const uint64_t WHEEL_MASK = WHEEL_SIZE - 1;
+    static const size_t NODE_CHUNK_SIZE = 1024;
+    using ROOT_WHEEL = std::array<TimerLink, ROOT_SIZE>;
+    using WHEEL = std::array<TimerLink, WHEEL_SIZE>;
+    using NODE_CHUNK_VECTOR = std::vector<std::unique_ptr<TimerNode[]>>;
+  private:
+    TimerNode* AllocNode();
+    void FreeNode(TimerNode* node);
+    TimerNode* GetNode(TimerId timerId);
+    void Schedule(TimerNode* node);
+    size_t Cascade(int n);
+    void CascadeOverflow();
+    bool Expire(uint64_t now, int64_t deadline_us, int* nfired);
+  private:
+    static void ListInit(TimerLink* head);
+    static bool ListEmpty(const TimerLink* head);
+    static void ListAppend(TimerLink* head, TimerLink* link);
+    static void ListRemove(TimerLink* link);
+    static void ListSplice(TimerLink* from, TimerLink* to);
+  private:
+    ROOT_WHEEL root_;
+    std::array<WHEEL, WHEEL_NUM> wheels_;
+    TimerLink overflow_; ///< Timers beyond the range of the outermost wheel
+    TimerLink expired_; ///< Timers already due when they were (re)scheduled
+    TimerLink pending_; ///< Timers being fired by the current Run()
+    TimerNode* running_; ///< The timer whose ontimeout callback is being invoked
+    TimerNode* free_nodes_;
+    NODE_CHUNK_VECTOR chunks_;
+    uint64_t current_; ///< The next tick to be processed
+    size_t size_;
+};
+}
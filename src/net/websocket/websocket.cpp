@@ -58,6 +58,8 @@ void WebSocket::Dispose(bool disposed) {
         onmessage_callback_ = nullptr;
         onerror_callback_ = nullptr;
         onclose_callback_ = nullptr;
+        onhighwater_callback_ = nullptr;
+        ondrain_callback_ = nullptr;
     }
 }
 
@@ -98,6 +100,32 @@ void WebSocket::OnClose() {
     Dispose(false);
 }
 
+void WebSocket::OnHighWater() {
+    Invoke(onhighwater_callback_);
+}
+
+void WebSocket::OnDrain() {
+    Invoke(ondrain_callback_);
+}
+
+bool WebSocket::Export(std::string* state) {
+    //A frame half decoded lives in the codec, hand over between frames only
+    if (!server_ || !handshake_ || !codec_websocket_->at_frame_boundary()) {
+        return false;
+    }
+    *state = peer_ip_;
+    return true;
+}
+
+bool WebSocket::Import(const std::string& state) {
+    peer_ip_ = state;
+    handshake_ = true;
+    keepalive_time_ = event_loop_->Time();
+    log_info("WebSocket(%lld, %s) taken over", guid_, peer_ip_.c_str());
+    Invoke(onopen_callback_);
+    return true;
+}
+
 void WebSocket::Update() {
     if (!is_alive()) {
         int err = handshake_ ? ERROR_WEBSOCKET_KEEPALIVETIMEOUT : ERROR_WEBSOCKET_HANDSHAKETIMEOUT;
@@ -227,7 +255,18 @@ void WebSocket::HandleMessage(const WebSocketMessage* msg) {
 
 bool WebSocket::Send(const WebSocketMessage& msg) {
     if (socket_ && socket_->is_connected()) {
+        if (msg.opcode == Opcode::Text || msg.opcode == Opcode::Binary) {
+            //Control frames always go out, data frames are subject to the overflow policy
+            size_t len = msg.data_ref ? msg.data_len : (msg.bytes_ref ? msg.bytes_ref->size() : msg.data.size());
+            if (!socket_->Admit(len)) {
+                return false;
+            }
+        }
+        size_t offset = socket_->get_write_offset();
         codec_websocket_->Write(socket_, &msg);
+        if (msg.droppable) {
+            socket_->MarkDroppable(offset);
+        }
         return true;
     }
     return false;
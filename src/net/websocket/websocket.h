@@ -18,6 +18,8 @@ typedef std::function<void()> onopen_callback;
 typedef std::function<void(const WebSocketMessage* msg)> onmessage_callback;
 typedef std::function<void(int err)> onerror_callback;
 typedef std::function<void()> onclose_callback;
+typedef std::function<void()> onhighwater_callback;
+typedef std::function<void()> ondrain_callback;
 
 class WebSocket;
 typedef std::shared_ptr<WebSocket> WebSocketPtr;
@@ -40,6 +42,10 @@ class WebSocket:
     void OnRead() override;
     void OnError(int err) override;
     void OnClose() override;
+    void OnHighWater() override;
+    void OnDrain() override;
+    bool Export(std::string* state) override;
+    bool Import(const std::string& state) override;
   protected:
     void HandleHandshake(const tinynet::http::HttpMessage& msg);
     void OnHandshakeReq(const tinynet::http::HttpMessage& msg);
@@ -61,6 +67,10 @@ class WebSocket:
 
     void set_onclose_callback(onclose_callback cb) { onclose_callback_ = cb; }
 
+    void set_onhighwater_callback(onhighwater_callback cb) { onhighwater_callback_ = cb; }
+
+    void set_ondrain_callback(ondrain_callback cb) { ondrain_callback_ = cb; }
+
     const std::string& get_peer_ip() const { return peer_ip_; }
 
   public:
@@ -84,6 +94,8 @@ class WebSocket:
     onmessage_callback	onmessage_callback_;
     onerror_callback	onerror_callback_;
     onclose_callback	onclose_callback_;
+    onhighwater_callback onhighwater_callback_;
+    ondrain_callback	ondrain_callback_;
 };
 
 }
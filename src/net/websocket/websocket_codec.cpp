@@ -180,9 +180,7 @@ void WebSocketCodec::Write(net::SocketPtr& sock, const WebSocketMessage *msg ) {
 }
 
 void WebSocketCodec::Write(net::SocketPtr& sock, Opcode opcode, const char* msg, size_t len) {
-    sock->wbuf()->reserve(sock->wbuf()->size() + MAX_FRAME_HEADER_LENGTH + len);
-
-    char* buf = sock->wbuf()->end();
+    char* buf = sock->PrepareWrite(MAX_FRAME_HEADER_LENGTH + len);
     char* p = buf;
     size_t nlen = 0;
     *p = (char)opcode | 0x80;
@@ -233,7 +231,7 @@ void WebSocketCodec::Write(net::SocketPtr& sock, Opcode opcode, const char* msg,
     }
     p += len;
     nlen += len;
-    sock->wbuf()->commit(nlen);
+    sock->CommitWrite(nlen);
     sock->Flush();
 }
 }
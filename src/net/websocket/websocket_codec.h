@@ -46,6 +46,11 @@ class WebSocketCodec {
     void Write(net::SocketPtr& sock, const WebSocketMessage* msg);
     void Write(net::SocketPtr& sock, Opcode opcode, const char* msg, size_t len);
     void set_max_packet_size(int value) { max_packet_size_ = value; }
+    //No frame or fragmented message is being decoded
+    bool at_frame_boundary() const {
+        return decode_status_ == DecodeStatus::None || decode_status_ == DecodeStatus::Reset ||
+               (decode_status_ == DecodeStatus::Header && msg_.data.empty());
+    }
   private:
     WebSocketPacket		pkt_;
     WebSocketMessage	msg_;
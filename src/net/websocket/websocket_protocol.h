@@ -39,6 +39,7 @@ struct WebSocketMessage {
     const char* data_ref{ nullptr };
     size_t		data_len{ 0 };
     std::string* bytes_ref{ nullptr };
+    bool		droppable{ false }; ///< May be discarded by the drop_oldest overflow policy
 };
 
 }
@@ -4,6 +4,7 @@
 #include "websocket_codec.h"
 #include "net/http/http_codec.h"
 #include "base/error_code.h"
+#include "util/net_utils.h"
 #include "net/http/http_server.h"
 #include "websocket.h"
 #include <functional>
@@ -28,6 +29,7 @@ WebSocketServer::WebSocketServer(EventLoop *loop, SSLContext* ctx) :
 
 
 WebSocketServer::~WebSocketServer() {
+    StopShards();
     if (update_timer_) {
         event_loop_->ClearTimer(update_timer_);
     }
@@ -36,7 +38,11 @@ WebSocketServer::~WebSocketServer() {
 int WebSocketServer::Start(net::ServerOptions& opts) {
     int err;
     if (opts.name.empty()) opts.name = "WebSocket";
-
+#ifndef _WIN32
+    if (opts.io_threads > 0 && opts.listen_path.empty()) {
+        return StartShards(opts);
+    }
+#endif
     if ((err = net::SocketServer::Start(opts)) == ERROR_OK) {
         update_timer_ = event_loop_->AddTimer(kUpdateInterval, kUpdateInterval,
                                               std::bind(&WebSocketServer::Update, this));
@@ -45,6 +51,7 @@ int WebSocketServer::Start(net::ServerOptions& opts) {
 }
 
 void WebSocketServer::Stop() {
+    StopShards();
     if (update_timer_) {
         event_loop_->ClearTimer(update_timer_);
     }
@@ -61,10 +68,30 @@ net::SocketChannelPtr WebSocketServer::CreateChannel(net::SocketPtr sock) {
     session->set_onerror_callback(onerror);
     auto onclose = std::bind(&WebSocketServer::websocket_session_onclose, this, session->get_guid());
     session->set_onclose_callback(onclose);
+    auto onhighwater = std::bind(&WebSocketServer::websocket_session_onhighwater, this, session->get_guid());
+    session->set_onhighwater_callback(onhighwater);
+    auto ondrain = std::bind(&WebSocketServer::websocket_session_ondrain, this, session->get_guid());
+    session->set_ondrain_callback(ondrain);
     return session;
 }
 
+static void shard_send(WebSocketServer* shard, int64_t session_guid, std::shared_ptr<WebSocketMessage> msg) {
+    shard->Send(session_guid, *msg);
+}
+
+static void shard_broadcast(WebSocketServer* shard, std::shared_ptr<WebSocketMessage> msg) {
+    shard->Broadcast(*msg);
+}
+
 void WebSocketServer::CloseSession(int64_t session_guid) {
+    if (io_loops_) {
+        auto it = session_shards_.find(session_guid);
+        if (it != session_shards_.end()) {
+            WebSocketServer* shard = shards_[it->second.shard].get();
+            shard->event_loop()->AddTask(std::bind(&WebSocketServer::CloseSession, shard, session_guid));
+        }
+        return;
+    }
     auto session = GetChannel<WebSocket>(session_guid);
     if (session) {
         session->Close(ERROR_WEBSOCKET_CLOSEDBYSERVER);
@@ -72,12 +99,35 @@ void WebSocketServer::CloseSession(int64_t session_guid) {
 }
 
 bool WebSocketServer::Send(int64_t channel_guid, const WebSocketMessage& msg ) {
+    if (io_loops_) {
+        auto it = session_shards_.find(channel_guid);
+        if (it == session_shards_.end()) return false;
+        WebSocketServer* shard = shards_[it->second.shard].get();
+        shard->event_loop()->AddTask(std::bind(shard_send, shard, channel_guid, CopyMessage(msg)));
+        return true;
+    }
     auto session = GetChannel<WebSocket>(channel_guid);
     return session ? session->Send(msg) : false;
 }
 
 
+std::string WebSocketServer::GetPeerIp(int64_t session_guid) {
+    if (io_loops_) {
+        auto it = session_shards_.find(session_guid);
+        return it != session_shards_.end() ? it->second.addr : std::string();
+    }
+    auto session = GetChannel<WebSocket>(session_guid);
+    return session ? session->get_peer_ip() : std::string();
+}
+
 void WebSocketServer::Broadcast(const WebSocketMessage& msg) {
+    if (io_loops_) {
+        auto shared_msg = CopyMessage(msg);
+        for (auto& shard : shards_) {
+            shard->event_loop()->AddTask(std::bind(shard_broadcast, shard.get(), shared_msg));
+        }
+        return;
+    }
     for (auto& entry : channels_) {
         auto session = std::static_pointer_cast<WebSocket>(entry.second);
         if (session) {
@@ -137,5 +187,184 @@ void WebSocketServer::websocket_session_onerror(int64_t session_guid, int err) {
     }
 }
 
+void WebSocketServer::websocket_session_onhighwater(int64_t session_guid) {
+    if (websocket_session_callback_ != nullptr) {
+        server::WebSocketSessionEvent evt;
+        evt.type = server::WEBSOCKET_SESSION_EVENT_ON_HIGHWATER;
+        evt.guid = session_guid;
+        websocket_session_callback_(evt);
+    }
+}
+
+void WebSocketServer::websocket_session_ondrain(int64_t session_guid) {
+    if (websocket_session_callback_ != nullptr) {
+        server::WebSocketSessionEvent evt;
+        evt.type = server::WEBSOCKET_SESSION_EVENT_ON_DRAIN;
+        evt.guid = session_guid;
+        websocket_session_callback_(evt);
+    }
+}
+
+int WebSocketServer::StartShards(net::ServerOptions& opts) {
+    if (io_loops_) return ERROR_SERVER_STARTED;
+    opts_ = opts;
+    //The shards share one TLS context and so one session cache and ticket key
+    int err = InitSSL();
+    if (err != ERROR_OK) return err;
+    io_loops_.reset(new(std::nothrow) net::IoLoopGroup());
+    if (!io_loops_) return ERROR_OS_OOM;
+    err = io_loops_->Init(opts.io_threads, event_loop_);
+    if (err != ERROR_OK) {
+        io_loops_.reset();
+        return err;
+    }
+    self_ = std::make_shared<WebSocketServer*>(this);
+    net::ServerOptions shard_opts = opts_;
+    shard_opts.io_threads = 0;
+    shard_opts.reuseport = true;
+    for (size_t i = 0; i < io_loops_->size(); ++i) {
+        std::unique_ptr<WebSocketServer> shard(new(std::nothrow) WebSocketServer(io_loops_->get_loop(i), ssl_ctx_));
+        if (!shard) {
+            err = ERROR_OS_OOM;
+            break;
+        }
+        shard->set_websocket_session_callback(std::bind(&WebSocketServer::PostShardEvent, this, i, std::placeholders::_1));
+        if (hot_upgrade_) {
+            hot_upgrade_->TakeListener(opts_.name, &shard->inherited_listener_);
+        }
+        if ((err = shard->Start(shard_opts)) != ERROR_OK) {
+            break;
+        }
+        //The other shards join the address the first one resolved, including ephemeral and ranged ports
+        shard_opts.listen_url.clear();
+        shard_opts.listen_ip = shard->get_opts().listen_ip;
+        shard_opts.listen_port = shard->get_listen_port();
+        shards_.push_back(std::move(shard));
+    }
+    if (err != ERROR_OK) {
+        StopShards();
+        return err;
+    }
+    opts_.listen_port = shard_opts.listen_port;
+    if (hot_upgrade_) {
+        //Connections live on the loop of their shard, only the listeners are handed over
+        std::vector<net::HandoffSocket> socks;
+        hot_upgrade_->TakeChannels(opts_.name, &socks);
+        for (auto& sock : socks) {
+            NetUtils::Close(sock.fd);
+        }
+        hot_upgrade_->AddServer(this);
+    }
+    io_loops_->Start();
+    return ERROR_OK;
+}
+
+void WebSocketServer::CollectHandshakeStats(SSLHandshakeStats* stats) {
+    net::SocketServer::CollectHandshakeStats(stats);
+    //The counters are atomic, reading them across the io threads is safe
+    for (auto& shard : shards_) {
+        shard->CollectHandshakeStats(stats);
+    }
+}
+
+void WebSocketServer::Export(std::vector<net::HandoffSocket>* socks) {
+    if (!io_loops_) {
+        net::SocketServer::Export(socks);
+        return;
+    }
+    //The descriptors of the shard listeners never change once started, the shards keep accepting until they stop
+    for (auto& shard : shards_) {
+        shard->ExportListener(socks);
+    }
+}
+
+void WebSocketServer::Detach() {
+    if (!io_loops_) {
+        net::SocketServer::Detach();
+    }
+}
+
+void WebSocketServer::StopShards() {
+    if (!io_loops_) return;
+    io_loops_->Join();
+    for (auto& shard : shards_) {
+        shard->Stop();
+    }
+    shards_.clear();
+    io_loops_.reset();
+    session_shards_.clear();
+    self_.reset();
+}
+
+static void handle_shard_event(std::weak_ptr<WebSocketServer*> self, std::function<void(WebSocketServer*)> handler) {
+    if (auto server = self.lock()) {
+        handler(*server);
+    }
+}
+
+void WebSocketServer::PostShardEvent(size_t shard, const server::WebSocketSessionEvent& evt) {
+    ShardEventPtr ev = std::make_shared<ShardEvent>();
+    ev->type = evt.type;
+    ev->guid = evt.guid;
+    ev->err = evt.err;
+    if (evt.type == server::WEBSOCKET_SESSION_EVENT_ON_OPEN) {
+        //Kept by the app loop for the events after
+        auto session = shards_[shard]->GetChannel<WebSocket>(evt.guid);
+        if (session) {
+            ev->addr = session->get_peer_ip();
+        }
+    }
+    if (evt.msg) {
+        ev->msg.opcode = evt.msg->opcode;
+        ev->msg.data = evt.msg->data;
+    }
+    std::weak_ptr<WebSocketServer*> self(self_);
+    event_loop_->AddTask(std::bind(handle_shard_event, self,
+                                   std::function<void(WebSocketServer*)>(std::bind(&WebSocketServer::HandleShardEvent, std::placeholders::_1, shard, ev))));
+}
+
+void WebSocketServer::HandleShardEvent(size_t shard, ShardEventPtr ev) {
+    const std::string* addr = &ev->addr;
+    if (ev->type == server::WEBSOCKET_SESSION_EVENT_ON_OPEN) {
+        auto& session = session_shards_[ev->guid];
+        session.shard = shard;
+        session.addr = std::move(ev->addr);
+        addr = &session.addr;
+    } else {
+        auto it = session_shards_.find(ev->guid);
+        if (it != session_shards_.end()) {
+            addr = &it->second.addr;
+        }
+    }
+    if (websocket_session_callback_ != nullptr) {
+        server::WebSocketSessionEvent evt;
+        evt.type = ev->type;
+        evt.guid = ev->guid;
+        evt.err = ev->err;
+        evt.addr = addr;
+        if (ev->type == server::WEBSOCKET_SESSION_EVENT_ON_MESSAGE) {
+            evt.msg = &ev->msg;
+        }
+        websocket_session_callback_(evt);
+    }
+    if (ev->type == server::WEBSOCKET_SESSION_EVENT_ON_CLOSE) {
+        session_shards_.erase(ev->guid);
+    }
+}
+
+WebSocketServer::WebSocketMessagePtr WebSocketServer::CopyMessage(const WebSocketMessage& msg) {
+    WebSocketMessagePtr copy = std::make_shared<WebSocketMessage>();
+    copy->opcode = msg.opcode;
+    copy->droppable = msg.droppable;
+    if (msg.data_ref) {
+        copy->data.assign(msg.data_ref, msg.data_len);
+    } else if (msg.bytes_ref) {
+        copy->data = *msg.bytes_ref;
+    } else {
+        copy->data = msg.data;
+    }
+    return copy;
+}
+
 }
 }
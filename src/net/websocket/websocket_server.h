@@ -3,8 +3,11 @@
 #pragma once
 #include <functional>
 #include <memory>
+#include <vector>
+#include <unordered_map>
 #include "net/event_loop.h"
 #include "net/socket_server.h"
+#include "net/io_loop_group.h"
 #include "websocket_protocol.h"
 #include "net/ssl_context.h"
 
@@ -16,7 +19,9 @@ enum WebSocketSessionEventType {
     WEBSOCKET_SESSION_EVENT_ON_OPEN,
     WEBSOCKET_SESSION_EVENT_ON_MESSAGE,
     WEBSOCKET_SESSION_EVENT_ON_ERROR,
-    WEBSOCKET_SESSION_EVENT_ON_CLOSE
+    WEBSOCKET_SESSION_EVENT_ON_CLOSE,
+    WEBSOCKET_SESSION_EVENT_ON_HIGHWATER, ///< Pending output reached the high watermark
+    WEBSOCKET_SESSION_EVENT_ON_DRAIN ///< Pending output fell back to the low watermark
 };
 
 struct WebSocketSessionEvent {
@@ -24,6 +29,7 @@ struct WebSocketSessionEvent {
     int64_t guid{ 0 };
     const WebSocketMessage* msg{ nullptr };
     int err{ 0 };
+    const std::string* addr{ nullptr }; ///< Peer address, only set for sessions served on io loops
 };
 typedef std::function<void(const WebSocketSessionEvent& evt)> WebSocketSessionCallback;
 
@@ -43,13 +49,47 @@ class WebSocketServer :
     bool Send(int64_t channel_guid, const WebSocketMessage& msg);
 
     void Broadcast(const WebSocketMessage& msg);
+
+    void CollectHandshakeStats(SSLHandshakeStats* stats) override;
+    //Sessions open, those served by the shards included
+    size_t get_session_size() const { return io_loops_ ? session_shards_.size() : channel_size(); }
+    //Peer ip of an open session, empty if there is none
+    std::string GetPeerIp(int64_t session_guid);
+
+    void Export(std::vector<net::HandoffSocket>* socks) override;
+
+    void Detach() override;
   private:
     void Update();
+    int StartShards(net::ServerOptions& opts);
+    void StopShards();
+  private:
+    struct ShardEvent {
+        server::WebSocketSessionEventType type{ server::WEBSOCKET_SESSION_EVENT_NONE };
+        int64_t guid{ 0 };
+        int err{ 0 };
+        std::string addr; ///< Only read for the open event
+        WebSocketMessage msg;
+    };
+    //Session served by a shard, as seen by the app loop
+    struct ShardSession {
+        size_t shard{ 0 };
+        std::string addr;
+    };
+    typedef std::shared_ptr<ShardEvent> ShardEventPtr;
+    typedef std::shared_ptr<WebSocketMessage> WebSocketMessagePtr;
+    //Runs on the io loop of the shard
+    void PostShardEvent(size_t shard, const server::WebSocketSessionEvent& evt);
+    //Runs on the app loop
+    void HandleShardEvent(size_t shard, ShardEventPtr evt);
+    static WebSocketMessagePtr CopyMessage(const WebSocketMessage& msg);
   private:
     void websocket_session_onopen(int64_t session_guid);
     void websocket_session_onclose(int64_t session_guid);
     void websocket_session_onmessage(int64_t session_guid, const WebSocketMessage* msg);
     void websocket_session_onerror(int64_t session_guid, int err);
+    void websocket_session_onhighwater(int64_t session_guid);
+    void websocket_session_ondrain(int64_t session_guid);
   public:
     void set_websocket_session_callback(const server::WebSocketSessionCallback& cb) { websocket_session_callback_ = cb; }
 
@@ -66,6 +106,11 @@ class WebSocketServer :
   private:
     server::WebSocketSessionCallback websocket_session_callback_{ nullptr };
     int64_t update_timer_{ 0 };
+    //Multi-reactor mode: every shard is a server running on its own io loop
+    std::unique_ptr<net::IoLoopGroup> io_loops_;
+    std::vector<std::unique_ptr<WebSocketServer>> shards_;
+    std::unordered_map<int64_t, ShardSession> session_shards_;
+    std::shared_ptr<WebSocketServer*> self_; ///< Tasks posted by the shards hold a weak reference
 };
 }
 }
@@ -73,8 +73,8 @@ void RaftLogManager::AppendEntries(const std::vector<LogEntryPtr>& entries) {
     log_->append(entries);
 }
 
-bool RaftLogManager::InstallSapshot(uint64_t index, uint64_t term, uint32_t offset, const std::string& data, bool done) {
-    bool result = snapshot_->Install(index, term, offset, data, done);
+bool RaftLogManager::InstallSapshot(uint64_t index, uint64_t term, uint32_t offset, const char* data, size_t len, bool done) {
+    bool result = snapshot_->Install(index, term, offset, data, len, done);
     if (done && result) {
         log_->reset(index + 1);
         LogRotate();
@@ -13,7 +13,7 @@ class RaftLogManager {
     int Init(const std::string& data_dir);
     void AppendEntries(const std::vector<LogEntryPtr>& entries);
     void EraseEntries(uint64_t first, uint64_t last);
-    bool InstallSapshot(uint64_t index, uint64_t term, uint32_t offset, const std::string& data, bool done);
+    bool InstallSapshot(uint64_t index, uint64_t term, uint32_t offset, const char* data, size_t len, bool done);
     void SaveSnapshot(uint64_t index, uint64_t term, IOBuffer& buffer);
   public:
     uint64_t get_start_index();
@@ -6,6 +6,7 @@
 #include "util/string_utils.h"
 #include "logging/logging.h"
 #include "rpc/rpc_helper.h"
+#include "rpc/rpc_controller.h"
 #include "base/error_code.h"
 #include <functional>
 #include <algorithm>
@@ -26,6 +27,8 @@ static const int kCompactEntriesCount = 100000;
 
 static const size_t kInstallSnapshotFrameSize = 8 * 1024 * 1024;
 
+static const size_t kInstallSnapshotChunkSize = 1024 * 1024;
+
 static const char* STATE_NAMES[] = {
     "Unknown",
     "Leader",
@@ -101,6 +104,9 @@ int RaftNode::Init(const NodeConfig &config) {
     for (size_t i = 0; i < config_.peers.size(); ++i) {
         peers_[i] = std::make_shared<RaftPeer>(event_loop_, static_cast<int>(i));
         peers_[i]->Init(config_.peers[i]);
+        peers_[i]->set_compress_threshold((size_t)config_.compressThreshold);
+        //A vote or an append older than an election timeout is of no use to anybody
+        peers_[i]->set_call_timeout(config_.electionTimeout);
     }
 
     if ((err = log_manager_->Init(config_.dataDir))) {
@@ -297,6 +303,8 @@ void RaftNode::SendInstallSanpshot(int peerId) {
     if (peerId == config_.id) return;
     auto snap_file = log_manager_->get_snapshot()->get_snapshot_file();
     if (!snap_file) return;
+    //The response of the stream in flight sends the next one
+    if (snap_streams_[peerId]) return;
 
     if (snap_index_[peerId] != log_manager_->get_snapshot()->get_last_index()) {
         snap_index_[peerId] = log_manager_->get_snapshot()->get_last_index();
@@ -311,18 +319,51 @@ void RaftNode::SendInstallSanpshot(int peerId) {
     msg.set_leaderid(get_id());
     msg.set_lastincludedindex(log_manager_->get_snapshot()->get_last_index());
     msg.set_lastincludedterm(log_manager_->get_snapshot()->get_last_term());
+    auto callback = std::bind(&RaftNode::InstallSnapshotResponse, this, peerId,
+                              std::placeholders::_1, std::placeholders::_2);
+    if (!snap_chunked_[peerId]) {
+        //The whole file follows the request, as fast as the follower writes it
+        snap_offset_[peerId] = 0;
+        msg.set_offset(0);
+        msg.set_done(false);
+        auto stream = std::make_shared<rpc::RpcStream>();
+        stream->set_writable_callback(std::bind(&RaftNode::WriteSnapshotStream, this, peerId));
+        snap_streams_[peerId] = stream;
+        peer->InstallSnapshot(msg, std::move(stream), std::move(callback));
+        WriteSnapshotStream(peerId);
+        TRACE_LOG("Stream install snapshot to peer %d", peerId);
+        return;
+    }
     const char* data = snap_file->data() + snap_offset_[peerId];
     size_t len = (std::min)(snap_file->length() - snap_offset_[peerId], kInstallSnapshotFrameSize);
     msg.set_offset(static_cast<uint32_t>(snap_offset_[peerId]));
     msg.set_data(data, len);
     snap_offset_[peerId] += len;
     msg.set_done(snap_offset_[peerId] >= snap_file->length());
-    auto callback = std::bind(&RaftNode::InstallSnapshotResponse, this, peerId,
-                              std::placeholders::_1, std::placeholders::_2);
     peer->InstallSnapshot(msg, std::move(callback));
     TRACE_LOG("Send install snapshot to peer %d", peerId);
 }
 
+void RaftNode::WriteSnapshotStream(int peerId) {
+    auto& stream = snap_streams_[peerId];
+    if (!stream) return;
+    auto snapshot = log_manager_->get_snapshot();
+    auto snap_file = snapshot->get_snapshot_file();
+    if (!snap_file || snap_index_[peerId] != snapshot->get_last_index()) {
+        //Replaced by a newer snapshot, the follower drops the partial one and the response sends the new one
+        stream->Reset(ERROR_RPC_REQUESTCANCELED);
+        return;
+    }
+    while (snap_offset_[peerId] < snap_file->length() && stream->is_writable()) {
+        size_t len = (std::min)(snap_file->length() - snap_offset_[peerId], kInstallSnapshotChunkSize);
+        stream->Write(snap_file->data() + snap_offset_[peerId], len);
+        snap_offset_[peerId] += len;
+    }
+    if (snap_offset_[peerId] >= snap_file->length()) {
+        stream->Close();
+    }
+}
+
 void RaftNode::SetLeader(int id) {
     if (leader_id_ == id) return;
     leader_id_ = id;
@@ -338,11 +379,18 @@ void RaftNode::InitLeaderState() {
     match_index_.resize(config_.peers.size());
     snap_offset_.resize(config_.peers.size());
     snap_index_.resize(config_.peers.size());
+    snap_streams_.resize(config_.peers.size());
+    snap_chunked_.resize(config_.peers.size());
     for (size_t i = 0; i < config_.peers.size(); ++i) {
         match_index_[i] = 0;
         next_index_[i] = log_manager_->get_next_index();
         snap_offset_[i] = 0;
         snap_index_[i] = 0;
+        if (snap_streams_[i]) {
+            snap_streams_[i]->Reset(ERROR_RPC_REQUESTCANCELED);
+            snap_streams_[i].reset();
+        }
+        snap_chunked_[i] = false;
     }
 }
 
@@ -585,18 +633,62 @@ void RaftNode::InstallSnapshot(::google::protobuf::RpcController* controller, co
         response->set_term(log_manager_->get_current_term());
         return;
     }
+    if (static_cast<rpc::RpcController*>(controller)->get_stream()) {
+        done_guard.callback = nullptr;
+        ReceiveSnapshotStream(controller, request, response, done);
+        return;
+    }
     bool result = log_manager_->InstallSapshot(request->lastincludedindex(), request->lastincludedterm(),
-                  request->offset(), request->data(), request->done());
-    if (done && result) {
+                  request->offset(), request->data().data(), request->data().size(), request->done());
+    if (request->done() && result) {
         Recover();
     }
     response->set_term(log_manager_->get_current_term());
 }
 
+void RaftNode::ReceiveSnapshotStream(::google::protobuf::RpcController* controller, const ::tinynet::raft::InstallSnapshotReq* request,
+                                     ::tinynet::raft::InstallSnapshotResp* response, ::google::protobuf::Closure* done) {
+    auto stream = static_cast<rpc::RpcController*>(controller)->AcceptStream();
+    uint64_t index = request->lastincludedindex();
+    uint64_t term = request->lastincludedterm();
+    //Shared by both callbacks, the stream keeps them until the call is done
+    auto offset = std::make_shared<uint32_t>(0);
+    auto result = std::make_shared<bool>(true);
+    stream->set_message_callback([this, index, term, offset, result](const char* data, size_t len) {
+        if (!*result) return;
+        *result = log_manager_->InstallSapshot(index, term, *offset, data, len, false);
+        *offset += static_cast<uint32_t>(len);
+    });
+    rpc::RpcStream* s = stream.get();
+    stream->set_close_callback([this, s, index, term, offset, result, response, done](int err) {
+        rpc::ClosureGuard done_guard(done);
+        if (err == ERROR_OK) {
+            s->Close();
+            if (*result && log_manager_->InstallSapshot(index, term, *offset, nullptr, 0, true)) {
+                Recover();
+            }
+        }
+        response->set_term(log_manager_->get_current_term());
+    });
+}
+
 void RaftNode::InstallSnapshotResponse(int peerId, int error_code, const ::tinynet::raft::InstallSnapshotResp *response) {
+    if (peerId < (int)snap_streams_.size() && snap_streams_[peerId]) {
+        auto stream = std::move(snap_streams_[peerId]);
+        if (error_code != ERROR_OK) {
+            log_warning("Stream install snapshot to peer %d failed, err:%d, fall back to chunks", peerId, error_code);
+            snap_chunked_[peerId] = true;
+        }
+        if (error_code != ERROR_OK || stream->get_error() || !stream->is_closed()) {
+            //Started over from the first byte
+            snap_offset_[peerId] = 0;
+        }
+    }
     if (response->term() > log_manager_->get_current_term()) {
         ApplyTerm(response->term());
+        return;
     }
+    if (!is_leader()) return;
     SendInstallSanpshot(peerId);
 }
 
@@ -11,6 +11,7 @@
 #include "raft_snapshot.h"
 #include "raft.pb.h"
 #include "raft_log_manager.h"
+#include "rpc/rpc_stream.h"
 
 namespace tinynet {
 namespace raft {
@@ -59,6 +60,9 @@ class RaftNode {
     void SendAppendEntries();
     void SendAppendEntries(int peerId);
     void SendInstallSanpshot(int peerId);
+    void WriteSnapshotStream(int peerId);
+    void ReceiveSnapshotStream(::google::protobuf::RpcController* controller, const ::tinynet::raft::InstallSnapshotReq* request,
+                               ::tinynet::raft::InstallSnapshotResp* response, ::google::protobuf::Closure* done);
     void SetLeader(int id);
     void SetCurrentTime(int64_t current_time);
     void InitLeaderState();
@@ -105,6 +109,8 @@ class RaftNode {
     std::vector<uint64_t> match_index_;
     std::vector<size_t> snap_offset_;
     std::vector<uint64_t> snap_index_;
+    std::vector<rpc::RpcStreamPtr> snap_streams_; ///< Snapshot being streamed to the peer
+    std::vector<bool> snap_chunked_; ///< The peer failed a stream, snapshots go in chunks until the next term
     std::vector<RaftPeerPtr> peers_;
 
     NodeConfig config_;
@@ -22,17 +22,28 @@ RaftPeer::RaftPeer(EventLoop *loop, int peerId) :
 
 RaftPeer::~RaftPeer() = default;
 
+void RaftPeer::set_compress_threshold(size_t threshold) {
+    if (channel_) {
+        channel_->set_compress_threshold(threshold);
+    }
+}
+
 void RaftPeer::Init(const std::string& url) {
     if (!UriUtils::parse_address(url, &host_, &port_)) {
         log_fatal("Invalid address %s", url.c_str());
         return;
     }
-    channel_.reset(new (std::nothrow) rpc::RpcChannel(event_loop_));
+    channel_.reset(new (std::nothrow) rpc::RpcChannelPool(event_loop_));
     if (!channel_) {
         log_fatal("Create channel failed, out of memory");
         return;
     }
-    channel_->Init(host_, port_);
+    net::ChannelOptions opts;
+    opts.host = host_;
+    opts.port = port_;
+    //Votes and heartbeats never wait behind a snapshot
+    opts.bulk_methods.push_back(RaftRpcService::descriptor()->FindMethodByName("InstallSnapshot")->full_name());
+    channel_->Init(opts);
 
     stub_.reset(new (std::nothrow) RaftRpcService_Stub(channel_.get()));
     if (!stub_) {
@@ -54,6 +65,7 @@ void RaftPeer::HandleError(int err) {
 void RaftPeer::RequestVote(const VoteReq& req, RequestVoteCallback callback) {
     auto call = std::make_shared<RequestVoteCall>();
     call->request.CopyFrom(req);
+    if (call_timeout_ > 0) call->controller.SetTimeout(call_timeout_);
     stub_->RequestVote(&call->controller, &call->request, &call->response,
                        ::google::protobuf::NewCallback(this, &RaftPeer::OnRequestVoteResp, call, callback));
 }
@@ -61,6 +73,7 @@ void RaftPeer::RequestVote(const VoteReq& req, RequestVoteCallback callback) {
 void RaftPeer::AppendEntries(const AppendEntriesReq& req, AppendEntriesCallback callback) {
     auto call = std::make_shared<AppendEntriesCall>();
     call->request.CopyFrom(req);
+    if (call_timeout_ > 0) call->controller.SetTimeout(call_timeout_);
     stub_->AppendEntries(&call->controller, &call->request, &call->response,
                          ::google::protobuf::NewCallback(this, &RaftPeer::OnAppendEntriesResp, call, callback));
 }
@@ -68,6 +81,16 @@ void RaftPeer::AppendEntries(const AppendEntriesReq& req, AppendEntriesCallback
 void RaftPeer::InstallSnapshot(const InstallSnapshotReq& req, InstallSnapshotCallback callback) {
     auto call = std::make_shared<InstallSnapshotCall>();
     call->request.CopyFrom(req);
+    if (call_timeout_ > 0) call->controller.SetTimeout(call_timeout_);
+    stub_->InstallSnapshot(&call->controller, &call->request, &call->response,
+                           ::google::protobuf::NewCallback(this, &RaftPeer::OnInstallSnapshotResp, call, callback));
+}
+
+void RaftPeer::InstallSnapshot(const InstallSnapshotReq& req, rpc::RpcStreamPtr stream, InstallSnapshotCallback callback) {
+    auto call = std::make_shared<InstallSnapshotCall>();
+    call->request.CopyFrom(req);
+    //No deadline, the call lasts as long as the whole snapshot takes to flow on the stream
+    call->controller.set_stream(std::move(stream));
     stub_->InstallSnapshot(&call->controller, &call->request, &call->response,
                            ::google::protobuf::NewCallback(this, &RaftPeer::OnInstallSnapshotResp, call, callback));
 }
@@ -1,7 +1,7 @@
 // Copyright (C), Xianfeng Shang.  All rights reserved.
 // Author: Xianfeng Shang (shangxianfeng@outlook.com)
 #pragma once
-#include "rpc/rpc_channel.h"
+#include "rpc/rpc_channel_pool.h"
 #include "rpc/rpc_controller.h"
 #include "net/event_loop.h"
 #include "raft.pb.h"
@@ -22,6 +22,10 @@ class RaftPeer :
 
     void Init(const std::string& url);
     void Close();
+    //Snapshots and log entries of at least threshold bytes are sent compressed
+    void set_compress_threshold(size_t threshold);
+    //Votes, log entries and snapshot chunks are given up after timeout_ms, the peer drops them once late, 0 waits
+    void set_call_timeout(int timeout_ms) { call_timeout_ = timeout_ms; }
   public:
 
     typedef std::function<void(int err, const VoteResp *)> RequestVoteCallback;
@@ -34,6 +38,8 @@ class RaftPeer :
 
     typedef std::function<void(int err, const InstallSnapshotResp *)> InstallSnapshotCallback;
     void InstallSnapshot(const InstallSnapshotReq& req, InstallSnapshotCallback callback);
+    //The snapshot follows the request on stream instead of the data field
+    void InstallSnapshot(const InstallSnapshotReq& req, rpc::RpcStreamPtr stream, InstallSnapshotCallback callback);
   public:
 
     int get_id() const { return id_; }
@@ -67,7 +73,7 @@ class RaftPeer :
                                InstallSnapshotCallback callback);
   private:
     using StubPtr = std::unique_ptr<RaftRpcService_Stub>;
-    using ChannelPtr = std::unique_ptr<rpc::RpcChannel>;
+    using ChannelPtr = std::unique_ptr<rpc::RpcChannelPool>;
   private:
     int					id_;
     EventLoop*			event_loop_;
@@ -75,6 +81,7 @@ class RaftPeer :
     StubPtr				stub_;
     std::string			host_;
     int					port_;
+    int					call_timeout_{ 0 };
 };
 }
 }
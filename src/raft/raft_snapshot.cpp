@@ -146,7 +146,7 @@ bool RaftSnapshot::Save(uint64_t index, uint64_t term, IOBuffer& data) {
     return true;
 }
 
-bool RaftSnapshot::Install(uint64_t index, uint64_t term, uint32_t offset, const std::string& data, bool done) {
+bool RaftSnapshot::Install(uint64_t index, uint64_t term, uint32_t offset, const char* data, size_t len, bool done) {
     if (offset == 0) {
         std::string filename, staging_path;
         StringUtils::Format(filename, SNAP_NAME_FORMAT, index, term);
@@ -155,8 +155,10 @@ bool RaftSnapshot::Install(uint64_t index, uint64_t term, uint32_t offset, const
     }
     if (!install_file_) return false;
 
-    install_file_->Seek(offset);
-    install_file_->Write(&data[0], data.length());
+    if (len) {
+        install_file_->Seek(offset);
+        install_file_->Write(data, len);
+    }
     if (done) {
         std::string filename, staging_path, bin_path;
         StringUtils::Format(filename, SNAP_NAME_FORMAT, index, term);
@@ -19,7 +19,7 @@ class RaftSnapshot {
   public:
     int Init(const std::string& data_dir);
     bool Save(uint64_t index, uint64_t term, IOBuffer& data);
-    bool Install(uint64_t index, uint64_t term, uint32_t offset, const std::string& data, bool done);
+    bool Install(uint64_t index, uint64_t term, uint32_t offset, const char* data, size_t len, bool done);
   public:
   public:
     uint64_t get_last_index() const { return last_index_; }
@@ -34,6 +34,7 @@ struct NodeConfig {
     int snapshotCount{ 0 };
     int heartbeatInterval{ 0 };
     int electionTimeout{ 0 };
+    int compressThreshold{ 0 }; ///< RPC payloads of at least this many bytes are compressed, 0 disables it
     std::vector<std::string> peers;
 };
 
@@ -72,6 +73,7 @@ inline tinynet::json::Value& operator << (tinynet::json::Value& json_value, cons
     JSON_WRITE_FIELD(snapshotCount);
     JSON_WRITE_FIELD(heartbeatInterval);
     JSON_WRITE_FIELD(electionTimeout);
+    JSON_WRITE_FIELD(compressThreshold);
     JSON_WRITE_FIELD(peers);
     return json_value;
 }
@@ -0,0 +1,124 @@
+// Copyright (C), Xianfeng Shang.  All rights reserved.
+// Author: Xianfeng Shang (shangxianfeng@outlook.com)
+#include "rpc_call_map.h"
+#include <new>
+
+namespace tinynet {
+namespace rpc {
+
+static const size_t kInitialBuckets = 16;
+
+RpcCallMap::RpcCallMap() :
+    buckets_(kInitialBuckets, nullptr) {
+}
+
+RpcCallMap::~RpcCallMap() {
+    RpcInfo* rpc = RemoveAll();
+    while (rpc) {
+        RpcInfo* next = rpc->next_;
+        delete rpc;
+        rpc = next;
+    }
+    while (free_list_) {
+        RpcInfo* next = free_list_->next_;
+        delete free_list_;
+        free_list_ = next;
+    }
+}
+
+RpcInfo* RpcCallMap::Insert(uint64_t seq, google::protobuf::RpcController *controller, const google::protobuf::Message *request,
+                            google::protobuf::Message *response, google::protobuf::Closure *done) {
+    RpcInfo* rpc = free_list_;
+    if (rpc) {
+        free_list_ = rpc->next_;
+        --free_size_;
+    } else {
+        rpc = new(std::nothrow) RpcInfo();
+        if (!rpc) return nullptr;
+    }
+    rpc->seq_ = seq;
+    rpc->controller_ = controller;
+    rpc->request_ = request;
+    rpc->response_ = response;
+    rpc->done_ = done;
+    if (size_ >= buckets_.size()) {
+        Rehash(buckets_.size() * 2);
+    }
+    RpcInfo*& head = buckets_[seq & (buckets_.size() - 1)];
+    rpc->next_ = head;
+    head = rpc;
+    ++size_;
+    return rpc;
+}
+
+RpcInfo* RpcCallMap::Find(uint64_t seq) {
+    RpcInfo* rpc = buckets_[seq & (buckets_.size() - 1)];
+    while (rpc && rpc->seq_ != seq) {
+        rpc = rpc->next_;
+    }
+    return rpc;
+}
+
+RpcInfo* RpcCallMap::Remove(uint64_t seq) {
+    RpcInfo** link = &buckets_[seq & (buckets_.size() - 1)];
+    while (*link && (*link)->seq_ != seq) {
+        link = &(*link)->next_;
+    }
+    RpcInfo* rpc = *link;
+    if (rpc) {
+        *link = rpc->next_;
+        rpc->next_ = nullptr;
+        --size_;
+    }
+    return rpc;
+}
+
+RpcInfo* RpcCallMap::RemoveAll() {
+    RpcInfo* list = nullptr;
+    for (auto& head : buckets_) {
+        while (head) {
+            RpcInfo* rpc = head;
+            head = rpc->next_;
+            rpc->next_ = list;
+            list = rpc;
+        }
+    }
+    size_ = 0;
+    return list;
+}
+
+void RpcCallMap::Release(RpcInfo* rpc) {
+    if (free_size_ >= MAX_FREE_SIZE) {
+        delete rpc;
+        return;
+    }
+    //The done closure ran already or is deleted here, like a completed RpcInfo would
+    if (rpc->done_) {
+        delete rpc->done_;
+    }
+    rpc->controller_ = nullptr;
+    rpc->request_ = nullptr;
+    rpc->response_ = nullptr;
+    rpc->done_ = nullptr;
+    rpc->timer_id_ = INVALID_TIMER_ID;
+    rpc->metrics_ = nullptr;
+    rpc->next_ = free_list_;
+    free_list_ = rpc;
+    ++free_size_;
+}
+
+void RpcCallMap::Rehash(size_t nbuckets) {
+    std::vector<RpcInfo*> buckets(nbuckets, nullptr);
+    for (auto head : buckets_) {
+        while (head) {
+            RpcInfo* rpc = head;
+            head = rpc->next_;
+            RpcInfo*& slot = buckets[rpc->seq_ & (nbuckets - 1)];
+            rpc->next_ = slot;
+            slot = rpc;
+        }
+    }
+    buckets_.swap(buckets);
+}
+}
+}
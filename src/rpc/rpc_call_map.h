@@ -0,0 +1,76 @@
+// Copyright (C), Xianfeng Shang.  All rights reserved.
+// Author: Xianfeng Shang (shangxianfeng@outlook.com)
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "rpc_info.h"
+
+namespace tinynet {
+namespace rpc {
+
+//Client calls of a channel waiting for their responses, keyed by sequence.
+//The records are recycled through a free list and chained in place,
+//so a call allocates nothing once the map has grown to the number of calls in flight.
+class RpcCallMap {
+  public:
+    static const size_t MAX_FREE_SIZE = 1024;
+  public:
+    RpcCallMap();
+    ~RpcCallMap();
+  private:
+    RpcCallMap(const RpcCallMap&) = delete;
+    RpcCallMap& operator=(const RpcCallMap&) = delete;
+  public:
+    /**
+     * @brief Inserts a call with a recycled record
+     *
+     * @param seq
+     * @param controller
+     * @param request
+     * @param response
+     * @param done
+     * @return RpcInfo*
+     */
+    RpcInfo* Insert(uint64_t seq, google::protobuf::RpcController *controller, const google::protobuf::Message *request,
+                    google::protobuf::Message *response, google::protobuf::Closure *done);
+
+    RpcInfo* Find(uint64_t seq);
+    /**
+     * @brief Unlinks the call, the record goes back with Release() once the call completed
+     *
+     * @param seq
+     * @return RpcInfo*
+     */
+    RpcInfo* Remove(uint64_t seq);
+    /**
+     * @brief Unlinks all calls, returns them chained through RpcInfo::get_next()
+     *
+     * @return RpcInfo*
+     */
+    RpcInfo* RemoveAll();
+
+    void Release(RpcInfo* rpc);
+
+    template<typename Fn>
+    void ForEach(Fn fn) {
+        for (auto rpc : buckets_) {
+            for (; rpc; rpc = rpc->next_) {
+                fn(rpc);
+            }
+        }
+    }
+  public:
+    size_t size() const { return size_; }
+
+    bool empty() const { return size_ == 0; }
+  private:
+    void Rehash(size_t nbuckets);
+  private:
+    std::vector<RpcInfo*> buckets_; ///< Power of 2, the sequences in flight are consecutive and spread evenly
+    size_t size_{ 0 };
+    RpcInfo* free_list_{ nullptr };
+    size_t free_size_{ 0 };
+};
+}
+}
@@ -5,8 +5,14 @@
 #include "logging/logging.h"
 #include "base/unique_id.h"
 #include "base/error_code.h"
+#include "base/clock.h"
 #include "util/uri_utils.h"
 #include "net/stream_socket.h"
+#include "base/coding.h"
+#include "rpc_helper.h"
+#include <cstring>
+#include <algorithm>
+#include <vector>
 
 namespace tinynet {
 namespace rpc {
@@ -25,7 +31,16 @@ RpcChannel::RpcChannel(EventLoop *loop) :
     codec_(new (std::nothrow)RpcCodec()) {
 }
 
-RpcChannel::~RpcChannel() = default;
+RpcChannel::~RpcChannel() {
+    event_loop_->CancelTask(reopen_task_);
+    rpc_map_.ForEach([this](RpcInfo * rpc) {
+        event_loop_->ClearTimer(rpc->get_timer_id());
+        rpc->Detach();
+    });
+    for (auto& it : streams_) {
+        it.second->Detach(ERROR_RPC_CHANNELERROR);
+    }
+}
 
 void RpcChannel::Init(const std::string &ip, int port) {
     net::ChannelOptions opts;
@@ -36,34 +51,118 @@ void RpcChannel::Init(const std::string &ip, int port) {
 
 void RpcChannel::Init(net::ChannelOptions& opts) {
     opts.timeout = opts.timeout ? opts.timeout : kRpcChannelTimeout;
+    //The endpoint may run a newer server by now
+    negotiate_refused_ = false;
     if (opts.name.empty()) opts_.name = "RPC";
     SocketChannel::Init(opts);
 }
 
 void RpcChannel::Reset() {
-    PACKET_QUEUE empty;
-    packet_queue_.swap(empty);
+    pending_.clear();
+    if (reopen_task_ != INVALID_TASK_ID) {
+        //The calls held for a replay are not coming back
+        event_loop_->CancelTask(reopen_task_);
+        Run(ERROR_RPC_CHANNELERROR);
+    }
     Close(0);
 }
 
 void RpcChannel::CallMethod(const google::protobuf::MethodDescriptor* method, google::protobuf::RpcController* controller,
                             const google::protobuf::Message* request, google::protobuf::Message* response, google::protobuf::Closure* done) {
-    ++seq_;
-    rpc_map_[seq_] = std::make_shared<RpcInfo>(seq_, controller, request, response, done);
-    SendRequest(seq_, method->full_name(), request);
+    uint64_t seq = ++seq_;
+    auto rpc = rpc_map_.Insert(seq, controller, request, response, done);
+    if (!rpc) {
+        ClosureGuard guard(done);
+        if (controller) static_cast<RpcController*>(controller)->SetFailed(ERROR_OS_OOM);
+        return;
+    }
+    //Lives as long as the process, the call may be completed and released while it is sent
+    RpcMethodMetrics* metrics = RpcMetrics::Instance()->GetClientMetrics(method);
+    rpc->Begin(metrics);
+    auto c = static_cast<RpcController*>(controller);
+    int64_t remaining = -1;
+    if (c) {
+        //Both lambdas fit into the small buffer of std::function, nothing is allocated for them
+        remaining = c->get_remaining_ms();
+        if (remaining >= 0) {
+            rpc->set_timer_id(event_loop_->AddTimer(remaining, 0, [this, seq] { Timeout(seq); }));
+        }
+        c->set_cancel_callback([this, seq] { Abort(seq, ERROR_RPC_REQUESTCANCELED); });
+    }
+    //A reference of our own, the controller may be gone once the request is sent
+    RpcStreamPtr stream = c ? c->get_stream() : nullptr;
+    if (stream) {
+        stream->Attach(this, seq);
+        streams_[seq] = stream;
+        if (get_state() == net::ChannelState::CS_CONNECTED && !negotiating_ && !CanStream()) {
+            //Held requests are checked by Flush() once the server answered
+            RefuseStream(seq);
+            return;
+        }
+    }
+    if (remaining == 0) {
+        //Expired before it was sent, the timer fails it
+        return;
+    }
+    //A write failing right away completes the call inside, rpc, controller and request must not be used after
+    SendRequest(seq, RpcMethod::GetMethodId(method), request, remaining > 0 ? c->get_deadline() : 0,
+                stream ? PACKET_FLAG_STREAM : 0);
+    metrics->AddRequestBytes(codec_->get_write_size());
+    if (stream) {
+        //Follows the request, the service has not seen the stream before. Detached if the send failed.
+        stream->Open(0);
+    }
 }
 
 void RpcChannel::OnOpen() {
     log_info("[RPC] RPC channel(%lld, %s) opened", guid_, address_.c_str());
+    //Payloads go uncompressed and without deadline until the server answers
+    codec_->set_compress_threshold(0);
+    peer_deadline_ = false;
+    peer_features_ = 0;
+    if (!negotiate_refused_) {
+        //The requests wait for the answer, a server predating the negotiation closes the connection instead
+        negotiating_ = true;
+        uint32_t flags = (compress_threshold_ ? PACKET_FLAG_COMPRESSED : 0) | PACKET_FLAG_TIMEOUT;
+        codec_->WriteNegotiate(socket_, PacketType::REQUEST, flags, PACKET_FEATURES_NEGOTIATED);
+        return;
+    }
     Flush();
 }
 
 void RpcChannel::OnError(int err) {
     log_info("[RPC] RPC channel(%lld, %s) closed, err:%d, msg:%s",
              guid_, address_.c_str(), err, tinynet_strerror(err));
+    if (negotiating_) {
+        negotiating_ = false;
+        //What a server closing on the unknown method looks like, nothing was sent to it but the negotiation
+        if (err == ERROR_SOCKET_READ_EOF) {
+            negotiate_refused_ = true;
+            log_warning("[RPC] RPC channel(%lld, %s) closed while negotiating, requests go without compression nor deadline",
+                        guid_, address_.c_str());
+            //The held requests go again on a new connection, once this one is closed
+            if (rpc_map_.size() > 0 && reopen_task_ == INVALID_TASK_ID) {
+                reopen_task_ = event_loop_->AddTask(std::bind(&RpcChannel::Reopen, this));
+            }
+            return;
+        }
+    }
+    pending_.clear();
     Run(err);
 }
 
+void RpcChannel::Reopen() {
+    reopen_task_ = INVALID_TASK_ID;
+    if (get_state() != net::ChannelState::CS_CLOSED || rpc_map_.size() == 0) {
+        //Reopened by a call meanwhile, or nothing left to send
+        return;
+    }
+    int err = Open();
+    if (err != ERROR_OK) {
+        Run(err);
+    }
+}
+
 void RpcChannel::OnRead() {
     PacketHeader* header;
     while (socket_->is_connected() && (header = codec_->Read(socket_)) != nullptr) {
@@ -71,7 +170,32 @@ void RpcChannel::OnRead() {
     }
 }
 
+void RpcChannel::OnNegotiate(PacketHeader* header) {
+    peer_features_ = codec_->ReadNegotiate(socket_, header->len) & PACKET_FEATURES_NEGOTIATED;
+    bool compress = compress_threshold_ && (header->flags & PACKET_FLAG_COMPRESSED);
+    codec_->set_compress_threshold(compress ? compress_threshold_ : 0);
+    peer_deadline_ = (header->flags & PACKET_FLAG_TIMEOUT) != 0;
+    if (header->type == (uint32_t)PacketType::REQUEST) {
+        //Compressed payloads and deadlines are always accepted
+        codec_->WriteNegotiate(socket_, PacketType::RESPONSE, PACKET_FLAG_COMPRESSED | PACKET_FLAG_TIMEOUT,
+                               PACKET_FEATURES_NEGOTIATED);
+        return;
+    }
+    negotiating_ = false;
+    log_info("[RPC] RPC channel(%lld, %s) negotiated, compression:%s, deadline:%s, features:%x",
+             guid_, address_.c_str(), compress ? "on" : "off", peer_deadline_ ? "on" : "off", peer_features_);
+    Flush();
+}
+
 void RpcChannel::OnPacket(PacketHeader* header) {
+    if (header->type >= (uint32_t)PacketType::STREAM_DATA) {
+        OnStreamPacket(header);
+        return;
+    }
+    if (header->seq == 0 && header->method == RPC_METHOD_NEGOTIATE) {
+        OnNegotiate(header);
+        return;
+    }
     if (header->type == (uint32_t)PacketType::REQUEST) {
         auto server = get_server<RpcServer>();
         if (!server) {
@@ -80,48 +204,158 @@ void RpcChannel::OnPacket(PacketHeader* header) {
         }
         auto method = server->GetMethod(header->method);
         if (!method) {
-            Close(ERROR_RPC_METHODNOTFOUND);
+            log_warning("[RPC] RPC channel(%lld, %s) call %llu of unknown method %llx",
+                        guid_, address_.c_str(), header->seq, header->method);
+            //Tells a client probing for a method, e.g. TdcService.TransferBatch, that it is missing
+            codec_->Skip(socket_, header->len);
+            ReplyError(header->seq, ERROR_RPC_METHODNOTFOUND);
+            return;
+        }
+        if ((header->flags & PACKET_FLAG_STREAM) && method->get_worker_pool()) {
+            //Streams belong to the loop, a method run by the workers takes none. Its stream packets are dropped.
+            codec_->Skip(socket_, header->len);
+            ReplyError(header->seq, ERROR_RPC_STREAMREFUSED);
             return;
         }
+        int64_t deadline = 0;
+        if (header->flags & PACKET_FLAG_TIMEOUT) {
+            //Counted from the start of the loop iteration which read the request
+            deadline = event_loop_->Time() + header->timeout;
+            if (STime_ms() >= deadline) {
+                //The caller has given up already, do not waste time on it
+                codec_->Skip(socket_, header->len);
+                return;
+            }
+        }
         std::unique_ptr<google::protobuf::Message> request(method->NewRequest());
         if (!codec_->Read(socket_, request.get(), header->len)) {
             Close(ERROR_RPC_DECODEERROR);
             return;
         }
         auto rpc = std::make_shared<RpcInfo>(header->seq, request.release(), method->NewResponse());
+        rpc->Begin(method->get_metrics());
+        method->get_metrics()->AddRequestBytes(codec_->get_read_size());
+        if (deadline) {
+            static_cast<RpcController*>(rpc->get_controller())->SetDeadline(deadline);
+        }
+        if (header->flags & PACKET_FLAG_STREAM) {
+            auto stream = std::make_shared<RpcStream>();
+            if (!streams_.emplace(header->seq, stream).second) {
+                Close(ERROR_RPC_SEQUENCEERROR);
+                return;
+            }
+            stream->Attach(this, header->seq);
+            static_cast<RpcController*>(rpc->get_controller())->set_stream(std::move(stream));
+        }
 
+        auto done = ::google::protobuf::NewCallback(server, &RpcServer::SendResponse, guid_, rpc);
+        if (method->get_worker_pool()) {
+            RunOnWorker(method, rpc, done);
+            return;
+        }
         method->get_service()->CallMethod(method->get_descriptor(),
                                           rpc->get_controller(),
                                           rpc->get_request(),
                                           rpc->get_response(),
-                                          ::google::protobuf::NewCallback(server, &RpcServer::SendResponse, guid_, rpc));
+                                          done);
         return;
     }
     auto call = PopRpc(header->seq);
     if (!call) {
-        Close(ERROR_RPC_SEQUENCEERROR);
+        if (header->seq == 0 || header->seq > seq_) {
+            Close(ERROR_RPC_SEQUENCEERROR);
+            return;
+        }
+        //Timed out or canceled
+        codec_->Skip(socket_, header->len);
+        return;
+    }
+    if (header->flags & PACKET_FLAG_ERROR) {
+        codec_->Skip(socket_, header->len);
+        int err = (int)(int64_t)header->method;
+        auto it = streams_.find(header->seq);
+        if (it != streams_.end()) {
+            //The server never took it
+            auto stream = std::move(it->second);
+            streams_.erase(it);
+            stream->OnReset(err);
+        }
+        call->Run(err);
+        rpc_map_.Release(call);
         return;
     }
     auto response = call->get_response();
     if (!codec_->Read(socket_, response, header->len)) {
+        call->Run(ERROR_RPC_DECODEERROR);
+        rpc_map_.Release(call);
         Close(ERROR_RPC_DECODEERROR);
         return;
     }
+    call->get_metrics()->AddResponseBytes(codec_->get_read_size());
     call->Run(ERROR_OK);
+    rpc_map_.Release(call);
+}
+
+void RpcChannel::OnStreamPacket(PacketHeader* header) {
+    auto it = streams_.find(header->seq);
+    if (it == streams_.end()) {
+        //Reset or done on this side already
+        codec_->Skip(socket_, header->len);
+        return;
+    }
+    //The callbacks may remove it from the map
+    auto stream = it->second;
+    switch ((PacketType)header->type) {
+    case PacketType::STREAM_DATA: {
+        size_t size = 0;
+        const char* data = codec_->Peek(socket_, header->len, &size);
+        if (!data) {
+            Close(ERROR_RPC_DECODEERROR);
+            return;
+        }
+        stream->OnData(data, size);
+        codec_->Skip(socket_, header->len);
+        break;
+    }
+    case PacketType::STREAM_CREDIT: {
+        codec_->Skip(socket_, header->len);
+        stream->OnCredit(header->method);
+        break;
+    }
+    case PacketType::STREAM_CLOSE: {
+        codec_->Skip(socket_, header->len);
+        stream->OnClose();
+        break;
+    }
+    default: {
+        codec_->Skip(socket_, header->len);
+        streams_.erase(it);
+        stream->OnReset((int)(int64_t)header->method);
+        break;
+    }
+    }
 }
 
-bool RpcChannel::SendRequest(int64_t seq, const std::string& method, const google::protobuf::Message* request) {
+bool RpcChannel::SendRequest(int64_t seq, uint64_t method, const google::protobuf::Message* request, int64_t deadline,
+                             uint32_t flags) {
+    codec_->set_write_size(0);
     switch (get_state()) {
-    case net::ChannelState::CS_CLOSED: //Reset => BeginConnect => Enqueue
-        Reset();
+    case net::ChannelState::CS_CLOSED: //BeginConnect => Enqueue, after the requests held for a replay
     case net::ChannelState::CS_UNSPEC: //BeginConnect => Enqueue
         Open();
     case net::ChannelState::CS_CONNECTING: {
-        packet_queue_.emplace(std::move(std::make_shared<RpcPacket>(seq, request, StringUtils::Hash3(method.c_str()))));
+        //Until Flush() knows the time left the timeout field keeps the low bits of the deadline, never 0
+        codec_->Write(&pending_, PacketType::REQUEST, seq, method, request, deadline ? (uint32_t)deadline | 1 : 0, flags);
         break;
     }
     case net::ChannelState::CS_CONNECTED: {
-        codec_->Write(socket_, PacketType::REQUEST, seq, StringUtils::Hash3(method.c_str()), request);
+        if (negotiating_) {
+            codec_->Write(&pending_, PacketType::REQUEST, seq, method, request, deadline ? (uint32_t)deadline | 1 : 0, flags);
+            break;
+        }
+        //The timer of the call still fires on this side when the server cannot be told
+        uint32_t timeout = deadline && peer_deadline_ ? (uint32_t)(std::max)(deadline - STime_ms(), (int64_t)1) : 0;
+        codec_->Write(socket_, PacketType::REQUEST, seq, method, request, timeout, flags);
         break;
     }
     default:
@@ -130,37 +364,227 @@ bool RpcChannel::SendRequest(int64_t seq, const std::string& method, const googl
     return true;
 }
 
-void RpcChannel::PushRpc(uint64_t seq, RpcInfoPtr rpc) {
-    rpc_map_.emplace(seq, std::move(rpc));
+RpcInfo* RpcChannel::PopRpc(uint64_t seq) {
+    auto rpc = rpc_map_.Remove(seq);
+    if (rpc) {
+        event_loop_->ClearTimer(rpc->get_timer_id());
+    }
+    return rpc;
 }
 
-RpcInfoPtr RpcChannel::PopRpc(uint64_t seq) {
-    RpcInfoPtr rpc;
-    auto it = rpc_map_.find(seq);
-    if (it != rpc_map_.end()) {
-        rpc = std::move(it->second);
-        rpc_map_.erase(it);
+void RpcChannel::Abort(uint64_t seq, int err) {
+    auto rpc = PopRpc(seq);
+    if (!rpc) {
+        return;
     }
-    return rpc;
+    log_info("[RPC] RPC channel(%lld, %s) call %llu aborted, err:%d, msg:%s",
+             guid_, address_.c_str(), seq, err, tinynet_strerror(err));
+    auto it = streams_.find(seq);
+    if (it != streams_.end()) {
+        auto stream = std::move(it->second);
+        streams_.erase(it);
+        SendStream(PacketType::STREAM_RESET, seq, (uint64_t)(int64_t)err, nullptr, 0);
+        stream->OnReset(err);
+    }
+    rpc->Run(err);
+    rpc_map_.Release(rpc);
+}
+
+void RpcChannel::RefuseStream(uint64_t seq) {
+    auto it = streams_.find(seq);
+    if (it != streams_.end()) {
+        auto stream = std::move(it->second);
+        streams_.erase(it);
+        stream->OnReset(ERROR_RPC_STREAMUNSUPPORTED);
+    }
+    auto rpc = PopRpc(seq);
+    if (!rpc) {
+        return;
+    }
+    log_info("[RPC] RPC channel(%lld, %s) call %llu opens a stream the server does not take",
+             guid_, address_.c_str(), seq);
+    rpc->Run(ERROR_RPC_STREAMUNSUPPORTED);
+    rpc_map_.Release(rpc);
+}
+
+void RpcChannel::Timeout(uint64_t seq) {
+    auto rpc = rpc_map_.Find(seq);
+    if (!rpc) {
+        return;
+    }
+    //Fired already
+    rpc->set_timer_id(INVALID_TIMER_ID);
+    Abort(seq, ERROR_RPC_TIMEOUT);
+}
+
+//Done closure of a method run by a worker, the loop of the channel sends the response
+static void RunInLoop(EventLoop* loop, google::protobuf::Closure* done) {
+    loop->AddTask([done] { done->Run(); });
+}
+
+void RpcChannel::RunOnWorker(const RpcMethodPtr& method, const RpcInfoPtr& rpc, google::protobuf::Closure* done) {
+    //The call stays owned by done, only the loop deletes it. It has no stream, see OnPacket().
+    EventLoop* loop = event_loop_;
+    auto controller = rpc->get_controller();
+    auto request = rpc->get_request();
+    auto response = rpc->get_response();
+    bool queued = method->get_worker_pool()->Submit([loop, method, controller, request, response, done] {
+        if (static_cast<RpcController*>(controller)->IsExpired()) {
+            //Waited for a worker longer than the caller
+            RunInLoop(loop, done);
+            return;
+        }
+        method->get_service()->CallMethod(method->get_descriptor(), controller, request, response,
+                                          ::google::protobuf::NewCallback(&RunInLoop, loop, done));
+    });
+    if (queued) {
+        return;
+    }
+    log_warning("[RPC] RPC channel(%lld, %s) call %llu shed, %zu requests wait for the workers",
+                guid_, address_.c_str(), rpc->get_seq(), method->get_worker_pool()->get_pending());
+    rpc->End(ERROR_RPC_SERVERBUSY);
+    delete done;
+    ReplyError(rpc->get_seq(), ERROR_RPC_SERVERBUSY);
+}
+
+void RpcChannel::ReplyError(uint64_t seq, int err) {
+    if (!(peer_features_ & PACKET_FLAG_ERROR)) {
+        //A client predating the flag would take the reply for garbage, it learns the error from the log only
+        Close(err);
+        return;
+    }
+    codec_->WriteControl(socket_, PacketType::RESPONSE, seq, (uint64_t)(int64_t)err, PACKET_FLAG_ERROR);
 }
 
 void RpcChannel::SendResponse(RpcInfoPtr rpc) {
-    codec_->Write(socket_, PacketType::RESPONSE, rpc->get_seq(), 0, rpc->get_response());
+    auto c = static_cast<RpcController*>(rpc->get_controller());
+    auto& stream = c->get_stream();
+    if (stream && !stream->is_accepted()) {
+        stream->Reset(ERROR_RPC_STREAMREFUSED);
+    }
+    if (c->IsExpired()) {
+        //Nobody waits for it any more
+        rpc->End(ERROR_RPC_TIMEOUT);
+        return;
+    }
+    auto response = rpc->get_response();
+    codec_->Write(socket_, PacketType::RESPONSE, rpc->get_seq(), 0, response);
+    rpc->get_metrics()->AddResponseBytes(codec_->get_write_size());
+    rpc->End(c->ErrorCode());
 }
 
 void RpcChannel::Run(int err) {
-    RPC_MAP rpc_map;
-    rpc_map_.swap(rpc_map);
-    for (auto it = rpc_map.begin(); it != rpc_map.end();) {
-        it->second->Run(err);
-        rpc_map.erase(it++);
+    ResetStreams(err);
+    //Calls made by the callbacks below go into the emptied map
+    auto rpc = rpc_map_.RemoveAll();
+    while (rpc) {
+        auto next = rpc->get_next();
+        event_loop_->ClearTimer(rpc->get_timer_id());
+        rpc->Run(err);
+        rpc_map_.Release(rpc);
+        rpc = next;
     }
 }
 
 void RpcChannel::Flush() {
-    while (!packet_queue_.empty()) {
-        codec_->Write(socket_, packet_queue_.front().get());
-        packet_queue_.pop();
+    if (pending_.empty()) {
+        return;
+    }
+    uint32_t now = (uint32_t)STime_ms();
+    //Calls opening a stream the server does not take, failed once the others are sent
+    std::vector<uint64_t> refused;
+    const char* p = pending_.begin();
+    const char* end = pending_.end();
+    while (p < end) {
+        PacketHeader header;
+        size_t headerSize = RpcCodec::DecodeHeader(p, &header);
+        size_t packetSize = headerSize + header.len;
+        //Calls timed out or canceled while connecting are not sent, nor the packets of their streams
+        bool live;
+        if (header.type == (uint32_t)PacketType::REQUEST) {
+            live = rpc_map_.Find(header.seq) != nullptr;
+            if (live && (header.flags & PACKET_FLAG_STREAM) && !CanStream()) {
+                refused.push_back(header.seq);
+                live = false;
+            }
+        } else if (std::find(refused.begin(), refused.end(), header.seq) != refused.end()) {
+            //The packets of a refused stream follow its request
+            live = false;
+        } else {
+            live = header.type == (uint32_t)PacketType::STREAM_RESET || streams_.count(header.seq) > 0;
+        }
+        if (live && (header.flags & PACKET_FLAG_TIMEOUT) && !peer_deadline_) {
+            //Encoded before the server answered, it would take the flagged request for another packet type
+            char* out = socket_->PrepareWrite(packetSize - RPC_PACKET_TIMEOUT_LEN);
+            memcpy(out, p, RPC_PACKET_HEADER_LEN);
+            EncodeFixed32(out, header.type | (header.flags & ~PACKET_FLAG_TIMEOUT));
+            memcpy(out + RPC_PACKET_HEADER_LEN, p + headerSize, header.len);
+            socket_->CommitWrite(packetSize - RPC_PACKET_TIMEOUT_LEN);
+        } else if (live) {
+            char* out = socket_->PrepareWrite(packetSize);
+            memcpy(out, p, packetSize);
+            if (header.flags & PACKET_FLAG_TIMEOUT) {
+                int32_t timeout = (int32_t)(header.timeout - now);
+                EncodeFixed32(out + RPC_PACKET_HEADER_LEN, (uint32_t)(std::max)(timeout, 1));
+            }
+            socket_->CommitWrite(packetSize);
+        }
+        p += packetSize;
+    }
+    pending_.clear();
+    socket_->Flush();
+    for (auto seq : refused) {
+        RefuseStream(seq);
+    }
+}
+
+void RpcChannel::SendStream(PacketType type, uint64_t id, uint64_t method, const void* data, size_t len) {
+    switch (get_state()) {
+    case net::ChannelState::CS_CONNECTING:
+        codec_->Write(&pending_, type, id, method, data, len);
+        break;
+    case net::ChannelState::CS_CONNECTED:
+        if (negotiating_) {
+            //Behind the request of the stream
+            codec_->Write(&pending_, type, id, method, data, len);
+            break;
+        }
+        codec_->Write(socket_, type, id, method, data, len);
+        break;
+    default:
+        break;
+    }
+}
+
+int RpcChannel::SendStream(uint64_t id, const google::protobuf::Message& msg) {
+    switch (get_state()) {
+    case net::ChannelState::CS_CONNECTING:
+        return codec_->Write(&pending_, PacketType::STREAM_DATA, id, 0, &msg) ? ERROR_OK : ERROR_RPC_ENCODEERROR;
+    case net::ChannelState::CS_CONNECTED:
+        if (negotiating_) {
+            return codec_->Write(&pending_, PacketType::STREAM_DATA, id, 0, &msg) ? ERROR_OK : ERROR_RPC_ENCODEERROR;
+        }
+        codec_->Write(socket_, PacketType::STREAM_DATA, id, 0, &msg);
+        return ERROR_OK;
+    default:
+        return ERROR_RPC_STREAMCLOSED;
+    }
+}
+
+void RpcChannel::RemoveStream(uint64_t id) {
+    streams_.erase(id);
+}
+
+void RpcChannel::ResetStreams(int err) {
+    if (streams_.empty()) {
+        return;
+    }
+    //Streams opened by the callbacks below go into the emptied map
+    std::unordered_map<uint64_t, RpcStreamPtr> streams;
+    streams.swap(streams_);
+    for (auto& it : streams) {
+        SendStream(PacketType::STREAM_RESET, it.first, (uint64_t)(int64_t)err, nullptr, 0);
+        it.second->OnReset(err);
     }
 }
 
@@ -3,7 +3,6 @@
 #pragma once
 #include "google/protobuf/service.h"
 #include "net/socket_channel.h"
-#include <queue>
 #include <memory>
 #include "rpc_packet.h"
 #include "rpc_codec.h"
@@ -11,6 +10,8 @@
 #include "rpc_controller.h"
 #include "rpc_method.h"
 #include "rpc_info.h"
+#include "rpc_call_map.h"
+#include "rpc_stream.h"
 
 namespace tinynet {
 namespace rpc {
@@ -25,6 +26,7 @@ typedef std::shared_ptr<RpcChannel> RpcChannelPtr;
 class RpcChannel :
     public net::SocketChannel,
     public google::protobuf::RpcChannel {
+    friend class RpcStream;
   public:
     /**
      * @brief Construct a new Rpc Channel object
@@ -83,6 +85,29 @@ class RpcChannel :
                             google::protobuf::Message *response,
                             google::protobuf::Closure *done) override;
 
+  public:
+    /**
+     * @brief Payloads of at least threshold bytes are compressed once the peer accepted compression.
+     * A client asks for it on each connection, a server answers whatever its threshold. 0 disables it.
+     *
+     * @param threshold
+     */
+    void set_compress_threshold(size_t threshold) { compress_threshold_ = threshold; }
+
+    const RpcCodecStats& get_compress_stats() const { return codec_->get_stats(); }
+    /**
+     * @brief Whether the peer of the current or last connection answers a failed call with its error code,
+     * ERROR_RPC_METHODNOTFOUND among others, instead of closing the connection
+     *
+     * @return bool
+     */
+    bool CanReplyError() const { return (peer_features_ & PACKET_FLAG_ERROR) != 0; }
+    /**
+     * @brief Client calls waiting for their responses
+     *
+     * @return size_t
+     */
+    size_t get_pending_count() const { return rpc_map_.size(); }
   public:
     void SendResponse(RpcInfoPtr rpc);
   public:
@@ -92,21 +117,47 @@ class RpcChannel :
     void OnRead() override;
     void OnError(int err) override;
     void OnPacket(PacketHeader *header);
+    void OnNegotiate(PacketHeader *header);
+    void OnStreamPacket(PacketHeader *header);
   private:
-    bool SendRequest(int64_t seq, const std::string &method, const google::protobuf::Message *request);
-    void PushRpc(uint64_t seq, RpcInfoPtr rpc);
-    RpcInfoPtr PopRpc(uint64_t seq);
+    bool SendRequest(int64_t seq, uint64_t method, const google::protobuf::Message *request, int64_t deadline,
+                     uint32_t flags);
+    RpcInfo* PopRpc(uint64_t seq);
     void Flush();
+    //Connects again to replay the requests held while a server refused the negotiation
+    void Reopen();
+    //Completes the call with err, the response arriving later is dropped
+    void Abort(uint64_t seq, int err);
+    void Timeout(uint64_t seq);
+    //Fails a call opening a stream the server does not take, nothing was sent for it
+    void RefuseStream(uint64_t seq);
+    bool CanStream() const { return (peer_features_ & PACKET_FLAG_STREAM) != 0; }
+    //Runs the request on the workers of the method, or answers ERROR_RPC_SERVERBUSY when they are overloaded
+    void RunOnWorker(const RpcMethodPtr& method, const RpcInfoPtr& rpc, google::protobuf::Closure* done);
+    //Answers a request with err instead of running it, closes the connection of a client not taking PACKET_FLAG_ERROR
+    void ReplyError(uint64_t seq, int err);
+  private:
+    //Called by the streams
+    void SendStream(PacketType type, uint64_t id, uint64_t method, const void* data, size_t len);
+    int SendStream(uint64_t id, const google::protobuf::Message& msg);
+    void RemoveStream(uint64_t id);
+    //Breaks the streams of the channel, the peer is told if it is still connected
+    void ResetStreams(int err);
 
   private:
-    using RPC_MAP = std::unordered_map<uint64_t, RpcInfoPtr>;
-    using PACKET_QUEUE = std::queue<RpcPacketPtr>;
     using RpcCodecPtr = std::unique_ptr<RpcCodec>;
   private:
     uint64_t                  seq_;
-    PACKET_QUEUE              packet_queue_;
+    IOBuffer                  pending_;     //Requests encoded while connecting or negotiating
     RpcCodecPtr               codec_;
-    RPC_MAP                   rpc_map_;
+    RpcCallMap                rpc_map_;
+    std::unordered_map<uint64_t, RpcStreamPtr> streams_; //Keyed by the sequence of the call which opened them
+    size_t                    compress_threshold_{ 0 };
+    bool                      negotiating_{ false };   //Waiting for the answer of the server
+    bool                      negotiate_refused_{ false }; //The server closed the connection instead of answering, until Init()
+    bool                      peer_deadline_{ false }; //The peer accepted PACKET_FLAG_TIMEOUT on this connection
+    uint32_t                  peer_features_{ 0 };     //PACKET_FEATURES_NEGOTIATED understood by the peer on this connection
+    TaskId                    reopen_task_{ INVALID_TASK_ID };
 };
 }
 }
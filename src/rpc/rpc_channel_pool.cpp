@@ -0,0 +1,128 @@
+// Copyright (C), Xianfeng Shang.  All rights reserved.
+// Author: Xianfeng Shang (shangxianfeng@outlook.com)
+#include "rpc_channel_pool.h"
+#include "rpc_controller.h"
+#include "rpc_method.h"
+#include "util/string_utils.h"
+#include <algorithm>
+
+namespace tinynet {
+namespace rpc {
+
+RpcChannelPool::RpcChannelPool(EventLoop *loop) :
+    event_loop_(loop) {
+}
+
+RpcChannelPool::~RpcChannelPool() = default;
+
+void RpcChannelPool::Init(const std::string &ip, int port) {
+    net::ChannelOptions opts;
+    opts.host = ip;
+    opts.port = port;
+    Init(opts);
+}
+
+void RpcChannelPool::Init(net::ChannelOptions &opts) {
+    strategy_ = opts.pool_strategy;
+    int pool_size = (std::max)(opts.pool_size, 1);
+    for (int i = 0; i < pool_size; ++i) {
+        channels_.push_back(CreateChannel(opts));
+    }
+    if (opts.bulk_methods.empty()) {
+        return;
+    }
+    for (auto& name : opts.bulk_methods) {
+        //Same hash as the method ids of the packets
+        bulk_methods_.insert(StringUtils::Hash3(name.c_str()));
+    }
+    bulk_channel_ = CreateChannel(opts);
+}
+
+void RpcChannelPool::Reset() {
+    for (auto& channel : channels_) {
+        channel->Reset();
+    }
+    if (bulk_channel_) {
+        bulk_channel_->Reset();
+    }
+}
+
+void RpcChannelPool::Run(int err) {
+    for (auto& channel : channels_) {
+        channel->Run(err);
+    }
+    if (bulk_channel_) {
+        bulk_channel_->Run(err);
+    }
+}
+
+void RpcChannelPool::CallMethod(const google::protobuf::MethodDescriptor *method, google::protobuf::RpcController *controller,
+                                const google::protobuf::Message *request, google::protobuf::Message *response,
+                                google::protobuf::Closure *done) {
+    Select(method, controller)->CallMethod(method, controller, request, response, done);
+}
+
+void RpcChannelPool::set_compress_threshold(size_t threshold) {
+    compress_threshold_ = threshold;
+    for (auto& channel : channels_) {
+        channel->set_compress_threshold(threshold);
+    }
+    if (bulk_channel_) {
+        bulk_channel_->set_compress_threshold(threshold);
+    }
+}
+
+size_t RpcChannelPool::get_pending_count() const {
+    size_t count = bulk_channel_ ? bulk_channel_->get_pending_count() : 0;
+    for (auto& channel : channels_) {
+        count += channel->get_pending_count();
+    }
+    return count;
+}
+
+RpcChannelPtr RpcChannelPool::CreateChannel(net::ChannelOptions &opts) {
+    auto channel = std::make_shared<rpc::RpcChannel>(event_loop_);
+    channel->set_compress_threshold(compress_threshold_);
+    //Each connection completes the options for itself
+    net::ChannelOptions channel_opts = opts;
+    channel->Init(channel_opts);
+    return channel;
+}
+
+rpc::RpcChannel* RpcChannelPool::Select(const google::protobuf::MethodDescriptor *method, google::protobuf::RpcController *controller) {
+    if (bulk_channel_ && bulk_methods_.count(RpcMethod::GetMethodId(method))) {
+        return bulk_channel_.get();
+    }
+    if (channels_.size() == 1) {
+        return channels_[0].get();
+    }
+    auto c = static_cast<RpcController*>(controller);
+    if (strategy_ == net::ChannelPoolStrategy::HASH && c && c->has_hash_key()) {
+        return channels_[c->get_hash_key() % channels_.size()].get();
+    }
+    return SelectLeastPending();
+}
+
+rpc::RpcChannel* RpcChannelPool::SelectLeastPending() {
+    size_t n = channels_.size();
+    size_t best = next_ % n;
+    size_t best_load = SIZE_MAX;
+    for (size_t i = 0; i < n; ++i) {
+        size_t index = (next_ + i) % n;
+        auto& channel = channels_[index];
+        //A connection down is used once the others are busy, the call reconnects it
+        size_t load = channel->get_pending_count();
+        if (channel->get_state() != net::ChannelState::CS_CONNECTED) {
+            ++load;
+        }
+        if (load < best_load) {
+            best = index;
+            best_load = load;
+            if (load == 0) break;
+        }
+    }
+    next_ = best + 1;
+    return channels_[best].get();
+}
+}
+}
@@ -0,0 +1,113 @@
+// Copyright (C), Xianfeng Shang.  All rights reserved.
+// Author: Xianfeng Shang (shangxianfeng@outlook.com)
+#pragma once
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_set>
+#include <vector>
+#include "google/protobuf/service.h"
+#include "net/event_loop.h"
+#include "rpc_channel.h"
+
+namespace tinynet {
+namespace rpc {
+class RpcChannelPool;
+typedef std::shared_ptr<RpcChannelPool> RpcChannelPoolPtr;
+
+//Several connections to one endpoint used as a single channel, so that one large response
+//only holds up the calls behind it on its own connection.
+//Each call goes through the connection chosen by ChannelOptions::pool_strategy,
+//the methods named in ChannelOptions::bulk_methods through a connection of their own.
+//Each connection reconnects by itself with the next call it is given.
+class RpcChannelPool :
+    public google::protobuf::RpcChannel {
+  public:
+    /**
+     * @brief Construct a new Rpc Channel Pool object
+     *
+     * @param loop
+     */
+    RpcChannelPool(EventLoop *loop);
+    /**
+     * @brief Destroy the Rpc Channel Pool object
+     *
+     */
+    virtual ~RpcChannelPool();
+  private:
+    RpcChannelPool(const RpcChannelPool&) = delete;
+    RpcChannelPool& operator=(const RpcChannelPool&) = delete;
+  public:
+    /**
+     * @brief Initialize the pool with the given ip and port
+     *
+     * @param ip
+     * @param port
+     */
+    void Init(const std::string &ip, int port);
+    /**
+     * @brief Initialize the pool with the given options, see ChannelOptions::pool_size
+     *
+     * @param opts
+     */
+    void Init(net::ChannelOptions &opts);
+    /**
+     * @brief Reset all connections
+     *
+     */
+    void Reset();
+    /**
+     * @brief Completes the calls in flight on all connections with err
+     *
+     * @param err
+     */
+    void Run(int err);
+  public:
+    /**
+     * @brief Override google protobuf rpc channel CallMethod
+     *
+     * @param method
+     * @param controller
+     * @param request
+     * @param response
+     * @param done
+     */
+    virtual void CallMethod(const google::protobuf::MethodDescriptor *method,
+                            google::protobuf::RpcController *controller,
+                            const google::protobuf::Message *request,
+                            google::protobuf::Message *response,
+                            google::protobuf::Closure *done) override;
+  public:
+    /**
+     * @brief See RpcChannel::set_compress_threshold(), applies to all connections
+     *
+     * @param threshold
+     */
+    void set_compress_threshold(size_t threshold);
+    /**
+     * @brief Client calls waiting for their responses on all connections
+     *
+     * @return size_t
+     */
+    size_t get_pending_count() const;
+    /**
+     * @brief Connections of the pool, the bulk lane included
+     *
+     * @return size_t
+     */
+    size_t size() const { return channels_.size() + (bulk_channel_ ? 1 : 0); }
+  private:
+    RpcChannelPtr CreateChannel(net::ChannelOptions &opts);
+    rpc::RpcChannel* Select(const google::protobuf::MethodDescriptor *method, google::protobuf::RpcController *controller);
+    rpc::RpcChannel* SelectLeastPending();
+  private:
+    EventLoop*                   event_loop_;
+    std::vector<RpcChannelPtr>   channels_;
+    RpcChannelPtr                bulk_channel_; ///< Lane of the bulk methods
+    std::unordered_set<uint64_t> bulk_methods_; ///< Ids of the bulk methods, see RpcMethod::GetMethodId()
+    net::ChannelPoolStrategy     strategy_{ net::ChannelPoolStrategy::LEAST_PENDING };
+    size_t                       next_{ 0 }; ///< Where the search of the least busy connection starts, spreads the ties
+    size_t                       compress_threshold_{ 0 };
+};
+}
+}
@@ -8,19 +8,34 @@
 #include "zero_copy_stream.h"
 #include "base/runtime_logger.h"
 #include "base/coding.h"
+#include "util/zlib_utils.h"
+#include "zlib.h"
+#include <algorithm>
+#include <cstring>
 
 namespace tinynet {
 namespace rpc {
 
+//Scratch buffers larger than this are given back after each packet
+static const size_t kMaxScratchSize = 1024 * 1024;
+
+static size_t GetHeaderLength(const PacketHeader& header) {
+    return RPC_PACKET_HEADER_LEN + ((header.flags & PACKET_FLAG_TIMEOUT) ? RPC_PACKET_TIMEOUT_LEN : 0);
+}
+
 static void EncodeHeader(char* buf, const PacketHeader& header) {
     int offset = 0;
-    EncodeFixed32(buf + offset,header.type);
+    EncodeFixed32(buf + offset,header.type | header.flags);
     offset += sizeof(uint32_t);
     EncodeFixed32(buf + offset, header.len);
     offset += sizeof(uint32_t);
     EncodeFixed64(buf + offset, header.method);
     offset += sizeof(uint64_t);
     EncodeFixed64(buf + offset, header.seq);
+    offset += sizeof(uint64_t);
+    if (header.flags & PACKET_FLAG_TIMEOUT) {
+        EncodeFixed32(buf + offset, header.timeout);
+    }
 }
 
 void RpcCodec::Write(net::SocketPtr& sock, RpcPacket *packet) {
@@ -28,44 +43,244 @@ void RpcCodec::Write(net::SocketPtr& sock, RpcPacket *packet) {
         sock->SetError(ERROR_RPC_MESSAGETOOLONG);
         return;
     }
-    size_t packetSize = RPC_PACKET_HEADER_LEN + packet->body.size();
-    sock->wbuf()->reserve(sock->wbuf()->size() + packetSize);
-    char* p = sock->wbuf()->end();
+    size_t headerSize = GetHeaderLength(packet->header);
+    size_t packetSize = headerSize + packet->body.size();
+    char* p = sock->PrepareWrite(packetSize);
     EncodeHeader(p, packet->header);
-    p += RPC_PACKET_HEADER_LEN;
+    p += headerSize;
     std::copy(packet->body.begin(), packet->body.end(), p);
-    sock->wbuf()->commit(packetSize);
+    sock->CommitWrite(packetSize);
     sock->Flush();
 }
 
-void RpcCodec::Write(net::SocketPtr& sock, PacketType type, uint64_t seq, uint64_t method, const google::protobuf::Message *msg) {
+void RpcCodec::Write(net::SocketPtr& sock, PacketType type, uint64_t seq, uint64_t method, const google::protobuf::Message *msg,
+                     uint32_t timeout, uint32_t flags) {
     PacketHeader header;
     header.len = (uint32_t)msg->ByteSize();
+    write_size_ = header.len;
     header.type = (uint32_t)type;
     header.seq = seq;
     header.method = method;
+    header.flags = flags;
+    if (timeout) {
+        header.flags |= PACKET_FLAG_TIMEOUT;
+        header.timeout = timeout;
+    }
+    size_t headerSize = GetHeaderLength(header);
 
-    size_t packetSize = RPC_PACKET_HEADER_LEN + header.len;
-    sock->wbuf()->reserve(sock->wbuf()->size() + packetSize);
-    char* p = sock->wbuf()->end();
+    if (compress_threshold_ && header.len >= compress_threshold_) {
+        IOBuffer* body = Compress(msg, &header);
+        if (!body) {
+            log_runtime_error("SerializeToArray faild, type:%d, seq:%llu, method:%u, msg:%s", type, seq, method, msg->GetTypeName().c_str());
+            ReleaseScratch();
+            return;
+        }
+        char* p = sock->PrepareWrite(headerSize + body->size());
+        EncodeHeader(p, header);
+        memcpy(p + headerSize, body->begin(), body->size());
+        sock->CommitWrite(headerSize + body->size());
+        ReleaseScratch();
+        sock->Flush();
+        return;
+    }
+    stats_.tx_uncompressed_bytes += header.len;
+
+    if (sock->wchain()) {
+        //Serialize the body straight into the chained blocks
+        if (!msg->IsInitialized()) {
+            log_runtime_error("SerializeToZeroCopyStream faild, type:%d, seq:%llu, method:%u, msg:%s", type, seq, method, msg->GetTypeName().c_str());
+            return;
+        }
+        EncodeHeader(sock->PrepareWrite(headerSize), header);
+        sock->CommitWrite(headerSize);
+        ZeroCopyOutputStream stream(sock->wchain());
+        msg->SerializePartialToZeroCopyStream(&stream);
+        sock->Flush();
+        return;
+    }
+    size_t packetSize = headerSize + header.len;
+    char* p = sock->PrepareWrite(packetSize);
     EncodeHeader(p, header);
-    p += RPC_PACKET_HEADER_LEN;
+    p += headerSize;
     if (!msg->SerializeToArray(p, (int)header.len)) {
         log_runtime_error("SerializeToArray faild, type:%d, seq:%llu, method:%u, msg:%s", type, seq, method, msg->GetTypeName().c_str());
         return;
     }
-    sock->wbuf()->commit(packetSize);
+    sock->CommitWrite(packetSize);
+    sock->Flush();
+}
+
+bool RpcCodec::Write(IOBuffer* buf, PacketType type, uint64_t seq, uint64_t method, const google::protobuf::Message *msg,
+                     uint32_t timeout, uint32_t flags) {
+    PacketHeader header;
+    header.len = (uint32_t)msg->ByteSize();
+    write_size_ = header.len;
+    header.type = (uint32_t)type;
+    header.seq = seq;
+    header.method = method;
+    header.flags = flags;
+    if (timeout) {
+        header.flags |= PACKET_FLAG_TIMEOUT;
+        header.timeout = timeout;
+    }
+    size_t headerSize = GetHeaderLength(header);
+    char* p = buf->prepare(headerSize + header.len);
+    EncodeHeader(p, header);
+    if (!msg->SerializeToArray(p + headerSize, (int)header.len)) {
+        log_runtime_error("SerializeToArray faild, type:%d, seq:%llu, method:%u, msg:%s", type, seq, method, msg->GetTypeName().c_str());
+        return false;
+    }
+    buf->commit(headerSize + header.len);
+    stats_.tx_uncompressed_bytes += header.len;
+    return true;
+}
+
+void RpcCodec::Write(net::SocketPtr& sock, PacketType type, uint64_t seq, uint64_t method, const void* data, size_t len) {
+    if (len >= MAX_RPC_PACKET_LEN) {
+        sock->SetError(ERROR_RPC_MESSAGETOOLONG);
+        return;
+    }
+    PacketHeader header;
+    header.type = (uint32_t)type;
+    header.len = (uint32_t)len;
+    header.method = method;
+    header.seq = seq;
+    const char* body = (const char*)data;
+    if (compress_threshold_ && len >= compress_threshold_ && Deflate(body, &header)) {
+        body = packed_.begin();
+    } else {
+        stats_.tx_uncompressed_bytes += len;
+    }
+    char* p = sock->PrepareWrite(RPC_PACKET_HEADER_LEN + header.len);
+    EncodeHeader(p, header);
+    if (header.len > 0) {
+        memcpy(p + RPC_PACKET_HEADER_LEN, body, header.len);
+    }
+    sock->CommitWrite(RPC_PACKET_HEADER_LEN + header.len);
+    ReleaseScratch();
+    sock->Flush();
+}
+
+void RpcCodec::Write(IOBuffer* buf, PacketType type, uint64_t seq, uint64_t method, const void* data, size_t len) {
+    PacketHeader header;
+    header.type = (uint32_t)type;
+    header.len = (uint32_t)len;
+    header.method = method;
+    header.seq = seq;
+    char* p = buf->prepare(RPC_PACKET_HEADER_LEN + len);
+    EncodeHeader(p, header);
+    if (len > 0) {
+        memcpy(p + RPC_PACKET_HEADER_LEN, data, len);
+    }
+    buf->commit(RPC_PACKET_HEADER_LEN + len);
+    stats_.tx_uncompressed_bytes += len;
+}
+
+void RpcCodec::WriteControl(net::SocketPtr& sock, PacketType type, uint64_t seq, uint64_t method, uint32_t flags) {
+    PacketHeader header;
+    header.type = (uint32_t)type;
+    header.len = 0;
+    header.method = method;
+    header.seq = seq;
+    header.flags = flags;
+    size_t headerSize = GetHeaderLength(header);
+    EncodeHeader(sock->PrepareWrite(headerSize), header);
+    sock->CommitWrite(headerSize);
+    sock->Flush();
+}
+
+void RpcCodec::WriteNegotiate(net::SocketPtr& sock, PacketType type, uint32_t flags, uint32_t features) {
+    PacketHeader header;
+    header.type = (uint32_t)type;
+    header.len = sizeof(uint32_t);
+    header.method = RPC_METHOD_NEGOTIATE;
+    header.seq = 0;
+    header.flags = flags;
+    size_t headerSize = GetHeaderLength(header);
+    char* p = sock->PrepareWrite(headerSize + header.len);
+    EncodeHeader(p, header);
+    EncodeFixed32(p + headerSize, features);
+    sock->CommitWrite(headerSize + header.len);
     sock->Flush();
 }
 
+uint32_t RpcCodec::ReadNegotiate(net::SocketPtr& sock, size_t len) {
+    uint32_t features = 0;
+    //Never compressed, PACKET_FLAG_COMPRESSED only tells the peer accepts it
+    if (len >= sizeof(uint32_t) && sock->rbuf()->size() >= len) {
+        features = DecodeFixed32(sock->rbuf()->begin());
+    }
+    Skip(sock, len);
+    return features;
+}
+
+IOBuffer* RpcCodec::Compress(const google::protobuf::Message *msg, PacketHeader* header) {
+    plain_.clear();
+    if (!msg->SerializeToArray(plain_.prepare(header->len), (int)header->len)) {
+        return nullptr;
+    }
+    plain_.commit(header->len);
+    if (!Deflate(plain_.begin(), header)) {
+        //Not worth it, sent as it is
+        stats_.tx_uncompressed_bytes += plain_.size();
+        return &plain_;
+    }
+    return &packed_;
+}
+
+bool RpcCodec::Deflate(const char* data, PacketHeader* header) {
+    packed_.clear();
+    if (ZlibUtils::deflate((unsigned char*)data, header->len, &packed_) != Z_OK ||
+            packed_.size() >= header->len) {
+        return false;
+    }
+    ++stats_.tx_packets;
+    stats_.tx_raw_bytes += header->len;
+    stats_.tx_compressed_bytes += packed_.size();
+    header->flags |= PACKET_FLAG_COMPRESSED;
+    header->len = (uint32_t)packed_.size();
+    return true;
+}
+
+void RpcCodec::ReleaseScratch() {
+    plain_.clear();
+    packed_.clear();
+    if (plain_.capacity() > kMaxScratchSize) {
+        plain_.release();
+    }
+    if (packed_.capacity() > kMaxScratchSize) {
+        packed_.release();
+    }
+}
+
+size_t RpcCodec::DecodeHeader(const char* p, PacketHeader* header) {
+    header->type = DecodeFixed32(p);
+    header->flags = header->type & ~PACKET_TYPE_MASK;
+    header->type &= PACKET_TYPE_MASK;
+    p += sizeof(uint32_t);
+    header->len = DecodeFixed32(p);
+    p += sizeof(uint32_t);
+    header->method = DecodeFixed64(p);
+    p += sizeof(uint64_t);
+    header->seq = DecodeFixed64(p);
+    p += sizeof(uint64_t);
+    header->timeout = (header->flags & PACKET_FLAG_TIMEOUT) ? DecodeFixed32(p) : 0;
+    return GetHeaderLength(*header);
+}
+
 PacketHeader* RpcCodec::Read(net::SocketPtr& sock) {
     if (sock->rbuf()->size() < RPC_PACKET_HEADER_LEN) {
         return nullptr;
     }
     const char* p = sock->rbuf()->begin();
     header_.type = DecodeFixed32(p);
-    if (header_.type != (uint32_t)PacketType::REQUEST &&
-            header_.type != (uint32_t)PacketType::RESPONSE) {
+    header_.flags = header_.type & ~PACKET_TYPE_MASK;
+    header_.type &= PACKET_TYPE_MASK;
+    if (header_.flags & ~PACKET_FLAGS_KNOWN) {
+        sock->SetError(ERROR_RPC_DECODEERROR);
+        return nullptr;
+    }
+    if (header_.type > (uint32_t)PacketType::STREAM_RESET) {
         sock->SetError(ERROR_RPC_DECODEERROR);
         return nullptr;
     }
@@ -75,14 +290,17 @@ PacketHeader* RpcCodec::Read(net::SocketPtr& sock) {
         sock->SetError(ERROR_RPC_MESSAGETOOLONG);
         return nullptr;
     }
-    if (sock->rbuf()->size() < (header_.len + RPC_PACKET_HEADER_LEN)) {
+    size_t headerSize = GetHeaderLength(header_);
+    if (sock->rbuf()->size() < (header_.len + headerSize)) {
         return nullptr;
     }
     p += sizeof(uint32_t);
     header_.method = DecodeFixed64(p);
     p += sizeof(uint64_t);
     header_.seq = DecodeFixed64(p);
-    sock->rbuf()->consume(RPC_PACKET_HEADER_LEN);
+    p += sizeof(uint64_t);
+    header_.timeout = (header_.flags & PACKET_FLAG_TIMEOUT) ? DecodeFixed32(p) : 0;
+    sock->rbuf()->consume(headerSize);
     return &header_;
 }
 
@@ -91,12 +309,59 @@ google::protobuf::Message* RpcCodec::Read(net::SocketPtr& sock, google::protobuf
         return nullptr;
     }
     const char* p = sock->rbuf()->begin();
+    if (header_.flags & PACKET_FLAG_COMPRESSED) {
+        plain_.clear();
+        bool ok = ZlibUtils::inflate((unsigned char*)p, len, &plain_, MAX_RPC_PACKET_LEN) == Z_OK &&
+                  body->ParseFromArray(plain_.begin(), (int)plain_.size());
+        ++stats_.rx_packets;
+        stats_.rx_raw_bytes += plain_.size();
+        stats_.rx_compressed_bytes += len;
+        read_size_ = plain_.size();
+        ReleaseScratch();
+        if (!ok) {
+            sock->SetError(ERROR_RPC_DECODEERROR);
+            return nullptr;
+        }
+        sock->rbuf()->consume(len);
+        return body;
+    }
     if (!body->ParseFromArray(p, (int)len)) {
         sock->SetError(ERROR_RPC_DECODEERROR);
         return nullptr;
     }
+    stats_.rx_uncompressed_bytes += len;
+    read_size_ = len;
     sock->rbuf()->consume(len);
     return body;
 }
+
+const char* RpcCodec::Peek(net::SocketPtr& sock, size_t len, size_t* size) {
+    if (sock->rbuf()->size() < len) {
+        return nullptr;
+    }
+    const char* p = sock->rbuf()->begin();
+    if (!(header_.flags & PACKET_FLAG_COMPRESSED)) {
+        stats_.rx_uncompressed_bytes += len;
+        *size = len;
+        return p;
+    }
+    plain_.clear();
+    int err = ZlibUtils::inflate((unsigned char*)p, len, &plain_, MAX_RPC_PACKET_LEN);
+    ++stats_.rx_packets;
+    stats_.rx_raw_bytes += plain_.size();
+    stats_.rx_compressed_bytes += len;
+    if (err != Z_OK) {
+        ReleaseScratch();
+        sock->SetError(ERROR_RPC_DECODEERROR);
+        return nullptr;
+    }
+    *size = plain_.size();
+    return plain_.begin();
+}
+
+void RpcCodec::Skip(net::SocketPtr& sock, size_t len) {
+    sock->rbuf()->consume((std::min)(len, sock->rbuf()->size()));
+    ReleaseScratch();
+}
 }
 }
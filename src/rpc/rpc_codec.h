@@ -6,17 +6,81 @@
 #include <memory>
 namespace tinynet {
 namespace rpc {
+/**
+ * @brief Payload compression counters of a channel
+ *
+ */
+struct RpcCodecStats {
+    uint64_t tx_packets{ 0 }; ///< Packets sent compressed
+    uint64_t tx_raw_bytes{ 0 }; ///< Their payload bytes before compression
+    uint64_t tx_compressed_bytes{ 0 }; ///< Their payload bytes on the wire
+    uint64_t tx_uncompressed_bytes{ 0 }; ///< Payload bytes sent as they are
+    uint64_t rx_packets{ 0 }; ///< Packets received compressed
+    uint64_t rx_raw_bytes{ 0 }; ///< Their payload bytes after decompression
+    uint64_t rx_compressed_bytes{ 0 }; ///< Their payload bytes on the wire
+    uint64_t rx_uncompressed_bytes{ 0 }; ///< Payload bytes received as they are
+};
+
 class RpcCodec {
   public:
     void Write(net::SocketPtr& sock, RpcPacket *packet);
 
-    void Write(net::SocketPtr& sock, PacketType type, uint64_t seq, uint64_t method, const google::protobuf::Message *msg);
+    void Write(net::SocketPtr& sock, PacketType type, uint64_t seq, uint64_t method, const google::protobuf::Message *msg,
+               uint32_t timeout = 0, uint32_t flags = 0);
+    //Encodes the packet into buf, for requests waiting for the connection
+    bool Write(IOBuffer* buf, PacketType type, uint64_t seq, uint64_t method, const google::protobuf::Message *msg,
+               uint32_t timeout = 0, uint32_t flags = 0);
+    //Sends len bytes as they are as the payload, used by the streams
+    void Write(net::SocketPtr& sock, PacketType type, uint64_t seq, uint64_t method, const void* data, size_t len);
+
+    void Write(IOBuffer* buf, PacketType type, uint64_t seq, uint64_t method, const void* data, size_t len);
 
     PacketHeader* Read(net::SocketPtr& sock);
 
     google::protobuf::Message* Read(net::SocketPtr& sock, google::protobuf::Message* body, size_t len);
+    //Payload of the packet just read, inflated when it is compressed. Valid until Skip() consumes it.
+    const char* Peek(net::SocketPtr& sock, size_t len, size_t* size);
+    //Drops the body of a packet nobody waits for any more
+    void Skip(net::SocketPtr& sock, size_t len);
+    //Decodes a header written by this codec, returns its length
+    static size_t DecodeHeader(const char* p, PacketHeader* header);
+    //Sends a packet without payload, used by the negotiation and the errors of the calls
+    void WriteControl(net::SocketPtr& sock, PacketType type, uint64_t seq, uint64_t method, uint32_t flags);
+    //Sends the negotiation, flags in the header and features in the payload, see RPC_METHOD_NEGOTIATE
+    void WriteNegotiate(net::SocketPtr& sock, PacketType type, uint32_t flags, uint32_t features);
+    //Consumes the payload of the negotiation just read, returns the features in it, 0 if there are none
+    uint32_t ReadNegotiate(net::SocketPtr& sock, size_t len);
+  public:
+    /**
+     * @brief Payloads of at least threshold bytes are compressed from now on, 0 stops compressing
+     *
+     * @param threshold
+     */
+    void set_compress_threshold(size_t threshold) { compress_threshold_ = threshold; }
+
+    size_t get_compress_threshold() const { return compress_threshold_; }
+
+    const RpcCodecStats& get_stats() const { return stats_; }
+    //Bytes of the last message read, after decompression
+    size_t get_read_size() const { return read_size_; }
+    //Bytes of the last message written, before compression
+    size_t get_write_size() const { return write_size_; }
+
+    void set_write_size(size_t size) { write_size_ = size; }
+  private:
+    IOBuffer* Compress(const google::protobuf::Message *msg, PacketHeader* header);
+    //Deflates header->len bytes into packed_, false when it does not pay off
+    bool Deflate(const char* data, PacketHeader* header);
+    void ReleaseScratch();
   public:
     PacketHeader header_;
+  private:
+    size_t compress_threshold_{ 0 };
+    size_t read_size_{ 0 };
+    size_t write_size_{ 0 };
+    IOBuffer plain_; ///< Scratch buffers of the compression
+    IOBuffer packed_;
+    RpcCodecStats stats_;
 };
 }
 }
@@ -4,6 +4,7 @@
 #include "base/error_code.h"
 #include "base/clock.h"
 #include "logging/logging.h"
+#include <algorithm>
 namespace tinynet {
 namespace rpc {
 
@@ -11,7 +12,12 @@ void RpcController::Reset() {
     error_code_ = ERROR_OK;
     canceled_ = false;
     cancel_event_handler_ = nullptr;
+    cancel_callback_ = nullptr;
     send_time_ = Time_ms();
+    deadline_ = 0;
+    stream_.reset();
+    hash_key_ = 0;
+    has_hash_key_ = false;
 }
 
 bool RpcController::Failed() const {
@@ -24,8 +30,17 @@ std::string RpcController::ErrorText() const {
 
 void RpcController::StartCancel() {
     canceled_ = true;
+    if (cancel_callback_) {
+        //The done closure of the call runs inside, it may delete the controller
+        auto callback = std::move(cancel_callback_);
+        cancel_callback_ = nullptr;
+        callback();
+        return;
+    }
     if (cancel_event_handler_) {
-        cancel_event_handler_->Run();
+        auto handler = cancel_event_handler_;
+        cancel_event_handler_ = nullptr;
+        handler->Run();
     }
 }
 
@@ -39,6 +54,29 @@ bool RpcController::IsCanceled() const {
 void RpcController::NotifyOnCancel(google::protobuf::Closure* callback) {
     cancel_event_handler_ = callback;
 }
+
+void RpcController::SetTimeout(int64_t timeout_ms) {
+    deadline_ = STime_ms() + (std::max)(timeout_ms, (int64_t)1);
+}
+
+void RpcController::SetDeadline(int64_t deadline_ms) {
+    deadline_ = deadline_ms;
+}
+
+int64_t RpcController::get_remaining_ms() const {
+    if (deadline_ == 0) {
+        return -1;
+    }
+    return (std::max)(deadline_ - STime_ms(), (int64_t)0);
+}
+
+RpcStreamPtr RpcController::AcceptStream(uint32_t window) {
+    if (stream_ && !stream_->is_accepted()) {
+        stream_->Open(window);
+    }
+    return stream_;
+}
+
 void RpcController::Trace() {
     log_info("Rpc response time %lld", (Time_ms() - send_time_));
 }
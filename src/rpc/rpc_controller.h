@@ -1,7 +1,10 @@
 // Copyright (C), Xianfeng Shang.  All rights reserved.
 // Author: Xianfeng Shang (shangxianfeng@outlook.com)
 #pragma once
+#include <cstdint>
+#include <functional>
 #include "google/protobuf/service.h"
+#include "rpc_stream.h"
 namespace tinynet {
 namespace rpc {
 class RpcController :
@@ -20,13 +23,86 @@ class RpcController :
 
     int ErrorCode() const { return error_code_; }
 
+  public:
+    /**
+     * @brief Client side, the call fails with ERROR_RPC_TIMEOUT when no response arrived within timeout_ms.
+     * Set before CallMethod(), the server receives the time left along with the request.
+     *
+     * @param timeout_ms
+     */
+    void SetTimeout(int64_t timeout_ms);
+    /**
+     * @brief Same as SetTimeout() with a point in time of the steady clock, see STime_ms()
+     *
+     * @param deadline_ms
+     */
+    void SetDeadline(int64_t deadline_ms);
+
+    int64_t get_deadline() const { return deadline_; }
+    /**
+     * @brief Milliseconds left before the deadline, 0 once it passed and -1 without deadline
+     *
+     * @return int64_t
+     */
+    int64_t get_remaining_ms() const;
+    /**
+     * @brief Server side, whether the caller has given up on the call already
+     *
+     * @return true
+     * @return false
+     */
+    bool IsExpired() const { return get_remaining_ms() == 0; }
+    /**
+     * @brief Installed by the channel while the call is in flight, StartCancel() aborts the call with it
+     *
+     * @param callback
+     */
+    void set_cancel_callback(std::function<void()> callback) { cancel_callback_ = std::move(callback); }
+  public:
+    /**
+     * @brief Client side, opens the stream along with the next call made with this controller.
+     * The stream breaks if the call fails before the service accepted it. A server which did not
+     * negotiate streams gets nothing, the call fails with ERROR_RPC_STREAMUNSUPPORTED on this side.
+     *
+     * @param stream a new stream
+     */
+    void set_stream(RpcStreamPtr stream) { stream_ = std::move(stream); }
+
+    const RpcStreamPtr& get_stream() const { return stream_; }
+    /**
+     * @brief Server side, takes the stream the caller opened, nullptr if it opened none.
+     * A stream not accepted by the time the response is sent is refused.
+     *
+     * @param window see RpcStream::RpcStream(), 0 for the default one
+     * @return RpcStreamPtr
+     */
+    RpcStreamPtr AcceptStream(uint32_t window = 0);
+    /**
+     * @brief Client side, the calls with the same key go through the same connection of a pool routing by hash,
+     * see RpcChannelPool
+     *
+     * @param key
+     */
+    void set_hash_key(uint64_t key) {
+        hash_key_ = key;
+        has_hash_key_ = true;
+    }
+
+    bool has_hash_key() const { return has_hash_key_; }
+
+    uint64_t get_hash_key() const { return hash_key_; }
   public:
     void Trace();
   private:
-    int error_code_;
+    int error_code_{ 0 };
     bool canceled_{false};
     google::protobuf::Closure *cancel_event_handler_{nullptr};
-    int64_t send_time_;
+    std::function<void()> cancel_callback_;
+    int64_t send_time_{ 0 };
+    int64_t deadline_{ 0 };
+    RpcStreamPtr stream_;
+    uint64_t hash_key_{ 0 };
+    bool has_hash_key_{ false };
 };
 }
 }
\ No newline at end of file
@@ -3,6 +3,8 @@
 #include "rpc_info.h"
 #include "rpc_controller.h"
 #include "rpc_helper.h"
+#include "base/clock.h"
+#include "base/error_code.h"
 namespace tinynet {
 namespace rpc {
 RpcInfo::RpcInfo(uint64_t seq, google::protobuf::RpcController *controller, const google::protobuf::Message *request,
@@ -27,6 +29,8 @@ RpcInfo::RpcInfo(uint64_t seq, const google::protobuf::Message* request, google:
 }
 
 RpcInfo::~RpcInfo() {
+    //Dropped without an answer
+    End(ERROR_RPC_CHANNELERROR);
     if (delete_members_) {
         if (controller_) {
             delete controller_;
@@ -48,12 +52,38 @@ RpcInfo::~RpcInfo() {
 }
 
 void RpcInfo::Run(int err) {
+    End(err);
     auto c = static_cast<RpcController*>(controller_);
+    if (c) {
+        c->set_cancel_callback(nullptr);
+    }
     if (c && err) {
         c->SetFailed(err);
     }
     ClosureGuard guard(done_);
     done_ = nullptr;
 }
+
+void RpcInfo::Detach() {
+    End(ERROR_RPC_CHANNELERROR);
+    auto c = static_cast<RpcController*>(controller_);
+    if (c) {
+        c->set_cancel_callback(nullptr);
+    }
+}
+
+void RpcInfo::Begin(RpcMethodMetrics* metrics) {
+    metrics_ = metrics;
+    start_us_ = STime_us();
+    metrics->Begin();
+}
+
+void RpcInfo::End(int err) {
+    if (!metrics_) {
+        return;
+    }
+    metrics_->End(err, STime_us() - start_us_);
+    metrics_ = nullptr;
+}
 }
 }
@@ -4,6 +4,8 @@
 #include <memory>
 #include "google/protobuf/message.h"
 #include "google/protobuf/service.h"
+#include "net/timer_manager.h"
+#include "rpc_metrics.h"
 
 namespace tinynet {
 namespace rpc {
@@ -11,7 +13,9 @@ class RpcInfo;
 typedef std::shared_ptr<RpcInfo> RpcInfoPtr;
 
 class RpcInfo {
+    friend class RpcCallMap;
   public:
+    RpcInfo() = default;
     RpcInfo(uint64_t seq, google::protobuf::RpcController *controller, const google::protobuf::Message *request,
             google::protobuf::Message *response, google::protobuf::Closure *done);
     RpcInfo(uint64_t seq, const google::protobuf::Message* request, google::protobuf::Message *response);
@@ -30,15 +34,33 @@ class RpcInfo {
 
     template<class T>
     T* get_response() { return static_cast<T*>(response_); }
+
+    TimerId& get_timer_id() { return timer_id_; }
+
+    void set_timer_id(TimerId timer_id) { timer_id_ = timer_id; }
+
+    RpcInfo* get_next() { return next_; }
+
+    RpcMethodMetrics* get_metrics() { return metrics_; }
   public:
     void Run(int err);
+    //The channel goes away without completing the call, the controller must not reach it any more
+    void Detach();
+    //Counts the call in metrics and starts timing it, End() or Run() completes it
+    void Begin(RpcMethodMetrics* metrics);
+
+    void End(int err);
   private:
-    uint64_t seq_;
-    google::protobuf::RpcController *controller_;
-    const google::protobuf::Message *request_;
-    google::protobuf::Message *response_;
-    google::protobuf::Closure *done_;
-    bool delete_members_;
+    uint64_t seq_{ 0 };
+    google::protobuf::RpcController *controller_{ nullptr };
+    const google::protobuf::Message *request_{ nullptr };
+    google::protobuf::Message *response_{ nullptr };
+    google::protobuf::Closure *done_{ nullptr };
+    bool delete_members_{ false };
+    TimerId timer_id_{ INVALID_TIMER_ID }; ///< Deadline timer of a client call
+    RpcInfo* next_{ nullptr }; ///< Chain of the RpcCallMap bucket or free list
+    RpcMethodMetrics* metrics_{ nullptr }; ///< Counters of the method while the call is in flight
+    int64_t start_us_{ 0 };
 };
 }
 }
@@ -1,6 +1,8 @@
 // Copyright (C), Xianfeng Shang.  All rights reserved.
 // Author: Xianfeng Shang (shangxianfeng@outlook.com)
 #include "rpc_method.h"
+#include <unordered_map>
+#include "util/string_utils.h"
 namespace tinynet {
 namespace rpc {
 RpcMethod::RpcMethod(std::shared_ptr<google::protobuf::Service> service, const google::protobuf::MethodDescriptor* descriptor) :
@@ -14,5 +16,17 @@ google::protobuf::Message* RpcMethod::NewRequest() {
 google::protobuf::Message* RpcMethod::NewResponse() {
     return service_->GetResponsePrototype(descriptor_).New();
 }
+
+uint64_t RpcMethod::GetMethodId(const google::protobuf::MethodDescriptor* descriptor) {
+    //The descriptors of the generated pool live as long as the process
+    thread_local static std::unordered_map<const google::protobuf::MethodDescriptor*, uint64_t> method_ids;
+    auto it = method_ids.find(descriptor);
+    if (it != method_ids.end()) {
+        return it->second;
+    }
+    uint64_t method_id = StringUtils::Hash3(descriptor->full_name().c_str());
+    method_ids.emplace(descriptor, method_id);
+    return method_id;
+}
 }
 }
@@ -3,7 +3,10 @@
 #pragma once
 #include "google/protobuf/service.h"
 #include "google/protobuf/message.h"
+#include <cstdint>
 #include <memory>
+#include "rpc_worker_pool.h"
+#include "rpc_metrics.h"
 namespace tinynet {
 namespace rpc {
 class RpcMethod;
@@ -22,9 +25,34 @@ class RpcMethod {
   public:
     google::protobuf::Message* NewRequest();
     google::protobuf::Message* NewResponse();
+  public:
+    /**
+     * @brief Workers running the method, nullptr to run it on the event loop of the server
+     *
+     * @param pool
+     */
+    void set_worker_pool(RpcWorkerPoolPtr pool) { pool_ = std::move(pool); }
+
+    const RpcWorkerPoolPtr& get_worker_pool() const { return pool_; }
+    //Counters of the calls served, those of the loop of the server, resolved by its first call
+    RpcMethodMetrics* get_metrics() {
+        if (!metrics_) metrics_ = RpcMetrics::Instance()->GetServerMetrics(descriptor_);
+        return metrics_;
+    }
+  public:
+    /**
+     * @brief Dispatch id of the method in the packet header, the hash of its full name.
+     * Computed once per method and thread, clients and servers use the same ids.
+     *
+     * @param descriptor
+     * @return uint64_t
+     */
+    static uint64_t GetMethodId(const google::protobuf::MethodDescriptor* descriptor);
   private:
     std::shared_ptr<google::protobuf::Service> service_;
     const google::protobuf::MethodDescriptor* descriptor_;
+    RpcWorkerPoolPtr pool_;
+    RpcMethodMetrics* metrics_{ nullptr };
 };
 }
 }
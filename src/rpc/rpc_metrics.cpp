@@ -0,0 +1,198 @@
+// Copyright (C), Xianfeng Shang.  All rights reserved.
+// Author: Xianfeng Shang (shangxianfeng@outlook.com)
+#include "rpc_metrics.h"
+#include "rpc_method.h"
+#include "util/string_utils.h"
+#include <algorithm>
+#include <cmath>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+namespace tinynet {
+namespace rpc {
+
+static inline int Log2Floor(uint64_t value) {
+#ifdef _MSC_VER
+    unsigned long index;
+    _BitScanReverse64(&index, value);
+    return (int)index;
+#else
+    return 63 - __builtin_clzll(value);
+#endif
+}
+
+int RpcLatencyHistogram::GetBucket(uint64_t value_us) {
+    //Below 2 * SUB_BUCKETS every value has a bucket of its own
+    if (value_us < (uint64_t)(2 * SUB_BUCKETS)) {
+        return (int)value_us;
+    }
+    int exponent = Log2Floor(value_us);
+    if (exponent >= MAX_EXPONENT) {
+        return BUCKETS - 1;
+    }
+    int sub_bucket = (int)(value_us >> (exponent - SUB_BUCKET_BITS)) & (SUB_BUCKETS - 1);
+    return (exponent - SUB_BUCKET_BITS + 1) * SUB_BUCKETS + sub_bucket;
+}
+
+uint64_t RpcLatencyHistogram::GetUpperBound(int bucket) {
+    if (bucket + 1 < 2 * SUB_BUCKETS) {
+        return (uint64_t)bucket;
+    }
+    if (bucket >= BUCKETS - 1) {
+        return UINT64_MAX;
+    }
+    //Lower bound of the next bucket
+    int next = bucket + 1;
+    int exponent = next / SUB_BUCKETS + SUB_BUCKET_BITS - 1;
+    uint64_t lower = (uint64_t)(SUB_BUCKETS + next % SUB_BUCKETS) << (exponent - SUB_BUCKET_BITS);
+    return lower - 1;
+}
+
+uint64_t RpcLatencyHistogram::GetPercentile(const std::vector<uint64_t>& counts, uint64_t total, double percentile) {
+    if (total == 0) {
+        return 0;
+    }
+    uint64_t rank = (std::max)((uint64_t)std::ceil(percentile * (double)total), (uint64_t)1);
+    uint64_t seen = 0;
+    for (size_t i = 0; i < counts.size(); ++i) {
+        seen += counts[i];
+        if (seen >= rank) {
+            return GetUpperBound((int)i);
+        }
+    }
+    return GetUpperBound((int)counts.size() - 1);
+}
+
+void RpcLatencyHistogram::Collect(std::vector<uint64_t>* counts) const {
+    counts->resize(BUCKETS);
+    for (int i = 0; i < BUCKETS; ++i) {
+        (*counts)[i] += buckets_[i].load(std::memory_order_relaxed);
+    }
+}
+
+RpcMethodMetrics::RpcMethodMetrics(uint64_t method_id, const std::string& name, bool server) :
+    method_id_(method_id),
+    name_(name),
+    server_(server) {
+}
+
+void RpcMethodMetrics::End(int err, int64_t elapsed_us) {
+    if (err) {
+        AddCounter(errors_, 1);
+    }
+    uint64_t value = elapsed_us > 0 ? (uint64_t)elapsed_us : 0;
+    AddCounter(total_us_, value);
+    latency_.Record(value);
+}
+
+void RpcMethodMetrics::Collect(RpcMethodStats* stats, std::vector<uint64_t>* counts) const {
+    stats->name = name_;
+    stats->method_id = method_id_;
+    stats->server = server_;
+    stats->calls += calls_.load(std::memory_order_relaxed);
+    stats->errors += errors_.load(std::memory_order_relaxed);
+    stats->request_bytes += request_bytes_.load(std::memory_order_relaxed);
+    stats->response_bytes += response_bytes_.load(std::memory_order_relaxed);
+    stats->total_us += total_us_.load(std::memory_order_relaxed);
+    latency_.Collect(counts);
+}
+
+//Fills the fields derived from the merged latencies
+static void SetLatencyStats(RpcMethodStats* stats, const std::vector<uint64_t>& counts) {
+    uint64_t total = 0;
+    int highest = -1;
+    for (int i = 0; i < (int)counts.size(); ++i) {
+        if (counts[i]) {
+            total += counts[i];
+            highest = i;
+        }
+    }
+    //Read apart from the histogram, a call completing meanwhile must not show up as -1
+    stats->in_flight = (std::max)((int64_t)(stats->calls - total), (int64_t)0);
+    stats->p50_us = RpcLatencyHistogram::GetPercentile(counts, total, 0.5);
+    stats->p99_us = RpcLatencyHistogram::GetPercentile(counts, total, 0.99);
+    stats->p999_us = RpcLatencyHistogram::GetPercentile(counts, total, 0.999);
+    stats->max_us = highest >= 0 ? RpcLatencyHistogram::GetUpperBound(highest) : 0;
+}
+
+RpcMethodMetrics* RpcMetrics::GetClientMetrics(const google::protobuf::MethodDescriptor* method) {
+    return Get(method, false);
+}
+
+RpcMethodMetrics* RpcMetrics::GetServerMetrics(const google::protobuf::MethodDescriptor* method) {
+    return Get(method, true);
+}
+
+RpcMethodMetrics* RpcMetrics::Get(const google::protobuf::MethodDescriptor* method, bool server) {
+    //The descriptors of the generated pool live as long as the process
+    using Cache = std::unordered_map<const google::protobuf::MethodDescriptor*, RpcMethodMetrics*>;
+    thread_local static Cache caches[2];
+    //Calls in a row mostly go to the same method
+    thread_local static const google::protobuf::MethodDescriptor* last_method[2] = { nullptr, nullptr };
+    thread_local static RpcMethodMetrics* last_metrics[2] = { nullptr, nullptr };
+    int side = server ? 1 : 0;
+    if (last_method[side] == method) {
+        return last_metrics[side];
+    }
+    Cache& cache = caches[side];
+    auto it = cache.find(method);
+    RpcMethodMetrics* metrics;
+    if (it != cache.end()) {
+        metrics = it->second;
+    } else {
+        metrics = Create(method, server);
+        cache.emplace(method, metrics);
+    }
+    last_method[side] = method;
+    last_metrics[side] = metrics;
+    return metrics;
+}
+
+RpcMethodMetrics* RpcMetrics::Create(const google::protobuf::MethodDescriptor* method, bool server) {
+    uint64_t method_id = RpcMethod::GetMethodId(method);
+    std::unique_ptr<RpcMethodMetrics> metrics(new RpcMethodMetrics(method_id, method->full_name(), server));
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto& threads = (server ? server_ : client_)[method_id];
+    threads.push_back(std::move(metrics));
+    return threads.back().get();
+}
+
+void RpcMetrics::Collect(std::vector<RpcMethodStats>* stats) {
+    std::vector<uint64_t> counts;
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto map : { &client_, &server_ }) {
+        for (auto& it : *map) {
+            stats->emplace_back();
+            counts.assign(RpcLatencyHistogram::BUCKETS, 0);
+            for (auto& metrics : it.second) {
+                metrics->Collect(&stats->back(), &counts);
+            }
+            SetLatencyStats(&stats->back(), counts);
+        }
+    }
+}
+
+void RpcMetrics::Dump(std::string* output) {
+    std::vector<RpcMethodStats> stats;
+    Collect(&stats);
+    std::sort(stats.begin(), stats.end(), [](const RpcMethodStats& a, const RpcMethodStats& b) {
+        return a.server != b.server ? a.server < b.server : a.name < b.name;
+    });
+    for (auto& s : stats) {
+        const char* side = s.server ? "server" : "client";
+        const char* name = s.name.c_str();
+        StringUtils::Format(*output, "rpc_calls{side=\"%s\",method=\"%s\"} %llu\n", side, name, (unsigned long long)s.calls);
+        StringUtils::Format(*output, "rpc_errors{side=\"%s\",method=\"%s\"} %llu\n", side, name, (unsigned long long)s.errors);
+        StringUtils::Format(*output, "rpc_in_flight{side=\"%s\",method=\"%s\"} %lld\n", side, name, (long long)s.in_flight);
+        StringUtils::Format(*output, "rpc_request_bytes{side=\"%s\",method=\"%s\"} %llu\n", side, name, (unsigned long long)s.request_bytes);
+        StringUtils::Format(*output, "rpc_response_bytes{side=\"%s\",method=\"%s\"} %llu\n", side, name, (unsigned long long)s.response_bytes);
+        StringUtils::Format(*output, "rpc_latency_us_sum{side=\"%s\",method=\"%s\"} %llu\n", side, name, (unsigned long long)s.total_us);
+        StringUtils::Format(*output, "rpc_latency_us{side=\"%s\",method=\"%s\",quantile=\"0.5\"} %llu\n", side, name, (unsigned long long)s.p50_us);
+        StringUtils::Format(*output, "rpc_latency_us{side=\"%s\",method=\"%s\",quantile=\"0.99\"} %llu\n", side, name, (unsigned long long)s.p99_us);
+        StringUtils::Format(*output, "rpc_latency_us{side=\"%s\",method=\"%s\",quantile=\"0.999\"} %llu\n", side, name, (unsigned long long)s.p999_us);
+        StringUtils::Format(*output, "rpc_latency_us_max{side=\"%s\",method=\"%s\"} %llu\n", side, name, (unsigned long long)s.max_us);
+    }
+}
+}
+}
@@ -0,0 +1,161 @@
+// Copyright (C), Xianfeng Shang.  All rights reserved.
+// Author: Xianfeng Shang (shangxianfeng@outlook.com)
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "google/protobuf/descriptor.h"
+#include "base/singleton.h"
+
+namespace tinynet {
+namespace rpc {
+
+/**
+ * @brief Snapshot of the counters of one method on one side, see RpcMetrics::Collect()
+ *
+ */
+struct RpcMethodStats {
+    std::string name; ///< Full name of the method
+    uint64_t method_id{ 0 }; ///< Id of the method in the packets, see RpcMethod::GetMethodId()
+    bool server{ false }; ///< Calls served, or made as a client
+    uint64_t calls{ 0 }; ///< Calls started
+    uint64_t errors{ 0 }; ///< Calls completed with an error
+    int64_t in_flight{ 0 }; ///< Calls started and not completed yet
+    uint64_t request_bytes{ 0 }; ///< Bytes of the request messages, before compression
+    uint64_t response_bytes{ 0 }; ///< Bytes of the response messages, before compression
+    uint64_t total_us{ 0 }; ///< Sum of the latencies of the calls completed
+    uint64_t p50_us{ 0 };
+    uint64_t p99_us{ 0 };
+    uint64_t p999_us{ 0 };
+    uint64_t max_us{ 0 }; ///< Upper bound of the highest bucket used
+};
+
+//Adds value to a counter written by a single thread, a plain add without the lock prefix of fetch_add.
+//Other threads may still load the counter at any time.
+inline void AddCounter(std::atomic<uint64_t>& counter, uint64_t value) {
+    counter.store(counter.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+}
+
+//Latencies in microseconds counted in the log-linear buckets of HdrHistogram: 8 buckets per power of 2,
+//so a percentile is off by 12.5% at most. Written by one thread, see RpcMethodMetrics.
+class RpcLatencyHistogram {
+  public:
+    static const int SUB_BUCKET_BITS = 3;
+    static const int SUB_BUCKETS = 1 << SUB_BUCKET_BITS;
+    static const int MAX_EXPONENT = 36; ///< Latencies from 2^36us, 19 hours, share the last bucket
+    static const int BUCKETS = (MAX_EXPONENT - SUB_BUCKET_BITS + 1) * SUB_BUCKETS;
+  public:
+    void Record(uint64_t value_us) { AddCounter(buckets_[GetBucket(value_us)], 1); }
+    /**
+     * @brief Adds the counts of the buckets to counts
+     *
+     * @param counts resized to BUCKETS
+     */
+    void Collect(std::vector<uint64_t>* counts) const;
+  public:
+    static int GetBucket(uint64_t value_us);
+    /**
+     * @brief Highest value counted in bucket
+     *
+     * @param bucket
+     * @return uint64_t
+     */
+    static uint64_t GetUpperBound(int bucket);
+    /**
+     * @brief Upper bound of the bucket holding the value of rank percentile * total
+     *
+     * @param counts see Collect()
+     * @param total sum of counts
+     * @param percentile in [0, 1]
+     * @return uint64_t
+     */
+    static uint64_t GetPercentile(const std::vector<uint64_t>& counts, uint64_t total, double percentile);
+  private:
+    std::atomic<uint64_t> buckets_[BUCKETS] {};
+};
+
+//Counters of the calls of one method on one side, made on one thread.
+//Every thread has its own copy so the counters take plain adds, no atomic read-modify-write
+//and no cache line bouncing between the loops. RpcMetrics::Collect() merges the threads.
+//A call is counted by the thread that started it, completing it on another thread is safe
+//but may lose a count to the race.
+//The calls in flight are the calls started minus the latencies recorded.
+class RpcMethodMetrics {
+  public:
+    RpcMethodMetrics(uint64_t method_id, const std::string& name, bool server);
+  public:
+    void Begin() { AddCounter(calls_, 1); }
+
+    void End(int err, int64_t elapsed_us);
+
+    void AddRequestBytes(size_t len) { AddCounter(request_bytes_, len); }
+
+    void AddResponseBytes(size_t len) { AddCounter(response_bytes_, len); }
+    /**
+     * @brief Adds the counters to stats and the latencies to counts
+     *
+     * @param stats
+     * @param counts see RpcLatencyHistogram::Collect()
+     */
+    void Collect(RpcMethodStats* stats, std::vector<uint64_t>* counts) const;
+  private:
+    const uint64_t method_id_;
+    const std::string name_;
+    const bool server_;
+    std::atomic<uint64_t> calls_{ 0 };
+    std::atomic<uint64_t> errors_{ 0 };
+    std::atomic<uint64_t> request_bytes_{ 0 };
+    std::atomic<uint64_t> response_bytes_{ 0 };
+    std::atomic<uint64_t> total_us_{ 0 };
+    RpcLatencyHistogram latency_;
+};
+
+//Process-wide registry of the counters of the methods by method id, for clients and servers apart.
+//The counters live as long as the process, channels and methods keep plain pointers to them.
+//Those of a thread that exited stay in the totals.
+class RpcMetrics :
+    public tinynet::Singleton<RpcMetrics> {
+  public:
+    /**
+     * @brief Counters of the calls to method made on the calling thread, lock-free once it has used them
+     *
+     * @param method
+     * @return RpcMethodMetrics*
+     */
+    RpcMethodMetrics* GetClientMetrics(const google::protobuf::MethodDescriptor* method);
+    /**
+     * @brief Counters of the calls of method served on the calling thread, see GetClientMetrics()
+     *
+     * @param method
+     * @return RpcMethodMetrics*
+     */
+    RpcMethodMetrics* GetServerMetrics(const google::protobuf::MethodDescriptor* method);
+    /**
+     * @brief Snapshot of the counters of every method used so far
+     *
+     * @param stats
+     */
+    void Collect(std::vector<RpcMethodStats>* stats);
+    /**
+     * @brief Text exposition of the snapshot, one "name{labels} value" line per counter
+     *
+     * @param output
+     */
+    void Dump(std::string* output);
+  private:
+    RpcMethodMetrics* Get(const google::protobuf::MethodDescriptor* method, bool server);
+
+    RpcMethodMetrics* Create(const google::protobuf::MethodDescriptor* method, bool server);
+  private:
+    using MetricsMap = std::unordered_map<uint64_t, std::vector<std::unique_ptr<RpcMethodMetrics>>>; ///< One per thread
+  private:
+    std::mutex mutex_;
+    MetricsMap client_;
+    MetricsMap server_;
+};
+}
+}
@@ -27,6 +27,8 @@ RPC fragment header
 +-+-+-+---------+-------------------------------+--------------+
 |					seq(4/8bytes)							   |
 +-+-+-+---------+-------------------------------+--------------+
+|					timeout(4 bytes, PACKET_FLAG_TIMEOUT only)  |
++-+-+-+---------+-------------------------------+--------------+
 |					payload data							   |
 +-+-+-+---------+-------------------------------+--------------+
 |					payload data continued					   |
@@ -37,20 +39,59 @@ typedef std::shared_ptr<RpcPacket> RpcPacketPtr;
 
 enum class PacketType: uint32_t {
     REQUEST,
-    RESPONSE
+    RESPONSE,
+    STREAM_DATA, ///< One message of the stream named by seq
+    STREAM_CREDIT, ///< The method field holds the bytes the receiver consumed since its last credit
+    STREAM_CLOSE, ///< The sender writes no more messages, the other direction goes on
+    STREAM_RESET ///< The method field holds the error code, the stream is gone in both directions
 };
 
+//The low 16 bits of the type field hold the packet type, the high 16 bits the flags
+constexpr uint32_t PACKET_TYPE_MASK = 0xffff;
+//Request with a deadline, the milliseconds left when it was sent follow the header.
+//Only sent to peers which accepted it, see RPC_METHOD_NEGOTIATE, the caller times out on its own otherwise.
+constexpr uint32_t PACKET_FLAG_TIMEOUT = 1 << 16;
+//The payload is deflated with zlib, only sent to peers which accepted it, see RPC_METHOD_NEGOTIATE.
+constexpr uint32_t PACKET_FLAG_COMPRESSED = 1 << 17;
+
+//Request opening a stream, its sequence is the stream id in both directions, see RpcStream.
+//Only set when the caller attached a stream to the call, and only sent to peers which accepted it:
+//the STREAM_* packets go along, a server predating them closes the connection on them.
+constexpr uint32_t PACKET_FLAG_STREAM = 1 << 18;
+
+//Response of a call the server did not run, the method field holds the error code and no payload follows.
+//Only sent when the server sheds the call, see RpcWorkerPool, and only to peers which accepted it.
+constexpr uint32_t PACKET_FLAG_ERROR = 1 << 19;
+
+constexpr uint32_t PACKET_FLAGS_KNOWN = PACKET_FLAG_TIMEOUT | PACKET_FLAG_COMPRESSED | PACKET_FLAG_STREAM | PACKET_FLAG_ERROR;
+
+//Empty request of sequence 0 sent first by a client, its flags tell what the client accepts
+//(PACKET_FLAG_COMPRESSED, PACKET_FLAG_TIMEOUT), the flags of the empty response what the server accepts.
+//Servers older than the flags close the connection, the client then stops asking.
+//A 4 bytes payload holds the flags understood in the other packets (PACKET_FEATURES_NEGOTIATED).
+//Peers predating it send none and skip the one they get, they understand none of these flags.
+constexpr uint64_t RPC_METHOD_NEGOTIATE = 0;
+
+constexpr uint32_t PACKET_FEATURES_NEGOTIATED = PACKET_FLAG_ERROR | PACKET_FLAG_STREAM;
+
 struct PacketHeader {
     uint32_t type ; //type field indicates the packet whether a request packet or a response packet.
     uint32_t len;
     uint64_t method;
     uint64_t seq;
+    uint32_t flags{ 0 };
+    uint32_t timeout{ 0 }; ///< Milliseconds left before the caller gives up, with PACKET_FLAG_TIMEOUT
 };
 
 constexpr size_t RPC_PACKET_HEADER_LEN = 24;
 
+constexpr size_t RPC_PACKET_TIMEOUT_LEN = 4;
+
 constexpr size_t MAX_RPC_PACKET_LEN = 256 * 1024 * 1024; //256M
 
+//Bytes a stream may send before the receiver granted its window, each message counts its payload and a header
+constexpr uint32_t RPC_STREAM_INITIAL_WINDOW = 64 * 1024;
+
 struct RpcPacket {
     PacketHeader header;
     std::string body;
@@ -45,17 +45,30 @@ uint64_t RpcServer::Now() {
 }
 
 net::SocketChannelPtr RpcServer::CreateChannel(net::SocketPtr sock) {
-    return std::make_shared<RpcChannel>(std::move(sock), this);
+    auto channel = std::make_shared<RpcChannel>(std::move(sock), this);
+    channel->set_compress_threshold(compress_threshold_);
+    return channel;
 }
 
-void RpcServer::RegisterService(std::shared_ptr<google::protobuf::Service> service) {
+void RpcServer::RegisterService(std::shared_ptr<google::protobuf::Service> service, RpcWorkerPoolPtr pool) {
     const google::protobuf::ServiceDescriptor* serviceDescriptor = service->GetDescriptor();
     for (int i = 0; i < serviceDescriptor->method_count(); ++i) {
         const google::protobuf::MethodDescriptor *methodDescriptor = serviceDescriptor->method(i);
-        uint64_t method_id = StringUtils::Hash3(methodDescriptor->full_name().c_str());
-        methods_[method_id] = std::make_shared<RpcMethod>(service, methodDescriptor);
+        uint64_t method_id = RpcMethod::GetMethodId(methodDescriptor);
+        auto method = std::make_shared<RpcMethod>(service, methodDescriptor);
+        method->set_worker_pool(pool);
+        methods_[method_id] = std::move(method);
     }
 }
+
+int RpcServer::SetWorkerPool(const std::string& method_name, RpcWorkerPoolPtr pool) {
+    auto method = GetMethod(StringUtils::Hash3(method_name.c_str()));
+    if (!method) {
+        return ERROR_RPC_METHODNOTFOUND;
+    }
+    method->set_worker_pool(std::move(pool));
+    return ERROR_OK;
+}
 RpcMethodPtr RpcServer::GetMethod(uint64_t method_id) {
     auto it = methods_.find(method_id);
     if (it == methods_.end()) {
@@ -66,9 +79,12 @@ RpcMethodPtr RpcServer::GetMethod(uint64_t method_id) {
 
 void RpcServer::SendResponse(int64_t guid, RpcInfoPtr rpc) {
     auto channel = GetChannel<RpcChannel>(guid);
-    if (channel) {
-        channel->SendResponse(std::move(rpc));
+    if (!channel) {
+        //Closed while the method ran
+        rpc->End(ERROR_RPC_CHANNELERROR);
+        return;
     }
+    channel->SendResponse(std::move(rpc));
 }
 }
 }
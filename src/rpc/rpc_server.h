@@ -31,19 +31,26 @@ class RpcServer:
     //virtual RpcChannelPtr CreateChannel(const std::string& ip, int port);
     uint64_t Now();
   public:
-    //Register a service
-    void RegisterService(std::shared_ptr<google::protobuf::Service> service);
+    //Register a service, its methods run on the workers of pool if given instead of the loop.
+    //Streams are not thread safe: such methods take none, requests opening one fail with ERROR_RPC_STREAMREFUSED.
+    void RegisterService(std::shared_ptr<google::protobuf::Service> service, RpcWorkerPoolPtr pool = nullptr);
+    //Runs a method registered already on the workers of pool, or on the loop with nullptr.
+    //Same restriction as RegisterService(), a method using streams must stay on the loop.
+    int SetWorkerPool(const std::string& method_name, RpcWorkerPoolPtr pool);
   public:
     using METHOD_MAP = std::unordered_map<uint64_t, RpcMethodPtr>;
     const METHOD_MAP& get_methods() { return methods_; }
     RpcMethodPtr GetMethod(uint64_t method_id);
     void SendResponse(int64_t guid, RpcInfoPtr rpc);
+    //Responses of at least threshold bytes are compressed for the clients asking for it, 0 disables it
+    void set_compress_threshold(size_t threshold) { compress_threshold_ = threshold; }
   private:
     using CHANNEL_MAP = std::unordered_map<int64_t, RpcChannelPtr>;
     using CHANNEL_ID_SET = std::unordered_set<int64_t>;
   private:
     METHOD_MAP			methods_;
     net::ServerOptions	opts_;
+    size_t				compress_threshold_{ 0 };
 };
 }
 }
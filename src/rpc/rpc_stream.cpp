@@ -0,0 +1,162 @@
+// Copyright (C), Xianfeng Shang.  All rights reserved.
+// Author: Xianfeng Shang (shangxianfeng@outlook.com)
+#include "rpc_stream.h"
+#include "rpc_channel.h"
+#include "base/error_code.h"
+#include <algorithm>
+
+namespace tinynet {
+namespace rpc {
+
+RpcStream::RpcStream(uint32_t window):
+    window_((std::max)(window, RPC_STREAM_INITIAL_WINDOW)) {
+}
+
+RpcStream::~RpcStream() = default;
+
+int RpcStream::Write(const google::protobuf::Message& msg) {
+    if (error_) return error_;
+    if (!channel_ || local_closed_) return ERROR_RPC_STREAMCLOSED;
+    if (credit_ <= 0) return ERROR_RPC_STREAMFULL;
+    credit_ -= (int64_t)(msg.ByteSize() + RPC_PACKET_HEADER_LEN);
+    return channel_->SendStream(id_, msg);
+}
+
+int RpcStream::Write(const void* data, size_t len) {
+    if (error_) return error_;
+    if (!channel_ || local_closed_) return ERROR_RPC_STREAMCLOSED;
+    if (credit_ <= 0) return ERROR_RPC_STREAMFULL;
+    if (len >= MAX_RPC_PACKET_LEN) return ERROR_RPC_MESSAGETOOLONG;
+    credit_ -= (int64_t)(len + RPC_PACKET_HEADER_LEN);
+    channel_->SendStream(PacketType::STREAM_DATA, id_, 0, data, len);
+    return ERROR_OK;
+}
+
+void RpcStream::Close() {
+    if (!channel_ || local_closed_) {
+        return;
+    }
+    local_closed_ = true;
+    channel_->SendStream(PacketType::STREAM_CLOSE, id_, 0, nullptr, 0);
+    if (remote_closed_) {
+        Finish();
+    }
+}
+
+void RpcStream::Reset(int err) {
+    if (!channel_) {
+        return;
+    }
+    error_ = err ? err : ERROR_RPC_STREAMCLOSED;
+    received_.clear();
+    channel_->SendStream(PacketType::STREAM_RESET, id_, (uint64_t)(int64_t)error_, nullptr, 0);
+    Finish();
+}
+
+void RpcStream::set_message_callback(MessageCallback callback) {
+    message_callback_ = std::move(callback);
+    while (message_callback_ && !received_.empty()) {
+        std::string msg = std::move(received_.front());
+        received_.pop_front();
+        message_callback_(msg.data(), msg.size());
+        Consume(msg.size());
+    }
+    if (remote_closed_ && received_.empty() && !error_) {
+        NotifyClose(ERROR_OK);
+    }
+}
+
+void RpcStream::Attach(RpcChannel* channel, uint64_t id) {
+    channel_ = channel;
+    id_ = id;
+}
+
+void RpcStream::Open(uint32_t window) {
+    if (window) {
+        window_ = (std::max)(window, RPC_STREAM_INITIAL_WINDOW);
+    }
+    accepted_ = true;
+    if (channel_ && window_ > granted_) {
+        channel_->SendStream(PacketType::STREAM_CREDIT, id_, window_ - granted_, nullptr, 0);
+        granted_ = window_;
+    }
+}
+
+void RpcStream::OnData(const char* data, size_t len) {
+    if (remote_closed_) {
+        return;
+    }
+    if (message_callback_ && received_.empty()) {
+        message_callback_(data, len);
+        Consume(len);
+        return;
+    }
+    received_.emplace_back(data, len);
+}
+
+void RpcStream::OnCredit(uint64_t bytes) {
+    bool blocked = credit_ <= 0;
+    credit_ += (int64_t)(std::min)(bytes, (uint64_t)UINT32_MAX);
+    if (blocked && credit_ > 0 && writable_callback_) {
+        writable_callback_();
+    }
+}
+
+void RpcStream::OnClose() {
+    if (remote_closed_) {
+        return;
+    }
+    remote_closed_ = true;
+    if (received_.empty()) {
+        NotifyClose(ERROR_OK);
+    }
+    if (local_closed_) {
+        Finish();
+    }
+}
+
+void RpcStream::OnReset(int err) {
+    channel_ = nullptr;
+    error_ = err ? err : ERROR_RPC_STREAMCLOSED;
+    received_.clear();
+    NotifyClose(error_);
+    if (!local_closed_ && writable_callback_) {
+        //A writer waiting for credit learns it from Write()
+        writable_callback_();
+    }
+}
+
+void RpcStream::Detach(int err) {
+    channel_ = nullptr;
+    error_ = err;
+}
+
+void RpcStream::Consume(size_t len) {
+    consumed_ += len + RPC_PACKET_HEADER_LEN;
+    //Given back in batches of half the window, the writer never waits for a round trip while the reader keeps up
+    if (channel_ && !remote_closed_ && consumed_ >= granted_ / 2) {
+        channel_->SendStream(PacketType::STREAM_CREDIT, id_, consumed_, nullptr, 0);
+        consumed_ = 0;
+    }
+}
+
+void RpcStream::Finish() {
+    if (!channel_) {
+        return;
+    }
+    auto channel = channel_;
+    channel_ = nullptr;
+    channel->RemoveStream(id_);
+}
+
+void RpcStream::NotifyClose(int err) {
+    if (err == ERROR_OK) {
+        if (close_notified_) return;
+        close_notified_ = true;
+    }
+    if (close_callback_) {
+        close_callback_(err);
+    }
+}
+}
+}
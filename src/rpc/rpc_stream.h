@@ -0,0 +1,134 @@
+// Copyright (C), Xianfeng Shang.  All rights reserved.
+// Author: Xianfeng Shang (shangxianfeng@outlook.com)
+#pragma once
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <string>
+#include "google/protobuf/message.h"
+#include "rpc_packet.h"
+
+namespace tinynet {
+namespace rpc {
+class RpcChannel;
+class RpcStream;
+typedef std::shared_ptr<RpcStream> RpcStreamPtr;
+
+//Ordered sequence of messages in both directions, opened along with a call and carried by the channel of the call.
+//The client attaches a new stream to the controller before the call, see RpcController::set_stream(),
+//the service takes it with RpcController::AcceptStream() and may answer the call whenever it likes.
+//Each side grants the other a window of bytes and gives them back as its callback consumes the messages,
+//a writer stops when is_writable() turns false and goes on from the writable callback.
+class RpcStream {
+    friend class RpcChannel;
+    friend class RpcController;
+  public:
+    static const uint32_t DEFAULT_WINDOW = 4 * 1024 * 1024;
+  public:
+    typedef std::function<void(const char* data, size_t len)> MessageCallback;
+    typedef std::function<void(int err)> CloseCallback;
+    typedef std::function<void()> WritableCallback;
+  public:
+    /**
+     * @brief Construct a new Rpc Stream object
+     *
+     * @param window bytes of messages received but not consumed yet the peer may send, at least RPC_STREAM_INITIAL_WINDOW
+     */
+    explicit RpcStream(uint32_t window = DEFAULT_WINDOW);
+    ~RpcStream();
+  private:
+    RpcStream(const RpcStream&) = delete;
+    RpcStream& operator=(const RpcStream&) = delete;
+  public:
+    /**
+     * @brief Sends a message, fails with ERROR_RPC_STREAMFULL while the peer grants no credit
+     *
+     * @param msg
+     * @return int
+     */
+    int Write(const google::protobuf::Message& msg);
+    /**
+     * @brief Sends len bytes as one message
+     *
+     * @param data
+     * @param len
+     * @return int
+     */
+    int Write(const void* data, size_t len);
+    /**
+     * @brief Half close, no more messages are written. The peer may go on writing until it closes too.
+     *
+     */
+    void Close();
+    /**
+     * @brief Gives up on the stream in both directions, the peer is told err. No callback runs.
+     *
+     * @param err
+     */
+    void Reset(int err);
+  public:
+    /**
+     * @brief Messages received are passed to callback, the ones received before are passed right away.
+     * The bytes go back to the peer once the callback returns.
+     *
+     * @param callback
+     */
+    void set_message_callback(MessageCallback callback);
+    /**
+     * @brief Called with ERROR_OK after the last message of the peer, and with an error if the stream
+     * breaks before both sides closed it: reset by the peer, the call aborted or the connection lost.
+     *
+     * @param callback
+     */
+    void set_close_callback(CloseCallback callback) { close_callback_ = std::move(callback); }
+    /**
+     * @brief Called when the peer grants credit again after a writer used it up, or the stream breaks
+     *
+     * @param callback
+     */
+    void set_writable_callback(WritableCallback callback) { writable_callback_ = std::move(callback); }
+
+    bool is_writable() const { return channel_ && !local_closed_ && credit_ > 0; }
+
+    bool is_closed() const { return local_closed_ && remote_closed_; }
+
+    uint64_t get_id() const { return id_; }
+
+    int get_error() const { return error_; }
+  private:
+    //Called by the channel
+    void Attach(RpcChannel* channel, uint64_t id);
+    //Grants the peer the part of the window beyond the initial one
+    void Open(uint32_t window);
+    void OnData(const char* data, size_t len);
+    void OnCredit(uint64_t bytes);
+    void OnClose();
+    void OnReset(int err);
+    //The channel goes away, nothing is sent nor called any more
+    void Detach(int err);
+
+    bool is_accepted() const { return accepted_; }
+  private:
+    void Consume(size_t len);
+    void Finish();
+    void NotifyClose(int err);
+  private:
+    RpcChannel* channel_{ nullptr };
+    uint64_t id_{ 0 };
+    uint32_t window_;
+    uint32_t granted_{ RPC_STREAM_INITIAL_WINDOW }; ///< Window the peer was told so far
+    int64_t credit_{ RPC_STREAM_INITIAL_WINDOW }; ///< Bytes the peer accepts, below 0 after a message larger than the credit
+    uint64_t consumed_{ 0 }; ///< Bytes consumed and not given back yet
+    bool accepted_{ false };
+    bool local_closed_{ false };
+    bool remote_closed_{ false };
+    bool close_notified_{ false }; ///< The close callback ran with ERROR_OK
+    int error_{ 0 };
+    std::deque<std::string> received_; ///< Messages waiting for the message callback
+    MessageCallback message_callback_;
+    CloseCallback close_callback_;
+    WritableCallback writable_callback_;
+};
+}
+}
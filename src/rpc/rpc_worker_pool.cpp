@@ -0,0 +1,70 @@
+// Copyright (C), Xianfeng Shang.  All rights reserved.
+// Author: Xianfeng Shang (shangxianfeng@outlook.com)
+#include "rpc_worker_pool.h"
+#include "base/error_code.h"
+
+namespace tinynet {
+namespace rpc {
+
+RpcWorkerPool::RpcWorkerPool() = default;
+
+RpcWorkerPool::~RpcWorkerPool() {
+    Stop();
+}
+
+int RpcWorkerPool::Start(int nthreads, size_t max_pending) {
+    if (!threads_.empty()) return ERROR_SERVER_STARTED;
+    max_pending_ = max_pending;
+    stopping_ = false;
+    for (int i = 0; i < nthreads; ++i) {
+        threads_.emplace_back(&RpcWorkerPool::Run, this);
+    }
+    return ERROR_OK;
+}
+
+void RpcWorkerPool::Stop() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    cond_.notify_all();
+    for (auto& thread : threads_) {
+        if (thread.joinable()) thread.join();
+    }
+    threads_.clear();
+}
+
+bool RpcWorkerPool::Submit(TaskFunc task) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (stopping_ || threads_.empty() || tasks_.size() >= max_pending_) {
+            shed_count_.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        tasks_.emplace_back(std::move(task));
+    }
+    cond_.notify_one();
+    return true;
+}
+
+size_t RpcWorkerPool::get_pending() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return tasks_.size();
+}
+
+void RpcWorkerPool::Run() {
+    for (;;) {
+        TaskFunc task;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            cond_.wait(lock, [this] { return stopping_ || !tasks_.empty(); });
+            //The queue is drained before leaving, the loops wait for the responses
+            if (tasks_.empty()) return;
+            task = std::move(tasks_.front());
+            tasks_.pop_front();
+        }
+        task();
+    }
+}
+}
+}
@@ -0,0 +1,78 @@
+// Copyright (C), Xianfeng Shang.  All rights reserved.
+// Author: Xianfeng Shang (shangxianfeng@outlook.com)
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "net/task_manager.h"
+
+namespace tinynet {
+namespace rpc {
+class RpcWorkerPool;
+typedef std::shared_ptr<RpcWorkerPool> RpcWorkerPoolPtr;
+
+//Threads running the CPU heavy methods of services instead of the event loop, see RpcServer::RegisterService().
+//The requests, responses and controllers stay owned by the loop: a worker only runs the method
+//and the done closure goes back to the loop, which sends the response.
+//A request finding max_pending requests queued already is answered with ERROR_RPC_SERVERBUSY,
+//clients which did not negotiate PACKET_FLAG_ERROR have their connection closed instead.
+//Methods using streams must run on the loop, the streams are not thread safe: requests opening one
+//for a method of the pool are refused with ERROR_RPC_STREAMREFUSED before they reach a worker.
+class RpcWorkerPool {
+  public:
+    RpcWorkerPool();
+    ~RpcWorkerPool();
+  private:
+    RpcWorkerPool(const RpcWorkerPool&) = delete;
+    RpcWorkerPool& operator=(const RpcWorkerPool&) = delete;
+  public:
+    /**
+     * @brief Starts the threads
+     *
+     * @param nthreads number of threads
+     * @param max_pending requests waiting for a thread beyond which new ones are shed
+     * @return int ERROR_OK on success
+     */
+    int Start(int nthreads, size_t max_pending);
+    /**
+     * @brief Runs the requests queued already and waits for the threads.
+     * Called before the loops of the services stop, the responses go back to them.
+     *
+     */
+    void Stop();
+    /**
+     * @brief Queues task for a thread, thread safe. Returns false when the queue is full or the pool stopped.
+     *
+     * @param task
+     * @return true
+     * @return false
+     */
+    bool Submit(TaskFunc task);
+  public:
+    size_t size() const { return threads_.size(); }
+
+    size_t get_pending();
+    /**
+     * @brief Requests shed since the start
+     *
+     * @return uint64_t
+     */
+    uint64_t get_shed_count() const { return shed_count_.load(std::memory_order_relaxed); }
+  private:
+    void Run();
+  private:
+    std::mutex mutex_;
+    std::condition_variable cond_;
+    std::deque<TaskFunc> tasks_;
+    std::vector<std::thread> threads_;
+    size_t max_pending_{ 0 };
+    bool stopping_{ false };
+    std::atomic<uint64_t> shed_count_{ 0 };
+};
+}
+}
@@ -7,15 +7,31 @@ static const int kDefaultBlockSize = 8192;
 
 ZeroCopyOutputStream::ZeroCopyOutputStream(IOBuffer* io_buf) :
     io_buf_(io_buf),
+    io_chain_(nullptr),
     position_(0),
     block_size_(kDefaultBlockSize) {
     io_buf_->reserve(io_buf_->size() + block_size_);
 }
 
+ZeroCopyOutputStream::ZeroCopyOutputStream(IOBufferChain* io_chain) :
+    io_buf_(nullptr),
+    io_chain_(io_chain),
+    position_(0),
+    block_size_(0) {
+}
+
 ZeroCopyOutputStream::~ZeroCopyOutputStream() {
 }
 
 bool ZeroCopyOutputStream::Next(void** data, int* size) {
+    if (io_chain_) {
+        size_t avail = 0;
+        *data = io_chain_->prepare_some(&avail);
+        *size = static_cast<int>(avail);
+        io_chain_->commit(avail);
+        position_ += avail;
+        return true;
+    }
     if (position_ >= block_size_) {
         block_size_ += block_size_;
         io_buf_->reserve(io_buf_->size() + block_size_);
@@ -27,6 +43,9 @@ bool ZeroCopyOutputStream::Next(void** data, int* size) {
 }
 
 void ZeroCopyOutputStream::BackUp(int count) {
+    if (io_chain_) {
+        io_chain_->backup(static_cast<size_t>(count));
+    }
     position_ -= static_cast<size_t>(count);
 }
 
@@ -39,6 +58,7 @@ void ZeroCopyOutputStream::Reset() {
 }
 
 void ZeroCopyOutputStream::Commit() {
+    if (io_chain_) return;
     io_buf_->commit(position_);
 }
 
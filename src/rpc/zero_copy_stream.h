@@ -3,12 +3,17 @@
 #pragma once
 #include "google/protobuf/io/zero_copy_stream.h"
 #include "base/io_buffer_stream.h"
+#include "base/io_buffer_chain.h"
 namespace tinynet {
 namespace rpc {
 class ZeroCopyOutputStream :
     public google::protobuf::io::ZeroCopyOutputStream {
   public:
     explicit ZeroCopyOutputStream(IOBuffer* io_buf);
+    /**
+     * @brief Serializes straight into the blocks of a chained buffer, bytes are committed as they are handed out
+     */
+    explicit ZeroCopyOutputStream(IOBufferChain* io_chain);
     ~ZeroCopyOutputStream();
   public:
     ZeroCopyOutputStream(const ZeroCopyOutputStream&) = delete;
@@ -24,6 +29,7 @@ class ZeroCopyOutputStream :
     void Commit();
   private:
     IOBuffer* io_buf_;
+    IOBufferChain* io_chain_;
     size_t position_;
     size_t block_size_;
 };
@@ -27,6 +27,12 @@ const ::google::protobuf::internal::GeneratedMessageReflection*
 const ::google::protobuf::Descriptor* TransferResponse_descriptor_ = NULL;
 const ::google::protobuf::internal::GeneratedMessageReflection*
   TransferResponse_reflection_ = NULL;
+const ::google::protobuf::Descriptor* TransferBatchRequest_descriptor_ = NULL;
+const ::google::protobuf::internal::GeneratedMessageReflection*
+  TransferBatchRequest_reflection_ = NULL;
+const ::google::protobuf::Descriptor* TransferBatchResponse_descriptor_ = NULL;
+const ::google::protobuf::internal::GeneratedMessageReflection*
+  TransferBatchResponse_reflection_ = NULL;
 const ::google::protobuf::ServiceDescriptor* TdcRpcService_descriptor_ = NULL;
 
 }  // namespace
@@ -70,6 +76,36 @@ void protobuf_AssignDesc_tdc_2eproto() {
       ::google::protobuf::DescriptorPool::generated_pool(),
       ::google::protobuf::MessageFactory::generated_factory(),
       sizeof(TransferResponse));
+  TransferBatchRequest_descriptor_ = file->message_type(2);
+  static const int TransferBatchRequest_offsets_[1] = {
+    GOOGLE_PROTOBUF_GENERATED_MESSAGE_FIELD_OFFSET(TransferBatchRequest, messages_),
+  };
+  TransferBatchRequest_reflection_ =
+    new ::google::protobuf::internal::GeneratedMessageReflection(
+      TransferBatchRequest_descriptor_,
+      TransferBatchRequest::default_instance_,
+      TransferBatchRequest_offsets_,
+      GOOGLE_PROTOBUF_GENERATED_MESSAGE_FIELD_OFFSET(TransferBatchRequest, _has_bits_[0]),
+      GOOGLE_PROTOBUF_GENERATED_MESSAGE_FIELD_OFFSET(TransferBatchRequest, _unknown_fields_),
+      -1,
+      ::google::protobuf::DescriptorPool::generated_pool(),
+      ::google::protobuf::MessageFactory::generated_factory(),
+      sizeof(TransferBatchRequest));
+  TransferBatchResponse_descriptor_ = file->message_type(3);
+  static const int TransferBatchResponse_offsets_[1] = {
+    GOOGLE_PROTOBUF_GENERATED_MESSAGE_FIELD_OFFSET(TransferBatchResponse, results_),
+  };
+  TransferBatchResponse_reflection_ =
+    new ::google::protobuf::internal::GeneratedMessageReflection(
+      TransferBatchResponse_descriptor_,
+      TransferBatchResponse::default_instance_,
+      TransferBatchResponse_offsets_,
+      GOOGLE_PROTOBUF_GENERATED_MESSAGE_FIELD_OFFSET(TransferBatchResponse, _has_bits_[0]),
+      GOOGLE_PROTOBUF_GENERATED_MESSAGE_FIELD_OFFSET(TransferBatchResponse, _unknown_fields_),
+      -1,
+      ::google::protobuf::DescriptorPool::generated_pool(),
+      ::google::protobuf::MessageFactory::generated_factory(),
+      sizeof(TransferBatchResponse));
   TdcRpcService_descriptor_ = file->service(0);
 }
 
@@ -87,6 +123,10 @@ void protobuf_RegisterTypes(const ::std::string&) {
     TransferRequest_descriptor_, &TransferRequest::default_instance());
   ::google::protobuf::MessageFactory::InternalRegisterGeneratedMessage(
     TransferResponse_descriptor_, &TransferResponse::default_instance());
+  ::google::protobuf::MessageFactory::InternalRegisterGeneratedMessage(
+    TransferBatchRequest_descriptor_, &TransferBatchRequest::default_instance());
+  ::google::protobuf::MessageFactory::InternalRegisterGeneratedMessage(
+    TransferBatchResponse_descriptor_, &TransferBatchResponse::default_instance());
 }
 
 }  // namespace
@@ -96,6 +136,10 @@ void protobuf_ShutdownFile_tdc_2eproto() {
   delete TransferRequest_reflection_;
   delete TransferResponse::default_instance_;
   delete TransferResponse_reflection_;
+  delete TransferBatchRequest::default_instance_;
+  delete TransferBatchRequest_reflection_;
+  delete TransferBatchResponse::default_instance_;
+  delete TransferBatchResponse_reflection_;
 }
 
 void protobuf_AddDesc_tdc_2eproto() {
@@ -108,15 +152,25 @@ void protobuf_AddDesc_tdc_2eproto() {
     "\n\ttdc.proto\022\013tinynet.tdc\"-\n\017TransferRequ"
     "est\022\014\n\004guid\030\001 \001(\003\022\014\n\004body\030\002 \001(\014\";\n\020Trans"
     "ferResponse\022\014\n\004guid\030\001 \001(\003\022\031\n\nerror_code\030"
-    "\002 \001(\005:\005-58012X\n\rTdcRpcService\022G\n\010Transfe"
-    "r\022\034.tinynet.tdc.TransferRequest\032\035.tinyne"
-    "t.tdc.TransferResponseB\003\200\001\001", 227);
+    "\002 \001(\005:\005-5801\"F\n\024TransferBatchRequest\022.\n\010"
+    "messages\030\001 \003(\0132\034.tinynet.tdc.TransferReq"
+    "uest\"G\n\025TransferBatchResponse\022.\n\007results"
+    "\030\001 \003(\0132\035.tinynet.tdc.TransferResponse2\260\001"
+    "\n\rTdcRpcService\022G\n\010Transfer\022\034.tinynet.td"
+    "c.TransferRequest\032\035.tinynet.tdc.Transfer"
+    "Response\022V\n\rTransferBatch\022!.tinynet.tdc."
+    "TransferBatchRequest\032\".tinynet.tdc.Trans"
+    "ferBatchResponseB\003\200\001\001", 461);
   ::google::protobuf::MessageFactory::InternalRegisterGeneratedFile(
     "tdc.proto", &protobuf_RegisterTypes);
   TransferRequest::default_instance_ = new TransferRequest();
   TransferResponse::default_instance_ = new TransferResponse();
+  TransferBatchRequest::default_instance_ = new TransferBatchRequest();
+  TransferBatchResponse::default_instance_ = new TransferBatchResponse();
   TransferRequest::default_instance_->InitAsDefaultInstance();
   TransferResponse::default_instance_->InitAsDefaultInstance();
+  TransferBatchRequest::default_instance_->InitAsDefaultInstance();
+  TransferBatchResponse::default_instance_->InitAsDefaultInstance();
   ::google::protobuf::internal::OnShutdown(&protobuf_ShutdownFile_tdc_2eproto);
 }
 
@@ -661,6 +715,442 @@ void TransferResponse::Swap(TransferResponse* other) {
   return metadata;
 }
 
+// ===================================================================
+
+#ifndef _MSC_VER
+const int TransferBatchRequest::kMessagesFieldNumber;
+#endif  // !_MSC_VER
+
+TransferBatchRequest::TransferBatchRequest()
+  : ::google::protobuf::Message() {
+  SharedCtor();
+  // @@protoc_insertion_point(constructor:tinynet.tdc.TransferBatchRequest)
+}
+
+void TransferBatchRequest::InitAsDefaultInstance() {
+}
+
+TransferBatchRequest::TransferBatchRequest(const TransferBatchRequest& from)
+  : ::google::protobuf::Message() {
+  SharedCtor();
+  MergeFrom(from);
+  // @@protoc_insertion_point(copy_constructor:tinynet.tdc.TransferBatchRequest)
+}
+
+void TransferBatchRequest::SharedCtor() {
+  _cached_size_ = 0;
+  ::memset(_has_bits_, 0, sizeof(_has_bits_));
+}
+
+TransferBatchRequest::~TransferBatchRequest() {
+  // @@protoc_insertion_point(destructor:tinynet.tdc.TransferBatchRequest)
+  SharedDtor();
+}
+
+void TransferBatchRequest::SharedDtor() {
+  if (this != default_instance_) {
+  }
+}
+
+void TransferBatchRequest::SetCachedSize(int size) const {
+  GOOGLE_SAFE_CONCURRENT_WRITES_BEGIN();
+  _cached_size_ = size;
+  GOOGLE_SAFE_CONCURRENT_WRITES_END();
+}
+const ::google::protobuf::Descriptor* TransferBatchRequest::descriptor() {
+  protobuf_AssignDescriptorsOnce();
+  return TransferBatchRequest_descriptor_;
+}
+
+const TransferBatchRequest& TransferBatchRequest::default_instance() {
+  if (default_instance_ == NULL) protobuf_AddDesc_tdc_2eproto();
+  return *default_instance_;
+}
+
+TransferBatchRequest* TransferBatchRequest::default_instance_ = NULL;
+
+TransferBatchRequest* TransferBatchRequest::New() const {
+  return new TransferBatchRequest;
+}
+
+void TransferBatchRequest::Clear() {
+  messages_.Clear();
+  ::memset(_has_bits_, 0, sizeof(_has_bits_));
+  mutable_unknown_fields()->Clear();
+}
+
+bool TransferBatchRequest::MergePartialFromCodedStream(
+    ::google::protobuf::io::CodedInputStream* input) {
+#define DO_(EXPRESSION) if (!(EXPRESSION)) goto failure
+  ::google::protobuf::uint32 tag;
+  // @@protoc_insertion_point(parse_start:tinynet.tdc.TransferBatchRequest)
+  for (;;) {
+    ::std::pair< ::google::protobuf::uint32, bool> p = input->ReadTagWithCutoff(127);
+    tag = p.first;
+    if (!p.second) goto handle_unusual;
+    switch (::google::protobuf::internal::WireFormatLite::GetTagFieldNumber(tag)) {
+      // repeated .tinynet.tdc.TransferRequest messages = 1;
+      case 1: {
+        if (tag == 10) {
+         parse_messages:
+          DO_(::google::protobuf::internal::WireFormatLite::ReadMessageNoVirtual(
+                input, add_messages()));
+        } else {
+          goto handle_unusual;
+        }
+        if (input->ExpectTag(10)) goto parse_messages;
+        if (input->ExpectAtEnd()) goto success;
+        break;
+      }
+
+      default: {
+      handle_unusual:
+        if (tag == 0 ||
+            ::google::protobuf::internal::WireFormatLite::GetTagWireType(tag) ==
+            ::google::protobuf::internal::WireFormatLite::WIRETYPE_END_GROUP) {
+          goto success;
+        }
+        DO_(::google::protobuf::internal::WireFormat::SkipField(
+              input, tag, mutable_unknown_fields()));
+        break;
+      }
+    }
+  }
+success:
+  // @@protoc_insertion_point(parse_success:tinynet.tdc.TransferBatchRequest)
+  return true;
+failure:
+  // @@protoc_insertion_point(parse_failure:tinynet.tdc.TransferBatchRequest)
+  return false;
+#undef DO_
+}
+
+void TransferBatchRequest::SerializeWithCachedSizes(
+    ::google::protobuf::io::CodedOutputStream* output) const {
+  // @@protoc_insertion_point(serialize_start:tinynet.tdc.TransferBatchRequest)
+  // repeated .tinynet.tdc.TransferRequest messages = 1;
+  for (int i = 0; i < this->messages_size(); i++) {
+    ::google::protobuf::internal::WireFormatLite::WriteMessageMaybeToArray(
+      1, this->messages(i), output);
+  }
+
+  if (!unknown_fields().empty()) {
+    ::google::protobuf::internal::WireFormat::SerializeUnknownFields(
+        unknown_fields(), output);
+  }
+  // @@protoc_insertion_point(serialize_end:tinynet.tdc.TransferBatchRequest)
+}
+
+::google::protobuf::uint8* TransferBatchRequest::SerializeWithCachedSizesToArray(
+    ::google::protobuf::uint8* target) const {
+  // @@protoc_insertion_point(serialize_to_array_start:tinynet.tdc.TransferBatchRequest)
+  // repeated .tinynet.tdc.TransferRequest messages = 1;
+  for (int i = 0; i < this->messages_size(); i++) {
+    target = ::google::protobuf::internal::WireFormatLite::
+      WriteMessageNoVirtualToArray(
+        1, this->messages(i), target);
+  }
+
+  if (!unknown_fields().empty()) {
+    target = ::google::protobuf::internal::WireFormat::SerializeUnknownFieldsToArray(
+        unknown_fields(), target);
+  }
+  // @@protoc_insertion_point(serialize_to_array_end:tinynet.tdc.TransferBatchRequest)
+  return target;
+}
+
+int TransferBatchRequest::ByteSize() const {
+  int total_size = 0;
+
+  // repeated .tinynet.tdc.TransferRequest messages = 1;
+  total_size += 1 * this->messages_size();
+  for (int i = 0; i < this->messages_size(); i++) {
+    total_size +=
+      ::google::protobuf::internal::WireFormatLite::MessageSizeNoVirtual(
+        this->messages(i));
+  }
+
+  if (!unknown_fields().empty()) {
+    total_size +=
+      ::google::protobuf::internal::WireFormat::ComputeUnknownFieldsSize(
+        unknown_fields());
+  }
+  GOOGLE_SAFE_CONCURRENT_WRITES_BEGIN();
+  _cached_size_ = total_size;
+  GOOGLE_SAFE_CONCURRENT_WRITES_END();
+  return total_size;
+}
+
+void TransferBatchRequest::MergeFrom(const ::google::protobuf::Message& from) {
+  GOOGLE_CHECK_NE(&from, this);
+  const TransferBatchRequest* source =
+    ::google::protobuf::internal::dynamic_cast_if_available<const TransferBatchRequest*>(
+      &from);
+  if (source == NULL) {
+    ::google::protobuf::internal::ReflectionOps::Merge(from, this);
+  } else {
+    MergeFrom(*source);
+  }
+}
+
+void TransferBatchRequest::MergeFrom(const TransferBatchRequest& from) {
+  GOOGLE_CHECK_NE(&from, this);
+  messages_.MergeFrom(from.messages_);
+  mutable_unknown_fields()->MergeFrom(from.unknown_fields());
+}
+
+void TransferBatchRequest::CopyFrom(const ::google::protobuf::Message& from) {
+  if (&from == this) return;
+  Clear();
+  MergeFrom(from);
+}
+
+void TransferBatchRequest::CopyFrom(const TransferBatchRequest& from) {
+  if (&from == this) return;
+  Clear();
+  MergeFrom(from);
+}
+
+bool TransferBatchRequest::IsInitialized() const {
+
+  return true;
+}
+
+void TransferBatchRequest::Swap(TransferBatchRequest* other) {
+  if (other != this) {
+    messages_.Swap(&other->messages_);
+    std::swap(_has_bits_[0], other->_has_bits_[0]);
+    _unknown_fields_.Swap(&other->_unknown_fields_);
+    std::swap(_cached_size_, other->_cached_size_);
+  }
+}
+
+::google::protobuf::Metadata TransferBatchRequest::GetMetadata() const {
+  protobuf_AssignDescriptorsOnce();
+  ::google::protobuf::Metadata metadata;
+  metadata.descriptor = TransferBatchRequest_descriptor_;
+  metadata.reflection = TransferBatchRequest_reflection_;
+  return metadata;
+}
+
+// ===================================================================
+
+#ifndef _MSC_VER
+const int TransferBatchResponse::kResultsFieldNumber;
+#endif  // !_MSC_VER
+
+TransferBatchResponse::TransferBatchResponse()
+  : ::google::protobuf::Message() {
+  SharedCtor();
+  // @@protoc_insertion_point(constructor:tinynet.tdc.TransferBatchResponse)
+}
+
+void TransferBatchResponse::InitAsDefaultInstance() {
+}
+
+TransferBatchResponse::TransferBatchResponse(const TransferBatchResponse& from)
+  : ::google::protobuf::Message() {
+  SharedCtor();
+  MergeFrom(from);
+  // @@protoc_insertion_point(copy_constructor:tinynet.tdc.TransferBatchResponse)
+}
+
+void TransferBatchResponse::SharedCtor() {
+  _cached_size_ = 0;
+  ::memset(_has_bits_, 0, sizeof(_has_bits_));
+}
+
+TransferBatchResponse::~TransferBatchResponse() {
+  // @@protoc_insertion_point(destructor:tinynet.tdc.TransferBatchResponse)
+  SharedDtor();
+}
+
+void TransferBatchResponse::SharedDtor() {
+  if (this != default_instance_) {
+  }
+}
+
+void TransferBatchResponse::SetCachedSize(int size) const {
+  GOOGLE_SAFE_CONCURRENT_WRITES_BEGIN();
+  _cached_size_ = size;
+  GOOGLE_SAFE_CONCURRENT_WRITES_END();
+}
+const ::google::protobuf::Descriptor* TransferBatchResponse::descriptor() {
+  protobuf_AssignDescriptorsOnce();
+  return TransferBatchResponse_descriptor_;
+}
+
+const TransferBatchResponse& TransferBatchResponse::default_instance() {
+  if (default_instance_ == NULL) protobuf_AddDesc_tdc_2eproto();
+  return *default_instance_;
+}
+
+TransferBatchResponse* TransferBatchResponse::default_instance_ = NULL;
+
+TransferBatchResponse* TransferBatchResponse::New() const {
+  return new TransferBatchResponse;
+}
+
+void TransferBatchResponse::Clear() {
+  results_.Clear();
+  ::memset(_has_bits_, 0, sizeof(_has_bits_));
+  mutable_unknown_fields()->Clear();
+}
+
+bool TransferBatchResponse::MergePartialFromCodedStream(
+    ::google::protobuf::io::CodedInputStream* input) {
+#define DO_(EXPRESSION) if (!(EXPRESSION)) goto failure
+  ::google::protobuf::uint32 tag;
+  // @@protoc_insertion_point(parse_start:tinynet.tdc.TransferBatchResponse)
+  for (;;) {
+    ::std::pair< ::google::protobuf::uint32, bool> p = input->ReadTagWithCutoff(127);
+    tag = p.first;
+    if (!p.second) goto handle_unusual;
+    switch (::google::protobuf::internal::WireFormatLite::GetTagFieldNumber(tag)) {
+      // repeated .tinynet.tdc.TransferResponse results = 1;
+      case 1: {
+        if (tag == 10) {
+         parse_results:
+          DO_(::google::protobuf::internal::WireFormatLite::ReadMessageNoVirtual(
+                input, add_results()));
+        } else {
+          goto handle_unusual;
+        }
+        if (input->ExpectTag(10)) goto parse_results;
+        if (input->ExpectAtEnd()) goto success;
+        break;
+      }
+
+      default: {
+      handle_unusual:
+        if (tag == 0 ||
+            ::google::protobuf::internal::WireFormatLite::GetTagWireType(tag) ==
+            ::google::protobuf::internal::WireFormatLite::WIRETYPE_END_GROUP) {
+          goto success;
+        }
+        DO_(::google::protobuf::internal::WireFormat::SkipField(
+              input, tag, mutable_unknown_fields()));
+        break;
+      }
+    }
+  }
+success:
+  // @@protoc_insertion_point(parse_success:tinynet.tdc.TransferBatchResponse)
+  return true;
+failure:
+  // @@protoc_insertion_point(parse_failure:tinynet.tdc.TransferBatchResponse)
+  return false;
+#undef DO_
+}
+
+void TransferBatchResponse::SerializeWithCachedSizes(
+    ::google::protobuf::io::CodedOutputStream* output) const {
+  // @@protoc_insertion_point(serialize_start:tinynet.tdc.TransferBatchResponse)
+  // repeated .tinynet.tdc.TransferResponse results = 1;
+  for (int i = 0; i < this->results_size(); i++) {
+    ::google::protobuf::internal::WireFormatLite::WriteMessageMaybeToArray(
+      1, this->results(i), output);
+  }
+
+  if (!unknown_fields().empty()) {
+    ::google::protobuf::internal::WireFormat::SerializeUnknownFields(
+        unknown_fields(), output);
+  }
+  // @@protoc_insertion_point(serialize_end:tinynet.tdc.TransferBatchResponse)
+}
+
+::google::protobuf::uint8* TransferBatchResponse::SerializeWithCachedSizesToArray(
+    ::google::protobuf::uint8* target) const {
+  // @@protoc_insertion_point(serialize_to_array_start:tinynet.tdc.TransferBatchResponse)
+  // repeated .tinynet.tdc.TransferResponse results = 1;
+  for (int i = 0; i < this->results_size(); i++) {
+    target = ::google::protobuf::internal::WireFormatLite::
+      WriteMessageNoVirtualToArray(
+        1, this->results(i), target);
+  }
+
+  if (!unknown_fields().empty()) {
+    target = ::google::protobuf::internal::WireFormat::SerializeUnknownFieldsToArray(
+        unknown_fields(), target);
+  }
+  // @@protoc_insertion_point(serialize_to_array_end:tinynet.tdc.TransferBatchResponse)
+  return target;
+}
+
+int TransferBatchResponse::ByteSize() const {
+  int total_size = 0;
+
+  // repeated .tinynet.tdc.TransferResponse results = 1;
+  total_size += 1 * this->results_size();
+  for (int i = 0; i < this->results_size(); i++) {
+    total_size +=
+      ::google::protobuf::internal::WireFormatLite::MessageSizeNoVirtual(
+        this->results(i));
+  }
+
+  if (!unknown_fields().empty()) {
+    total_size +=
+      ::google::protobuf::internal::WireFormat::ComputeUnknownFieldsSize(
+        unknown_fields());
+  }
+  GOOGLE_SAFE_CONCURRENT_WRITES_BEGIN();
+  _cached_size_ = total_size;
+  GOOGLE_SAFE_CONCURRENT_WRITES_END();
+  return total_size;
+}
+
+void TransferBatchResponse::MergeFrom(const ::google::protobuf::Message& from) {
+  GOOGLE_CHECK_NE(&from, this);
+  const TransferBatchResponse* source =
+    ::google::protobuf::internal::dynamic_cast_if_available<const TransferBatchResponse*>(
+      &from);
+  if (source == NULL) {
+    ::google::protobuf::internal::ReflectionOps::Merge(from, this);
+  } else {
+    MergeFrom(*source);
+  }
+}
+
+void TransferBatchResponse::MergeFrom(const TransferBatchResponse& from) {
+  GOOGLE_CHECK_NE(&from, this);
+  results_.MergeFrom(from.results_);
+  mutable_unknown_fields()->MergeFrom(from.unknown_fields());
+}
+
+void TransferBatchResponse::CopyFrom(const ::google::protobuf::Message& from) {
+  if (&from == this) return;
+  Clear();
+  MergeFrom(from);
+}
+
+void TransferBatchResponse::CopyFrom(const TransferBatchResponse& from) {
+  if (&from == this) return;
+  Clear();
+  MergeFrom(from);
+}
+
+bool TransferBatchResponse::IsInitialized() const {
+
+  return true;
+}
+
+void TransferBatchResponse::Swap(TransferBatchResponse* other) {
+  if (other != this) {
+    results_.Swap(&other->results_);
+    std::swap(_has_bits_[0], other->_has_bits_[0]);
+    _unknown_fields_.Swap(&other->_unknown_fields_);
+    std::swap(_cached_size_, other->_cached_size_);
+  }
+}
+
+::google::protobuf::Metadata TransferBatchResponse::GetMetadata() const {
+  protobuf_AssignDescriptorsOnce();
+  ::google::protobuf::Metadata metadata;
+  metadata.descriptor = TransferBatchResponse_descriptor_;
+  metadata.reflection = TransferBatchResponse_reflection_;
+  return metadata;
+}
+
 
 // ===================================================================
 
@@ -684,6 +1174,14 @@ void TdcRpcService::Transfer(::google::protobuf::RpcController* controller,
   done->Run();
 }
 
+void TdcRpcService::TransferBatch(::google::protobuf::RpcController* controller,
+                         const ::tinynet::tdc::TransferBatchRequest*,
+                         ::tinynet::tdc::TransferBatchResponse*,
+                         ::google::protobuf::Closure* done) {
+  controller->SetFailed("Method TransferBatch() not implemented.");
+  done->Run();
+}
+
 void TdcRpcService::CallMethod(const ::google::protobuf::MethodDescriptor* method,
                              ::google::protobuf::RpcController* controller,
                              const ::google::protobuf::Message* request,
@@ -697,6 +1195,12 @@ void TdcRpcService::CallMethod(const ::google::protobuf::MethodDescriptor* metho
              ::google::protobuf::down_cast< ::tinynet::tdc::TransferResponse*>(response),
              done);
       break;
+    case 1:
+      TransferBatch(controller,
+             ::google::protobuf::down_cast<const ::tinynet::tdc::TransferBatchRequest*>(request),
+             ::google::protobuf::down_cast< ::tinynet::tdc::TransferBatchResponse*>(response),
+             done);
+      break;
     default:
       GOOGLE_LOG(FATAL) << "Bad method index; this should never happen.";
       break;
@@ -709,6 +1213,8 @@ const ::google::protobuf::Message& TdcRpcService::GetRequestPrototype(
   switch(method->index()) {
     case 0:
       return ::tinynet::tdc::TransferRequest::default_instance();
+    case 1:
+      return ::tinynet::tdc::TransferBatchRequest::default_instance();
     default:
       GOOGLE_LOG(FATAL) << "Bad method index; this should never happen.";
       return *reinterpret_cast< ::google::protobuf::Message*>(NULL);
@@ -721,6 +1227,8 @@ const ::google::protobuf::Message& TdcRpcService::GetResponsePrototype(
   switch(method->index()) {
     case 0:
       return ::tinynet::tdc::TransferResponse::default_instance();
+    case 1:
+      return ::tinynet::tdc::TransferBatchResponse::default_instance();
     default:
       GOOGLE_LOG(FATAL) << "Bad method index; this should never happen.";
       return *reinterpret_cast< ::google::protobuf::Message*>(NULL);
@@ -745,6 +1253,13 @@ void TdcRpcService_Stub::Transfer(::google::protobuf::RpcController* controller,
   channel_->CallMethod(descriptor()->method(0),
                        controller, request, response, done);
 }
+void TdcRpcService_Stub::TransferBatch(::google::protobuf::RpcController* controller,
+                              const ::tinynet::tdc::TransferBatchRequest* request,
+                              ::tinynet::tdc::TransferBatchResponse* response,
+                              ::google::protobuf::Closure* done) {
+  channel_->CallMethod(descriptor()->method(1),
+                       controller, request, response, done);
+}
 
 // @@protoc_insertion_point(namespace_scope)
 
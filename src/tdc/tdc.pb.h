@@ -37,6 +37,8 @@ void protobuf_ShutdownFile_tdc_2eproto();
 
 class TransferRequest;
 class TransferResponse;
+class TransferBatchRequest;
+class TransferBatchResponse;
 
 // ===================================================================
 
@@ -221,6 +223,170 @@ class TransferResponse : public ::google::protobuf::Message {
   void InitAsDefaultInstance();
   static TransferResponse* default_instance_;
 };
+// -------------------------------------------------------------------
+
+class TransferBatchRequest : public ::google::protobuf::Message {
+ public:
+  TransferBatchRequest();
+  virtual ~TransferBatchRequest();
+
+  TransferBatchRequest(const TransferBatchRequest& from);
+
+  inline TransferBatchRequest& operator=(const TransferBatchRequest& from) {
+    CopyFrom(from);
+    return *this;
+  }
+
+  inline const ::google::protobuf::UnknownFieldSet& unknown_fields() const {
+    return _unknown_fields_;
+  }
+
+  inline ::google::protobuf::UnknownFieldSet* mutable_unknown_fields() {
+    return &_unknown_fields_;
+  }
+
+  static const ::google::protobuf::Descriptor* descriptor();
+  static const TransferBatchRequest& default_instance();
+
+  void Swap(TransferBatchRequest* other);
+
+  // implements Message ----------------------------------------------
+
+  TransferBatchRequest* New() const;
+  void CopyFrom(const ::google::protobuf::Message& from);
+  void MergeFrom(const ::google::protobuf::Message& from);
+  void CopyFrom(const TransferBatchRequest& from);
+  void MergeFrom(const TransferBatchRequest& from);
+  void Clear();
+  bool IsInitialized() const;
+
+  int ByteSize() const;
+  bool MergePartialFromCodedStream(
+      ::google::protobuf::io::CodedInputStream* input);
+  void SerializeWithCachedSizes(
+      ::google::protobuf::io::CodedOutputStream* output) const;
+  ::google::protobuf::uint8* SerializeWithCachedSizesToArray(::google::protobuf::uint8* output) const;
+  int GetCachedSize() const { return _cached_size_; }
+  private:
+  void SharedCtor();
+  void SharedDtor();
+  void SetCachedSize(int size) const;
+  public:
+  ::google::protobuf::Metadata GetMetadata() const;
+
+  // nested types ----------------------------------------------------
+
+  // accessors -------------------------------------------------------
+
+  // repeated .tinynet.tdc.TransferRequest messages = 1;
+  inline int messages_size() const;
+  inline void clear_messages();
+  static const int kMessagesFieldNumber = 1;
+  inline const ::tinynet::tdc::TransferRequest& messages(int index) const;
+  inline ::tinynet::tdc::TransferRequest* mutable_messages(int index);
+  inline ::tinynet::tdc::TransferRequest* add_messages();
+  inline const ::google::protobuf::RepeatedPtrField< ::tinynet::tdc::TransferRequest >&
+      messages() const;
+  inline ::google::protobuf::RepeatedPtrField< ::tinynet::tdc::TransferRequest >*
+      mutable_messages();
+
+  // @@protoc_insertion_point(class_scope:tinynet.tdc.TransferBatchRequest)
+ private:
+
+  ::google::protobuf::UnknownFieldSet _unknown_fields_;
+
+  ::google::protobuf::uint32 _has_bits_[1];
+  mutable int _cached_size_;
+  ::google::protobuf::RepeatedPtrField< ::tinynet::tdc::TransferRequest > messages_;
+  friend void  protobuf_AddDesc_tdc_2eproto();
+  friend void protobuf_AssignDesc_tdc_2eproto();
+  friend void protobuf_ShutdownFile_tdc_2eproto();
+
+  void InitAsDefaultInstance();
+  static TransferBatchRequest* default_instance_;
+};
+// -------------------------------------------------------------------
+
+class TransferBatchResponse : public ::google::protobuf::Message {
+ public:
+  TransferBatchResponse();
+  virtual ~TransferBatchResponse();
+
+  TransferBatchResponse(const TransferBatchResponse& from);
+
+  inline TransferBatchResponse& operator=(const TransferBatchResponse& from) {
+    CopyFrom(from);
+    return *this;
+  }
+
+  inline const ::google::protobuf::UnknownFieldSet& unknown_fields() const {
+    return _unknown_fields_;
+  }
+
+  inline ::google::protobuf::UnknownFieldSet* mutable_unknown_fields() {
+    return &_unknown_fields_;
+  }
+
+  static const ::google::protobuf::Descriptor* descriptor();
+  static const TransferBatchResponse& default_instance();
+
+  void Swap(TransferBatchResponse* other);
+
+  // implements Message ----------------------------------------------
+
+  TransferBatchResponse* New() const;
+  void CopyFrom(const ::google::protobuf::Message& from);
+  void MergeFrom(const ::google::protobuf::Message& from);
+  void CopyFrom(const TransferBatchResponse& from);
+  void MergeFrom(const TransferBatchResponse& from);
+  void Clear();
+  bool IsInitialized() const;
+
+  int ByteSize() const;
+  bool MergePartialFromCodedStream(
+      ::google::protobuf::io::CodedInputStream* input);
+  void SerializeWithCachedSizes(
+      ::google::protobuf::io::CodedOutputStream* output) const;
+  ::google::protobuf::uint8* SerializeWithCachedSizesToArray(::google::protobuf::uint8* output) const;
+  int GetCachedSize() const { return _cached_size_; }
+  private:
+  void SharedCtor();
+  void SharedDtor();
+  void SetCachedSize(int size) const;
+  public:
+  ::google::protobuf::Metadata GetMetadata() const;
+
+  // nested types ----------------------------------------------------
+
+  // accessors -------------------------------------------------------
+
+  // repeated .tinynet.tdc.TransferResponse results = 1;
+  inline int results_size() const;
+  inline void clear_results();
+  static const int kResultsFieldNumber = 1;
+  inline const ::tinynet::tdc::TransferResponse& results(int index) const;
+  inline ::tinynet::tdc::TransferResponse* mutable_results(int index);
+  inline ::tinynet::tdc::TransferResponse* add_results();
+  inline const ::google::protobuf::RepeatedPtrField< ::tinynet::tdc::TransferResponse >&
+      results() const;
+  inline ::google::protobuf::RepeatedPtrField< ::tinynet::tdc::TransferResponse >*
+      mutable_results();
+
+  // @@protoc_insertion_point(class_scope:tinynet.tdc.TransferBatchResponse)
+ private:
+
+  ::google::protobuf::UnknownFieldSet _unknown_fields_;
+
+  ::google::protobuf::uint32 _has_bits_[1];
+  mutable int _cached_size_;
+  ::google::protobuf::RepeatedPtrField< ::tinynet::tdc::TransferResponse > results_;
+  friend void  protobuf_AddDesc_tdc_2eproto();
+  friend void protobuf_AssignDesc_tdc_2eproto();
+  friend void protobuf_ShutdownFile_tdc_2eproto();
+
+  void InitAsDefaultInstance();
+  static TransferBatchResponse* default_instance_;
+};
 // ===================================================================
 
 class TdcRpcService_Stub;
@@ -240,6 +406,10 @@ class TdcRpcService : public ::google::protobuf::Service {
                        const ::tinynet::tdc::TransferRequest* request,
                        ::tinynet::tdc::TransferResponse* response,
                        ::google::protobuf::Closure* done);
+  virtual void TransferBatch(::google::protobuf::RpcController* controller,
+                       const ::tinynet::tdc::TransferBatchRequest* request,
+                       ::tinynet::tdc::TransferBatchResponse* response,
+                       ::google::protobuf::Closure* done);
 
   // implements Service ----------------------------------------------
 
@@ -273,6 +443,10 @@ class TdcRpcService_Stub : public TdcRpcService {
                        const ::tinynet::tdc::TransferRequest* request,
                        ::tinynet::tdc::TransferResponse* response,
                        ::google::protobuf::Closure* done);
+  void TransferBatch(::google::protobuf::RpcController* controller,
+                       const ::tinynet::tdc::TransferBatchRequest* request,
+                       ::tinynet::tdc::TransferBatchResponse* response,
+                       ::google::protobuf::Closure* done);
  private:
   ::google::protobuf::RpcChannel* channel_;
   bool owns_channel_;
@@ -439,6 +613,74 @@ inline void TransferResponse::set_error_code(::google::protobuf::int32 value) {
   // @@protoc_insertion_point(field_set:tinynet.tdc.TransferResponse.error_code)
 }
 
+// -------------------------------------------------------------------
+
+// TransferBatchRequest
+
+// repeated .tinynet.tdc.TransferRequest messages = 1;
+inline int TransferBatchRequest::messages_size() const {
+  return messages_.size();
+}
+inline void TransferBatchRequest::clear_messages() {
+  messages_.Clear();
+}
+inline const ::tinynet::tdc::TransferRequest& TransferBatchRequest::messages(int index) const {
+  // @@protoc_insertion_point(field_get:tinynet.tdc.TransferBatchRequest.messages)
+  return messages_.Get(index);
+}
+inline ::tinynet::tdc::TransferRequest* TransferBatchRequest::mutable_messages(int index) {
+  // @@protoc_insertion_point(field_mutable:tinynet.tdc.TransferBatchRequest.messages)
+  return messages_.Mutable(index);
+}
+inline ::tinynet::tdc::TransferRequest* TransferBatchRequest::add_messages() {
+  // @@protoc_insertion_point(field_add:tinynet.tdc.TransferBatchRequest.messages)
+  return messages_.Add();
+}
+inline const ::google::protobuf::RepeatedPtrField< ::tinynet::tdc::TransferRequest >&
+TransferBatchRequest::messages() const {
+  // @@protoc_insertion_point(field_list:tinynet.tdc.TransferBatchRequest.messages)
+  return messages_;
+}
+inline ::google::protobuf::RepeatedPtrField< ::tinynet::tdc::TransferRequest >*
+TransferBatchRequest::mutable_messages() {
+  // @@protoc_insertion_point(field_mutable_list:tinynet.tdc.TransferBatchRequest.messages)
+  return &messages_;
+}
+
+// -------------------------------------------------------------------
+
+// TransferBatchResponse
+
+// repeated .tinynet.tdc.TransferResponse results = 1;
+inline int TransferBatchResponse::results_size() const {
+  return results_.size();
+}
+inline void TransferBatchResponse::clear_results() {
+  results_.Clear();
+}
+inline const ::tinynet::tdc::TransferResponse& TransferBatchResponse::results(int index) const {
+  // @@protoc_insertion_point(field_get:tinynet.tdc.TransferBatchResponse.results)
+  return results_.Get(index);
+}
+inline ::tinynet::tdc::TransferResponse* TransferBatchResponse::mutable_results(int index) {
+  // @@protoc_insertion_point(field_mutable:tinynet.tdc.TransferBatchResponse.results)
+  return results_.Mutable(index);
+}
+inline ::tinynet::tdc::TransferResponse* TransferBatchResponse::add_results() {
+  // @@protoc_insertion_point(field_add:tinynet.tdc.TransferBatchResponse.results)
+  return results_.Add();
+}
+inline const ::google::protobuf::RepeatedPtrField< ::tinynet::tdc::TransferResponse >&
+TransferBatchResponse::results() const {
+  // @@protoc_insertion_point(field_list:tinynet.tdc.TransferBatchResponse.results)
+  return results_;
+}
+inline ::google::protobuf::RepeatedPtrField< ::tinynet::tdc::TransferResponse >*
+TransferBatchResponse::mutable_results() {
+  // @@protoc_insertion_point(field_mutable_list:tinynet.tdc.TransferBatchResponse.results)
+  return &results_;
+}
+
 
 // @@protoc_insertion_point(namespace_scope)
 
@@ -2,6 +2,7 @@
 // Author: Xianfeng Shang (shangxianfeng@outlook.com)
 #include "tdc_channel.h"
 #include "net/stream_socket.h"
+#include "ipc/shm_socket.h"
 #include "tdc_service.h"
 #include "base/error_code.h"
 #include "logging/logging.h"
@@ -10,27 +11,46 @@
 #include "google/protobuf/stubs/common.h"
 #include "util/net_utils.h"
 #include "util/uri_utils.h"
+#include "base/clock.h"
 #include <algorithm>
 
 namespace tinynet {
 namespace tdc {
 
-static const uint32_t kMaxSendWindowSize = 16;
-static const uint32_t kInitSendWindowSize = 1;
+static const uint32_t kInitSendWindowSize = 16;
+static const uint32_t kMinSendWindowSize = 4;
+static const uint32_t kMaxSendWindowSize = 64 * 1024;
+static const size_t kMaxBatchCount = 1024;
+static const size_t kMaxBatchBytes = 256 * 1024;
+static const int64_t kMinRttLifetime = 10 * 1000 * 1000;
+static const int64_t kMinQueueDelay = 5 * 1000;
 static const int kMessageQueueOverflowThreshold = 100000;
 static const int kMaxRetryCount = 3;
 static const int kMaxRetryDelay = 10 * 1000;
+//A server refusing TransferBatch is asked again after that, it may have been upgraded
+static const int64_t kBatchRetryInterval = 5 * 60 * 1000 * 1000LL;
 
 TdcChannel::TdcChannel(const std::string& name, TdcService *service) :
     guid_(NewUniqueId()),
     name_(name),
     service_(service),
     state_(CS_INIT),
+    unsent_bytes_(0),
+    flush_task_(INVALID_TASK_ID),
     send_window_(kInitSendWindowSize),
+    slow_start_threshold_(kMaxSendWindowSize),
+    window_credit_(0),
+    min_rtt_(0),
+    min_rtt_time_(0),
+    recovery_time_(0),
+    batch_refused_(false),
+    batch_acked_(false),
+    batch_refused_time_(0),
     retry_count(0),
     error_code_(0),
     timer_guid_(0) {
     channel_ = std::make_shared<rpc::RpcChannel>(service_->event_loop());
+    channel_->set_compress_threshold((size_t)service_->get_options().compressThreshold);
     stub_ = std::make_shared <TdcRpcService_Stub>(channel_.get());
 }
 
@@ -38,6 +58,9 @@ TdcChannel::~TdcChannel() {
     if (timer_guid_) {
         service_->event_loop()->ClearTimer(timer_guid_);
     }
+    if (flush_task_ != INVALID_TASK_ID) {
+        service_->event_loop()->CancelTask(flush_task_);
+    }
 }
 
 void TdcChannel::Init() {
@@ -52,12 +75,17 @@ void TdcChannel::SendMsg(const void* body, size_t len, TdcMessageCallback callba
 }
 
 void TdcChannel::SendMsg(TdcMessagePtr msg) {
+    unsent_bytes_ += msg->get_request().body().size();
     send_queue_.Emplace(std::move(msg));
     if (send_queue_.Size() >= kMessageQueueOverflowThreshold) {
         HandleError(ERROR_TDC_MESSAGEQUEUEOVERFLOW);
         return;
     }
-    Update();
+    if (send_queue_.Rsize() >= kMaxBatchCount || unsent_bytes_ >= kMaxBatchBytes) {
+        Update();
+        return;
+    }
+    FlushLater();
 }
 
 void TdcChannel::HandleError(int err) {
@@ -65,13 +93,53 @@ void TdcChannel::HandleError(int err) {
              guid_, name_.c_str(), err, tinynet_strerror(err));
     error_code_ = err;
     state_ = CS_INIT;
+    target_.reset();
+    //The calls failed by the reset find nothing in flight
+    inflight_.clear();
+    ResetWindow();
     channel_->Reset();
     Run(err);
 }
 
+void TdcChannel::FlushLater() {
+    if (flush_task_ != INVALID_TASK_ID) return;
+    flush_task_ = service_->event_loop()->AddTask([this] {
+        flush_task_ = INVALID_TASK_ID;
+        Update();
+    });
+}
+
 void TdcChannel::Send() {
+    if (state_ == CS_LOCAL) {
+        SendLocal();
+        return;
+    }
+    if (batch_refused_ && send_queue_.Lsize() == 0 && STime_us() - batch_refused_time_ > kBatchRetryInterval) {
+        //Nothing in flight, the answers of both kinds never mix
+        batch_refused_ = false;
+        batch_acked_ = false;
+    }
+    if (batch_refused_) {
+        SendEach();
+        return;
+    }
+    while (send_queue_.Rsize() > 0 && send_queue_.Lsize() < send_window_) {
+        TdcBatchPtr batch = std::make_shared<TdcBatch>();
+        size_t bytes = 0;
+        do {
+            bytes += batch->Add(send_queue_.Next());
+        } while (send_queue_.Rsize() > 0 && send_queue_.Lsize() < send_window_ &&
+                 batch->size() < kMaxBatchCount && bytes < kMaxBatchBytes);
+        unsent_bytes_ -= (std::min)(bytes, unsent_bytes_);
+        inflight_.push_back(batch);
+        batch->Send(stub_.get(), google::protobuf::NewCallback(service_, &TdcService::AfterSendBatch, guid_, batch));
+    }
+}
+
+void TdcChannel::SendEach() {
     while (send_queue_.Rsize() > 0 && send_queue_.Lsize() < send_window_) {
         TdcMessagePtr msg = send_queue_.Next();
+        unsent_bytes_ -= (std::min)(msg->get_request().body().size(), unsent_bytes_);
         msg->Send(stub_.get(), google::protobuf::NewCallback(service_, &TdcService::AfterSend, guid_, msg->get_guid()));
     }
 }
@@ -85,6 +153,7 @@ void TdcChannel::Resend(int err) {
     ++retry_count;
     uint64_t delay = (std::min)(retry_count * retry_count * 1000, kMaxRetryDelay);
     state_ = CS_INIT;
+    ResetWindow();
 
     timer_guid_ = service_->event_loop()->AddTimer(delay, 0, std::bind(&TdcChannel::UpdateLater, this));
 }
@@ -120,11 +189,150 @@ void TdcChannel::AfterSend(int64_t msg_guid) {
     }
     send_queue_.Pop();
     msg->Run(err);
-    send_window_ = (std::min)(send_window_ * 2, kMaxSendWindowSize);
     retry_count = 0;
     Send();
 }
 
+void TdcChannel::AfterSendBatch(const TdcBatchPtr& batch) {
+    if (inflight_.empty() || inflight_.front() != batch) {
+        //Failed or put back together with the rest of the queue already
+        return;
+    }
+    inflight_.pop_front();
+    int err = batch->get_controller().ErrorCode();
+    //A server answering errors says so when it lacks TransferBatch. One too old for that closes the connection
+    //instead, whereas a closed connection is only a restart for a server which could have answered.
+    if (err == ERROR_RPC_METHODNOTFOUND ||
+        (err == ERROR_SOCKET_READ_EOF && !batch_acked_ && !channel_->CanReplyError())) {
+        batch_refused_ = true;
+        batch_refused_time_ = STime_us();
+        log_warning("TDC channel(%lld, %s) TransferBatch refused, err:%d, sending the messages one by one",
+                    guid_, name_.c_str(), err);
+        unsent_bytes_ += batch->Restore();
+        RestoreInflight();
+        send_queue_.Rewind();
+        ResetWindow();
+        //Sent again once the RPC channel is done failing the other batches, whose answers are ignored
+        FlushLater();
+        return;
+    }
+    if (err) {
+        HandleError(err);
+        return;
+    }
+    batch_acked_ = true;
+    size_t count = batch->size();
+    if (send_queue_.Lsize() < count || send_queue_.Front() != batch->get_message(0)) {
+        HandleError(ERROR_TDC_MESSAGEOUTOFSEQUENCE);
+        return;
+    }
+    std::vector<int32_t> results(count);
+    size_t delivered = 0;
+    for (; delivered < count; ++delivered) {
+        results[delivered] = batch->GetResult(delivered);
+        if (results[delivered] == ERROR_TDC_SERVICEMOVED) {
+            break;
+        }
+    }
+    for (size_t i = 0; i < delivered; ++i) {
+        send_queue_.Pop();
+    }
+    if (delivered < count) {
+        //The messages before the first moved one are done with, the rest go again
+        unsent_bytes_ += batch->Restore(delivered);
+        RestoreInflight();
+        send_queue_.Rewind();
+        Resend(ERROR_TDC_SERVICEMOVED);
+    } else {
+        OnAcked(count, STime_us() - batch->get_send_time());
+        retry_count = 0;
+    }
+    for (size_t i = 0; i < delivered; ++i) {
+        batch->get_message(i)->Run(results[i]);
+    }
+    if (state_ == CS_RESOLVED) {
+        Send();
+    }
+}
+
+void TdcChannel::OnAcked(size_t acked, int64_t rtt) {
+    int64_t now = STime_us();
+    //The floor expires now and then in case the path got slower for good
+    if (min_rtt_ == 0 || rtt <= min_rtt_ || now - min_rtt_time_ > kMinRttLifetime) {
+        min_rtt_ = rtt;
+        min_rtt_time_ = now;
+    }
+    //Time above the floor is spent in queues, mostly the peer's loop falling behind: back off before they grow
+    if (rtt - min_rtt_ > (std::max)(min_rtt_, kMinQueueDelay)) {
+        if (now >= recovery_time_) {
+            send_window_ = (std::max)(send_window_ * 7 / 10, kMinSendWindowSize);
+            slow_start_threshold_ = send_window_;
+            window_credit_ = 0;
+            //Once per round trip, the batches in flight went out with the old window
+            recovery_time_ = now + rtt;
+        }
+        return;
+    }
+    if (send_window_ < slow_start_threshold_) {
+        //Doubles per round trip until the first back off
+        send_window_ += (uint32_t)acked;
+    } else {
+        //An eighth more per round trip
+        window_credit_ += (uint32_t)acked;
+        send_window_ += window_credit_ / 8;
+        window_credit_ %= 8;
+    }
+    send_window_ = (std::min)(send_window_, kMaxSendWindowSize);
+}
+
+void TdcChannel::ResetWindow() {
+    send_window_ = kInitSendWindowSize;
+    slow_start_threshold_ = kMaxSendWindowSize;
+    window_credit_ = 0;
+    min_rtt_ = 0;
+    min_rtt_time_ = 0;
+    recovery_time_ = 0;
+}
+
+void TdcChannel::RestoreInflight() {
+    //The requests were serialized when sent, answers still to come for them are dropped
+    for (auto& batch : inflight_) {
+        unsent_bytes_ += batch->Restore();
+    }
+    inflight_.clear();
+}
+
+void TdcChannel::SendLocal() {
+    //The mailbox keeps the order, every queued message is handed over at once
+    unsent_bytes_ = 0;
+    while (send_queue_.Rsize() > 0) {
+        TdcMessagePtr msg = send_queue_.Next();
+        std::string body;
+        msg->TakeBody(&body);
+        if (!target_->Post(std::bind(&TdcService::DeliverLocal, target_, service_->get_local_endpoint(),
+                                     guid_, msg->get_guid(), std::move(body)))) {
+            HandleError(ERROR_TDC_SERVICEUNAVAILABLE);
+            return;
+        }
+    }
+}
+
+void TdcChannel::AfterDeliverLocal(int64_t msg_guid, int32_t err) {
+    if (state_ != CS_LOCAL) {
+        //Failed together with the rest of the queue already
+        return;
+    }
+    if (err == ERROR_TDC_SERVICEUNAVAILABLE) {
+        //The service stopped, it may run somewhere else by now
+        HandleError(err);
+        return;
+    }
+    if (send_queue_.Lsize() > 0) {
+        send_queue_.Front()->SetResult(err);
+    }
+    AfterSend(msg_guid);
+}
+
 void TdcChannel::Update() {
     switch (state_) {
     case CS_INIT:
@@ -133,6 +341,7 @@ void TdcChannel::Update() {
     case CS_RESOLVING:
         break;
     case CS_RESOLVED:
+    case CS_LOCAL:
         Send();
         break;
     default:
@@ -154,6 +363,13 @@ void TdcChannel::Resolve() {
         address_name.append(service_->get_root_dir()).append(name_);
         resolving_name = &address_name;
     }
+    if ((target_ = TdcLocalDirectory::Instance()->Find(*resolving_name)) && service_->get_local_endpoint()) {
+        log_info("TDC channel(%lld, %s) delivers to %s inside the process", guid_, name_.c_str(), resolving_name->c_str());
+        state_ = CS_LOCAL;
+        SendLocal();
+        return;
+    }
+    target_.reset();
     log_info("TDC channel(%lld, %s) resolving name:%s", guid_, name_.c_str(), resolving_name->c_str());
     service_->get_resolver()->Get(*resolving_name, std::bind(&TdcService::AfterResolved, service_, guid_, std::placeholders::_1));
     state_ = CS_RESOLVING;
@@ -166,7 +382,8 @@ void TdcChannel::AfterResolved(const naming::NamingReply& reply) {
         HandleError(reply.err);
         return;
     }
-    if (!UriUtils::parse_address(reply.value, &host_, &port_)) {
+    bool shm = ipc::ShmSocket::is_shm_url(reply.value);
+    if (!shm && !UriUtils::parse_address(reply.value, &host_, &port_)) {
         HandleError(ERROR_TNS_UNRECOGNIZEDFORMAT);
         return;
     }
@@ -174,15 +391,24 @@ void TdcChannel::AfterResolved(const naming::NamingReply& reply) {
              guid_, name_.c_str(), reply.value.c_str());
     net::ChannelOptions opts;
     opts.name = name_;
-    opts.host = host_;
-    opts.port = port_;
+    if (shm) {
+        opts.url = reply.value;
+    } else {
+        opts.host = host_;
+        opts.port = port_;
+    }
     opts.debug = true;
     channel_->Init(opts);
+    //Another server may stand behind the name now, batches are tried again
+    batch_refused_ = false;
+    batch_acked_ = false;
     state_ = CS_RESOLVED;
     Update();
 }
 
 void TdcChannel::Run(int err) {
+    inflight_.clear();
+    unsent_bytes_ = 0;
     send_queue_.Run(err);
 }
 
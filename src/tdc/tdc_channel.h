@@ -5,6 +5,9 @@
 #include "tdc_message.h"
 #include "tdc_message_queue.h"
 #include "naming/naming_resolver.h"
+#include "tdc_local_directory.h"
+#include "net/task_manager.h"
+#include <deque>
 
 namespace tinynet {
 namespace tdc {
@@ -22,7 +25,8 @@ class TdcChannel {
     enum ChannelState {
         CS_INIT = 0,
         CS_RESOLVING = 1,
-        CS_RESOLVED = 2
+        CS_RESOLVED = 2,
+        CS_LOCAL = 3 ///< The service runs in this process, messages go through its mailbox
     };
   public:
     void Init();
@@ -44,12 +48,34 @@ class TdcChannel {
 
     void UpdateLater();
 
+    //Sends the queued messages at the end of the loop iteration, batched
+    void FlushLater();
+
     void Send();
+    //Sends the queued messages with a Transfer call each, to a server without TransferBatch
+    void SendEach();
 
     void Resend(int err);
 
     void AfterSend(int64_t msg_guid);
 
+    void AfterSendBatch(const TdcBatchPtr& batch);
+    /**
+     * @brief Adapts the send window to the round trip time of an answered batch
+     *
+     * @param acked messages answered
+     * @param rtt microseconds
+     */
+    void OnAcked(size_t acked, int64_t rtt);
+    //Starts the window over, the path changed or failed
+    void ResetWindow();
+    //Gives the bodies back to the messages in flight so that they can be sent again
+    void RestoreInflight();
+
+    void SendLocal();
+
+    void AfterDeliverLocal(int64_t msg_guid, int32_t err);
+
     void Resolve();
 
     void AfterResolved(const naming::NamingReply& reply);
@@ -60,10 +86,22 @@ class TdcChannel {
     std::string			name_;
     rpc::RpcChannelPtr  channel_;
     StubPtr				stub_;
+    TdcLocalEndpointPtr	target_; ///< Mailbox of the service when it runs in this process
     TdcService *		service_;
     ChannelState		state_;
     TdcMessageQueue		send_queue_;
-    uint32_t			send_window_;
+    std::deque<TdcBatchPtr> inflight_; ///< Batches awaiting their answer, in the order sent
+    size_t				unsent_bytes_; ///< Bodies queued but not sent yet
+    TaskId				flush_task_;
+    uint32_t			send_window_; ///< Messages allowed in flight
+    uint32_t			slow_start_threshold_;
+    uint32_t			window_credit_; ///< Messages acked toward the next additive increase
+    int64_t				min_rtt_; ///< Microseconds, the round trip time without queueing
+    int64_t				min_rtt_time_;
+    int64_t				recovery_time_; ///< The window is not cut again before that
+    bool				batch_refused_; ///< The server lacks TransferBatch
+    bool				batch_acked_; ///< A batch was answered since the name was resolved
+    int64_t				batch_refused_time_;
     std::string			host_;
     int					port_;
     int					retry_count;
@@ -0,0 +1,54 @@
+// Copyright (C), Xianfeng Shang.  All rights reserved.
+// Author: Xianfeng Shang (shangxianfeng@outlook.com)
+#include "tdc_local_directory.h"
+#include <thread>
+#include "net/event_loop.h"
+
+namespace tinynet {
+namespace tdc {
+
+TdcLocalEndpoint::TdcLocalEndpoint(EventLoop* loop, TdcService* service) :
+    event_loop_(loop),
+    service_(service) {
+}
+
+//Post() announces itself before looking at closed_, Close() sets closed_ before waiting for the posters:
+//with sequentially consistent accesses a task is either refused or queued before Close() returns.
+bool TdcLocalEndpoint::Post(TaskFunc task) {
+    posting_.fetch_add(1);
+    bool open = !closed_.load();
+    if (open) {
+        event_loop_->AddTask(std::move(task));
+    }
+    posting_.fetch_sub(1);
+    return open;
+}
+
+void TdcLocalEndpoint::Close() {
+    closed_.store(true);
+    while (posting_.load() != 0) {
+        std::this_thread::yield();
+    }
+    service_ = nullptr;
+}
+
+void TdcLocalDirectory::Register(const std::string& name, TdcLocalEndpointPtr endpoint) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    endpoints_[name] = std::move(endpoint);
+}
+
+void TdcLocalDirectory::Unregister(const std::string& name, const TdcLocalEndpoint* endpoint) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = endpoints_.find(name);
+    if (it != endpoints_.end() && it->second.get() == endpoint) {
+        endpoints_.erase(it);
+    }
+}
+
+TdcLocalEndpointPtr TdcLocalDirectory::Find(const std::string& name) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = endpoints_.find(name);
+    return it != endpoints_.end() ? it->second : nullptr;
+}
+}
+}
@@ -0,0 +1,71 @@
+// Copyright (C), Xianfeng Shang.  All rights reserved.
+// Author: Xianfeng Shang (shangxianfeng@outlook.com)
+#pragma once
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include "base/singleton.h"
+#include "net/task_manager.h"
+
+namespace tinynet {
+class EventLoop;
+namespace tdc {
+class TdcService;
+
+//Mailbox of a TDC service, other apps of the process post tasks to its event loop through it.
+//Posting is lock-free, the task queue of the event loop is the mailbox.
+class TdcLocalEndpoint {
+  public:
+    TdcLocalEndpoint(EventLoop* loop, TdcService* service);
+  public:
+    /**
+     * @brief Runs task on the loop of the service, thread safe.
+     * Returns false once the endpoint is closed.
+     *
+     * @param task
+     * @return true
+     * @return false
+     */
+    bool Post(TaskFunc task);
+    /**
+     * @brief Refuses new tasks, returns once no thread is posting any more. Called on the loop of the service.
+     *
+     */
+    void Close();
+    /**
+     * @brief The service, nullptr once closed. Only valid on the loop of the service.
+     *
+     * @return TdcService*
+     */
+    TdcService* get_service() const { return service_; }
+  private:
+    EventLoop* event_loop_;
+    TdcService* service_;
+    std::atomic<bool> closed_{ false };
+    std::atomic<int> posting_{ 0 }; ///< Threads inside Post()
+};
+typedef std::shared_ptr<TdcLocalEndpoint> TdcLocalEndpointPtr;
+
+//Process-local directory of the started TDC services by their naming name,
+//messages to a service found here skip the naming service and the network.
+class TdcLocalDirectory:
+    public tinynet::Singleton<TdcLocalDirectory> {
+  public:
+    void Register(const std::string& name, TdcLocalEndpointPtr endpoint);
+    /**
+     * @brief Removes name if it is still registered by endpoint
+     *
+     * @param name
+     * @param endpoint
+     */
+    void Unregister(const std::string& name, const TdcLocalEndpoint* endpoint);
+
+    TdcLocalEndpointPtr Find(const std::string& name);
+  private:
+    std::mutex mutex_;
+    std::unordered_map<std::string, TdcLocalEndpointPtr> endpoints_;
+};
+}
+}
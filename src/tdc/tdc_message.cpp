@@ -1,8 +1,14 @@
 // Copyright (C), Xianfeng Shang.  All rights reserved.
 // Author: Xianfeng Shang (shangxianfeng@outlook.com)
 #include "tdc_message.h"
+#include "base/clock.h"
+#include "base/error_code.h"
+#include "logging/logging.h"
 namespace tinynet {
 namespace tdc {
+//Transfers not answered by then fail and go again, the service skips those it reads too late
+static const int64_t kTransferTimeout = 10 * 1000;
+
 TdcMessage::TdcMessage(int64_t guid,
                        const std::string &body,
                        TdcMessageCallback callback) :
@@ -40,8 +46,59 @@ void TdcMessage::Run(int32_t err) {
 
 void TdcMessage::Send(TdcRpcService_Stub *stub, ::google::protobuf::Closure *done) {
     controller_.Reset();
+    controller_.SetTimeout(kTransferTimeout);
     return stub->Transfer(&controller_, &request_, &response_, done);
 }
 
+void TdcMessage::TakeBody(std::string* body) {
+    request_.mutable_body()->swap(*body);
+}
+
+void TdcMessage::RestoreBody(std::string* body) {
+    request_.mutable_body()->swap(*body);
+}
+
+void TdcMessage::SetResult(int32_t err) {
+    controller_.Reset();
+    response_.set_guid(request_.guid());
+    response_.set_error_code(err);
+}
+size_t TdcBatch::Add(TdcMessagePtr msg) {
+    tdc::TransferRequest* entry = request_.add_messages();
+    entry->set_guid(msg->get_guid());
+    msg->TakeBody(entry->mutable_body());
+    messages_.push_back(std::move(msg));
+    return entry->body().size();
+}
+
+void TdcBatch::Send(TdcRpcService_Stub *stub, ::google::protobuf::Closure *done) {
+    controller_.Reset();
+    controller_.SetTimeout(kTransferTimeout);
+    send_time_ = STime_us();
+    stub->TransferBatch(&controller_, &request_, &response_, done);
+}
+
+size_t TdcBatch::Restore(size_t index) {
+    size_t bytes = 0;
+    for (size_t i = index; i < messages_.size(); ++i) {
+        std::string* body = request_.mutable_messages((int)i)->mutable_body();
+        bytes += body->size();
+        messages_[i]->RestoreBody(body);
+    }
+    return bytes;
+}
+
+int32_t TdcBatch::GetResult(size_t index) const {
+    if ((int)index >= response_.results_size()) {
+        return ERROR_TDC_SERVICEUNAVAILABLE;
+    }
+    const tdc::TransferResponse& result = response_.results((int)index);
+    if (result.guid() != messages_[index]->get_guid()) {
+        log_warning("TDC batch request msg guid %lld not equal response msg guid %lld",
+                    messages_[index]->get_guid(), result.guid());
+    }
+    return result.error_code();
+}
+
 }
 }
@@ -6,6 +6,7 @@
 #include "tdc.pb.h"
 #include <memory>
 #include <functional>
+#include <vector>
 #include "rpc/rpc_controller.h"
 #include "base/io_buffer.h"
 
@@ -24,6 +25,12 @@ class TdcMessage {
   public:
     void Run(int32_t err);
     void Send(TdcRpcService_Stub* stub, ::google::protobuf::Closure* done);
+    //Moves the body out of the request, for delivery inside the process
+    void TakeBody(std::string* body);
+    //Puts back a body taken by TakeBody()
+    void RestoreBody(std::string* body);
+    //Records the result of a delivery inside the process as if the response had arrived
+    void SetResult(int32_t err);
   public:
     const tdc::TransferRequest& get_request() const {
         return request_;
@@ -43,5 +50,50 @@ class TdcMessage {
     rpc::RpcController controller_;
     TdcMessageCallback callback_;
 };
+
+class TdcBatch;
+typedef std::shared_ptr<TdcBatch> TdcBatchPtr;
+
+//Consecutive messages of a channel carried by one TransferBatch call.
+//The bodies move into the request and back out by Restore() when the messages have to be sent again.
+class TdcBatch {
+  public:
+    /**
+     * @brief Appends msg to the request
+     *
+     * @param msg
+     * @return size_t the size of its body
+     */
+    size_t Add(TdcMessagePtr msg);
+    void Send(TdcRpcService_Stub* stub, ::google::protobuf::Closure* done);
+    /**
+     * @brief Gives the bodies back to the messages from the index-th on
+     *
+     * @param index
+     * @return size_t the bytes given back
+     */
+    size_t Restore(size_t index = 0);
+    //Result of the index-th message, ERROR_TDC_SERVICEUNAVAILABLE when the response lacks it
+    int32_t GetResult(size_t index) const;
+  public:
+    size_t size() const {
+        return messages_.size();
+    }
+    const TdcMessagePtr& get_message(size_t index) const {
+        return messages_[index];
+    }
+    const rpc::RpcController& get_controller() const {
+        return controller_;
+    }
+    int64_t get_send_time() const {
+        return send_time_;
+    }
+  private:
+    std::vector<TdcMessagePtr> messages_;
+    tdc::TransferBatchRequest request_;
+    tdc::TransferBatchResponse response_;
+    rpc::RpcController controller_;
+    int64_t send_time_{ 0 }; ///< Microseconds, for the round trip time
+};
 }
 }
@@ -23,5 +23,19 @@ void TdcRpcServiceImpl::Transfer(::google::protobuf::RpcController* controller,
     service_->ParseMessage(request->body());
     response->set_error_code(ERROR_OK);
 }
+
+void TdcRpcServiceImpl::TransferBatch(::google::protobuf::RpcController* controller,
+                                      const ::tinynet::tdc::TransferBatchRequest* request,
+                                      ::tinynet::tdc::TransferBatchResponse* response,
+                                      ::google::protobuf::Closure* done) {
+    rpc::ClosureGuard done_guard(done);
+    response->mutable_results()->Reserve(request->messages_size());
+    for (auto& msg : request->messages()) {
+        auto result = response->add_results();
+        result->set_guid(msg.guid());
+        service_->ParseMessage(msg.body());
+        result->set_error_code(ERROR_OK);
+    }
+}
 }
 }
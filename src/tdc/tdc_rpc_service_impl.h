@@ -17,6 +17,11 @@ class TdcRpcServiceImpl :
                   const ::tinynet::tdc::TransferRequest* request,
                   ::tinynet::tdc::TransferResponse* response,
                   ::google::protobuf::Closure* done) override;
+
+    void TransferBatch(::google::protobuf::RpcController* controller,
+                       const ::tinynet::tdc::TransferBatchRequest* request,
+                       ::tinynet::tdc::TransferBatchResponse* response,
+                       ::google::protobuf::Closure* done) override;
   private:
     TdcService * service_;
 };
@@ -7,6 +7,7 @@
 #include "base/error_code.h"
 #include "util/string_utils.h"
 #include "util/uri_utils.h"
+#include "ipc/shm_socket.h"
 
 namespace tinynet {
 namespace tdc {
@@ -32,6 +33,7 @@ TdcService::~TdcService() {
     if (register_timer_) {
         event_loop_->ClearTimer(register_timer_);
     }
+    UnregisterLocal();
 }
 
 void TdcService::Init(const TdcOptions& opts) {
@@ -44,8 +46,10 @@ void TdcService::Init(const TdcOptions& opts) {
     }
     address_.first.append(root_dir_).append(options_.name);
     resolver_.reset(new(std::nothrow)naming::NamingResolver(event_loop_));
+    resolver_->set_compress_threshold((size_t)opts.compressThreshold);
     resolver_->Init(opts.tns_addrs);
     server_.reset(new(std::nothrow) rpc::RpcServer(event_loop_));
+    server_->set_compress_threshold((size_t)opts.compressThreshold);
     auto service_impl = std::make_shared<TdcRpcServiceImpl>(this);
     server_->RegisterService(std::static_pointer_cast<::google::protobuf::Service>(service_impl));
 }
@@ -61,6 +65,7 @@ int TdcService::Start(const std::tuple<int, int>& ports)  {
         return err;
     }
     StringUtils::Format(address_.second, "tcp://%s:%d", host.c_str(), server_->get_listen_port());
+    RegisterLocal();
     register_timer_ = event_loop_->AddTimer(0, options_.registrationInterval, std::bind(&TdcService::RegisterService, this));
     return err;
 }
@@ -69,6 +74,18 @@ int TdcService::Start(const std::string& addr) {
     std::string host;
     int port = 0;
     int err = ERROR_OK;
+    if (ipc::ShmSocket::is_shm_url(addr)) {
+        //Only reachable by the services of the same host
+        net::ServerOptions opts;
+        opts.listen_url = addr;
+        if ((err = server_->Start(opts)) != ERROR_OK) {
+            return err;
+        }
+        address_.second = addr;
+        RegisterLocal();
+        register_timer_ = event_loop_->AddTimer(0, options_.registrationInterval, std::bind(&TdcService::RegisterService, this));
+        return err;
+    }
     if (!UriUtils::parse_address(addr, &host, &port)) {
         err = ERROR_URI_UNRECOGNIZED;
         return err;
@@ -81,6 +98,7 @@ int TdcService::Start(const std::string& addr) {
         return err;
     }
     UriUtils::format_address(address_.second, "tcp", host, &port);
+    RegisterLocal();
     register_timer_ = event_loop_->AddTimer(0, options_.registrationInterval, std::bind(&TdcService::RegisterService, this));
     return err;
 }
@@ -169,6 +187,15 @@ void TdcService::AfterSend(int64_t channel_guid, int64_t msg_guid) {
     log_warning("Can not find channel[%lld], maybe removed!", channel_guid);
 }
 
+void TdcService::AfterSendBatch(int64_t channel_guid, TdcBatchPtr batch) {
+    auto channel = GetChannel(channel_guid);
+    if (channel) {
+        channel->AfterSendBatch(batch);
+        return;
+    }
+    log_warning("Can not find channel[%lld], maybe removed!", channel_guid);
+}
+
 void TdcService::AfterResolved(int64_t channel_guid, const naming::NamingReply& reply) {
     auto channel = GetChannel(channel_guid);
     if (channel) {
@@ -178,6 +205,42 @@ void TdcService::AfterResolved(int64_t channel_guid, const naming::NamingReply&
     log_warning("Can not find channel[%lld], maybe removed!", channel_guid);
 }
 
+void TdcService::RegisterLocal() {
+    if (local_endpoint_) return;
+    local_endpoint_ = std::make_shared<TdcLocalEndpoint>(event_loop_, this);
+    TdcLocalDirectory::Instance()->Register(address_.first, local_endpoint_);
+}
+
+void TdcService::UnregisterLocal() {
+    if (!local_endpoint_) return;
+    TdcLocalDirectory::Instance()->Unregister(address_.first, local_endpoint_.get());
+    //Messages already posted find no service and fail with ERROR_TDC_SERVICEUNAVAILABLE
+    local_endpoint_->Close();
+    local_endpoint_.reset();
+}
+
+void TdcService::DeliverLocal(TdcLocalEndpointPtr target, TdcLocalEndpointPtr source,
+                              int64_t channel_guid, int64_t msg_guid, const std::string& body) {
+    int32_t err = ERROR_OK;
+    if (auto service = target->get_service()) {
+        service->ParseMessage(body);
+    } else {
+        err = ERROR_TDC_SERVICEUNAVAILABLE;
+    }
+    source->Post(std::bind(&TdcService::AfterDeliverLocal, source, channel_guid, msg_guid, err));
+}
+
+void TdcService::AfterDeliverLocal(TdcLocalEndpointPtr source, int64_t channel_guid, int64_t msg_guid, int32_t err) {
+    auto service = source->get_service();
+    if (!service) return;
+    auto channel = service->GetChannel(channel_guid);
+    if (channel) {
+        channel->AfterDeliverLocal(msg_guid, err);
+        return;
+    }
+    log_warning("Can not find channel[%lld], maybe removed!", channel_guid);
+}
+
 bool TdcService::ParseMessage(const std::string& msg_body) {
     if (receive_msg_cb_) {
         return receive_msg_cb_(msg_body);
@@ -189,6 +252,7 @@ void TdcService::Stop() {
     if (register_timer_) {
         event_loop()->ClearTimer(register_timer_);
     }
+    UnregisterLocal();
     if (resolver_) {
         resolver_->Stop();
     }
@@ -5,6 +5,7 @@
 #include "rpc/rpc_server.h"
 #include "net/event_loop.h"
 #include "tdc_channel.h"
+#include "tdc_local_directory.h"
 #include <functional>
 #include <tuple>
 
@@ -19,6 +20,7 @@ struct TdcOptions {
     int expiryTime{ 0 };
     bool debugMode{ false };
     std::string nameSpace;
+    int compressThreshold{ 0 }; ///< Message bodies of at least this many bytes are sent compressed, 0 disables it
 };
 
 //TinyNet distributed communication service
@@ -44,6 +46,8 @@ class TdcService {
   public:
     const std::string& get_root_dir() { return root_dir_; }
 
+    const TdcOptions& get_options() const { return options_; }
+
     EventLoop * event_loop() { return event_loop_; }
 
     naming::NamingResolver* get_resolver() { return resolver_.get(); }
@@ -51,13 +55,24 @@ class TdcService {
     rpc::RpcServer* get_server() { return server_.get(); }
 
     bool ExistsChannel(const std::string& name);
+
+    const TdcLocalEndpointPtr& get_local_endpoint() const { return local_endpoint_; }
   private:
     TdcChannelPtr GetChannel(const std::string& name);
     TdcChannelPtr GetChannel(int64_t guid);
     TdcChannelPtr RemoveChannel(const std::string& name);
     void RegisterService();
     void AfterSend(int64_t channel_guid, int64_t msg_guid);
+
+    void AfterSendBatch(int64_t channel_guid, TdcBatchPtr batch);
     void AfterResolved(int64_t channel_guid, const naming::NamingReply& reply);
+    void RegisterLocal();
+    void UnregisterLocal();
+    //Runs on the loop of the receiving service
+    static void DeliverLocal(TdcLocalEndpointPtr target, TdcLocalEndpointPtr source,
+                             int64_t channel_guid, int64_t msg_guid, const std::string& body);
+    //Runs on the loop of the sending service
+    static void AfterDeliverLocal(TdcLocalEndpointPtr source, int64_t channel_guid, int64_t msg_guid, int32_t err);
   public:
     bool ParseMessage(const std::string& msg_body);
 
@@ -73,6 +88,7 @@ class TdcService {
     std::unique_ptr<naming::NamingResolver> resolver_;
     std::unique_ptr<rpc::RpcServer>	server_;
     ChannelMap			channels_;
+    TdcLocalEndpointPtr	local_endpoint_; ///< Mailbox for the apps of this process, registered while started
     int64_t				register_timer_;
     TdcReceiveMessageCallback	receive_msg_cb_;
     uint64_t			failed_count_;
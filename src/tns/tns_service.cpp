@@ -31,6 +31,7 @@ int TnsService::Init(const std::string& name, const raft::NodeConfig& raft_confi
         err = ERROR_OS_OOM;
         return err;
     }
+    server_->set_compress_threshold((size_t)raft_config.compressThreshold);
     raft_->RegisterService(server_.get());
 
     naming_.reset(new(std::nothrow) naming::NamingService(event_loop_));
@@ -171,6 +171,49 @@ int BindAndListenTcp(const char* host, int port, int backlog, int flags, int* er
     return s;
 }
 
+int BindUdp(const char* host, int port, int flags, int* err) {
+    int s, res;
+    char service[6];
+    struct addrinfo hints, *begin, *end, *it;
+    snprintf(service, sizeof(service), "%d", port);
+    service[sizeof(service) - 1] = '\0';
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_DGRAM;
+    hints.ai_flags = AI_PASSIVE;
+    end = NULL;
+    s = -1;
+    res = getaddrinfo(host, service, &hints, &begin);
+    if (res != 0) {
+        *err = tinynet::ERROR_NET_GETADDRINFO;
+        return -1;
+    }
+    *err = tinynet::ERROR_SOCKET_BIND;
+    for (it = begin; it != end; it = it->ai_next) {
+        s = (int)::socket(it->ai_family, it->ai_socktype, it->ai_protocol);
+        if (s == -1) continue;
+        if ((*err = SetNonBlocking(s)) != 0) break;
+        if ((*err = SetReuseAddr(s)) != 0) break;
+        if (it->ai_family == AF_INET6) {
+            if ((*err = SetIPV6Only(s, flags & TCP_FLAGS_IPV6ONLY)) != 0) break;
+        }
+        if (flags & TCP_FLAGS_REUSEPORT) {
+            if ((*err = SetReusePort(s)) != 0) break;
+        }
+        if ((*err = Bind(s, it->ai_addr, (int)it->ai_addrlen)) == 0) {
+            break;
+        } else {
+            Close(s);
+        }
+    }
+    freeaddrinfo(begin);
+    if (*err) {
+        if (s != -1) Close(s);
+        return -1;
+    }
+    return s;
+}
+
 #ifdef _WIN32
 int BindAndListenUnix(const char* path, int backlog, int *err) {
     *err = 0;
@@ -518,9 +561,13 @@ int Writev(int fd, tinynet::iov_t* iov, int len) {
 
 
 int ReadAll(int fd, tinynet::iovs_t& iovs, int* nread) {
+    return ReadAll(fd, &iovs[0], (int)iovs.size(), nread);
+}
+
+int ReadAll(int fd, tinynet::iov_t* iov, int len, int* nread) {
     int err = tinynet::ERROR_OK;
     *nread = 0;
-    int n = (int)Readv(fd, &iovs[0], (int)iovs.size());
+    int n = (int)Readv(fd, iov, len);
     if (n > 0) {
         *nread = n;
     } else if (n == 0) {
@@ -555,9 +602,13 @@ int ReadAll(int fd, void* buf, size_t len, int* nread) {
 
 
 int WriteAll(int fd, tinynet::iovs_t& iovs, int* nwrite) {
+    return WriteAll(fd, &iovs[0], (int)iovs.size(), nwrite);
+}
+
+int WriteAll(int fd, tinynet::iov_t* iov, int len, int* nwrite) {
     int err = tinynet::ERROR_OK;
     *nwrite = 0;
-    int n = (int)Writev(fd, &iovs[0], (int)iovs.size());
+    int n = (int)Writev(fd, iov, len);
     if (n > 0) {
         *nwrite = n;
     } else if(n == 0) {
@@ -624,6 +675,53 @@ int ConnectTcp(const char* host, int port, int af, int* err) {
     return s;
 }
 
+int ConnectUdp(const char* host, int port, int* err) {
+    int s, res;
+    char service[6];
+    struct addrinfo hints, *begin, *end, *it;
+    snprintf(service, sizeof(service), "%d", port);
+    service[sizeof(service) - 1] = '\0';
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_DGRAM;
+    hints.ai_flags = AI_NUMERICSERV;
+    end = NULL;
+    s = -1;
+    *err = 0;
+
+    if ((res = getaddrinfo(host, service, &hints, &begin)) != 0) {
+        *err = tinynet::ERROR_NET_GETADDRINFO;
+        return -1;
+    }
+    *err = tinynet::ERROR_SOCKET_CONNECT;
+    for (it = begin; it != end; it = it->ai_next) {
+        s = (int)socket(it->ai_family, it->ai_socktype, it->ai_protocol);
+        if (s == -1) {
+            continue;
+        }
+        //Connecting a datagram socket only fixes the peer address, it never blocks
+        if ((*err = Connect(s, it->ai_addr, (int)it->ai_addrlen)) != 0) {
+            Close(s);
+            continue;
+        }
+        break;
+    }
+    freeaddrinfo(begin);
+    return *err ? -1 : s;
+}
+
+int GetNameInfo(const struct sockaddr* sa, std::string* ip, int* port) {
+    char host[INET6_ADDRSTRLEN];
+    char service[8];
+    socklen_t len = sa->sa_family == AF_INET6 ? sizeof(struct sockaddr_in6) : sizeof(struct sockaddr_in);
+    if (getnameinfo(sa, len, host, sizeof(host), service, sizeof(service), NI_NUMERICHOST | NI_NUMERICSERV) != 0) {
+        return -1;
+    }
+    if (ip) ip->assign(host);
+    if (port) *port = atoi(service);
+    return 0;
+}
+
 #ifdef _WIN32
 int ConnectUnix(const char* path, int* err) {
     int s;
@@ -932,5 +1030,79 @@ fail:
 int SocketPair(int family, int type, int protocol, int fd[2]) {
     return ::socketpair(family, type, protocol, fd);
 }
+
+int SendFd(int s, int fd, const void* data, size_t len) {
+    union {
+        char buf[CMSG_SPACE(sizeof(int))];
+        struct cmsghdr align;
+    } control;
+    const char* p = (const char*)data;
+    bool pass_fd = fd != -1;
+    while (len > 0) {
+        struct iovec iov;
+        iov.iov_base = (void*)p;
+        iov.iov_len = len;
+        struct msghdr msg;
+        memset(&msg, 0, sizeof(msg));
+        msg.msg_iov = &iov;
+        msg.msg_iovlen = 1;
+        if (pass_fd) {
+            memset(&control, 0, sizeof(control));
+            msg.msg_control = control.buf;
+            msg.msg_controllen = sizeof(control.buf);
+            struct cmsghdr* cmsg = CMSG_FIRSTHDR(&msg);
+            cmsg->cmsg_level = SOL_SOCKET;
+            cmsg->cmsg_type = SCM_RIGHTS;
+            cmsg->cmsg_len = CMSG_LEN(sizeof(int));
+            memcpy(CMSG_DATA(cmsg), &fd, sizeof(int));
+        }
+        ssize_t n = ::sendmsg(s, &msg, 0);
+        if (n == -1) {
+            if (errno == EINTR) continue;
+            return tinynet::ERROR_SOCKET_WRITE;
+        }
+        //The descriptor travels with the first byte sent
+        pass_fd = false;
+        p += n;
+        len -= (size_t)n;
+    }
+    return 0;
+}
+
+int RecvFd(int s, int* fd, void* buf, size_t len) {
+    union {
+        char buf[CMSG_SPACE(sizeof(int))];
+        struct cmsghdr align;
+    } control;
+    char* p = (char*)buf;
+    *fd = -1;
+    while (len > 0) {
+        struct iovec iov;
+        iov.iov_base = p;
+        iov.iov_len = len;
+        struct msghdr msg;
+        memset(&msg, 0, sizeof(msg));
+        msg.msg_iov = &iov;
+        msg.msg_iovlen = 1;
+        msg.msg_control = control.buf;
+        msg.msg_controllen = sizeof(control.buf);
+        ssize_t n = ::recvmsg(s, &msg, 0);
+        if (n == -1) {
+            if (errno == EINTR) continue;
+            return tinynet::ERROR_SOCKET_READ;
+        }
+        if (n == 0) {
+            return tinynet::ERROR_SOCKET_READ_EOF;
+        }
+        for (struct cmsghdr* cmsg = CMSG_FIRSTHDR(&msg); cmsg; cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+            if (cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SCM_RIGHTS && *fd == -1) {
+                memcpy(fd, CMSG_DATA(cmsg), sizeof(int));
+            }
+        }
+        p += n;
+        len -= (size_t)n;
+    }
+    return 0;
+}
 #endif // _WIN32
 }
@@ -28,6 +28,8 @@ int BindAndListenTcp(const char* host, int port,
 
 int BindAndListenUnix(const char* path, int backlog, int* err);
 
+int BindUdp(const char* host, int port, int flags, int* err);
+
 int SetReuseAddr(int fd);
 
 int SetReusePort(int fd);
@@ -50,6 +52,10 @@ int ConnectTcp(const char* host, int port, int af, int* err);
 
 int ConnectUnix(const char* path, int* err);
 
+int ConnectUdp(const char* host, int port, int* err);
+
+int GetNameInfo(const struct sockaddr* sa, std::string* ip, int* port);
+
 int Read(int fd, void *buf, size_t len);
 
 int Write(int fd, const void *data, size_t len);
@@ -60,8 +66,12 @@ int Writev(int fd, tinynet::iov_t* iov, int len);
 
 int ReadAll(int fd, tinynet::iovs_t& iovs, int* nread);
 
+int ReadAll(int fd, tinynet::iov_t* iov, int len, int* nread);
+
 int WriteAll(int fd, tinynet::iovs_t& iovs, int* nwrite);
 
+int WriteAll(int fd, tinynet::iov_t* iov, int len, int* nwrite);
+
 int ReadAll(int fd, void *buf, size_t len, int* nread);
 
 int WriteAll(int fd, const void *data, size_t len, int* nwrite);
@@ -71,4 +81,12 @@ int WaitEvent(int fd, int mask, int timeout_ms);
 int LookupAddressFamily(const char* protocol);
 
 int SocketPair(int family, int type, int protocol, int fd[2]);
+
+#ifndef _WIN32
+//Sends len bytes over a blocking unix domain socket, passing fd along with them unless it is -1
+int SendFd(int s, int fd, const void* data, size_t len);
+
+//Receives len bytes sent by SendFd(), *fd is -1 when no descriptor came with them
+int RecvFd(int s, int* fd, void* buf, size_t len);
+#endif
 }
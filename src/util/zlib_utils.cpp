@@ -41,10 +41,11 @@ int deflate(unsigned char* data, size_t len, tinynet::IOBuffer* out_buf) {
     return Z_OK;
 }
 
-int inflate(unsigned char* data, size_t len, tinynet::IOBuffer* out_buf) {
+int inflate(unsigned char* data, size_t len, tinynet::IOBuffer* out_buf, size_t max_len) {
     int ret;
     unsigned have;
     z_stream zs;
+    size_t start = out_buf->size();
 
     /* allocate inflate state */
     zs.zalloc = Z_NULL;
@@ -58,33 +59,39 @@ int inflate(unsigned char* data, size_t len, tinynet::IOBuffer* out_buf) {
     }
 
 
-    /* decompress until deflate stream ends or end of file */
-    do {
-        zs.avail_in = (uInt)len;
-        if (zs.avail_in == 0)
-            break;
-        zs.next_in = data;
-
-        /* run inflate() on input until output buffer not full */
-        do {
-            out_buf->reserve(out_buf->size() + kDefaultBlockSize);
-            zs.avail_out = kDefaultBlockSize;
-            zs.next_out = reinterpret_cast<Bytef*>(out_buf->end());
-            ret = inflate(&zs, Z_NO_FLUSH);
-            assert(ret != Z_STREAM_ERROR);  /* state not clobbered */
-            switch (ret) {
-            case Z_NEED_DICT:
-                ret = Z_DATA_ERROR;     /* and fall through */
-            case Z_DATA_ERROR:
-            case Z_MEM_ERROR:
-                (void)inflateEnd(&zs);
-                return ret;
-            }
-            have = kDefaultBlockSize - zs.avail_out;
-            out_buf->commit(have);
-        } while (zs.avail_out == 0);
+    /* all of the input is there, feed it once */
+    zs.avail_in = (uInt)len;
+    zs.next_in = data;
+    if (zs.avail_in == 0) {
+        (void)inflateEnd(&zs);
+        return Z_DATA_ERROR;
+    }
 
-        /* done when inflate() says it's done */
+    /* run inflate() until the deflate stream ends */
+    do {
+        out_buf->reserve(out_buf->size() + kDefaultBlockSize);
+        zs.avail_out = kDefaultBlockSize;
+        zs.next_out = reinterpret_cast<Bytef*>(out_buf->end());
+        ret = inflate(&zs, Z_NO_FLUSH);
+        assert(ret != Z_STREAM_ERROR);  /* state not clobbered */
+        switch (ret) {
+        case Z_NEED_DICT:
+            ret = Z_DATA_ERROR;     /* and fall through */
+        case Z_DATA_ERROR:
+        case Z_MEM_ERROR:
+            (void)inflateEnd(&zs);
+            return ret;
+        case Z_BUF_ERROR:
+            /* no progress with room left, the stream is truncated */
+            (void)inflateEnd(&zs);
+            return Z_DATA_ERROR;
+        }
+        have = kDefaultBlockSize - zs.avail_out;
+        out_buf->commit(have);
+        if (out_buf->size() - start > max_len) {
+            (void)inflateEnd(&zs);
+            return Z_BUF_ERROR;
+        }
     } while (ret != Z_STREAM_END);
 
     /* clean up and return */
@@ -5,5 +5,6 @@
 namespace ZlibUtils {
 int deflate(unsigned char* data, size_t len, tinynet::IOBuffer* out_buf);
 
-int inflate(unsigned char* data, size_t len, tinynet::IOBuffer* out_buf);
+//Fails with Z_BUF_ERROR when the data inflates to more than max_len bytes
+int inflate(unsigned char* data, size_t len, tinynet::IOBuffer* out_buf, size_t max_len = (size_t)-1);
 }
\ No newline at end of file